@@ -0,0 +1,379 @@
+#include <render_device/platform.h>
+
+#include <render_device/render_device.h>
+#include <render_device/command_list.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// Compares encoding a scene of many small draws directly on the device thread against
+// encoding it into one CommandList per worker thread and submitting the lists, against
+// writing every object's constants to the device's uniform ring up front and then
+// drawing with just a SetUniformData per object, and against writing them to a vertex
+// buffer of per-instance data and drawing every object with one instanced draw.
+//
+// usage: command_list_benchmark [objects] [threads]
+//
+// Run with RENDER_DEVICE=null to measure the CPU cost of encoding without a GPU.
+
+const char *vertexShaderSource = "#version 410 core\n"
+	"uniform mat4 uModel;\n"
+	"uniform mat4 uViewProjection;\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"void main()\n"
+	"{\n"
+	"   gl_Position = uViewProjection * uModel * vec4(aPos, 1.0);\n"
+	"}";
+const char *pixelShaderSource = "#version 410 core\n"
+	"uniform float uShade;\n"
+	"out vec4 FragColor;\n"
+	"void main()\n"
+	"{\n"
+	"   FragColor = vec4(uShade, 0.5, 1.0 - uShade, 1.0);\n"
+	"}\n";
+
+// the same shaders, reading the per-object values from a uniform block
+const char *ringVertexShaderSource = "#version 410 core\n"
+	"layout (std140) uniform PerDraw { mat4 uModel; float uShade; };\n"
+	"uniform mat4 uViewProjection;\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"void main()\n"
+	"{\n"
+	"   gl_Position = uViewProjection * uModel * vec4(aPos, 1.0);\n"
+	"}";
+const char *ringPixelShaderSource = "#version 410 core\n"
+	"layout (std140) uniform PerDraw { mat4 uModel; float uShade; };\n"
+	"out vec4 FragColor;\n"
+	"void main()\n"
+	"{\n"
+	"   FragColor = vec4(uShade, 0.5, 1.0 - uShade, 1.0);\n"
+	"}\n";
+
+// the same shaders again, reading the per-object values from per-instance vertex elements
+const char *instancedVertexShaderSource = "#version 410 core\n"
+	"uniform mat4 uViewProjection;\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in mat4 aModel;\n"
+	"layout (location = 5) in float aShade;\n"
+	"out float vShade;\n"
+	"void main()\n"
+	"{\n"
+	"   vShade = aShade;\n"
+	"   gl_Position = uViewProjection * aModel * vec4(aPos, 1.0);\n"
+	"}";
+const char *instancedPixelShaderSource = "#version 410 core\n"
+	"in float vShade;\n"
+	"out vec4 FragColor;\n"
+	"void main()\n"
+	"{\n"
+	"   FragColor = vec4(vShade, 0.5, 1.0 - vShade, 1.0);\n"
+	"}\n";
+
+// std140 layout of the PerDraw block, which is also the layout of the per-instance vertex elements
+struct PerDraw
+{
+	float model[16];
+	float shade;
+	float padding[3];
+};
+
+struct Scene
+{
+	render::PipelineParam *uModelParam;
+	render::PipelineParam *uShadeParam;
+	render::Pipeline *pipeline;
+	render::VertexArray *vertexArray;
+	render::IndexBuffer *indexBuffer;
+	int indexCount;
+	int numObjects;
+	int gridSize;
+	float time;
+};
+
+// A little per-object work, as scene traversal would do
+static glm::mat4 ObjectModel(const Scene &scene, int i)
+{
+	const float spacing = 2.0f / scene.gridSize;
+	glm::vec3 position(-1.0f + spacing * (i % scene.gridSize + 0.5f), -1.0f + spacing * (i / scene.gridSize + 0.5f), 0.0f);
+	glm::mat4 model = glm::translate(glm::mat4(1), position);
+	model = glm::rotate(model, scene.time + i * 0.1f, glm::vec3(0.3f, 1.0f, 0.0f));
+	return glm::scale(model, glm::vec3(spacing * 0.5f));
+}
+
+// Walk objects [begin, end) of the scene and encode their draws; DEVICE is either the
+// RenderDevice itself or a CommandList, which share the same call signatures.
+template<class DEVICE, class SETPARAMS>
+static void EncodeObjects(const Scene &scene, int begin, int end, DEVICE &device, SETPARAMS setParams)
+{
+	device.SetPipeline(scene.pipeline);
+	device.SetVertexArray(scene.vertexArray);
+	device.SetIndexBuffer(scene.indexBuffer);
+
+	for(int i = begin; i < end; i++)
+	{
+		glm::mat4 model = ObjectModel(scene, i);
+		setParams(glm::value_ptr(model), static_cast<float>(i) / scene.numObjects);
+		device.DrawTrianglesIndexed32(0, scene.indexCount);
+	}
+}
+
+static double Milliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+int main(int argc, char **argv)
+{
+	int numObjects = argc > 1 ? atoi(argv[1]) : 10000;
+	unsigned int numThreads = argc > 2 ? static_cast<unsigned int>(atoi(argv[2])) : std::thread::hardware_concurrency();
+	if(numObjects < 1)
+		numObjects = 1;
+	if(numThreads < 1)
+		numThreads = 1;
+
+	platform::InitPlatform();
+
+	platform::PLATFORM_WINDOW_REF window =
+		platform::CreatePlatformWindow(800, 800, "Command List Benchmark");
+	if(!window)
+	{
+		platform::TerminatePlatform();
+		return -1;
+	}
+
+	render::RenderDevice *renderDevice = render::CreateRenderDevice(800, 800);
+
+	render::VertexShader *vertexShader = renderDevice->CreateVertexShader(vertexShaderSource);
+	render::PixelShader *pixelShader = renderDevice->CreatePixelShader(pixelShaderSource);
+	render::Pipeline *pipeline = renderDevice->CreatePipeline(vertexShader, pixelShader);
+	renderDevice->DestroyVertexShader(vertexShader);
+	renderDevice->DestroyPixelShader(pixelShader);
+
+	// look up parameters up front; workers only record, they never call into the device
+	render::PipelineParam *uModelParam = pipeline->GetParam("uModel");
+	render::PipelineParam *uViewProjectionParam = pipeline->GetParam("uViewProjection");
+	render::PipelineParam *uShadeParam = pipeline->GetParam("uShade");
+
+	vertexShader = renderDevice->CreateVertexShader(ringVertexShaderSource);
+	pixelShader = renderDevice->CreatePixelShader(ringPixelShaderSource);
+	render::Pipeline *ringPipeline = renderDevice->CreatePipeline(vertexShader, pixelShader);
+	renderDevice->DestroyVertexShader(vertexShader);
+	renderDevice->DestroyPixelShader(pixelShader);
+	render::PipelineParam *ringViewProjectionParam = ringPipeline ? ringPipeline->GetParam("uViewProjection") : nullptr;
+	if(ringPipeline && !ringPipeline->SetUniformBlockSlot("PerDraw", 0))
+	{
+		renderDevice->DestroyPipeline(ringPipeline);
+		ringPipeline = nullptr;
+	}
+
+	vertexShader = renderDevice->CreateVertexShader(instancedVertexShaderSource);
+	pixelShader = renderDevice->CreatePixelShader(instancedPixelShaderSource);
+	render::Pipeline *instancedPipeline = renderDevice->CreatePipeline(vertexShader, pixelShader);
+	renderDevice->DestroyVertexShader(vertexShader);
+	renderDevice->DestroyPixelShader(pixelShader);
+	render::PipelineParam *instancedViewProjectionParam = instancedPipeline ? instancedPipeline->GetParam("uViewProjection") : nullptr;
+
+	float vertices[] = {
+		-1, -1,  1,   1, -1,  1,   1,  1,  1,  -1,  1,  1,
+		-1, -1, -1,   1, -1, -1,   1,  1, -1,  -1,  1, -1
+	};
+	uint32_t indices[] = {
+		0, 1, 2, 0, 2, 3,  1, 5, 6, 1, 6, 2,  3, 2, 6, 3, 6, 7,
+		5, 4, 7, 5, 7, 6,  4, 0, 3, 4, 3, 7,  4, 5, 1, 4, 1, 0
+	};
+
+	render::VertexBuffer *vertexBuffer = renderDevice->CreateVertexBuffer(sizeof(vertices), vertices);
+	render::VertexElement vertexElement = { 0, render::VERTEXELEMENTTYPE_FLOAT, 3, 0, 0, 0 };
+	render::VertexDescription *vertexDescription = renderDevice->CreateVertexDescription(1, &vertexElement);
+	render::VertexArray *vertexArray = renderDevice->CreateVertexArray(1, &vertexBuffer, &vertexDescription);
+	render::IndexBuffer *indexBuffer = renderDevice->CreateIndexBuffer(sizeof(indices), indices);
+
+	// the model matrix of each instance takes four vertex elements, one per column
+	std::vector<PerDraw> instances(numObjects);
+	render::VertexBuffer *instanceBuffer = renderDevice->CreateVertexBuffer(numObjects * static_cast<long long>(sizeof(PerDraw)), nullptr, render::BUFFERUSAGE_STREAM);
+	render::VertexElement instanceElements[] = {
+		{ 1, render::VERTEXELEMENTTYPE_FLOAT, 4, sizeof(PerDraw), 0, 1 },
+		{ 2, render::VERTEXELEMENTTYPE_FLOAT, 4, sizeof(PerDraw), 16, 1 },
+		{ 3, render::VERTEXELEMENTTYPE_FLOAT, 4, sizeof(PerDraw), 32, 1 },
+		{ 4, render::VERTEXELEMENTTYPE_FLOAT, 4, sizeof(PerDraw), 48, 1 },
+		{ 5, render::VERTEXELEMENTTYPE_FLOAT, 1, sizeof(PerDraw), 64, 1 }
+	};
+	render::VertexDescription *instanceDescription = renderDevice->CreateVertexDescription(5, instanceElements);
+	render::VertexBuffer *instancedBuffers[] = { vertexBuffer, instanceBuffer };
+	render::VertexDescription *instancedDescriptions[] = { vertexDescription, instanceDescription };
+	render::VertexArray *instancedVertexArray = renderDevice->CreateVertexArray(2, instancedBuffers, instancedDescriptions);
+
+	Scene scene;
+	scene.uModelParam = uModelParam;
+	scene.uShadeParam = uShadeParam;
+	scene.pipeline = pipeline;
+	scene.vertexArray = vertexArray;
+	scene.indexBuffer = indexBuffer;
+	scene.indexCount = sizeof(indices) / sizeof(*indices);
+	scene.numObjects = numObjects;
+	scene.gridSize = 1;
+	while(scene.gridSize * scene.gridSize < numObjects)
+		scene.gridSize++;
+	scene.time = 0.0f;
+
+	std::vector<render::CommandList *> commandLists;
+	for(unsigned int i = 0; i < numThreads; i++)
+		commandLists.push_back(new render::CommandList);
+
+	std::vector<long long> ringOffsets(numObjects);
+
+	double directMs = 0.0, encodeMs = 0.0, submitMs = 0.0, ringMs = 0.0, instancedMs = 0.0;
+	int frames = 0;
+
+	while(platform::PollPlatformWindow(window))
+	{
+		glm::mat4 model(glm::uninitialize), view(glm::uninitialize), projection(glm::uninitialize);
+		platform::GetPlatformViewport(model, view, projection);
+		glm::mat4 viewProjection = projection * view;
+		uViewProjectionParam->SetAsMat4(glm::value_ptr(viewProjection));
+
+		renderDevice->Clear(0.2f, 0.3f, 0.3f);
+
+		// direct submission on this thread
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		renderDevice->BeginGpuScope("Direct");
+		EncodeObjects(scene, 0, numObjects, *renderDevice, [&](const float *model, float shade) {
+			uModelParam->SetAsMat4(model);
+			uShadeParam->SetAsFloat(shade);
+		});
+		renderDevice->EndGpuScope();
+		directMs += Milliseconds(std::chrono::steady_clock::now() - start);
+
+		// the same draws again, encoded by worker threads into their own command lists
+		start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for(unsigned int t = 0; t < numThreads; t++)
+		{
+			workers.push_back(std::thread([&scene, &commandLists, numObjects, numThreads, t]() {
+				render::CommandList &commandList = *commandLists[t];
+				commandList.Reset();
+				EncodeObjects(scene, numObjects * t / numThreads, numObjects * (t + 1) / numThreads, commandList, [&](const float *model, float shade) {
+					commandList.SetParamAsMat4(scene.uModelParam, model);
+					commandList.SetParamAsFloat(scene.uShadeParam, shade);
+				});
+			}));
+		}
+		for(std::thread &worker : workers)
+			worker.join();
+		encodeMs += Milliseconds(std::chrono::steady_clock::now() - start);
+
+		start = std::chrono::steady_clock::now();
+		renderDevice->BeginGpuScope("Command Lists");
+		renderDevice->SubmitCommandLists(numThreads, &commandLists[0]);
+		renderDevice->EndGpuScope();
+		submitMs += Milliseconds(std::chrono::steady_clock::now() - start);
+
+		// once more, with the constants of every object written to the uniform ring before the draws
+		if(ringPipeline)
+		{
+			start = std::chrono::steady_clock::now();
+			renderDevice->BeginGpuScope("Uniform Ring");
+			if(ringViewProjectionParam)
+				ringViewProjectionParam->SetAsMat4(glm::value_ptr(viewProjection));
+			for(int i = 0; i < numObjects; i++)
+			{
+				PerDraw perDraw = {};
+				glm::mat4 model = ObjectModel(scene, i);
+				memcpy(perDraw.model, glm::value_ptr(model), sizeof(perDraw.model));
+				perDraw.shade = static_cast<float>(i) / numObjects;
+				ringOffsets[i] = renderDevice->WriteUniformData(&perDraw, sizeof(perDraw));
+			}
+
+			renderDevice->SetPipeline(ringPipeline);
+			renderDevice->SetVertexArray(vertexArray);
+			renderDevice->SetIndexBuffer(indexBuffer);
+			for(int i = 0; i < numObjects; i++)
+			{
+				if(ringOffsets[i] < 0)
+					break;
+				renderDevice->SetUniformData(0, ringOffsets[i], sizeof(PerDraw));
+				renderDevice->DrawTrianglesIndexed32(0, scene.indexCount);
+			}
+			renderDevice->EndGpuScope();
+			ringMs += Milliseconds(std::chrono::steady_clock::now() - start);
+		}
+
+		// and with the constants of every object in a vertex buffer, drawn as instances of one draw
+		if(instancedPipeline && instanceBuffer)
+		{
+			start = std::chrono::steady_clock::now();
+			renderDevice->BeginGpuScope("Instanced");
+			if(instancedViewProjectionParam)
+				instancedViewProjectionParam->SetAsMat4(glm::value_ptr(viewProjection));
+			for(int i = 0; i < numObjects; i++)
+			{
+				glm::mat4 model = ObjectModel(scene, i);
+				memcpy(instances[i].model, glm::value_ptr(model), sizeof(instances[i].model));
+				instances[i].shade = static_cast<float>(i) / numObjects;
+			}
+			renderDevice->UpdateVertexBuffer(instanceBuffer, 0, numObjects * static_cast<long long>(sizeof(PerDraw)), &instances[0]);
+
+			renderDevice->SetPipeline(instancedPipeline);
+			renderDevice->SetVertexArray(instancedVertexArray);
+			renderDevice->SetIndexBuffer(indexBuffer);
+			renderDevice->DrawTrianglesIndexed32Instanced(0, scene.indexCount, numObjects);
+			renderDevice->EndGpuScope();
+			instancedMs += Milliseconds(std::chrono::steady_clock::now() - start);
+		}
+
+		scene.time += 0.01f;
+		frames++;
+
+		renderDevice->EndFrame();
+
+		platform::PresentPlatformWindow(window);
+	}
+
+	if(frames > 0)
+	{
+		std::cout << numObjects << " objects, " << numThreads << " threads, " << frames << " frames" << std::endl;
+		std::cout << "direct:              " << directMs / frames << " ms/frame" << std::endl;
+		std::cout << "command list encode: " << encodeMs / frames << " ms/frame" << std::endl;
+		std::cout << "command list submit: " << submitMs / frames << " ms/frame" << std::endl;
+		if(ringPipeline)
+			std::cout << "uniform ring:        " << ringMs / frames << " ms/frame" << std::endl;
+		if(instancedPipeline && instanceBuffer)
+			std::cout << "instanced:           " << instancedMs / frames << " ms/frame" << std::endl;
+
+		render::GpuScopeStats gpuStats[4];
+		unsigned int numScopes = renderDevice->GetGpuScopeStats(4, gpuStats);
+		for(unsigned int i = 0; i < numScopes && i < 4; i++)
+			std::cout << "GPU " << gpuStats[i].name << ": " << gpuStats[i].avgMs << " ms/frame (min " << gpuStats[i].minMs << ", max " << gpuStats[i].maxMs << ")" << std::endl;
+	}
+
+	for(render::CommandList *commandList : commandLists)
+		delete commandList;
+
+	renderDevice->DestroyVertexArray(instancedVertexArray);
+	renderDevice->DestroyVertexDescription(instanceDescription);
+	renderDevice->DestroyVertexBuffer(instanceBuffer);
+	renderDevice->DestroyIndexBuffer(indexBuffer);
+	renderDevice->DestroyVertexArray(vertexArray);
+	renderDevice->DestroyVertexDescription(vertexDescription);
+	renderDevice->DestroyVertexBuffer(vertexBuffer);
+	renderDevice->DestroyPipeline(pipeline);
+	if(ringPipeline)
+		renderDevice->DestroyPipeline(ringPipeline);
+	if(instancedPipeline)
+		renderDevice->DestroyPipeline(instancedPipeline);
+
+	render::DestroyRenderDevice(renderDevice);
+
+	platform::TerminatePlatform();
+
+	return 0;
+}
@@ -1,7 +1,9 @@
 #include <render_device/platform.h>
 
 #include <render_device/render_device.h>
+#include <render_device/software_shader.h>
 
+#include <cstddef>
 #include <cstdint>
 
 #include <glm/glm.hpp>
@@ -31,6 +33,56 @@ const char *pixelShaderSource = "#version 410 core\n"
 	"   FragColor = vec4(texture(uTextureSampler, FragTexCoord).rgb, 1);\n"
 	"}\n";
 
+// C++ equivalents of the shaders above for the software RenderDevice
+struct SoftwareVertexUniforms
+{
+	float uModel[16];
+	float uView[16];
+	float uProjection[16];
+};
+
+struct SoftwarePixelUniforms
+{
+	int uTextureSampler;
+};
+
+static void SoftwareVertexShader(const void *uniforms, const float (*attributes)[4], float *position, float *varyings)
+{
+	const SoftwareVertexUniforms *u = static_cast<const SoftwareVertexUniforms *>(uniforms);
+	glm::vec4 clip = glm::make_mat4(u->uProjection) * glm::make_mat4(u->uView) * glm::make_mat4(u->uModel) *
+		glm::vec4(attributes[0][0], attributes[0][1], attributes[0][2], 1.0f);
+	position[0] = clip.x;
+	position[1] = clip.y;
+	position[2] = clip.z;
+	position[3] = clip.w;
+
+	// FragTexCoord
+	varyings[0] = attributes[1][0];
+	varyings[1] = attributes[1][1];
+}
+
+static void SoftwarePixelShader(const void *uniforms, const render::SoftwareSampler &sampler, const float *varyings, float *color)
+{
+	const SoftwarePixelUniforms *u = static_cast<const SoftwarePixelUniforms *>(uniforms);
+	sampler.Sample(u->uTextureSampler, varyings[0], varyings[1], color);
+	color[3] = 1.0f;
+}
+
+static const render::SoftwareUniform softwareVertexUniforms[] = {
+	{ "uModel", render::SOFTWAREUNIFORMTYPE_MAT4, 1, offsetof(SoftwareVertexUniforms, uModel) },
+	{ "uView", render::SOFTWAREUNIFORMTYPE_MAT4, 1, offsetof(SoftwareVertexUniforms, uView) },
+	{ "uProjection", render::SOFTWAREUNIFORMTYPE_MAT4, 1, offsetof(SoftwareVertexUniforms, uProjection) }
+};
+
+static const render::SoftwareUniform softwarePixelUniforms[] = {
+	{ "uTextureSampler", render::SOFTWAREUNIFORMTYPE_INT, 1, offsetof(SoftwarePixelUniforms, uTextureSampler) }
+};
+
+static const render::SoftwareVertexShaderDesc softwareVertexShader = {
+	SoftwareVertexShader, 2, sizeof(SoftwareVertexUniforms), 3, softwareVertexUniforms };
+static const render::SoftwarePixelShaderDesc softwarePixelShader = {
+	SoftwarePixelShader, sizeof(SoftwarePixelUniforms), 1, softwarePixelUniforms };
+
 struct Vertex
 {
 	float x, y, z;
@@ -51,7 +103,10 @@ int main()
 		return -1;
 	}
 
-	render::RenderDevice *renderDevice = render::CreateRenderDevice();
+	render::RenderDevice *renderDevice = render::CreateRenderDevice(800, 800);
+
+	render::RegisterSoftwareVertexShader(vertexShaderSource, &softwareVertexShader);
+	render::RegisterSoftwarePixelShader(pixelShaderSource, &softwarePixelShader);
 
 	render::VertexShader *vertexShader = renderDevice->CreateVertexShader(vertexShaderSource);
 
@@ -122,8 +177,8 @@ int main()
 	render::VertexBuffer *vertexBuffer = renderDevice->CreateVertexBuffer(sizeof(vertices), vertices);
 
 	render::VertexElement vertexElements[] = {
-		{ 0, render::VERTEXELEMENTTYPE_FLOAT, 3, sizeof(Vertex), 0 },
-		{ 1, render::VERTEXELEMENTTYPE_FLOAT, 2, sizeof(Vertex), 12 }
+		{ 0, render::VERTEXELEMENTTYPE_FLOAT, 3, sizeof(Vertex), 0, 0 },
+		{ 1, render::VERTEXELEMENTTYPE_FLOAT, 2, sizeof(Vertex), 12, 0 }
 	};
 	render::VertexDescription *vertexDescription = renderDevice->CreateVertexDescription(COUNT_OF(vertexElements), vertexElements);
 
@@ -150,11 +205,17 @@ int main()
 		20, 21, 22, 20, 22, 23
 	};
 
-	render::IndexBuffer *indexBuffer = renderDevice->CreateIndexBuffer(sizeof(indices), indices);
+	// the cube has few vertices, so its indices are stored as 16-bit
+	render::IndexFormat indexFormat;
+	render::IndexBuffer *indexBuffer = render::CreateNarrowedIndexBuffer(renderDevice, COUNT_OF(indices), indices, indexFormat);
 
 	// create texture
 	render::Texture2D *texture2D = renderDevice->CreateTexture2D(BMPWIDTH, BMPHEIGHT, image32);
 
+	// trilinear filtering, clamped to the edges of the texture
+	render::SamplerState *samplerState = renderDevice->CreateSamplerState(render::TEXTUREFILTER_LINEAR, render::TEXTUREFILTER_LINEAR,
+		render::MIPFILTER_LINEAR, render::TEXTUREWRAP_CLAMP_TO_EDGE, render::TEXTUREWRAP_CLAMP_TO_EDGE);
+
 	while(platform::PollPlatformWindow(window))
 	{
 		glm::mat4 model(glm::uninitialize), view(glm::uninitialize), projection(glm::uninitialize);
@@ -166,8 +227,9 @@ int main()
 
 		renderDevice->Clear(0.2f, 0.3f, 0.3f);
 
-		// Set the texture for slot 0
+		// Set the texture and how it is sampled for slot 0
 		renderDevice->SetTexture2D(0, texture2D);
+		renderDevice->SetSamplerState(0, samplerState);
 
 		renderDevice->SetPipeline(pipeline);
 		renderDevice->SetVertexArray(vertexArray);
@@ -175,12 +237,18 @@ int main()
 		// Set the index buffer
 		renderDevice->SetIndexBuffer(indexBuffer);
 
-		// Draw assuming index buffer consists of 32-bit, unsigned integers
-		renderDevice->DrawTrianglesIndexed32(0, COUNT_OF(indices));
+		// Draw with the index format the buffer was created with
+		if(indexFormat == render::INDEXFORMAT_16)
+			renderDevice->DrawTrianglesIndexed16(0, COUNT_OF(indices));
+		else
+			renderDevice->DrawTrianglesIndexed32(0, COUNT_OF(indices));
+
+		renderDevice->EndFrame();
 
 		platform::PresentPlatformWindow(window);
 	}
 
+	renderDevice->DestroySamplerState(samplerState);
 	renderDevice->DestroyTexture2D(texture2D);
 	renderDevice->DestroyIndexBuffer(indexBuffer);
 	renderDevice->DestroyVertexArray(vertexArray);
@@ -188,6 +256,8 @@ int main()
 	renderDevice->DestroyVertexBuffer(vertexBuffer);
 	renderDevice->DestroyPipeline(pipeline);
 
+	render::DestroyRenderDevice(renderDevice);
+
 	platform::TerminatePlatform();
 
 	return 0;
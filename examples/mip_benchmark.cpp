@@ -0,0 +1,128 @@
+#include <render_device/platform.h>
+
+#include <render_device/render_device.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image888.h"
+
+// Compares the ways a texture's mip chain can be filled: not at all, by the driver after
+// the top level is uploaded, and by filtering every level on the CPU and uploading them
+// together. Every frame creates one texture of each size with each policy, timing the
+// CPU inside CreateTexture2D and the GPU with a scope around each creation. The smallest
+// texture is the 512x512 sample image; the larger ones are synthetic.
+//
+// usage: mip_benchmark [largest size]
+//
+// Run with PLATFORM_HEADLESS_FRAMES set to choose the number of frames.
+
+static const char *policyNames[render::MIPPOLICY_MAX] = { "None", "Driver", "CPU" };
+
+struct Image
+{
+	int size;
+	const void *data;
+	std::vector<uint32_t> pixels; // for synthetic images
+};
+
+static double Milliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+int main(int argc, char **argv)
+{
+	int largestSize = argc > 1 ? atoi(argv[1]) : 2048;
+
+	platform::InitPlatform();
+
+	platform::PLATFORM_WINDOW_REF window =
+		platform::CreatePlatformWindow(800, 800, "Mip Benchmark");
+	if(!window)
+	{
+		platform::TerminatePlatform();
+		return -1;
+	}
+
+	render::RenderDevice *renderDevice = render::CreateRenderDevice(800, 800);
+
+	// the sample image, then synthetic images of doubling size with detail at every scale
+	std::vector<Image> images(1);
+	images[0].size = BMPWIDTH;
+	images[0].data = image32;
+	for(int size = BMPWIDTH * 2; size <= largestSize; size *= 2)
+	{
+		Image image;
+		image.size = size;
+		image.pixels.resize(static_cast<size_t>(size) * size);
+		for(int y = 0; y < size; y++)
+			for(int x = 0; x < size; x++)
+				image.pixels[static_cast<size_t>(y) * size + x] = ((x ^ y) & 0xFF) | ((x * 3 & 0xFF) << 8) | ((y * 5 & 0xFF) << 16);
+		images.push_back(image);
+	}
+	for(Image &image : images)
+		if(!image.pixels.empty())
+			image.data = &image.pixels[0];
+
+	// GPU scope names, which must stay valid while the device uses them
+	std::vector<std::string> scopeNames;
+	for(const Image &image : images)
+		for(int policy = 0; policy < render::MIPPOLICY_MAX; policy++)
+			scopeNames.push_back(std::to_string(image.size) + " " + policyNames[policy]);
+
+	std::vector<double> cpuMs(scopeNames.size(), 0.0);
+	std::vector<render::Texture2D *> textures;
+	int frames = 0;
+	while(platform::PollPlatformWindow(window))
+	{
+		renderDevice->Clear(0.2f, 0.3f, 0.3f);
+
+		for(size_t i = 0; i < scopeNames.size(); i++)
+		{
+			const Image &image = images[i / render::MIPPOLICY_MAX];
+			render::MipPolicy mipPolicy = static_cast<render::MipPolicy>(i % render::MIPPOLICY_MAX);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			renderDevice->BeginGpuScope(scopeNames[i].c_str());
+			textures.push_back(renderDevice->CreateTexture2D(image.size, image.size, image.data, render::TEXTUREFORMAT_RGBX8, 0, mipPolicy));
+			renderDevice->EndGpuScope();
+			cpuMs[i] += Milliseconds(std::chrono::steady_clock::now() - start);
+		}
+
+		frames++;
+		renderDevice->EndFrame();
+
+		// the textures are destroyed once the frame that filled them has been submitted
+		for(render::Texture2D *texture : textures)
+			renderDevice->DestroyTexture2D(texture);
+		textures.clear();
+
+		platform::PresentPlatformWindow(window);
+	}
+
+	if(frames > 0)
+	{
+		std::vector<render::GpuScopeStats> gpuStats(scopeNames.size());
+		unsigned int numScopes = renderDevice->GetGpuScopeStats(static_cast<unsigned int>(gpuStats.size()), &gpuStats[0]);
+
+		std::cout << frames << " frames" << std::endl;
+		for(size_t i = 0; i < scopeNames.size(); i++)
+		{
+			std::cout << scopeNames[i] << ": CPU " << cpuMs[i] / frames << " ms";
+			if(i < numScopes)
+				std::cout << ", GPU " << gpuStats[i].avgMs << " ms (min " << gpuStats[i].minMs << ", max " << gpuStats[i].maxMs << ")";
+			std::cout << std::endl;
+		}
+	}
+
+	render::DestroyRenderDevice(renderDevice);
+
+	platform::TerminatePlatform();
+
+	return 0;
+}
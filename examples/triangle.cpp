@@ -1,6 +1,7 @@
 #include <render_device/platform.h>
 
 #include <render_device/render_device.h>
+#include <render_device/software_shader.h>
 
 const char *vertexShaderSource = "#version 410 core\n"
 	"layout (location = 0) in vec3 aPos;\n"
@@ -15,6 +16,26 @@ const char *pixelShaderSource = "#version 410 core\n"
 	"   FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
 	"}\n\0";
 
+// C++ equivalents of the shaders above for the software RenderDevice
+static void SoftwareVertexShader(const void *uniforms, const float (*attributes)[4], float *position, float *varyings)
+{
+	position[0] = attributes[0][0];
+	position[1] = attributes[0][1];
+	position[2] = attributes[0][2];
+	position[3] = 1.0f;
+}
+
+static void SoftwarePixelShader(const void *uniforms, const render::SoftwareSampler &sampler, const float *varyings, float *color)
+{
+	color[0] = 1.0f;
+	color[1] = 0.5f;
+	color[2] = 0.2f;
+	color[3] = 1.0f;
+}
+
+static const render::SoftwareVertexShaderDesc softwareVertexShader = { SoftwareVertexShader, 0, 0, 0, nullptr };
+static const render::SoftwarePixelShaderDesc softwarePixelShader = { SoftwarePixelShader, 0, 0, nullptr };
+
 int main()
 {
 	platform::InitPlatform();
@@ -29,7 +50,10 @@ int main()
 		return -1;
 	}
 
-	render::RenderDevice *renderDevice = render::CreateRenderDevice();
+	render::RenderDevice *renderDevice = render::CreateRenderDevice(800, 600);
+
+	render::RegisterSoftwareVertexShader(vertexShaderSource, &softwareVertexShader);
+	render::RegisterSoftwarePixelShader(pixelShaderSource, &softwarePixelShader);
 
 	// build and compile our shader program
 	// ------------------------------------
@@ -55,7 +79,7 @@ int main()
 
 	render::VertexBuffer *vertexBuffer = renderDevice->CreateVertexBuffer(sizeof(vertices), vertices);
 
-	render::VertexElement vertexElement = { 0, render::VERTEXELEMENTTYPE_FLOAT, 3, 0, 0, };
+	render::VertexElement vertexElement = { 0, render::VERTEXELEMENTTYPE_FLOAT, 3, 0, 0, 0 };
 	render::VertexDescription *vertexDescription = renderDevice->CreateVertexDescription(1, &vertexElement);
 
 	render::VertexArray *vertexArray = renderDevice->CreateVertexArray(1, &vertexBuffer, &vertexDescription);
@@ -73,6 +97,8 @@ int main()
 		renderDevice->SetVertexArray(vertexArray);
 		renderDevice->DrawTriangles(0, 3);
 
+		renderDevice->EndFrame();
+
 		platform::PresentPlatformWindow(window);
 	}
 
@@ -83,6 +109,8 @@ int main()
 	renderDevice->DestroyVertexBuffer(vertexBuffer);
 	renderDevice->DestroyPipeline(pipeline);
 
+	render::DestroyRenderDevice(renderDevice);
+
 	platform::TerminatePlatform();
 
 	return 0;
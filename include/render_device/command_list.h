@@ -0,0 +1,159 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace render
+{
+
+// Records RenderDevice commands into a compact stream of packets so that draws can
+// be encoded on worker threads and later submitted, in order, with
+// RenderDevice::SubmitCommandLists on the thread that owns the device.
+//
+// Packets are written back to back into large memory blocks owned by the list.
+// A list must only be recorded by one thread at a time, so giving each worker
+// thread its own list gives each its own arena with no locking. Reset keeps the
+// blocks, so a list recorded every frame stops allocating after the first.
+//
+// Resources referenced by recorded commands must stay alive until the list has
+// been submitted. Array parameter values are copied into the list when recorded.
+class CommandList
+{
+public:
+
+	// A block of recorded packets
+	struct Block
+	{
+		char *data;
+		size_t used;
+		size_t capacity;
+	};
+
+	// blockSize is the size of each memory block; packets larger than this get a block of their own
+	explicit CommandList(size_t blockSize = 64 * 1024);
+
+	~CommandList();
+
+	CommandList(const CommandList &) = delete;
+	CommandList &operator=(const CommandList &) = delete;
+
+	// Discard all recorded commands, keeping the memory for reuse
+	void Reset();
+
+	// Returns true if no commands have been recorded since construction or the last Reset
+	bool IsEmpty() const { return m_NumCommands == 0; }
+
+	// Number of commands recorded since construction or the last Reset
+	unsigned int GetNumCommands() const { return m_NumCommands; }
+
+	// Blocks of recorded packets, in recording order; used by RenderDevice implementations to execute the list
+	const std::vector<Block> &GetBlocks() const { return m_Blocks; }
+
+	// Record RenderDevice::SetPipeline
+	void SetPipeline(Pipeline *pipeline);
+
+	// Record RenderDevice::SetVertexArray
+	void SetVertexArray(VertexArray *vertexArray);
+
+	// Record RenderDevice::SetIndexBuffer
+	void SetIndexBuffer(IndexBuffer *indexBuffer);
+
+	// Record RenderDevice::SetPrimitiveTopology
+	void SetPrimitiveTopology(PrimitiveTopology topology);
+
+	// Record RenderDevice::SetTexture2D
+	void SetTexture2D(unsigned int slot, Texture2D *texture2D);
+
+	// Record RenderDevice::SetTexture2DArray
+	void SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray);
+
+	// Record RenderDevice::SetSamplerState
+	void SetSamplerState(unsigned int slot, SamplerState *samplerState);
+
+	// Record RenderDevice::SetUniformBuffer
+	void SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer);
+
+	// Record RenderDevice::WriteUniformData and RenderDevice::SetUniformData with a copy
+	// of data, which is written to the device's uniform storage when the list is submitted
+	void SetUniformData(unsigned int slot, const void *data, unsigned int size);
+
+	// Record RenderDevice::SetRasterState
+	void SetRasterState(RasterState *rasterState);
+
+	// Record RenderDevice::SetDepthStencilState
+	void SetDepthStencilState(DepthStencilState *depthStencilState);
+
+	// Record PipelineParam::SetAsInt
+	void SetParamAsInt(PipelineParam *param, int value);
+
+	// Record PipelineParam::SetAsFloat
+	void SetParamAsFloat(PipelineParam *param, float value);
+
+	// Record PipelineParam::SetAsMat4
+	void SetParamAsMat4(PipelineParam *param, const float *value);
+
+	// Record PipelineParam::SetAsIntArray
+	void SetParamAsIntArray(PipelineParam *param, int count, const int *values);
+
+	// Record PipelineParam::SetAsFloatArray
+	void SetParamAsFloatArray(PipelineParam *param, int count, const float *values);
+
+	// Record PipelineParam::SetAsMat4Array
+	void SetParamAsMat4Array(PipelineParam *param, int count, const float *values);
+
+	// Record RenderDevice::Clear
+	void Clear(float red = 0.0f, float green = 0.0f, float blue = 0.0f, float alpha = 1.0f, float depth = 1.0f, int stencil = 0);
+
+	// Record RenderDevice::DrawTriangles
+	void DrawTriangles(int offset, int count);
+
+	// Record RenderDevice::DrawTrianglesIndexed32
+	void DrawTrianglesIndexed32(long long offset, int count, int baseVertex = 0);
+
+	// Record RenderDevice::DrawTrianglesIndexed16
+	void DrawTrianglesIndexed16(long long offset, int count, int baseVertex = 0);
+
+	// Record RenderDevice::DrawTrianglesInstanced
+	void DrawTrianglesInstanced(int offset, int count, int instanceCount);
+
+	// Record RenderDevice::DrawTrianglesIndexed32Instanced
+	void DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex = 0);
+
+	// Record RenderDevice::DrawTrianglesIndexed16Instanced
+	void DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex = 0);
+
+	// Record RenderDevice::DrawTrianglesMulti; the arrays are copied into the list
+	void DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts);
+
+	// Record RenderDevice::DrawTrianglesIndexedMulti; the arrays are copied into the list
+	void DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices = nullptr,
+		IndexFormat format = INDEXFORMAT_32);
+
+	// Record RenderDevice::DrawTrianglesIndexedIndirect; the arguments are read when the list is
+	// executed, so they may be written until it is submitted
+	void DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount = 1, IndexFormat format = INDEXFORMAT_32);
+
+	// Record RenderDevice::BeginGpuScope; only the pointer is recorded, so name must
+	// stay valid until the list has been submitted
+	void BeginGpuScope(const char *name);
+
+	// Record RenderDevice::EndGpuScope
+	void EndGpuScope();
+
+private:
+
+	// Reserve space for a packet of the given size, which must be a multiple of 8 bytes
+	void *Allocate(size_t size);
+
+	// Record a pipeline parameter update with its values copied inline
+	void SetParam(unsigned int type, PipelineParam *param, int count, const void *values, size_t size);
+
+	size_t m_BlockSize;
+	std::vector<Block> m_Blocks;
+	size_t m_CurrentBlock = 0;
+	unsigned int m_NumCommands = 0;
+};
+
+} // end namespace render
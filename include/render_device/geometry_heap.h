@@ -0,0 +1,174 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace render
+{
+
+class TlsfAllocator;
+
+// Identifies a mesh placed in a GeometryHeap; 0 is never a valid handle
+typedef uint32_t GeometryHandle;
+
+// Where a mesh was placed in a GeometryHeap
+struct GeometryEntry
+{
+	unsigned int page; // index of the page, as passed to GeometryHeap::GetVertexArray
+	int baseVertex; // first vertex of the mesh in its page
+	int vertexCount;
+	long long indexOffset; // in bytes, into the page's index buffer
+	int indexCount; // 0 for meshes without indices, drawn with DrawTriangles(baseVertex, vertexCount)
+};
+
+// Occupancy and fragmentation of a GeometryHeap, for tuning its page sizes and its
+// compaction budget
+struct GeometryHeapStats
+{
+	unsigned int pages = 0;
+	unsigned int entries = 0;
+	long long usedVertexBytes = 0;
+	long long usedIndexBytes = 0;
+	long long pageVertexBytes = 0; // vertex bytes of every page
+	long long pageIndexBytes = 0;
+	unsigned int freeVertexRanges = 0; // separate free ranges of every page
+	unsigned int freeIndexRanges = 0;
+	// the largest free range of any page. Insert and Compact place a mesh in any range that
+	// holds it, so a mesh no larger than this fits without adding a page, as long as its
+	// vertices and its indices both fit in the same page.
+	long long largestFreeVertexBytes = 0;
+	long long largestFreeIndexBytes = 0;
+
+	// 1 minus the fraction of free bytes in the largest free range of their page; 0 when
+	// every page's free space is in one range
+	float vertexFragmentation = 0.0f;
+	float indexFragmentation = 0.0f;
+
+	long long compactedBytes = 0; // moved by Compact since the heap was created
+	unsigned int releasedPages = 0; // released by Compact since the heap was created
+};
+
+// Packs the vertices and indices of many meshes of one vertex format into a few large
+// vertex and index buffers, so that they can be drawn one after another without
+// changing vertex arrays between them.
+//
+// Each page of the heap is a vertex buffer and an index buffer, with one vertex array
+// for the format. Meshes are placed in the first page with room for both their vertices
+// and their indices, with a TLSF allocator per buffer, and keep indices relative to their
+// own first vertex, which is passed as the base vertex of the draw:
+//
+//     const GeometryEntry *entry = heap.GetEntry(handle);
+//     renderDevice->SetVertexArray(heap.GetVertexArray(entry->page));
+//     renderDevice->SetIndexBuffer(heap.GetIndexBuffer(entry->page));
+//     renderDevice->DrawTrianglesIndexed32(entry->indexOffset, entry->indexCount, entry->baseVertex);
+//
+// Draws of meshes in the same page bind the same vertex array and index buffer, so
+// sorting draws by page leaves only the draws themselves.
+//
+// As meshes come and go, free space splinters into ranges too small to use. Compact,
+// called once a frame, moves meshes with RenderDevice::CopyVertexBuffer and
+// CopyIndexBuffer to close the gaps and to empty sparse pages, which it then releases,
+// moving no more than a byte budget a frame.
+class GeometryHeap
+{
+public:
+
+	// Vertices are vertexStride bytes, described by vertexElements. Pages hold
+	// pageVertexBytes of vertices and pageIndexBytes of 32-bit indices.
+	GeometryHeap(RenderDevice *renderDevice, unsigned int numVertexElements, const VertexElement *vertexElements, int vertexStride,
+		long long pageVertexBytes = 16 * 1024 * 1024, long long pageIndexBytes = 4 * 1024 * 1024);
+
+	~GeometryHeap();
+
+	GeometryHeap(const GeometryHeap &) = delete;
+	GeometryHeap &operator=(const GeometryHeap &) = delete;
+
+	// Place a mesh of vertexCount vertices and indexCount indices, adding a page if none
+	// has room. indices may be nullptr when indexCount is 0. Returns 0 if the mesh does
+	// not fit in a page.
+	GeometryHandle Insert(int vertexCount, const void *vertices, int indexCount, const unsigned int *indices);
+
+	// Remove a mesh, so that its space can be taken by later insertions. Empty pages are
+	// kept until Compact releases them.
+	void Remove(GeometryHandle handle);
+
+	// Move up to budgetBytes of vertices and indices to defragment the heap, and release
+	// pages left empty, keeping one for reuse. Returns the bytes moved.
+	//
+	// Moved meshes have their entries updated when this returns, so call it at a frame
+	// boundary, between EndFrame and the next frame's draws, and do not keep entries from
+	// before it. Draws already made keep reading their meshes' old ranges, as the copies
+	// are ordered after them.
+	long long Compact(long long budgetBytes);
+
+	// Returns where a mesh was placed, or nullptr if handle is not in the heap
+	const GeometryEntry *GetEntry(GeometryHandle handle) const;
+
+	// Returns the number of page indices in use, including those of released pages
+	unsigned int GetNumPages() const { return static_cast<unsigned int>(m_Pages.size()); }
+
+	// Returns the vertex array to bind when drawing the meshes placed in a page, or nullptr
+	// for a released page
+	VertexArray *GetVertexArray(unsigned int page) const { return page < m_Pages.size() ? m_Pages[page].vertexArray : nullptr; }
+
+	// Returns the index buffer to bind when drawing the meshes placed in a page
+	IndexBuffer *GetIndexBuffer(unsigned int page) const { return page < m_Pages.size() ? m_Pages[page].indexBuffer : nullptr; }
+
+	GeometryHeapStats GetStats() const;
+
+private:
+
+	// A page whose buffers are nullptr has been released, and its index is reused by the next page added
+	struct Page
+	{
+		VertexBuffer *vertexBuffer;
+		IndexBuffer *indexBuffer;
+		VertexArray *vertexArray;
+		std::unique_ptr<TlsfAllocator> vertices; // in vertices
+		std::unique_ptr<TlsfAllocator> indices; // in indices
+		unsigned int entries;
+	};
+
+	struct Slot
+	{
+		GeometryEntry entry;
+		uint32_t vertexBlock, indexBlock; // TlsfAllocator blocks of the entry's page
+		bool used;
+	};
+
+	// Take room for a mesh from a page; returns false, taking nothing, if it has none
+	bool Allocate(Page &page, int vertexCount, int indexCount, uint32_t &vertexBlock, uint32_t &indexBlock);
+
+	// Add an empty page, returning its index, or -1 if its buffers could not be created
+	int AddPage();
+
+	// Move meshes of the last page holding any to earlier pages, within budgetBytes; returns the bytes moved
+	long long EvacuatePage(long long budgetBytes);
+
+	// Move meshes of a page into the lowest free ranges below them, within budgetBytes; returns the bytes moved
+	long long DefragmentPage(unsigned int pageIndex, long long budgetBytes);
+
+	// Destroy the buffers of an empty page
+	void ReleasePage(Page &page);
+
+	// Returns the larger of the fractions of a page's vertices and indices in use
+	float GetOccupancy(const Page &page) const;
+
+	RenderDevice *m_RenderDevice;
+	VertexDescription *m_VertexDescription;
+	int m_VertexStride;
+	uint32_t m_PageVertices; // vertices per page
+	uint32_t m_PageIndices; // indices per page
+
+	std::vector<Page> m_Pages;
+	std::vector<Slot> m_Slots; // indexed by handle - 1
+	std::vector<GeometryHandle> m_FreeHandles;
+
+	long long m_CompactedBytes = 0;
+	unsigned int m_ReleasedPages = 0;
+};
+
+} // end namespace render
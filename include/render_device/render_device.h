@@ -3,6 +3,8 @@
 namespace render
 {
 
+class CommandList;
+
 // Encapsulates a vertex shader
 class VertexShader
 {
@@ -57,6 +59,11 @@ protected:
 	PipelineParam() {}
 };
 
+// Compact, pipeline-specific name for a PipelineParam, resolved without any lookup by name
+typedef int ParamHandle;
+
+const ParamHandle INVALID_PARAM_HANDLE = -1;
+
 // Encapsulates a shader pipeline
 class Pipeline
 {
@@ -65,14 +72,122 @@ public:
 	// virtual destructor to ensure subclasses have a virtual destructor
 	virtual ~Pipeline() {}
 
+	// Returns the param for the named uniform, or an element of it as in "bones[4]"; nullptr
+	// if the pipeline has no such uniform. The param lives as long as the pipeline.
 	virtual PipelineParam *GetParam(const char *name) = 0;
 
+	// Returns a handle to the param GetParam(name) would return, or INVALID_PARAM_HANDLE
+	virtual ParamHandle GetParamHandle(const char *name) = 0;
+
+	// Returns the param a handle from GetParamHandle refers to, or nullptr for an invalid handle
+	virtual PipelineParam *ResolveParam(ParamHandle handle) = 0;
+
+	// Read the uniform block called name from the uniform buffer slot given to SetUniformBuffer
+	// or SetUniformData; returns false if the pipeline has no such block
+	virtual bool SetUniformBlockSlot(const char *name, unsigned int slot) = 0;
+
 protected:
 
 	// protected default constructor to ensure these are never created directly
 	Pipeline() {}
 };
 
+// How often the contents of a buffer are expected to change, which decides where the
+// driver keeps it
+enum BufferUsage
+{
+	// Written once, or rarely, and drawn many times
+	BUFFERUSAGE_STATIC = 0,
+
+	// Rewritten now and then, and drawn many times in between
+	BUFFERUSAGE_DYNAMIC,
+
+	// Rewritten every frame, and drawn a few times
+	BUFFERUSAGE_STREAM,
+
+	BUFFERUSAGE_MAX
+};
+
+// Options for mapping a buffer, combined with |; a mapping is always write-only
+enum BufferMapFlags
+{
+	// The previous contents of the whole buffer are discarded. The buffer is given new
+	// storage while draws already made keep reading the old, so rewriting a buffer every
+	// frame never waits for the GPU.
+	BUFFERMAP_DISCARD = 1 << 0,
+
+	// The caller guarantees that no draw that has not finished reads the mapped range, so
+	// the device does not wait for the GPU; for appending to a buffer being drawn from
+	BUFFERMAP_UNSYNCHRONIZED = 1 << 1
+};
+
+// Width of the indices of an index buffer
+enum IndexFormat
+{
+	// 32-bit unsigned indices, drawn with DrawTrianglesIndexed32
+	INDEXFORMAT_32 = 0,
+
+	// 16-bit unsigned indices, drawn with DrawTrianglesIndexed16; half the memory and index
+	// fetch bandwidth of 32-bit indices, for meshes of up to 65535 vertices
+	INDEXFORMAT_16,
+
+	INDEXFORMAT_MAX
+};
+
+// How the vertices of a draw, taken in order from the vertex array or the index buffer,
+// form primitives
+enum PrimitiveTopology
+{
+	// Every three vertices form a separate triangle
+	PRIMITIVETOPOLOGY_TRIANGLE_LIST = 0,
+
+	// Every vertex after the first two forms a triangle with the two before it, keeping the
+	// winding of the first; about one index per triangle rather than three
+	PRIMITIVETOPOLOGY_TRIANGLE_STRIP,
+
+	// Every two vertices form a separate line
+	PRIMITIVETOPOLOGY_LINE_LIST,
+
+	// Every vertex after the first forms a line with the one before it
+	PRIMITIVETOPOLOGY_LINE_STRIP,
+
+	// Every vertex is a point
+	PRIMITIVETOPOLOGY_POINT_LIST,
+
+	PRIMITIVETOPOLOGY_MAX
+};
+
+// Indices of these values end the strip being drawn by an indexed draw of a strip topology,
+// and the next index starts a new one, so that many strips are drawn by one draw
+const unsigned int PRIMITIVE_RESTART_INDEX32 = 0xFFFFFFFF;
+const unsigned short PRIMITIVE_RESTART_INDEX16 = 0xFFFF;
+
+// Arguments of one draw of DrawTrianglesIndexedIndirect, as read from an IndirectBuffer;
+// the layout of OpenGL's DrawElementsIndirectCommand
+struct DrawIndexedIndirectCommand
+{
+	unsigned int count; // indices
+	unsigned int instanceCount; // 0 skips the draw, as for a culled object
+	unsigned int firstIndex; // in indices, not bytes, into the bound index buffer
+	int baseVertex;
+	unsigned int baseInstance; // must be 0 on OpenGL 4.1
+};
+
+// Returns the number of bytes in an index of format
+int GetIndexSize(IndexFormat format);
+
+// Returns the largest of count 32-bit indices, or 0 if count is 0
+unsigned int GetMaxIndex(long long count, const unsigned int *indices);
+
+// Returns the narrowest format that holds every one of count 32-bit indices. 16-bit indices
+// never use 0xFFFF, which is kept free to mark primitive restarts; restarts among the 32-bit
+// indices narrow to it rather than widening the format.
+IndexFormat GetNarrowestIndexFormat(long long count, const unsigned int *indices);
+
+// Copy count 32-bit indices, each of which fits in 16 bits or is PRIMITIVE_RESTART_INDEX32,
+// to narrowed, where restarts become PRIMITIVE_RESTART_INDEX16
+void NarrowIndices(long long count, const unsigned int *indices, unsigned short *narrowed);
+
 // Encapsulates a vertex buffer
 class VertexBuffer
 {
@@ -129,6 +244,20 @@ protected:
     IndexBuffer() {}
 };
 
+// Encapsulates a buffer of DrawIndexedIndirectCommand draw arguments, kept in GPU memory
+class IndirectBuffer
+{
+public:
+
+	// virtual destructor to ensure subclasses have a virtual destructor
+	virtual ~IndirectBuffer() {}
+
+protected:
+
+	// protected default constructor to ensure these are never created directly
+	IndirectBuffer() {}
+};
+
 // Encapsulates a 2D texture
 class Texture2D
 {
@@ -143,6 +272,182 @@ protected:
     Texture2D() {}
 };
 
+// Encapsulates an array of 2D textures of the same size, format and number of levels,
+// sampled as one texture with the layer as a third coordinate
+class Texture2DArray
+{
+public:
+
+	// virtual destructor to ensure subclasses have a virtual destructor
+	virtual ~Texture2DArray() {}
+
+protected:
+
+	// protected default constructor to ensure these are never created directly
+	Texture2DArray() {}
+};
+
+// Describes how the texels of a texture are stored
+enum TextureFormat
+{
+	// 32-bit pixels where 8 bits are used for each of the red, green, and blue
+	// components, from lowest to highest byte order; the most significant byte is ignored
+	TEXTUREFORMAT_RGBX8 = 0,
+
+	// 32-bit pixels where 8 bits are used for each of the red, green, blue, and alpha
+	// components, from lowest to highest byte order
+	TEXTUREFORMAT_RGBA8,
+
+	// Block-compressed formats, which store each 4x4 block of texels in 8 or 16 bytes;
+	// check IsTextureFormatSupported before creating textures of these formats
+
+	// RGB in 8 bytes per block (DXT1)
+	TEXTUREFORMAT_BC1,
+
+	// RGBA in 16 bytes per block (DXT5)
+	TEXTUREFORMAT_BC3,
+
+	// Red in 8 bytes per block
+	TEXTUREFORMAT_BC4,
+
+	// Red and green in 16 bytes per block
+	TEXTUREFORMAT_BC5,
+
+	// RGBA in 16 bytes per block, at higher quality than BC3
+	TEXTUREFORMAT_BC7,
+
+	// RGB in 8 bytes per block
+	TEXTUREFORMAT_ETC2_RGB8,
+
+	// RGBA in 16 bytes per block
+	TEXTUREFORMAT_ETC2_RGBA8,
+
+	TEXTUREFORMAT_MAX
+};
+
+// How the mip levels of a texture are filled when only its top level is supplied
+enum MipPolicy
+{
+	// The texture has a single level; for textures that are never minified
+	MIPPOLICY_NONE = 0,
+
+	// The driver generates the levels after the top level is uploaded
+	MIPPOLICY_DRIVER,
+
+	// The levels are box filtered on the CPU across several threads, then uploaded
+	// together with the top level
+	MIPPOLICY_CPU,
+
+	MIPPOLICY_MAX
+};
+
+// Returns whether the texels of format are stored in 4x4 blocks
+bool IsCompressedTextureFormat(TextureFormat format);
+
+// Returns the number of levels in a full mip chain of a width by height texture
+int GetTextureMipLevels(int width, int height);
+
+// Returns the number of bytes in one mip level of a width by height texture of format
+long long GetTextureLevelSize(TextureFormat format, int width, int height);
+
+// Returns the number of bytes in the first mipLevels levels of a width by height texture
+// of format, stored largest first and tightly packed
+long long GetTextureSize(TextureFormat format, int width, int height, int mipLevels);
+
+// Encapsulates how textures are sampled
+class SamplerState
+{
+public:
+
+	// virtual destructor to ensure subclasses have a virtual destructor
+	virtual ~SamplerState() {}
+
+protected:
+
+	// protected default constructor to ensure these are never created directly
+	SamplerState() {}
+};
+
+enum TextureFilter
+{
+	// Take the nearest texel
+	TEXTUREFILTER_NEAREST = 0,
+
+	// Blend the four nearest texels
+	TEXTUREFILTER_LINEAR,
+
+	TEXTUREFILTER_MAX
+};
+
+enum MipFilter
+{
+	// Sample the top level only
+	MIPFILTER_NONE = 0,
+
+	// Sample the nearest mip level
+	MIPFILTER_NEAREST,
+
+	// Blend the two nearest mip levels
+	MIPFILTER_LINEAR,
+
+	MIPFILTER_MAX
+};
+
+enum TextureWrap
+{
+	// Repeat the texture
+	TEXTUREWRAP_REPEAT = 0,
+
+	// Repeat the texture, mirroring every other repetition
+	TEXTUREWRAP_MIRRORED_REPEAT,
+
+	// Stretch the edge texels
+	TEXTUREWRAP_CLAMP_TO_EDGE,
+
+	TEXTUREWRAP_MAX
+};
+
+// Encapsulates a uniform buffer, which holds the values of a shader uniform block
+class UniformBuffer
+{
+public:
+
+	// virtual destructor to ensure subclasses have a virtual destructor
+	virtual ~UniformBuffer() {}
+
+protected:
+
+	// protected default constructor to ensure these are never created directly
+	UniformBuffer() {}
+};
+
+// Bytes of per-draw constants that RenderDevice::WriteUniformData is guaranteed to
+// accept in one frame
+const long long UNIFORM_DATA_FRAME_SIZE = 4 * 1024 * 1024;
+
+// Bytes of vertices and of indices that RenderDevice::WriteTransientVertices and
+// WriteTransientIndices are guaranteed to accept in one frame
+const long long TRANSIENT_VERTEX_FRAME_SIZE = 8 * 1024 * 1024;
+const long long TRANSIENT_INDEX_FRAME_SIZE = 2 * 1024 * 1024;
+
+// Where RenderDevice::WriteTransientVertices put vertices
+struct TransientVertices
+{
+	// owned by the device and the same every frame, so vertex arrays made with it can be
+	// kept; nullptr if the vertices did not fit
+	VertexBuffer *vertexBuffer;
+	long long offset; // in bytes, a multiple of the stride
+	int firstVertex; // offset / stride, for DrawTriangles and as the base of transient indices
+};
+
+// Where RenderDevice::WriteTransientIndices put 32-bit indices
+struct TransientIndices
+{
+	// owned by the device and the same every frame; nullptr if the indices did not fit
+	IndexBuffer *indexBuffer;
+	long long offset; // in bytes, for DrawTrianglesIndexed32
+};
+
 // Describes a vertex element's type
 enum VertexElementType
 {
@@ -175,6 +480,7 @@ struct VertexElement
 	int size; // number of components
 	int stride; // number of bytes between each successive element (leave zero for this to be assumed to be size times size of type)
 	long long offset; // offset where first occurrence of this vertex element resides in the buffer
+	unsigned int divisor; // zero for an element read once per vertex; otherwise it advances once every divisor instances of an instanced draw
 };
 
 // Encapsulates the rasterizer state
@@ -288,6 +594,20 @@ enum StencilAction
 	STENCIL_MAX
 };
 
+// GPU time spent in a named scope, gathered over the frames it was timed in; see
+// RenderDevice::BeginGpuScope. Times are in milliseconds; a scope entered several
+// times in a frame counts the sum for that frame.
+struct GpuScopeStats
+{
+	const char *name; // name passed to BeginGpuScope; valid until ResetGpuScopeStats or the device is destroyed
+	unsigned int depth; // nesting depth the scope was first timed at; 0 for outermost scopes
+	unsigned int frames; // number of frames the scope has been timed in
+	double lastMs; // time in the most recently resolved frame
+	double minMs;
+	double avgMs;
+	double maxMs;
+};
+
 // Encapsulates the render device API.
 class RenderDevice
 {
@@ -318,7 +638,23 @@ public:
 	virtual void SetPipeline(Pipeline *pipeline) = 0;
 
 	// Create a vertex buffer
-	virtual VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr) = 0;
+	virtual VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) = 0;
+
+	// Replace size bytes of a vertex buffer at offset with data. Replacing all of a dynamic
+	// or streamed buffer gives it new storage, so it never waits for draws reading the old.
+	virtual void UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data) = 0;
+
+	// Map size bytes of a vertex buffer at offset for writing, as mapFlags says; returns
+	// nullptr on failure. The buffer must be unmapped before it is next drawn from.
+	virtual void *MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags = 0) = 0;
+
+	// Unmap a vertex buffer mapped with MapVertexBuffer
+	virtual void UnmapVertexBuffer(VertexBuffer *vertexBuffer) = 0;
+
+	// Copy size bytes at sourceOffset of one vertex buffer to destinationOffset of another,
+	// or of the same one if the ranges do not overlap. The copy is made on the GPU, in order
+	// with draws, so draws made before it read the old contents and draws after it the new.
+	virtual void CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) = 0;
 
 	// Destroy a vertex buffer
 	virtual void DestroyVertexBuffer(VertexBuffer *vertexBuffer) = 0;
@@ -338,8 +674,21 @@ public:
 	// Set a vertex array as active for subsequent draw commands
 	virtual void SetVertexArray(VertexArray *vertexArray) = 0;
 
-    // Create an index buffer
-    virtual IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr) = 0;
+    // Create an index buffer of size bytes of indices of the given format; indexed draws of
+    // the other format are rejected while it is set
+    virtual IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC, IndexFormat format = INDEXFORMAT_32) = 0;
+
+	// Replace size bytes of an index buffer at offset with data, as UpdateVertexBuffer does
+	virtual void UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data) = 0;
+
+	// Map size bytes of an index buffer at offset for writing, as MapVertexBuffer does
+	virtual void *MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags = 0) = 0;
+
+	// Unmap an index buffer mapped with MapIndexBuffer
+	virtual void UnmapIndexBuffer(IndexBuffer *indexBuffer) = 0;
+
+	// Copy size bytes between index buffers, as CopyVertexBuffer does
+	virtual void CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size) = 0;
 
     // Destroy an index buffer
     virtual void DestroyIndexBuffer(IndexBuffer *indexBuffer) = 0;
@@ -347,13 +696,49 @@ public:
     // Set an index buffer as active for subsequent draw commands
     virtual void SetIndexBuffer(IndexBuffer *indexBuffer) = 0;
 
+	// Set how the vertices of subsequent draw commands form primitives; triangle lists until
+	// set. Every draw call draws primitives of this topology despite its name, and indexed
+	// draws of strips restart at PRIMITIVE_RESTART_INDEX16 or PRIMITIVE_RESTART_INDEX32.
+	virtual void SetPrimitiveTopology(PrimitiveTopology topology) = 0;
+
+	// Create an indirect buffer of size bytes of DrawIndexedIndirectCommand arguments
+	virtual IndirectBuffer *CreateIndirectBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) = 0;
+
+	// Replace size bytes of an indirect buffer at offset with data, as UpdateVertexBuffer does
+	virtual void UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data) = 0;
+
+	// Copy size bytes of a vertex buffer into an indirect buffer, as CopyVertexBuffer does, so
+	// that arguments computed into vertex buffers on the GPU are drawn without reading them back
+	virtual void CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) = 0;
+
+	// Destroy an indirect buffer
+	virtual void DestroyIndirectBuffer(IndirectBuffer *indirectBuffer) = 0;
+
 	// Create a 2D texture.
 	//
-	// data is assumed to consist of 32-bit pixel values where
-	// 8 bits are used for each of the red, green, and blue
-	// components, from lowest to highest byte order. The
-	// most significant byte is ignored.
-    virtual Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr) = 0;
+	// data holds mipLevels levels of texels of the given format, largest first and
+	// tightly packed, as sized by GetTextureSize. By default data is assumed to consist
+	// of 32-bit pixel values where 8 bits are used for each of the red, green, and blue
+	// components, from lowest to highest byte order. The most significant byte is ignored.
+	//
+	// A mipLevels of 0 means data holds the top level only, and the rest of the chain is
+	// filled as mipPolicy says for uncompressed formats; compressed textures get a single
+	// level. Returns nullptr if the format is not supported by the device.
+    virtual Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) = 0;
+
+	// Returns whether textures of format can be created on this device
+	virtual bool IsTextureFormatSupported(TextureFormat format) = 0;
+
+	// Replace the width by height region of mip level mipLevel of a texture whose top-left
+	// texel is at x, y with data in the texture's format, tightly packed. Regions of
+	// compressed textures must be aligned to 4x4 blocks, except where they reach the edge
+	// of the level.
+	//
+	// A synchronous update may wait until the GPU is done with the texture. An asynchronous
+	// one copies data to staging memory the GPU uploads from later, so that textures can
+	// be updated every frame without stalling; draws made after either see the new texels.
+	virtual void UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async = false) = 0;
 
     // Destroy a 2D texture
     virtual void DestroyTexture2D(Texture2D *texture2D) = 0;
@@ -361,6 +746,82 @@ public:
     // Set a 2D texture as active on a slot for subsequent draw commands
     virtual void SetTexture2D(unsigned int slot, Texture2D *texture2D) = 0;
 
+	// Create an array of layers 2D textures, whose layers are filled afterwards with
+	// UploadTexture2DArrayLayer. Each layer is laid out as the data of CreateTexture2D:
+	// mipLevels levels, or its top level only when mipLevels is 0, in which case the rest
+	// of its chain is filled as mipPolicy says. Returns nullptr if the format is not
+	// supported or there are more layers than the device allows.
+	virtual Texture2DArray *CreateTexture2DArray(int width, int height, int layers, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) = 0;
+
+	// Replace every level of one layer of a texture array with data, laid out as given to
+	// CreateTexture2DArray. Updates are synchronous or asynchronous as for UpdateTexture2D.
+	virtual void UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async = false) = 0;
+
+	// Replace a region of mip level mipLevel of one layer of a texture array, as
+	// UpdateTexture2D does for a 2D texture
+	virtual void UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+		bool async = false) = 0;
+
+	// Destroy a 2D texture array
+	virtual void DestroyTexture2DArray(Texture2DArray *texture2DArray) = 0;
+
+	// Set a 2D texture array as active on a slot for subsequent draw commands. A slot holds
+	// a 2D texture and a texture array independently; the type of the sampler bound to it
+	// in the pipeline decides which one is sampled.
+	virtual void SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray) = 0;
+
+	// Create a sampler state. Identical sampler states may be shared, so each must be
+	// destroyed once for every time it was created.
+	virtual SamplerState *CreateSamplerState(TextureFilter minFilter = TEXTUREFILTER_LINEAR, TextureFilter magFilter = TEXTUREFILTER_LINEAR,
+		MipFilter mipFilter = MIPFILTER_LINEAR, TextureWrap wrapS = TEXTUREWRAP_CLAMP_TO_EDGE, TextureWrap wrapT = TEXTUREWRAP_CLAMP_TO_EDGE) = 0;
+
+	// Destroy a sampler state
+	virtual void DestroySamplerState(SamplerState *samplerState) = 0;
+
+	// Set how the texture on a slot is sampled by subsequent draw commands, independently of
+	// the texture bound there; nullptr restores the default of CreateSamplerState()
+	virtual void SetSamplerState(unsigned int slot, SamplerState *samplerState) = 0;
+
+	// Create a uniform buffer, for uniform values shared by many draws
+	virtual UniformBuffer *CreateUniformBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) = 0;
+
+	// Replace size bytes of a uniform buffer at offset with data, as UpdateVertexBuffer does
+	virtual void UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data) = 0;
+
+	// Map size bytes of a uniform buffer at offset for writing, as MapVertexBuffer does
+	virtual void *MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags = 0) = 0;
+
+	// Unmap a uniform buffer mapped with MapUniformBuffer
+	virtual void UnmapUniformBuffer(UniformBuffer *uniformBuffer) = 0;
+
+	// Destroy a uniform buffer
+	virtual void DestroyUniformBuffer(UniformBuffer *uniformBuffer) = 0;
+
+	// Set a uniform buffer as active on a slot for subsequent draw commands
+	virtual void SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer) = 0;
+
+	// Copy per-draw constants into the device's streaming uniform storage, returning
+	// where they were put for SetUniformData, or -1 if they do not fit. The data stays
+	// valid until EndFrame; writing all of a frame's constants before its draws lets
+	// the device upload them at once.
+	virtual long long WriteUniformData(const void *data, long long size) = 0;
+
+	// Set size bytes of streaming uniform storage at offset, as returned by WriteUniformData
+	// this frame, as active on a slot for subsequent draw commands
+	virtual void SetUniformData(unsigned int slot, long long offset, long long size) = 0;
+
+	// Copy count vertices of stride bytes into the device's transient geometry storage, for
+	// geometry such as particles and debug lines that is made afresh every frame. The
+	// vertices stay valid until EndFrame, and are never copied again: the storage is
+	// written directly, and only once the GPU has finished drawing from it.
+	virtual TransientVertices WriteTransientVertices(const void *data, int count, int stride) = 0;
+
+	// Copy count 32-bit indices into transient geometry storage as WriteTransientVertices
+	// does, adding baseVertex to each, so that indices relative to the first of some
+	// transient vertices can be passed with their firstVertex
+	virtual TransientIndices WriteTransientIndices(const unsigned int *indices, int count, int baseVertex = 0) = 0;
+
 	// Create a raster state.
 	virtual RasterState *CreateRasterState(bool cullEnabled = true, Winding frontFace = WINDING_CCW, Face cullFace = FACE_BACK, RasterMode rasterMode = RASTERMODE_FILL) = 0;
 
@@ -401,14 +862,103 @@ public:
 	virtual void DrawTriangles(int offset, int count) = 0;
 
     // Draw a collection of triangles using the currently active shader pipeline, vertex array data,
-    // and index buffer
-    virtual void DrawTrianglesIndexed32(long long offset, int count) = 0;
+    // and index buffer; baseVertex is added to each index, so that meshes sharing one vertex
+    // array can keep indices relative to their own first vertex
+    virtual void DrawTrianglesIndexed32(long long offset, int count, int baseVertex = 0) = 0;
+
+	// Draw triangles as DrawTrianglesIndexed32 does, from an index buffer of 16-bit indices;
+	// offset is in bytes
+	virtual void DrawTrianglesIndexed16(long long offset, int count, int baseVertex = 0) = 0;
+
+	// Draw instanceCount instances of the triangles DrawTriangles would draw. Vertex elements
+	// with a divisor are read per instance rather than per vertex, so a vertex buffer of
+	// per-instance data, such as transforms, places each instance.
+	virtual void DrawTrianglesInstanced(int offset, int count, int instanceCount) = 0;
+
+	// Draw instanceCount instances of the triangles DrawTrianglesIndexed32 would draw; the base
+	// vertex applies to per-vertex elements only
+	virtual void DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) = 0;
+
+	// Draw instanceCount instances of the triangles DrawTrianglesIndexed16 would draw
+	virtual void DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) = 0;
+
+	// Make drawCount draws of the triangles DrawTriangles would draw, the ith from offsets[i]
+	// and counts[i] vertices, with the state of a single draw; one driver call on OpenGL
+	virtual void DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts) = 0;
+
+	// Make drawCount indexed draws with the state of a single draw, the ith of counts[i]
+	// indices at offsets[i] bytes into the bound index buffer of indices of format, each
+	// offset by baseVertices[i], or by nothing if baseVertices is nullptr. Runs of draws that
+	// share all of their state, such as meshes of a GeometryHeap page, collapse into one call.
+	virtual void DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices = nullptr,
+		IndexFormat format = INDEXFORMAT_32) = 0;
+
+	// Make drawCount indexed draws of indices of format from the bound index buffer, with the
+	// arguments of each read from consecutive DrawIndexedIndirectCommands at offset bytes, a
+	// multiple of 4, into an indirect buffer when the draw executes. Counts written on the GPU
+	// decide what is drawn without a round trip to the CPU.
+	virtual void DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount = 1, IndexFormat format = INDEXFORMAT_32) = 0;
+
+	// Execute the commands recorded into each command list, in order, as if they had been
+	// called directly on this device; must be called on the thread that owns the device
+	virtual void SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists) = 0;
+
+	// Mark the end of a frame; call once per frame, before presenting. Devices use frame
+	// boundaries to recycle per-frame resources and to collect GPU timings.
+	virtual void EndFrame() = 0;
+
+	// Begin timing the GPU work of subsequent commands as the scope called name; scopes nest
+	virtual void BeginGpuScope(const char *name) = 0;
+
+	// End the scope begun by the matching BeginGpuScope
+	virtual void EndGpuScope() = 0;
+
+	// Copy the statistics of up to maxScopes scopes into stats, in the order the scopes were
+	// first seen, and return the total number of scopes. Timings are read back a few frames
+	// after they are recorded so that the CPU never waits on the GPU for them.
+	virtual unsigned int GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats) = 0;
+
+	// Discard the statistics gathered so far
+	virtual void ResetGpuScopeStats() = 0;
+};
+
+// Identifies a RenderDevice implementation
+enum RenderDeviceType
+{
+	// OpenGL 4.1 device; requires a current context created by the platform
+	RENDERDEVICETYPE_OPENGL = 0,
+
+	// Device that tracks resources and state, but issues no graphics API calls
+	RENDERDEVICETYPE_NULL,
+
+	// Multithreaded SIMD rasterizer running on the CPU; see software_shader.h
+	RENDERDEVICETYPE_SOFTWARE,
+
+	RENDERDEVICETYPE_MAX
 };
 
-// Creates a RenderDevice
-RenderDevice *CreateRenderDevice();
+// Returns the RenderDevice type named by config ("opengl", "null", or "software"). If config
+// is null, the RENDER_DEVICE environment variable is used instead. Defaults to
+// OpenGL when neither names a known type.
+RenderDeviceType GetRenderDeviceType(const char *config = nullptr);
+
+// Creates a RenderDevice of the type selected by the RENDER_DEVICE environment variable,
+// rendering to a window of width by height pixels; devices that own their framebuffer,
+// such as the software device, create it at that size. If RENDER_DEVICE_CAPTURE names a
+// file, the device's calls are recorded to it; see trace.h.
+RenderDevice *CreateRenderDevice(int width, int height);
+
+// Creates a RenderDevice of the specified type, rendering to a window of width by height pixels
+RenderDevice *CreateRenderDevice(RenderDeviceType type, int width, int height);
 
 // Destroys a RenderDevice
 void DestroyRenderDevice(RenderDevice *renderDevice);
 
+// Creates an index buffer from count 32-bit indices, narrowed to 16-bit indices when every one
+// fits, as GetNarrowestIndexFormat decides. format receives the format of the buffer, which
+// selects DrawTrianglesIndexed16 or DrawTrianglesIndexed32 and, through GetIndexSize, the
+// byte offsets of its draws.
+IndexBuffer *CreateNarrowedIndexBuffer(RenderDevice *renderDevice, long long count, const unsigned int *indices, IndexFormat &format,
+	BufferUsage usage = BUFFERUSAGE_STATIC);
+
 } // end namespace render
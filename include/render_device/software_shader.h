@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+
+namespace render
+{
+
+// The software RenderDevice cannot compile GLSL, so shaders are C++ functions registered
+// against the same code string that is later passed to CreateVertexShader or
+// CreatePixelShader. The same application code can then run on either device.
+
+// Maximum number of vertex attribute locations available to a software vertex shader
+const unsigned int SOFTWARE_MAX_ATTRIBUTES = 16;
+
+// Maximum number of floats a software vertex shader can pass to a pixel shader
+const unsigned int SOFTWARE_MAX_VARYINGS = 32;
+
+// Describes the type of a software shader uniform
+enum SoftwareUniformType
+{
+	SOFTWAREUNIFORMTYPE_INT = 0,
+	SOFTWAREUNIFORMTYPE_FLOAT,
+	SOFTWAREUNIFORMTYPE_MAT4
+};
+
+// Describes a uniform within a software shader's uniform block. PipelineParam values
+// set on the named uniform are written to the block at the given byte offset, and
+// the block is passed to the shader function. A GLSL uniform block is described as
+// one uniform named after the block, with room for all of its bytes; the uniform
+// buffer bound to the block's slot is copied there before each draw.
+struct SoftwareUniform
+{
+	const char *name; // uniform name, as passed to Pipeline::GetParam
+	SoftwareUniformType type; // type of each element
+	int count; // number of array elements
+	size_t offset; // byte offset of the first element in the uniform block
+};
+
+// Samples the 2D textures bound to the device for use in software pixel shaders
+class SoftwareSampler
+{
+public:
+
+	// Bilinearly sample the texture bound to slot at normalized coordinates (u, v),
+	// clamping to the edge; writes red, green, blue, and alpha to rgba
+	virtual void Sample(unsigned int slot, float u, float v, float *rgba) const = 0;
+
+	// Sample a layer of the texture array bound to slot as Sample does; layer is rounded
+	// to the nearest layer and clamped to the array, as GLSL does for sampler2DArray
+	virtual void SampleArray(unsigned int slot, float u, float v, float layer, float *rgba) const = 0;
+
+protected:
+
+	// protected destructor; samplers are owned by the device
+	~SoftwareSampler() {}
+};
+
+// Transforms one vertex. attributes holds four floats for each attribute location,
+// defaulting to (0, 0, 0, 1) for locations the vertex arrays do not supply. Writes the
+// clip-space position (x, y, z, w) and the vertex shader's declared number of varyings.
+typedef void (*SoftwareVertexShaderFunc)(const void *uniforms, const float (*attributes)[4], float *position, float *varyings);
+
+// Shades one pixel given the perspective-correct interpolated varyings; writes red,
+// green, blue, and alpha in [0, 1] to color
+typedef void (*SoftwarePixelShaderFunc)(const void *uniforms, const SoftwareSampler &sampler, const float *varyings, float *color);
+
+// Describes a software vertex shader
+struct SoftwareVertexShaderDesc
+{
+	SoftwareVertexShaderFunc main;
+	unsigned int numVaryings;
+	size_t uniformBlockSize;
+	unsigned int numUniforms;
+	const SoftwareUniform *uniforms;
+};
+
+// Describes a software pixel shader
+struct SoftwarePixelShaderDesc
+{
+	SoftwarePixelShaderFunc main;
+	size_t uniformBlockSize;
+	unsigned int numUniforms;
+	const SoftwareUniform *uniforms;
+};
+
+// Register a C++ vertex shader to be used by the software RenderDevice in place of code.
+// The descriptor and its uniform array must outlive any shader created from it.
+void RegisterSoftwareVertexShader(const char *code, const SoftwareVertexShaderDesc *desc);
+
+// Register a C++ pixel shader to be used by the software RenderDevice in place of code.
+// The descriptor and its uniform array must outlive any shader created from it.
+void RegisterSoftwarePixelShader(const char *code, const SoftwarePixelShaderDesc *desc);
+
+} // end namespace render
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace render
+{
+
+class ThreadPool;
+
+// Identifies an image placed in a TextureAtlas; 0 is never a valid handle
+typedef uint32_t AtlasHandle;
+
+// Where an image was placed in a TextureAtlas
+struct AtlasEntry
+{
+	unsigned int page; // index of the page texture, as passed to TextureAtlas::GetPage
+	int x, y; // top-left texel of the image in its page, excluding padding
+	int width, height;
+	float u0, v0, u1, v1; // texture coordinates of the image's top-left and bottom-right corners
+};
+
+// Occupancy of a TextureAtlas, for tuning its page size
+struct TextureAtlasStats
+{
+	unsigned int pages = 0;
+	unsigned int entries = 0;
+	long long imageTexels = 0; // texels of the images themselves
+	long long usedTexels = 0; // texels taken by images with their padding and alignment
+	long long pageTexels = 0; // texels of every page
+	float occupancy = 0.0f; // usedTexels / pageTexels
+};
+
+// Packs many small RGBA8 images, such as icons and decals, into a few large page
+// textures so that they can be drawn without changing textures between them.
+//
+// Images are placed with a guillotine packer, which splits the free rectangle an image
+// is placed in into two and merges rectangles back together as images are removed, so
+// a page keeps taking new images as old ones are evicted. Images are copied into their
+// page with RenderDevice::UpdateTexture2D, asynchronously, with every mip level of the
+// page filtered on the CPU.
+//
+// Each image is surrounded by padding texels copied from its edges, so that filtering
+// and the lower mip levels do not bleed neighbouring images into it. Cells are aligned
+// to the size of a texel of the smallest level, so that every level of an image lies
+// within its own cell.
+class TextureAtlas
+{
+public:
+
+	// Pages are pageSize by pageSize textures of mipLevels levels. padding texels are kept
+	// around every image; at least 1 << (mipLevels - 1) keeps the smallest level free of
+	// bleeding as well.
+	TextureAtlas(RenderDevice *renderDevice, int pageSize = 2048, int mipLevels = 1, int padding = 1);
+
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas &) = delete;
+	TextureAtlas &operator=(const TextureAtlas &) = delete;
+
+	// Place a width by height image of 32-bit RGBA texels, adding a page if none has room.
+	// Returns 0 if the image, with its padding, does not fit in a page.
+	AtlasHandle Insert(int width, int height, const void *data);
+
+	// Remove an image, so that its space can be taken by later insertions. A page whose
+	// images are all removed is kept, empty, for reuse.
+	void Remove(AtlasHandle handle);
+
+	// Returns where an image was placed, or nullptr if handle is not in the atlas
+	const AtlasEntry *GetEntry(AtlasHandle handle) const;
+
+	unsigned int GetNumPages() const { return static_cast<unsigned int>(m_Pages.size()); }
+
+	// Returns a page texture to bind when drawing the images placed in it
+	Texture2D *GetPage(unsigned int page) const { return page < m_Pages.size() ? m_Pages[page].texture : nullptr; }
+
+	// Returns the fraction of a page taken by images with their padding
+	float GetPageOccupancy(unsigned int page) const;
+
+	TextureAtlasStats GetStats() const;
+
+private:
+
+	struct Rect
+	{
+		int x, y;
+		int width, height;
+	};
+
+	struct Page
+	{
+		Texture2D *texture;
+		std::vector<Rect> freeRects;
+		unsigned int entries;
+		long long usedTexels;
+	};
+
+	struct Slot
+	{
+		AtlasEntry entry;
+		Rect cell; // the image with its padding, as taken from the page
+		bool used;
+	};
+
+	// Split a free rectangle of a page around a cell placed at its top-left corner
+	void SplitFreeRect(Page &page, size_t index, int width, int height);
+
+	// Return a cell to the free rectangles of a page, merging it with its neighbours
+	void FreeRect(Page &page, const Rect &cell);
+
+	// Copy an image and its padding into a cell, filling every level
+	void Upload(const Page &page, const Rect &cell, int width, int height, const uint32_t *data);
+
+	RenderDevice *m_RenderDevice;
+	int m_PageSize;
+	int m_MipLevels;
+	int m_Padding;
+	int m_Alignment; // cells start and end on multiples of this
+
+	std::vector<Page> m_Pages;
+	std::vector<Slot> m_Slots; // indexed by handle - 1
+	std::vector<AtlasHandle> m_FreeHandles;
+	std::vector<uint32_t> m_Cell; // mip chain of the cell being uploaded
+
+	// filters the levels of cells; cells are small, so it has no workers of its own
+	std::unique_ptr<ThreadPool> m_ThreadPool;
+};
+
+} // end namespace render
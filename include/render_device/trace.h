@@ -0,0 +1,117 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace render
+{
+
+// Creates a RenderDevice that forwards every call to renderDevice and records the
+// calls, with all of their data (shader code, buffer and texture contents, parameter
+// values), to a binary trace file at path. The returned device owns renderDevice and
+// destroys it along with itself. If the file cannot be created, nullptr is returned
+// and renderDevice stays with the caller.
+//
+// CreateRenderDevice does this automatically when the RENDER_DEVICE_CAPTURE
+// environment variable names a file.
+RenderDevice *CreateCaptureRenderDevice(RenderDevice *renderDevice, const char *path);
+
+// Replays a trace written by a capture device against any RenderDevice, frame by
+// frame. The trace is memory-mapped and calls are decoded straight from the mapping,
+// so replay costs little more than the calls themselves.
+//
+// A frame ends with each recorded EndFrame call or, for traces of applications that
+// never call EndFrame, just before the first Clear that follows a draw, in which
+// case the replay calls EndFrame itself.
+class TraceReplay
+{
+public:
+
+	explicit TraceReplay(RenderDevice *renderDevice);
+
+	~TraceReplay();
+
+	TraceReplay(const TraceReplay &) = delete;
+	TraceReplay &operator=(const TraceReplay &) = delete;
+
+	// Map the trace at path; returns false if it cannot be read or is not a trace
+	bool Open(const char *path);
+
+	// Destroy any resources the trace created and unmap it
+	void Close();
+
+	// Replay the calls of the next frame; returns false once the end of the trace has been reached
+	bool ReplayFrame();
+
+	// Destroy any resources the trace created and start again from the first call
+	void Rewind();
+
+	// Number of calls replayed since the trace was opened
+	unsigned long long GetNumCalls() const { return m_NumCalls; }
+
+private:
+
+	// An object created by the trace, indexed by its id
+	struct Object
+	{
+		unsigned int type; // TraceCallType of the call that created the object
+		void *object;
+		bool transient; // a transient vertex or index buffer, or a vertex array reading a transient vertex buffer
+	};
+
+	// Issue one recorded call given its type and arguments
+	void ReplayCall(unsigned int type, const char *args);
+
+	// Move m_Cursor past the next chunk header; returns false at the end of the trace
+	bool NextChunk();
+
+	// Destroy the objects the trace created that it has not destroyed itself
+	void DestroyObjects();
+
+	template<class T> T *GetObject(unsigned int id) const;
+
+	void SetObject(unsigned int id, unsigned int type, void *object);
+
+	// Returns the first vertex, or the offset into the bound index buffer, that a recorded draw reads
+	// in this replay; those of transient buffers are remapped to where this frame's writes went
+	long long RemapFirstVertex(long long firstVertex) const;
+	long long RemapIndexOffset(long long offset) const;
+
+	RenderDevice *m_RenderDevice;
+
+	const char *m_Data = nullptr; // mapped trace
+	size_t m_Size = 0;
+	void *m_Mapping = nullptr; // platform handle for the mapping
+
+	const char *m_Cursor = nullptr; // next call header
+	const char *m_ChunkEnd = nullptr; // end of the current chunk's calls
+	bool m_FrameHasDraws = false;
+	bool m_HasEndFrames = false; // whether the trace delimits its frames with EndFrame
+
+	std::vector<Object> m_Objects;
+
+	// offsets WriteUniformData returned this frame, by the offset it returned when recorded
+	std::unordered_map<long long, long long> m_UniformDataOffsets;
+
+	// first vertices WriteTransientVertices and offsets WriteTransientIndices returned this frame, by those
+	// returned when recorded; draws from the transient buffers are remapped through them
+	std::unordered_map<long long, long long> m_TransientVertexOffsets;
+	std::unordered_map<long long, long long> m_TransientIndexOffsets;
+	bool m_TransientVerticesBound = false; // whether the bound vertex array reads transient vertices
+	bool m_TransientIndicesBound = false;
+
+	// scratch arrays for decoding calls, kept to avoid reallocating
+	std::vector<VertexElement> m_VertexElements;
+	std::vector<VertexBuffer *> m_VertexBuffers;
+	std::vector<VertexDescription *> m_VertexDescriptions;
+	std::vector<int> m_MultiDrawFirsts; // first vertices, or base vertices of indexed draws
+	std::vector<long long> m_MultiDrawOffsets;
+	std::vector<int> m_MultiDrawCounts;
+
+	unsigned long long m_NumCalls = 0;
+};
+
+} // end namespace render
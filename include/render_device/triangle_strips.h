@@ -0,0 +1,40 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <vector>
+
+namespace render
+{
+
+// How ConvertToTriangleStrips changed the size of a mesh's indices
+struct TriangleStripStats
+{
+	long long listIndices = 0; // of the whole triangles of the list
+	long long stripIndices = 0; // of the strips, restarts included
+	unsigned int strips = 0;
+	unsigned int droppedTriangles = 0; // degenerate triangles, which draw nothing
+
+	// fraction of the list's indices saved; negative when the mesh is so disconnected that
+	// restarts cost more than the strips save
+	float savings = 0.0f;
+};
+
+// Convert count indices of a triangle list into triangle strips separated by
+// PRIMITIVE_RESTART_INDEX32, to be drawn with PRIMITIVETOPOLOGY_TRIANGLE_STRIP:
+//
+//     TriangleStripStats stats = ConvertToTriangleStrips(count, indices, strips);
+//     IndexBuffer *indexBuffer = CreateNarrowedIndexBuffer(renderDevice, stats.stripIndices, strips.data(), format);
+//     ...
+//     renderDevice->SetPrimitiveTopology(PRIMITIVETOPOLOGY_TRIANGLE_STRIP);
+//
+// Strips are grown greedily across shared edges, starting from triangles with the fewest
+// neighbours, so that the edges of the mesh are used up first. Every triangle keeps its
+// winding, so culling is unchanged. A connected mesh takes a little over one index per
+// triangle rather than three, cutting its index memory and index fetch bandwidth.
+//
+// Degenerate triangles and those using PRIMITIVE_RESTART_INDEX32 as a vertex are dropped.
+// strips receives the converted indices, replacing its contents.
+TriangleStripStats ConvertToTriangleStrips(long long count, const unsigned int *indices, std::vector<unsigned int> &strips);
+
+} // end namespace render
@@ -0,0 +1,348 @@
+#include "render_device/command_list.h"
+
+#include "command_list_commands.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace render
+{
+
+CommandList::CommandList(size_t blockSize) : m_BlockSize(AlignCommandSize(blockSize))
+{
+}
+
+CommandList::~CommandList()
+{
+	for(Block &block : m_Blocks)
+		free(block.data);
+}
+
+void CommandList::Reset()
+{
+	for(Block &block : m_Blocks)
+		block.used = 0;
+	m_CurrentBlock = 0;
+	m_NumCommands = 0;
+}
+
+void *CommandList::Allocate(size_t size)
+{
+	m_NumCommands++;
+
+	if(!m_Blocks.empty())
+	{
+		Block *block = &m_Blocks[m_CurrentBlock];
+		if(block->used + size <= block->capacity)
+		{
+			void *packet = block->data + block->used;
+			block->used += size;
+			return packet;
+		}
+
+		// move on to the next retained block that is large enough, if any
+		while(m_CurrentBlock + 1 < m_Blocks.size())
+		{
+			block = &m_Blocks[++m_CurrentBlock];
+			if(size <= block->capacity)
+			{
+				block->used = size;
+				return block->data;
+			}
+		}
+
+		m_CurrentBlock++;
+	}
+
+	// malloc alignment is sufficient for every packet
+	Block block;
+	block.capacity = size > m_BlockSize ? size : m_BlockSize;
+	block.data = static_cast<char *>(malloc(block.capacity));
+	block.used = size;
+	m_Blocks.push_back(block);
+	return block.data;
+}
+
+void CommandList::SetPipeline(Pipeline *pipeline)
+{
+	CommandSetObject *command = static_cast<CommandSetObject *>(Allocate(sizeof(CommandSetObject)));
+	command->header.type = COMMANDTYPE_SET_PIPELINE;
+	command->header.size = sizeof(CommandSetObject);
+	command->object = pipeline;
+}
+
+void CommandList::SetVertexArray(VertexArray *vertexArray)
+{
+	CommandSetObject *command = static_cast<CommandSetObject *>(Allocate(sizeof(CommandSetObject)));
+	command->header.type = COMMANDTYPE_SET_VERTEX_ARRAY;
+	command->header.size = sizeof(CommandSetObject);
+	command->object = vertexArray;
+}
+
+void CommandList::SetIndexBuffer(IndexBuffer *indexBuffer)
+{
+	CommandSetObject *command = static_cast<CommandSetObject *>(Allocate(sizeof(CommandSetObject)));
+	command->header.type = COMMANDTYPE_SET_INDEX_BUFFER;
+	command->header.size = sizeof(CommandSetObject);
+	command->object = indexBuffer;
+}
+
+void CommandList::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	CommandSetPrimitiveTopology *command = static_cast<CommandSetPrimitiveTopology *>(Allocate(sizeof(CommandSetPrimitiveTopology)));
+	command->header.type = COMMANDTYPE_SET_PRIMITIVE_TOPOLOGY;
+	command->header.size = sizeof(CommandSetPrimitiveTopology);
+	command->topology = topology;
+	command->padding = 0;
+}
+
+void CommandList::SetTexture2D(unsigned int slot, Texture2D *texture2D)
+{
+	CommandSetTexture2D *command = static_cast<CommandSetTexture2D *>(Allocate(sizeof(CommandSetTexture2D)));
+	command->header.type = COMMANDTYPE_SET_TEXTURE2D;
+	command->header.size = sizeof(CommandSetTexture2D);
+	command->texture2D = texture2D;
+	command->slot = slot;
+}
+
+void CommandList::SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray)
+{
+	CommandSetTexture2DArray *command = static_cast<CommandSetTexture2DArray *>(Allocate(sizeof(CommandSetTexture2DArray)));
+	command->header.type = COMMANDTYPE_SET_TEXTURE2D_ARRAY;
+	command->header.size = sizeof(CommandSetTexture2DArray);
+	command->texture2DArray = texture2DArray;
+	command->slot = slot;
+}
+
+void CommandList::SetSamplerState(unsigned int slot, SamplerState *samplerState)
+{
+	CommandSetSamplerState *command = static_cast<CommandSetSamplerState *>(Allocate(sizeof(CommandSetSamplerState)));
+	command->header.type = COMMANDTYPE_SET_SAMPLER_STATE;
+	command->header.size = sizeof(CommandSetSamplerState);
+	command->samplerState = samplerState;
+	command->slot = slot;
+}
+
+void CommandList::SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer)
+{
+	CommandSetUniformBuffer *command = static_cast<CommandSetUniformBuffer *>(Allocate(sizeof(CommandSetUniformBuffer)));
+	command->header.type = COMMANDTYPE_SET_UNIFORM_BUFFER;
+	command->header.size = sizeof(CommandSetUniformBuffer);
+	command->uniformBuffer = uniformBuffer;
+	command->slot = slot;
+}
+
+void CommandList::SetUniformData(unsigned int slot, const void *data, unsigned int size)
+{
+	size_t packetSize = AlignCommandSize(sizeof(CommandSetUniformData) + size);
+	CommandSetUniformData *command = static_cast<CommandSetUniformData *>(Allocate(packetSize));
+	command->header.type = COMMANDTYPE_SET_UNIFORM_DATA;
+	command->header.size = static_cast<uint32_t>(packetSize);
+	command->slot = slot;
+	command->size = size;
+	memcpy(command + 1, data, size);
+}
+
+void CommandList::SetRasterState(RasterState *rasterState)
+{
+	CommandSetObject *command = static_cast<CommandSetObject *>(Allocate(sizeof(CommandSetObject)));
+	command->header.type = COMMANDTYPE_SET_RASTER_STATE;
+	command->header.size = sizeof(CommandSetObject);
+	command->object = rasterState;
+}
+
+void CommandList::SetDepthStencilState(DepthStencilState *depthStencilState)
+{
+	CommandSetObject *command = static_cast<CommandSetObject *>(Allocate(sizeof(CommandSetObject)));
+	command->header.type = COMMANDTYPE_SET_DEPTH_STENCIL_STATE;
+	command->header.size = sizeof(CommandSetObject);
+	command->object = depthStencilState;
+}
+
+void CommandList::SetParam(unsigned int type, PipelineParam *param, int count, const void *values, size_t size)
+{
+	size_t packetSize = AlignCommandSize(sizeof(CommandSetParam) + size);
+	CommandSetParam *command = static_cast<CommandSetParam *>(Allocate(packetSize));
+	command->header.type = type;
+	command->header.size = static_cast<uint32_t>(packetSize);
+	command->param = param;
+	command->count = count;
+	if(size)
+		memcpy(command + 1, values, size);
+}
+
+void CommandList::SetParamAsInt(PipelineParam *param, int value)
+{
+	SetParam(COMMANDTYPE_SET_PARAM_INT, param, 1, &value, sizeof(int));
+}
+
+void CommandList::SetParamAsFloat(PipelineParam *param, float value)
+{
+	SetParam(COMMANDTYPE_SET_PARAM_FLOAT, param, 1, &value, sizeof(float));
+}
+
+void CommandList::SetParamAsMat4(PipelineParam *param, const float *value)
+{
+	SetParam(COMMANDTYPE_SET_PARAM_MAT4, param, 1, value, 16 * sizeof(float));
+}
+
+void CommandList::SetParamAsIntArray(PipelineParam *param, int count, const int *values)
+{
+	if(count < 0)
+		count = 0;
+	SetParam(COMMANDTYPE_SET_PARAM_INT_ARRAY, param, count, values, static_cast<size_t>(count) * sizeof(int));
+}
+
+void CommandList::SetParamAsFloatArray(PipelineParam *param, int count, const float *values)
+{
+	if(count < 0)
+		count = 0;
+	SetParam(COMMANDTYPE_SET_PARAM_FLOAT_ARRAY, param, count, values, static_cast<size_t>(count) * sizeof(float));
+}
+
+void CommandList::SetParamAsMat4Array(PipelineParam *param, int count, const float *values)
+{
+	if(count < 0)
+		count = 0;
+	SetParam(COMMANDTYPE_SET_PARAM_MAT4_ARRAY, param, count, values, static_cast<size_t>(count) * 16 * sizeof(float));
+}
+
+void CommandList::Clear(float red, float green, float blue, float alpha, float depth, int stencil)
+{
+	CommandClear *command = static_cast<CommandClear *>(Allocate(sizeof(CommandClear)));
+	command->header.type = COMMANDTYPE_CLEAR;
+	command->header.size = sizeof(CommandClear);
+	command->red = red;
+	command->green = green;
+	command->blue = blue;
+	command->alpha = alpha;
+	command->depth = depth;
+	command->stencil = stencil;
+}
+
+void CommandList::DrawTriangles(int offset, int count)
+{
+	CommandDrawTriangles *command = static_cast<CommandDrawTriangles *>(Allocate(sizeof(CommandDrawTriangles)));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES;
+	command->header.size = sizeof(CommandDrawTriangles);
+	command->offset = offset;
+	command->count = count;
+}
+
+void CommandList::DrawTrianglesIndexed32(long long offset, int count, int baseVertex)
+{
+	CommandDrawTrianglesIndexed *command = static_cast<CommandDrawTrianglesIndexed *>(Allocate(sizeof(CommandDrawTrianglesIndexed)));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INDEXED32;
+	command->header.size = sizeof(CommandDrawTrianglesIndexed);
+	command->offset = offset;
+	command->count = count;
+	command->baseVertex = baseVertex;
+}
+
+void CommandList::DrawTrianglesIndexed16(long long offset, int count, int baseVertex)
+{
+	CommandDrawTrianglesIndexed *command = static_cast<CommandDrawTrianglesIndexed *>(Allocate(sizeof(CommandDrawTrianglesIndexed)));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INDEXED16;
+	command->header.size = sizeof(CommandDrawTrianglesIndexed);
+	command->offset = offset;
+	command->count = count;
+	command->baseVertex = baseVertex;
+}
+
+void CommandList::DrawTrianglesInstanced(int offset, int count, int instanceCount)
+{
+	size_t packetSize = AlignCommandSize(sizeof(CommandDrawTrianglesInstanced));
+	CommandDrawTrianglesInstanced *command = static_cast<CommandDrawTrianglesInstanced *>(Allocate(packetSize));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INSTANCED;
+	command->header.size = static_cast<uint32_t>(packetSize);
+	command->offset = offset;
+	command->count = count;
+	command->instanceCount = instanceCount;
+}
+
+void CommandList::DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	CommandDrawTrianglesIndexedInstanced *command = static_cast<CommandDrawTrianglesIndexedInstanced *>(Allocate(sizeof(CommandDrawTrianglesIndexedInstanced)));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INDEXED32_INSTANCED;
+	command->header.size = sizeof(CommandDrawTrianglesIndexedInstanced);
+	command->offset = offset;
+	command->count = count;
+	command->instanceCount = instanceCount;
+	command->baseVertex = baseVertex;
+}
+
+void CommandList::DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	CommandDrawTrianglesIndexedInstanced *command = static_cast<CommandDrawTrianglesIndexedInstanced *>(Allocate(sizeof(CommandDrawTrianglesIndexedInstanced)));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INDEXED16_INSTANCED;
+	command->header.size = sizeof(CommandDrawTrianglesIndexedInstanced);
+	command->offset = offset;
+	command->count = count;
+	command->instanceCount = instanceCount;
+	command->baseVertex = baseVertex;
+}
+
+void CommandList::DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts)
+{
+	if(drawCount < 0)
+		drawCount = 0;
+	size_t arraySize = static_cast<size_t>(drawCount) * sizeof(int);
+	size_t packetSize = AlignCommandSize(sizeof(CommandDrawTrianglesMulti) + 2 * arraySize);
+	CommandDrawTrianglesMulti *command = static_cast<CommandDrawTrianglesMulti *>(Allocate(packetSize));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_MULTI;
+	command->header.size = static_cast<uint32_t>(packetSize);
+	command->drawCount = drawCount;
+	command->padding = 0;
+	char *arrays = reinterpret_cast<char *>(command + 1);
+	memcpy(arrays, offsets, arraySize);
+	memcpy(arrays + arraySize, counts, arraySize);
+}
+
+void CommandList::DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices, IndexFormat format)
+{
+	if(drawCount < 0)
+		drawCount = 0;
+	size_t offsetsSize = static_cast<size_t>(drawCount) * sizeof(long long);
+	size_t countsSize = static_cast<size_t>(drawCount) * sizeof(int);
+	size_t packetSize = AlignCommandSize(sizeof(CommandDrawTrianglesIndexedMulti) + offsetsSize + (baseVertices ? 2 : 1) * countsSize);
+	CommandDrawTrianglesIndexedMulti *command = static_cast<CommandDrawTrianglesIndexedMulti *>(Allocate(packetSize));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INDEXED_MULTI;
+	command->header.size = static_cast<uint32_t>(packetSize);
+	command->drawCount = drawCount;
+	command->format = format;
+	command->hasBaseVertices = baseVertices != nullptr;
+	command->padding = 0;
+	char *arrays = reinterpret_cast<char *>(command + 1);
+	memcpy(arrays, offsets, offsetsSize);
+	memcpy(arrays + offsetsSize, counts, countsSize);
+	if(baseVertices)
+		memcpy(arrays + offsetsSize + countsSize, baseVertices, countsSize);
+}
+
+void CommandList::DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount, IndexFormat format)
+{
+	CommandDrawTrianglesIndexedIndirect *command = static_cast<CommandDrawTrianglesIndexedIndirect *>(Allocate(sizeof(CommandDrawTrianglesIndexedIndirect)));
+	command->header.type = COMMANDTYPE_DRAW_TRIANGLES_INDEXED_INDIRECT;
+	command->header.size = sizeof(CommandDrawTrianglesIndexedIndirect);
+	command->indirectBuffer = indirectBuffer;
+	command->offset = offset;
+	command->drawCount = drawCount;
+	command->format = format;
+}
+
+void CommandList::BeginGpuScope(const char *name)
+{
+	CommandBeginGpuScope *command = static_cast<CommandBeginGpuScope *>(Allocate(sizeof(CommandBeginGpuScope)));
+	command->header.type = COMMANDTYPE_BEGIN_GPU_SCOPE;
+	command->header.size = sizeof(CommandBeginGpuScope);
+	command->name = name;
+}
+
+void CommandList::EndGpuScope()
+{
+	CommandHeader *command = static_cast<CommandHeader *>(Allocate(sizeof(CommandHeader)));
+	command->type = COMMANDTYPE_END_GPU_SCOPE;
+	command->size = sizeof(CommandHeader);
+}
+
+} // end namespace render
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "render_device/command_list.h"
+
+#include <cstdint>
+
+namespace render
+{
+
+// Packet types recorded into a CommandList
+enum CommandType
+{
+	COMMANDTYPE_SET_PIPELINE = 0,
+	COMMANDTYPE_SET_VERTEX_ARRAY,
+	COMMANDTYPE_SET_INDEX_BUFFER,
+	COMMANDTYPE_SET_PRIMITIVE_TOPOLOGY,
+	COMMANDTYPE_SET_TEXTURE2D,
+	COMMANDTYPE_SET_TEXTURE2D_ARRAY,
+	COMMANDTYPE_SET_SAMPLER_STATE,
+	COMMANDTYPE_SET_UNIFORM_BUFFER,
+	COMMANDTYPE_SET_RASTER_STATE,
+	COMMANDTYPE_SET_DEPTH_STENCIL_STATE,
+	COMMANDTYPE_SET_PARAM_INT,
+	COMMANDTYPE_SET_PARAM_FLOAT,
+	COMMANDTYPE_SET_PARAM_MAT4,
+	COMMANDTYPE_SET_PARAM_INT_ARRAY,
+	COMMANDTYPE_SET_PARAM_FLOAT_ARRAY,
+	COMMANDTYPE_SET_PARAM_MAT4_ARRAY,
+	COMMANDTYPE_SET_UNIFORM_DATA,
+	COMMANDTYPE_CLEAR,
+	COMMANDTYPE_DRAW_TRIANGLES,
+	COMMANDTYPE_DRAW_TRIANGLES_INDEXED32,
+	COMMANDTYPE_DRAW_TRIANGLES_INDEXED16,
+	COMMANDTYPE_DRAW_TRIANGLES_INSTANCED,
+	COMMANDTYPE_DRAW_TRIANGLES_INDEXED32_INSTANCED,
+	COMMANDTYPE_DRAW_TRIANGLES_INDEXED16_INSTANCED,
+	COMMANDTYPE_DRAW_TRIANGLES_MULTI,
+	COMMANDTYPE_DRAW_TRIANGLES_INDEXED_MULTI,
+	COMMANDTYPE_DRAW_TRIANGLES_INDEXED_INDIRECT,
+	COMMANDTYPE_BEGIN_GPU_SCOPE,
+	COMMANDTYPE_END_GPU_SCOPE,
+	COMMANDTYPE_MAX
+};
+
+// Every packet starts with this header; size includes the header and any inline payload,
+// and is always a multiple of 8 bytes so the next packet stays aligned.
+struct CommandHeader
+{
+	uint32_t type;
+	uint32_t size;
+};
+
+// Packet for the Set* commands that bind a single object
+struct CommandSetObject
+{
+	CommandHeader header;
+	void *object;
+};
+
+struct CommandSetPrimitiveTopology
+{
+	CommandHeader header;
+	PrimitiveTopology topology;
+	int padding;
+};
+
+struct CommandSetTexture2D
+{
+	CommandHeader header;
+	Texture2D *texture2D;
+	unsigned int slot;
+};
+
+struct CommandSetTexture2DArray
+{
+	CommandHeader header;
+	Texture2DArray *texture2DArray;
+	unsigned int slot;
+};
+
+struct CommandSetSamplerState
+{
+	CommandHeader header;
+	SamplerState *samplerState;
+	unsigned int slot;
+};
+
+struct CommandSetUniformBuffer
+{
+	CommandHeader header;
+	UniformBuffer *uniformBuffer;
+	unsigned int slot;
+};
+
+// Packet for per-draw uniform data; size bytes follow the packet inline
+struct CommandSetUniformData
+{
+	CommandHeader header;
+	unsigned int slot;
+	unsigned int size;
+};
+
+// Packet for pipeline parameter updates; count values follow the packet inline
+struct CommandSetParam
+{
+	CommandHeader header;
+	PipelineParam *param;
+	int count;
+};
+
+struct CommandClear
+{
+	CommandHeader header;
+	float red, green, blue, alpha;
+	float depth;
+	int stencil;
+};
+
+struct CommandDrawTriangles
+{
+	CommandHeader header;
+	int offset;
+	int count;
+};
+
+// Packet for DrawTrianglesIndexed32 and DrawTrianglesIndexed16
+struct CommandDrawTrianglesIndexed
+{
+	CommandHeader header;
+	long long offset;
+	int count;
+	int baseVertex;
+};
+
+struct CommandDrawTrianglesInstanced
+{
+	CommandHeader header;
+	int offset;
+	int count;
+	int instanceCount;
+};
+
+// Packet for DrawTrianglesIndexed32Instanced and DrawTrianglesIndexed16Instanced
+struct CommandDrawTrianglesIndexedInstanced
+{
+	CommandHeader header;
+	long long offset;
+	int count;
+	int instanceCount;
+	int baseVertex;
+};
+
+// Packet for DrawTrianglesMulti; drawCount offsets then drawCount counts follow the packet inline
+struct CommandDrawTrianglesMulti
+{
+	CommandHeader header;
+	int drawCount;
+	int padding;
+};
+
+// Packet for DrawTrianglesIndexedMulti; drawCount offsets, then drawCount counts, then drawCount
+// base vertices if hasBaseVertices, follow the packet inline. Padded to keep the offsets 8-byte aligned.
+struct CommandDrawTrianglesIndexedMulti
+{
+	CommandHeader header;
+	int drawCount;
+	IndexFormat format;
+	int hasBaseVertices;
+	int padding;
+};
+
+struct CommandDrawTrianglesIndexedIndirect
+{
+	CommandHeader header;
+	IndirectBuffer *indirectBuffer;
+	long long offset;
+	int drawCount;
+	IndexFormat format;
+};
+
+struct CommandBeginGpuScope
+{
+	CommandHeader header;
+	const char *name;
+};
+
+// Round a packet size up to keep packets 8-byte aligned
+inline size_t AlignCommandSize(size_t size)
+{
+	return (size + 7) & ~size_t(7);
+}
+
+// Replays a command list against a device. DEVICE is the concrete device type, so when
+// it is final the calls below are bound statically instead of through the vtable.
+template<class DEVICE>
+void ExecuteCommandList(const CommandList &commandList, DEVICE &device)
+{
+	for(const CommandList::Block &block : commandList.GetBlocks())
+	{
+		const char *packet = block.data;
+		const char *end = block.data + block.used;
+		while(packet < end)
+		{
+			const CommandHeader *header = reinterpret_cast<const CommandHeader *>(packet);
+			switch(header->type)
+			{
+			case COMMANDTYPE_SET_PIPELINE:
+				device.SetPipeline(static_cast<Pipeline *>(reinterpret_cast<const CommandSetObject *>(packet)->object));
+				break;
+			case COMMANDTYPE_SET_VERTEX_ARRAY:
+				device.SetVertexArray(static_cast<VertexArray *>(reinterpret_cast<const CommandSetObject *>(packet)->object));
+				break;
+			case COMMANDTYPE_SET_INDEX_BUFFER:
+				device.SetIndexBuffer(static_cast<IndexBuffer *>(reinterpret_cast<const CommandSetObject *>(packet)->object));
+				break;
+			case COMMANDTYPE_SET_PRIMITIVE_TOPOLOGY:
+				device.SetPrimitiveTopology(reinterpret_cast<const CommandSetPrimitiveTopology *>(packet)->topology);
+				break;
+			case COMMANDTYPE_SET_TEXTURE2D:
+			{
+				const CommandSetTexture2D *command = reinterpret_cast<const CommandSetTexture2D *>(packet);
+				device.SetTexture2D(command->slot, command->texture2D);
+				break;
+			}
+			case COMMANDTYPE_SET_TEXTURE2D_ARRAY:
+			{
+				const CommandSetTexture2DArray *command = reinterpret_cast<const CommandSetTexture2DArray *>(packet);
+				device.SetTexture2DArray(command->slot, command->texture2DArray);
+				break;
+			}
+			case COMMANDTYPE_SET_SAMPLER_STATE:
+			{
+				const CommandSetSamplerState *command = reinterpret_cast<const CommandSetSamplerState *>(packet);
+				device.SetSamplerState(command->slot, command->samplerState);
+				break;
+			}
+			case COMMANDTYPE_SET_UNIFORM_BUFFER:
+			{
+				const CommandSetUniformBuffer *command = reinterpret_cast<const CommandSetUniformBuffer *>(packet);
+				device.SetUniformBuffer(command->slot, command->uniformBuffer);
+				break;
+			}
+			case COMMANDTYPE_SET_UNIFORM_DATA:
+			{
+				// written to the device's uniform storage only now, as lists do not know their submission order
+				const CommandSetUniformData *command = reinterpret_cast<const CommandSetUniformData *>(packet);
+				long long offset = device.WriteUniformData(command + 1, command->size);
+				if(offset >= 0)
+					device.SetUniformData(command->slot, offset, command->size);
+				break;
+			}
+			case COMMANDTYPE_SET_RASTER_STATE:
+				device.SetRasterState(static_cast<RasterState *>(reinterpret_cast<const CommandSetObject *>(packet)->object));
+				break;
+			case COMMANDTYPE_SET_DEPTH_STENCIL_STATE:
+				device.SetDepthStencilState(static_cast<DepthStencilState *>(reinterpret_cast<const CommandSetObject *>(packet)->object));
+				break;
+			case COMMANDTYPE_SET_PARAM_INT:
+			case COMMANDTYPE_SET_PARAM_FLOAT:
+			case COMMANDTYPE_SET_PARAM_MAT4:
+			case COMMANDTYPE_SET_PARAM_INT_ARRAY:
+			case COMMANDTYPE_SET_PARAM_FLOAT_ARRAY:
+			case COMMANDTYPE_SET_PARAM_MAT4_ARRAY:
+			{
+				const CommandSetParam *command = reinterpret_cast<const CommandSetParam *>(packet);
+				const void *values = command + 1;
+				switch(header->type)
+				{
+				case COMMANDTYPE_SET_PARAM_INT: command->param->SetAsInt(*static_cast<const int *>(values)); break;
+				case COMMANDTYPE_SET_PARAM_FLOAT: command->param->SetAsFloat(*static_cast<const float *>(values)); break;
+				case COMMANDTYPE_SET_PARAM_MAT4: command->param->SetAsMat4(static_cast<const float *>(values)); break;
+				case COMMANDTYPE_SET_PARAM_INT_ARRAY: command->param->SetAsIntArray(command->count, static_cast<const int *>(values)); break;
+				case COMMANDTYPE_SET_PARAM_FLOAT_ARRAY: command->param->SetAsFloatArray(command->count, static_cast<const float *>(values)); break;
+				default: command->param->SetAsMat4Array(command->count, static_cast<const float *>(values)); break;
+				}
+				break;
+			}
+			case COMMANDTYPE_CLEAR:
+			{
+				const CommandClear *command = reinterpret_cast<const CommandClear *>(packet);
+				device.Clear(command->red, command->green, command->blue, command->alpha, command->depth, command->stencil);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES:
+			{
+				const CommandDrawTriangles *command = reinterpret_cast<const CommandDrawTriangles *>(packet);
+				device.DrawTriangles(command->offset, command->count);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INDEXED32:
+			{
+				const CommandDrawTrianglesIndexed *command = reinterpret_cast<const CommandDrawTrianglesIndexed *>(packet);
+				device.DrawTrianglesIndexed32(command->offset, command->count, command->baseVertex);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INDEXED16:
+			{
+				const CommandDrawTrianglesIndexed *command = reinterpret_cast<const CommandDrawTrianglesIndexed *>(packet);
+				device.DrawTrianglesIndexed16(command->offset, command->count, command->baseVertex);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INSTANCED:
+			{
+				const CommandDrawTrianglesInstanced *command = reinterpret_cast<const CommandDrawTrianglesInstanced *>(packet);
+				device.DrawTrianglesInstanced(command->offset, command->count, command->instanceCount);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INDEXED32_INSTANCED:
+			{
+				const CommandDrawTrianglesIndexedInstanced *command = reinterpret_cast<const CommandDrawTrianglesIndexedInstanced *>(packet);
+				device.DrawTrianglesIndexed32Instanced(command->offset, command->count, command->instanceCount, command->baseVertex);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INDEXED16_INSTANCED:
+			{
+				const CommandDrawTrianglesIndexedInstanced *command = reinterpret_cast<const CommandDrawTrianglesIndexedInstanced *>(packet);
+				device.DrawTrianglesIndexed16Instanced(command->offset, command->count, command->instanceCount, command->baseVertex);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_MULTI:
+			{
+				const CommandDrawTrianglesMulti *command = reinterpret_cast<const CommandDrawTrianglesMulti *>(packet);
+				const int *offsets = reinterpret_cast<const int *>(command + 1);
+				device.DrawTrianglesMulti(command->drawCount, offsets, offsets + command->drawCount);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INDEXED_MULTI:
+			{
+				const CommandDrawTrianglesIndexedMulti *command = reinterpret_cast<const CommandDrawTrianglesIndexedMulti *>(packet);
+				const long long *offsets = reinterpret_cast<const long long *>(command + 1);
+				const int *counts = reinterpret_cast<const int *>(offsets + command->drawCount);
+				device.DrawTrianglesIndexedMulti(command->drawCount, offsets, counts, command->hasBaseVertices ? counts + command->drawCount : nullptr, command->format);
+				break;
+			}
+			case COMMANDTYPE_DRAW_TRIANGLES_INDEXED_INDIRECT:
+			{
+				const CommandDrawTrianglesIndexedIndirect *command = reinterpret_cast<const CommandDrawTrianglesIndexedIndirect *>(packet);
+				device.DrawTrianglesIndexedIndirect(command->indirectBuffer, command->offset, command->drawCount, command->format);
+				break;
+			}
+			case COMMANDTYPE_BEGIN_GPU_SCOPE:
+				device.BeginGpuScope(reinterpret_cast<const CommandBeginGpuScope *>(packet)->name);
+				break;
+			case COMMANDTYPE_END_GPU_SCOPE:
+				device.EndGpuScope();
+				break;
+			}
+			packet += header->size;
+		}
+	}
+}
+
+} // end namespace render
@@ -0,0 +1,417 @@
+#include "render_device/geometry_heap.h"
+
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace render
+{
+
+// the last page is emptied into the others by Compact when it is at most this full
+static const float EVACUATE_OCCUPANCY = 0.5f;
+
+GeometryHeap::GeometryHeap(RenderDevice *renderDevice, unsigned int numVertexElements, const VertexElement *vertexElements, int vertexStride,
+	long long pageVertexBytes, long long pageIndexBytes) :
+	m_RenderDevice(renderDevice), m_VertexDescription(nullptr), m_VertexStride(vertexStride), m_PageVertices(0), m_PageIndices(0)
+{
+	// allocators count in 32-bit units, which also keeps base vertices and index offsets in range of the draws
+	const long long maxUnits = 0x7FFFFFFF;
+	if(vertexStride <= 0 || pageVertexBytes < vertexStride || pageIndexBytes < 0 ||
+		pageVertexBytes / vertexStride > maxUnits || pageIndexBytes / 4 > maxUnits)
+	{
+		std::cout << "ERROR::GEOMETRYHEAP::INVALID_SIZE\n" << vertexStride << " byte vertices, " << pageVertexBytes << " vertex bytes, " << pageIndexBytes << " index bytes" << std::endl;
+		return;
+	}
+
+	m_VertexDescription = m_RenderDevice->CreateVertexDescription(numVertexElements, vertexElements);
+	m_PageVertices = static_cast<uint32_t>(pageVertexBytes / vertexStride);
+	m_PageIndices = static_cast<uint32_t>(pageIndexBytes / 4);
+}
+
+GeometryHeap::~GeometryHeap()
+{
+	for(Page &page : m_Pages)
+		if(page.vertexBuffer)
+			ReleasePage(page);
+	if(m_VertexDescription)
+		m_RenderDevice->DestroyVertexDescription(m_VertexDescription);
+}
+
+GeometryHandle GeometryHeap::Insert(int vertexCount, const void *vertices, int indexCount, const unsigned int *indices)
+{
+	// an empty page holds any mesh up to its size, so only larger meshes are turned away here
+	if(!vertices || vertexCount <= 0 || indexCount < 0 || (indexCount && !indices) ||
+		static_cast<uint32_t>(vertexCount) > m_PageVertices || static_cast<uint32_t>(indexCount) > m_PageIndices)
+	{
+		std::cout << "ERROR::GEOMETRYHEAP::INVALID_MESH\n" << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+		return 0;
+	}
+
+	// the first page with room for both the vertices and the indices
+	uint32_t vertexBlock = TlsfAllocator::INVALID_BLOCK, indexBlock = TlsfAllocator::INVALID_BLOCK;
+	size_t pageIndex = 0;
+	while(pageIndex < m_Pages.size() && !Allocate(m_Pages[pageIndex], vertexCount, indexCount, vertexBlock, indexBlock))
+		pageIndex++;
+
+	if(pageIndex == m_Pages.size())
+	{
+		int newPage = AddPage();
+		if(newPage < 0)
+			return 0;
+		pageIndex = static_cast<size_t>(newPage);
+		if(!Allocate(m_Pages[pageIndex], vertexCount, indexCount, vertexBlock, indexBlock))
+		{
+			// an empty page holds any mesh that passed the checks above, so this is only a safeguard
+			std::cout << "ERROR::GEOMETRYHEAP::ALLOCATION_FAILED\n" << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+			ReleasePage(m_Pages[pageIndex]);
+			if(pageIndex + 1 == m_Pages.size())
+				m_Pages.pop_back();
+			return 0;
+		}
+	}
+
+	Page &page = m_Pages[pageIndex];
+	page.entries++;
+	uint32_t firstVertex = page.vertices->GetOffset(vertexBlock);
+	m_RenderDevice->UpdateVertexBuffer(page.vertexBuffer, static_cast<long long>(firstVertex) * m_VertexStride,
+		static_cast<long long>(vertexCount) * m_VertexStride, vertices);
+
+	long long indexOffset = 0;
+	if(indexCount)
+	{
+		indexOffset = page.indices->GetOffset(indexBlock) * 4ll;
+		m_RenderDevice->UpdateIndexBuffer(page.indexBuffer, indexOffset, indexCount * 4ll, indices);
+	}
+
+	GeometryHandle handle;
+	if(!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else
+	{
+		m_Slots.push_back(Slot());
+		handle = static_cast<GeometryHandle>(m_Slots.size());
+	}
+
+	Slot &slot = m_Slots[handle - 1];
+	slot.vertexBlock = vertexBlock;
+	slot.indexBlock = indexBlock;
+	slot.used = true;
+	GeometryEntry &entry = slot.entry;
+	entry.page = static_cast<unsigned int>(pageIndex);
+	entry.baseVertex = static_cast<int>(firstVertex);
+	entry.vertexCount = vertexCount;
+	entry.indexOffset = indexOffset;
+	entry.indexCount = indexCount;
+	return handle;
+}
+
+void GeometryHeap::Remove(GeometryHandle handle)
+{
+	if(handle == 0 || handle > m_Slots.size() || !m_Slots[handle - 1].used)
+	{
+		std::cout << "ERROR::GEOMETRYHEAP::INVALID_HANDLE\n" << handle << std::endl;
+		return;
+	}
+
+	Slot &slot = m_Slots[handle - 1];
+	slot.used = false;
+	m_FreeHandles.push_back(handle);
+
+	Page &page = m_Pages[slot.entry.page];
+	page.entries--;
+	page.vertices->Free(slot.vertexBlock);
+	if(slot.indexBlock != TlsfAllocator::INVALID_BLOCK)
+		page.indices->Free(slot.indexBlock);
+}
+
+long long GeometryHeap::Compact(long long budgetBytes)
+{
+	// emptying a sparse page frees a whole page, so it goes before closing gaps within pages
+	long long moved = EvacuatePage(budgetBytes);
+	for(unsigned int i = 0; i < m_Pages.size() && moved < budgetBytes; i++)
+		if(m_Pages[i].vertexBuffer)
+			moved += DefragmentPage(i, budgetBytes - moved);
+
+	// one empty page is kept, so that a mesh removed and added back each frame does not recreate it
+	bool keptEmpty = false;
+	for(Page &page : m_Pages)
+	{
+		if(!page.vertexBuffer || page.entries)
+			continue;
+		if(!keptEmpty)
+		{
+			keptEmpty = true;
+			continue;
+		}
+		ReleasePage(page);
+		m_ReleasedPages++;
+	}
+
+	m_CompactedBytes += moved;
+	return moved;
+}
+
+const GeometryEntry *GeometryHeap::GetEntry(GeometryHandle handle) const
+{
+	if(handle == 0 || handle > m_Slots.size() || !m_Slots[handle - 1].used)
+		return nullptr;
+	return &m_Slots[handle - 1].entry;
+}
+
+GeometryHeapStats GeometryHeap::GetStats() const
+{
+	GeometryHeapStats stats;
+	for(const Slot &slot : m_Slots)
+		if(slot.used)
+			stats.entries++;
+
+	long long freeVertices = 0, freeIndices = 0, largestVertices = 0, largestIndices = 0;
+	for(const Page &page : m_Pages)
+	{
+		if(!page.vertexBuffer)
+			continue;
+		stats.pages++;
+		stats.usedVertexBytes += static_cast<long long>(page.vertices->GetUsed()) * m_VertexStride;
+		stats.usedIndexBytes += page.indices->GetUsed() * 4ll;
+		stats.freeVertexRanges += page.vertices->GetNumFreeRanges();
+		stats.freeIndexRanges += page.indices->GetNumFreeRanges();
+
+		uint32_t largestVertexRange = page.vertices->GetLargestFree(), largestIndexRange = page.indices->GetLargestFree();
+		stats.largestFreeVertexBytes = std::max(stats.largestFreeVertexBytes, static_cast<long long>(largestVertexRange) * m_VertexStride);
+		stats.largestFreeIndexBytes = std::max(stats.largestFreeIndexBytes, largestIndexRange * 4ll);
+		freeVertices += page.vertices->GetSize() - page.vertices->GetUsed();
+		freeIndices += page.indices->GetSize() - page.indices->GetUsed();
+		largestVertices += largestVertexRange;
+		largestIndices += largestIndexRange;
+	}
+	stats.pageVertexBytes = static_cast<long long>(m_PageVertices) * m_VertexStride * stats.pages;
+	stats.pageIndexBytes = m_PageIndices * 4ll * stats.pages;
+	if(freeVertices)
+		stats.vertexFragmentation = 1.0f - static_cast<float>(static_cast<double>(largestVertices) / freeVertices);
+	if(freeIndices)
+		stats.indexFragmentation = 1.0f - static_cast<float>(static_cast<double>(largestIndices) / freeIndices);
+	stats.compactedBytes = m_CompactedBytes;
+	stats.releasedPages = m_ReleasedPages;
+	return stats;
+}
+
+bool GeometryHeap::Allocate(Page &page, int vertexCount, int indexCount, uint32_t &vertexBlock, uint32_t &indexBlock)
+{
+	if(!page.vertexBuffer)
+		return false;
+
+	vertexBlock = page.vertices->Allocate(static_cast<uint32_t>(vertexCount));
+	if(vertexBlock == TlsfAllocator::INVALID_BLOCK)
+		return false;
+
+	indexBlock = TlsfAllocator::INVALID_BLOCK;
+	if(indexCount)
+	{
+		indexBlock = page.indices->Allocate(static_cast<uint32_t>(indexCount));
+		if(indexBlock == TlsfAllocator::INVALID_BLOCK)
+		{
+			page.vertices->Free(vertexBlock);
+			vertexBlock = TlsfAllocator::INVALID_BLOCK;
+			return false;
+		}
+	}
+	return true;
+}
+
+int GeometryHeap::AddPage()
+{
+	if(!m_VertexDescription)
+		return -1;
+
+	// the buffers are filled a mesh at a time and rarely rewritten
+	Page page;
+	page.vertexBuffer = m_RenderDevice->CreateVertexBuffer(static_cast<long long>(m_PageVertices) * m_VertexStride, nullptr, BUFFERUSAGE_STATIC);
+	page.indexBuffer = m_RenderDevice->CreateIndexBuffer(std::max(m_PageIndices * 4ll, 4ll), nullptr, BUFFERUSAGE_STATIC);
+	if(!page.vertexBuffer || !page.indexBuffer)
+	{
+		if(page.vertexBuffer)
+			m_RenderDevice->DestroyVertexBuffer(page.vertexBuffer);
+		if(page.indexBuffer)
+			m_RenderDevice->DestroyIndexBuffer(page.indexBuffer);
+		return -1;
+	}
+	page.vertexArray = m_RenderDevice->CreateVertexArray(1, &page.vertexBuffer, &m_VertexDescription);
+	page.vertices.reset(new TlsfAllocator(m_PageVertices));
+	page.indices.reset(new TlsfAllocator(m_PageIndices));
+	page.entries = 0;
+
+	// released pages leave their index free for the next
+	for(size_t i = 0; i < m_Pages.size(); i++)
+	{
+		if(!m_Pages[i].vertexBuffer)
+		{
+			m_Pages[i] = std::move(page);
+			return static_cast<int>(i);
+		}
+	}
+	m_Pages.push_back(std::move(page));
+	return static_cast<int>(m_Pages.size() - 1);
+}
+
+long long GeometryHeap::EvacuatePage(long long budgetBytes)
+{
+	// meshes only ever move from the last page holding any to earlier ones, so that pages
+	// never trade meshes back and forth; insertions fill the earlier pages first as well
+	size_t last = m_Pages.size();
+	while(last > 0 && !(m_Pages[last - 1].vertexBuffer && m_Pages[last - 1].entries))
+		last--;
+	if(last-- == 0 || GetOccupancy(m_Pages[last]) > EVACUATE_OCCUPANCY)
+		return 0;
+
+	// and only when the earlier pages have room for all of them, so the page is sure to empty
+	long long freeVertices = 0, freeIndices = 0;
+	for(size_t i = 0; i < last; i++)
+	{
+		const Page &page = m_Pages[i];
+		if(!page.vertexBuffer)
+			continue;
+		freeVertices += page.vertices->GetSize() - page.vertices->GetUsed();
+		freeIndices += page.indices->GetSize() - page.indices->GetUsed();
+	}
+	Page &source = m_Pages[last];
+	if(source.vertices->GetUsed() > freeVertices || source.indices->GetUsed() > freeIndices)
+		return 0;
+
+	long long moved = 0;
+	for(Slot &slot : m_Slots)
+	{
+		if(!source.entries)
+			break;
+		GeometryEntry &entry = slot.entry;
+		if(!slot.used || entry.page != last)
+			continue;
+
+		long long vertexBytes = static_cast<long long>(entry.vertexCount) * m_VertexStride, indexBytes = entry.indexCount * 4ll;
+		if(moved + vertexBytes + indexBytes > budgetBytes)
+			break;
+
+		// free space split into ranges may still leave a mesh nowhere to go, in which case it stays
+		uint32_t vertexBlock = TlsfAllocator::INVALID_BLOCK, indexBlock = TlsfAllocator::INVALID_BLOCK;
+		size_t pageIndex = 0;
+		while(pageIndex < last && !Allocate(m_Pages[pageIndex], entry.vertexCount, entry.indexCount, vertexBlock, indexBlock))
+			pageIndex++;
+		if(pageIndex == last)
+			continue;
+
+		Page &destination = m_Pages[pageIndex];
+		long long baseVertex = destination.vertices->GetOffset(vertexBlock);
+		m_RenderDevice->CopyVertexBuffer(destination.vertexBuffer, baseVertex * m_VertexStride,
+			source.vertexBuffer, static_cast<long long>(entry.baseVertex) * m_VertexStride, vertexBytes);
+		source.vertices->Free(slot.vertexBlock);
+
+		long long indexOffset = 0;
+		if(entry.indexCount)
+		{
+			indexOffset = destination.indices->GetOffset(indexBlock) * 4ll;
+			m_RenderDevice->CopyIndexBuffer(destination.indexBuffer, indexOffset, source.indexBuffer, entry.indexOffset, indexBytes);
+			source.indices->Free(slot.indexBlock);
+		}
+
+		source.entries--;
+		destination.entries++;
+		slot.vertexBlock = vertexBlock;
+		slot.indexBlock = indexBlock;
+		entry.page = static_cast<unsigned int>(pageIndex);
+		entry.baseVertex = static_cast<int>(baseVertex);
+		entry.indexOffset = indexOffset;
+		moved += vertexBytes + indexBytes;
+	}
+	return moved;
+}
+
+long long GeometryHeap::DefragmentPage(unsigned int pageIndex, long long budgetBytes)
+{
+	// a page whose free space is all in one range has nothing to gain
+	Page &page = m_Pages[pageIndex];
+	bool vertexGaps = page.vertices->GetNumFreeRanges() > 1, indexGaps = page.indices->GetNumFreeRanges() > 1;
+	if(!vertexGaps && !indexGaps)
+		return 0;
+
+	std::vector<Slot *> slots;
+	for(Slot &slot : m_Slots)
+		if(slot.used && slot.entry.page == pageIndex)
+			slots.push_back(&slot);
+
+	// the highest meshes move first, into the lowest ranges that hold them, so the free space gathers at the end
+	long long moved = 0;
+	if(vertexGaps)
+	{
+		std::sort(slots.begin(), slots.end(), [](const Slot *a, const Slot *b) { return a->entry.baseVertex > b->entry.baseVertex; });
+		for(Slot *slot : slots)
+		{
+			GeometryEntry &entry = slot->entry;
+			long long bytes = static_cast<long long>(entry.vertexCount) * m_VertexStride;
+			if(moved + bytes > budgetBytes)
+				return moved;
+
+			uint32_t block = page.vertices->AllocateLowest(static_cast<uint32_t>(entry.vertexCount), static_cast<uint32_t>(entry.baseVertex));
+			if(block == TlsfAllocator::INVALID_BLOCK)
+				continue;
+
+			long long baseVertex = page.vertices->GetOffset(block);
+			m_RenderDevice->CopyVertexBuffer(page.vertexBuffer, baseVertex * m_VertexStride, page.vertexBuffer,
+				static_cast<long long>(entry.baseVertex) * m_VertexStride, bytes);
+			page.vertices->Free(slot->vertexBlock);
+			slot->vertexBlock = block;
+			entry.baseVertex = static_cast<int>(baseVertex);
+			moved += bytes;
+		}
+	}
+
+	if(indexGaps)
+	{
+		std::sort(slots.begin(), slots.end(), [](const Slot *a, const Slot *b) { return a->entry.indexOffset > b->entry.indexOffset; });
+		for(Slot *slot : slots)
+		{
+			GeometryEntry &entry = slot->entry;
+			if(!entry.indexCount)
+				continue;
+			long long bytes = entry.indexCount * 4ll;
+			if(moved + bytes > budgetBytes)
+				return moved;
+
+			uint32_t block = page.indices->AllocateLowest(static_cast<uint32_t>(entry.indexCount), static_cast<uint32_t>(entry.indexOffset / 4));
+			if(block == TlsfAllocator::INVALID_BLOCK)
+				continue;
+
+			long long indexOffset = page.indices->GetOffset(block) * 4ll;
+			m_RenderDevice->CopyIndexBuffer(page.indexBuffer, indexOffset, page.indexBuffer, entry.indexOffset, bytes);
+			page.indices->Free(slot->indexBlock);
+			slot->indexBlock = block;
+			entry.indexOffset = indexOffset;
+			moved += bytes;
+		}
+	}
+	return moved;
+}
+
+void GeometryHeap::ReleasePage(Page &page)
+{
+	m_RenderDevice->DestroyVertexArray(page.vertexArray);
+	m_RenderDevice->DestroyIndexBuffer(page.indexBuffer);
+	m_RenderDevice->DestroyVertexBuffer(page.vertexBuffer);
+	page.vertexArray = nullptr;
+	page.indexBuffer = nullptr;
+	page.vertexBuffer = nullptr;
+	page.vertices.reset();
+	page.indices.reset();
+}
+
+float GeometryHeap::GetOccupancy(const Page &page) const
+{
+	float vertices = static_cast<float>(page.vertices->GetUsed()) / page.vertices->GetSize();
+	float indices = page.indices->GetSize() ? static_cast<float>(page.indices->GetUsed()) / page.indices->GetSize() : 0.0f;
+	return std::max(vertices, indices);
+}
+
+} // end namespace render
@@ -0,0 +1,80 @@
+#include "gpu_scope_table.h"
+
+namespace render
+{
+
+unsigned int GpuScopeTable::Find(const char *name, unsigned int depth)
+{
+	auto iter = m_Indices.find(name);
+	if(iter != m_Indices.end())
+		return iter->second;
+
+	Scope scope;
+	scope.name = name;
+	scope.depth = depth;
+	scope.frames = 0;
+	scope.frameMs = -1.0;
+	scope.lastMs = scope.minMs = scope.maxMs = scope.totalMs = 0.0;
+
+	unsigned int index = static_cast<unsigned int>(m_Scopes.size());
+	m_Scopes.push_back(scope);
+	m_Indices.insert(iter, std::make_pair(scope.name, index));
+	return index;
+}
+
+void GpuScopeTable::Accumulate(unsigned int index, double ms)
+{
+	Scope &scope = m_Scopes[index];
+	if(scope.frameMs < 0.0)
+	{
+		// first time this frame
+		scope.frameMs = 0.0;
+		m_FrameScopes.push_back(index);
+	}
+	scope.frameMs += ms;
+}
+
+void GpuScopeTable::ResolveFrame()
+{
+	for(unsigned int index : m_FrameScopes)
+	{
+		Scope &scope = m_Scopes[index];
+		double ms = scope.frameMs;
+		scope.frameMs = -1.0;
+
+		if(scope.frames == 0 || ms < scope.minMs)
+			scope.minMs = ms;
+		if(scope.frames == 0 || ms > scope.maxMs)
+			scope.maxMs = ms;
+		scope.lastMs = ms;
+		scope.totalMs += ms;
+		scope.frames++;
+	}
+	m_FrameScopes.clear();
+}
+
+unsigned int GpuScopeTable::GetStats(unsigned int maxScopes, GpuScopeStats *stats) const
+{
+	unsigned int numScopes = static_cast<unsigned int>(m_Scopes.size());
+	for(unsigned int i = 0; i < numScopes && i < maxScopes; i++)
+	{
+		const Scope &scope = m_Scopes[i];
+		stats[i].name = scope.name.c_str();
+		stats[i].depth = scope.depth;
+		stats[i].frames = scope.frames;
+		stats[i].lastMs = scope.lastMs;
+		stats[i].minMs = scope.minMs;
+		stats[i].avgMs = scope.frames ? scope.totalMs / scope.frames : 0.0;
+		stats[i].maxMs = scope.maxMs;
+	}
+	return numScopes;
+}
+
+void GpuScopeTable::Reset()
+{
+	m_Scopes.clear();
+	m_Indices.clear();
+	m_FrameScopes.clear();
+}
+
+} // end namespace render
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace render
+{
+
+// Accumulates per-frame GPU scope timings into GpuScopeStats for a RenderDevice.
+// Devices time their scopes however they can, add each time to the frame being
+// resolved with Accumulate, then call ResolveFrame once all of that frame's times
+// have been added.
+class GpuScopeTable
+{
+public:
+
+	// Returns the index of the scope called name, adding it at depth if it is new
+	unsigned int Find(const char *name, unsigned int depth);
+
+	// Add milliseconds spent in scope index to the frame being resolved
+	void Accumulate(unsigned int index, double ms);
+
+	// Record one sample for every scope accumulated into since the last call
+	void ResolveFrame();
+
+	// Implements RenderDevice::GetGpuScopeStats
+	unsigned int GetStats(unsigned int maxScopes, GpuScopeStats *stats) const;
+
+	// Forget every scope; indices returned by Find are no longer valid
+	void Reset();
+
+private:
+
+	struct Scope
+	{
+		std::string name;
+		unsigned int depth;
+		unsigned int frames;
+		double frameMs; // accumulated for the frame being resolved
+		double lastMs, minMs, maxMs, totalMs;
+	};
+
+	// a deque so that names stay put as scopes are added
+	std::deque<Scope> m_Scopes;
+	std::map<std::string, unsigned int> m_Indices;
+
+	// scopes accumulated into since the last ResolveFrame
+	std::vector<unsigned int> m_FrameScopes;
+};
+
+} // end namespace render
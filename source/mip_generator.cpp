@@ -0,0 +1,121 @@
+#include "mip_generator.h"
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_SSE2
+#endif
+
+namespace render
+{
+
+// Texels of a level below which it is filtered on the calling thread, as waking the pool costs more
+static const int MIP_PARALLEL_TEXELS = 64 * 1024;
+
+// Texels each job filters when a level is split among threads
+static const int MIP_JOB_TEXELS = 16 * 1024;
+
+// Rounded average of four texels, per 8-bit component
+static inline uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	uint32_t result = 0;
+	for(int shift = 0; shift < 32; shift += 8)
+	{
+		uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+		result |= ((sum + 2) >> 2) << shift;
+	}
+	return result;
+}
+
+// Filter one row of a level from the two source rows above it, width texels wide
+static void DownsampleRow(const uint32_t *row0, const uint32_t *row1, uint32_t *destination, int width)
+{
+	int x = 0;
+
+#if defined(MIP_SSE2)
+	// four destination texels per iteration; components are widened to 16 bits so the sums cannot overflow
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(2);
+	for(; x + 4 <= width; x += 4)
+	{
+		__m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x));
+		__m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x + 4));
+		__m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x));
+		__m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x + 4));
+
+		// vertical sums of source texel pairs 0-1, 2-3, 4-5 and 6-7
+		__m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+		__m128i sum23 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+		__m128i sum45 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+		__m128i sum67 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+		// horizontal sums leave each destination texel in the low 64 bits
+		sum01 = _mm_add_epi16(sum01, _mm_srli_si128(sum01, 8));
+		sum23 = _mm_add_epi16(sum23, _mm_srli_si128(sum23, 8));
+		sum45 = _mm_add_epi16(sum45, _mm_srli_si128(sum45, 8));
+		sum67 = _mm_add_epi16(sum67, _mm_srli_si128(sum67, 8));
+
+		__m128i low = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum01, sum23), round), 2);
+		__m128i high = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum45, sum67), round), 2);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(destination + x), _mm_packus_epi16(low, high));
+	}
+#endif
+
+	for(; x < width; x++)
+		destination[x] = Average4(row0[2 * x], row0[2 * x + 1], row1[2 * x], row1[2 * x + 1]);
+}
+
+// Filter rows [begin, end) of a level from the level above it
+static void DownsampleRows(const uint32_t *source, int sourceWidth, int sourceHeight, uint32_t *destination, int width, int begin, int end)
+{
+	for(int y = begin; y < end; y++)
+	{
+		if(sourceWidth > 1 && sourceHeight > 1)
+		{
+			DownsampleRow(source + static_cast<size_t>(2 * y) * sourceWidth, source + static_cast<size_t>(2 * y + 1) * sourceWidth,
+				destination + static_cast<size_t>(y) * width, width);
+			continue;
+		}
+
+		// a level one texel wide or high only averages along its other dimension
+		const uint32_t *row0 = source + static_cast<size_t>(std::min(2 * y, sourceHeight - 1)) * sourceWidth;
+		const uint32_t *row1 = source + static_cast<size_t>(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth;
+		for(int x = 0; x < width; x++)
+		{
+			int x0 = std::min(2 * x, sourceWidth - 1), x1 = std::min(2 * x + 1, sourceWidth - 1);
+			destination[static_cast<size_t>(y) * width + x] = Average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+		}
+	}
+}
+
+void GenerateMipChain(ThreadPool &threadPool, int width, int height, int numLevels, uint32_t *chain)
+{
+	uint32_t *source = chain;
+	for(int level = 1; level < numLevels; level++)
+	{
+		int levelWidth = std::max(width >> 1, 1), levelHeight = std::max(height >> 1, 1);
+		uint32_t *destination = source + static_cast<size_t>(width) * height;
+
+		// each level reads the one before it, so only the rows within a level run in parallel
+		if(levelWidth * levelHeight < MIP_PARALLEL_TEXELS)
+			DownsampleRows(source, width, height, destination, levelWidth, 0, levelHeight);
+		else
+		{
+			int rowsPerJob = std::max(MIP_JOB_TEXELS / levelWidth, 1);
+			unsigned int numJobs = static_cast<unsigned int>((levelHeight + rowsPerJob - 1) / rowsPerJob);
+			threadPool.ParallelFor(numJobs, [&](unsigned int job) {
+				int begin = static_cast<int>(job) * rowsPerJob;
+				DownsampleRows(source, width, height, destination, levelWidth, begin, std::min(begin + rowsPerJob, levelHeight));
+			});
+		}
+
+		source = destination;
+		width = levelWidth;
+		height = levelHeight;
+	}
+}
+
+} // end namespace render
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+namespace render
+{
+
+class ThreadPool;
+
+// Fill levels 1 to numLevels - 1 of a mip chain of 32-bit RGBA texels. chain holds the
+// width by height top level, followed by room for the other levels stored largest first
+// and tightly packed, as GetTextureSize lays them out. Every texel of a level is the
+// rounded average of the 2x2 block of the level above it; a trailing odd row or column
+// is dropped. The rows of large levels are split among the threads of threadPool.
+void GenerateMipChain(ThreadPool &threadPool, int width, int height, int numLevels, uint32_t *chain);
+
+} // end namespace render
@@ -0,0 +1,1250 @@
+#include "null_render_device.h"
+
+#include "command_list_commands.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <map>
+
+namespace render
+{
+
+class NullVertexShader : public VertexShader
+{
+public:
+
+	NullVertexShader(const char *code) : source(code ? code : "") {}
+
+	std::string source;
+};
+
+class NullPixelShader : public PixelShader
+{
+public:
+
+	NullPixelShader(const char *code) : source(code ? code : "") {}
+
+	std::string source;
+};
+
+class NullPipelineParam : public PipelineParam
+{
+public:
+
+	NullPipelineParam(NullRenderDeviceStats *_stats, ParamHandle _handle) : stats(_stats), handle(_handle) {}
+
+	void SetAsInt(int value) override
+	{
+		Store(&value, sizeof(value));
+	}
+
+	void SetAsFloat(float value) override
+	{
+		Store(&value, sizeof(value));
+	}
+
+	void SetAsMat4(const float *value) override
+	{
+		Store(value, 16 * sizeof(float));
+	}
+
+	void SetAsIntArray(int count, const int *values) override
+	{
+		Store(values, count * sizeof(int));
+	}
+
+	void SetAsFloatArray(int count, const float *values) override
+	{
+		Store(values, count * sizeof(float));
+	}
+
+	void SetAsMat4Array(int count, const float *values) override
+	{
+		Store(values, count * 16 * sizeof(float));
+	}
+
+	// keep a copy of the value, as a driver would for a uniform
+	void Store(const void *data, size_t size)
+	{
+		value.resize(size);
+		if(size)
+			memcpy(&value[0], data, size);
+		stats->paramUpdates++;
+	}
+
+	NullRenderDeviceStats *stats;
+	ParamHandle handle;
+	std::string value;
+};
+
+class NullPipeline : public Pipeline
+{
+public:
+
+	NullPipeline(NullRenderDeviceStats *_stats) : stats(_stats) {}
+
+	~NullPipeline() override
+	{
+		for(auto &iter : paramsByName)
+			delete iter.second;
+	}
+
+	PipelineParam *GetParam(const char *name) override
+	{
+		// without a shader compiler, every name is assumed to be an active uniform
+		auto iter = paramsByName.find(name);
+		if(iter == paramsByName.end())
+		{
+			iter = paramsByName.insert(iter, std::make_pair(name, new NullPipelineParam(stats, static_cast<ParamHandle>(params.size()))));
+			params.push_back(iter->second);
+		}
+		return iter->second;
+	}
+
+	ParamHandle GetParamHandle(const char *name) override
+	{
+		return static_cast<NullPipelineParam *>(GetParam(name))->handle;
+	}
+
+	PipelineParam *ResolveParam(ParamHandle handle) override
+	{
+		return handle >= 0 && handle < static_cast<ParamHandle>(params.size()) ? params[handle] : nullptr;
+	}
+
+	bool SetUniformBlockSlot(const char *name, unsigned int slot) override
+	{
+		return name != nullptr;
+	}
+
+	NullRenderDeviceStats *stats;
+	std::map<std::string, NullPipelineParam *> paramsByName;
+	std::vector<NullPipelineParam *> params; // by handle
+};
+
+// The size and usage of a vertex, index or uniform buffer, and the memory handed out while it is mapped
+class NullBuffer
+{
+public:
+
+	NullBuffer(long long _size, BufferUsage _usage) : size(_size), usage(_usage) {}
+
+	long long size;
+	BufferUsage usage;
+	bool mapped = false;
+	std::vector<char> mapping; // scratch handed out by Map*Buffer, kept for the next mapping
+};
+
+class NullVertexBuffer : public VertexBuffer
+{
+public:
+
+	NullVertexBuffer(long long size, BufferUsage usage) : storage(size, usage) {}
+
+	NullBuffer storage;
+};
+
+class NullVertexDescription : public VertexDescription
+{
+public:
+
+	NullVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements) : elements(vertexElements, vertexElements + numVertexElements) {}
+
+	std::vector<VertexElement> elements;
+};
+
+class NullVertexArray : public VertexArray
+{
+public:
+
+	NullVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+	{
+		for(unsigned int i = 0; i < numVertexBuffers; i++)
+		{
+			this->vertexBuffers.push_back(static_cast<NullVertexBuffer *>(vertexBuffers[i]));
+			this->vertexDescriptions.push_back(static_cast<NullVertexDescription *>(vertexDescriptions[i]));
+		}
+	}
+
+	std::vector<NullVertexBuffer *> vertexBuffers;
+	std::vector<NullVertexDescription *> vertexDescriptions;
+};
+
+class NullIndexBuffer : public IndexBuffer
+{
+public:
+
+	NullIndexBuffer(long long size, BufferUsage usage, IndexFormat _format) : storage(size, usage), format(_format) {}
+
+	NullBuffer storage;
+	IndexFormat format;
+};
+
+class NullIndirectBuffer : public IndirectBuffer
+{
+public:
+
+	NullIndirectBuffer(long long size, BufferUsage usage) : storage(size, usage) {}
+
+	NullBuffer storage;
+};
+
+// Returns the levels a texture created with mipLevels and mipPolicy ends up with, which are recorded
+// rather than the levels asked for
+static int ResolveMipLevels(int width, int height, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	if(mipLevels > 0)
+		return mipLevels;
+	return IsCompressedTextureFormat(format) || mipPolicy == MIPPOLICY_NONE ? 1 : GetTextureMipLevels(width, height);
+}
+
+// Returns whether a region of a level of a texture can be updated; compressed textures are updated in whole blocks
+static bool IsValidTextureRegion(int width, int height, TextureFormat format, int mipLevels, int mipLevel, int x, int y, int regionWidth, int regionHeight)
+{
+	if(mipLevel < 0 || mipLevel >= mipLevels)
+		return false;
+
+	int levelWidth = std::max(width >> mipLevel, 1), levelHeight = std::max(height >> mipLevel, 1);
+	if(x < 0 || y < 0 || regionWidth <= 0 || regionHeight <= 0 || x + regionWidth > levelWidth || y + regionHeight > levelHeight)
+		return false;
+
+	return !IsCompressedTextureFormat(format) ||
+		!(x % 4 || y % 4 || (regionWidth % 4 && x + regionWidth != levelWidth) || (regionHeight % 4 && y + regionHeight != levelHeight));
+}
+
+class NullTexture2D : public Texture2D
+{
+public:
+
+	NullTexture2D(int _width, int _height, TextureFormat _format, int _mipLevels) : width(_width), height(_height), format(_format), mipLevels(_mipLevels) {}
+
+	int width;
+	int height;
+	TextureFormat format;
+	int mipLevels;
+};
+
+class NullTexture2DArray : public Texture2DArray
+{
+public:
+
+	NullTexture2DArray(int _width, int _height, int _layers, TextureFormat _format, int _mipLevels, int _suppliedLevels) :
+		width(_width), height(_height), layers(_layers), format(_format), mipLevels(_mipLevels), suppliedLevels(_suppliedLevels) {}
+
+	int width;
+	int height;
+	int layers;
+	TextureFormat format;
+	int mipLevels;
+	int suppliedLevels; // levels in the data of each layer
+};
+
+// The number of layers OpenGL 4.1 guarantees a texture array can have
+static const int MAX_TEXTURE_LAYERS = 2048;
+
+class NullSamplerState : public SamplerState
+{
+public:
+
+	NullSamplerState(TextureFilter _minFilter, TextureFilter _magFilter, MipFilter _mipFilter, TextureWrap _wrapS, TextureWrap _wrapT) :
+		minFilter(_minFilter), magFilter(_magFilter), mipFilter(_mipFilter), wrapS(_wrapS), wrapT(_wrapT) {}
+
+	TextureFilter minFilter;
+	TextureFilter magFilter;
+	MipFilter mipFilter;
+	TextureWrap wrapS;
+	TextureWrap wrapT;
+};
+
+class NullUniformBuffer : public UniformBuffer
+{
+public:
+
+	NullUniformBuffer(long long size, BufferUsage usage) : storage(size, usage) {}
+
+	NullBuffer storage;
+};
+
+class NullRasterState : public RasterState
+{
+public:
+
+	NullRasterState(bool _cullEnabled, Winding _frontFace, Face _cullFace, RasterMode _rasterMode) :
+		cullEnabled(_cullEnabled), frontFace(_frontFace), cullFace(_cullFace), rasterMode(_rasterMode) {}
+
+	bool cullEnabled;
+	Winding frontFace;
+	Face cullFace;
+	RasterMode rasterMode;
+};
+
+class NullDepthStencilState : public DepthStencilState
+{
+public:
+
+	NullDepthStencilState(bool _depthEnabled, bool _depthWriteEnabled, Compare _depthCompare, bool _stencilEnabled) :
+		depthEnabled(_depthEnabled), depthWriteEnabled(_depthWriteEnabled), depthCompare(_depthCompare), stencilEnabled(_stencilEnabled) {}
+
+	bool depthEnabled;
+	bool depthWriteEnabled;
+	Compare depthCompare;
+	bool stencilEnabled;
+};
+
+NullRenderDevice::NullRenderDevice()
+{
+	m_DefaultRasterState = new NullRasterState(true, WINDING_CCW, FACE_BACK, RASTERMODE_FILL);
+	m_RasterState = m_DefaultRasterState;
+
+	m_DefaultDepthStencilState = new NullDepthStencilState(true, true, COMPARE_LESS, false);
+	m_DepthStencilState = m_DefaultDepthStencilState;
+}
+
+NullRenderDevice::~NullRenderDevice()
+{
+	delete m_DefaultRasterState;
+	delete m_DefaultDepthStencilState;
+	delete m_TransientVertexBuffer;
+	delete m_TransientIndexBuffer;
+
+	if(m_Stats.resourcesCreated != m_Stats.resourcesDestroyed)
+		std::cout << "WARNING::NULLRENDERDEVICE::LEAKED_RESOURCES\n" << (m_Stats.resourcesCreated - m_Stats.resourcesDestroyed) << " resources were not destroyed" << std::endl;
+}
+
+void NullRenderDevice::Error(const char *message)
+{
+	m_Stats.errors++;
+	std::cout << "ERROR::NULLRENDERDEVICE::" << message << std::endl;
+}
+
+VertexShader *NullRenderDevice::CreateVertexShader(const char *code)
+{
+	m_Stats.calls++;
+	m_Stats.resourcesCreated++;
+	return new NullVertexShader(code);
+}
+
+void NullRenderDevice::DestroyVertexShader(VertexShader *vertexShader)
+{
+	m_Stats.calls++;
+	if(vertexShader)
+		m_Stats.resourcesDestroyed++;
+	delete vertexShader;
+}
+
+PixelShader *NullRenderDevice::CreatePixelShader(const char *code)
+{
+	m_Stats.calls++;
+	m_Stats.resourcesCreated++;
+	return new NullPixelShader(code);
+}
+
+void NullRenderDevice::DestroyPixelShader(PixelShader *pixelShader)
+{
+	m_Stats.calls++;
+	if(pixelShader)
+		m_Stats.resourcesDestroyed++;
+	delete pixelShader;
+}
+
+Pipeline *NullRenderDevice::CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader)
+{
+	m_Stats.calls++;
+	if(!vertexShader || !pixelShader)
+	{
+		Error("PIPELINE_MISSING_SHADER");
+		return nullptr;
+	}
+	m_Stats.resourcesCreated++;
+	return new NullPipeline(&m_Stats);
+}
+
+void NullRenderDevice::DestroyPipeline(Pipeline *pipeline)
+{
+	m_Stats.calls++;
+	if(!pipeline)
+		return;
+	if(pipeline == m_Pipeline)
+		m_Pipeline = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete pipeline;
+}
+
+void NullRenderDevice::SetPipeline(Pipeline *pipeline)
+{
+	m_Stats.calls++;
+	NullPipeline *nullPipeline = static_cast<NullPipeline *>(pipeline);
+	if(nullPipeline == m_Pipeline)
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_Pipeline = nullPipeline;
+}
+
+bool NullRenderDevice::IsValidBuffer(const char *type, long long size, BufferUsage usage)
+{
+	std::string prefix(type);
+	if(size < 0)
+	{
+		Error((prefix + "_INVALID_SIZE").c_str());
+		return false;
+	}
+	if(usage < 0 || usage >= BUFFERUSAGE_MAX)
+	{
+		Error((prefix + "_INVALID_USAGE").c_str());
+		return false;
+	}
+	return true;
+}
+
+void NullRenderDevice::UpdateBuffer(const char *type, NullBuffer *buffer, long long offset, long long size, const void *data)
+{
+	std::string prefix(type);
+	if(!buffer || !data || offset < 0 || size <= 0 || offset + size > buffer->size)
+		return Error((prefix + "_INVALID_RANGE").c_str());
+	if(buffer->mapped)
+		return Error((prefix + "_MAPPED").c_str());
+
+	m_Stats.bufferUpdateBytes += size;
+}
+
+void *NullRenderDevice::MapBuffer(const char *type, NullBuffer *buffer, long long offset, long long size, unsigned int mapFlags)
+{
+	std::string prefix(type);
+	if(!buffer || offset < 0 || size <= 0 || offset + size > buffer->size)
+	{
+		Error((prefix + "_INVALID_RANGE").c_str());
+		return nullptr;
+	}
+	if(buffer->mapped)
+	{
+		Error((prefix + "_MAPPED").c_str());
+		return nullptr;
+	}
+
+	// nothing is read back from the mapping, so only the range is counted as written
+	buffer->mapped = true;
+	buffer->mapping.resize(static_cast<size_t>(size));
+	m_Stats.bufferUpdateBytes += size;
+	return &buffer->mapping[0];
+}
+
+void NullRenderDevice::CopyBuffer(const char *type, NullBuffer *destination, long long destinationOffset, NullBuffer *source, long long sourceOffset, long long size)
+{
+	std::string prefix(type);
+	if(!destination || !source || destinationOffset < 0 || sourceOffset < 0 || size <= 0 ||
+		destinationOffset + size > destination->size || sourceOffset + size > source->size)
+		return Error((prefix + "_INVALID_RANGE").c_str());
+	if(destination == source && destinationOffset < sourceOffset + size && sourceOffset < destinationOffset + size)
+		return Error((prefix + "_OVERLAPPING_COPY").c_str());
+	if(destination->mapped || source->mapped)
+		return Error((prefix + "_MAPPED").c_str());
+
+	m_Stats.bufferCopyBytes += size;
+}
+
+void NullRenderDevice::UnmapBuffer(const char *type, NullBuffer *buffer)
+{
+	if(!buffer || !buffer->mapped)
+		return Error((std::string(type) + "_NOT_MAPPED").c_str());
+	buffer->mapped = false;
+}
+
+VertexBuffer *NullRenderDevice::CreateVertexBuffer(long long size, const void *data, BufferUsage usage)
+{
+	m_Stats.calls++;
+	if(!IsValidBuffer("VERTEX_BUFFER", size, usage))
+		return nullptr;
+	m_Stats.resourcesCreated++;
+	return new NullVertexBuffer(size, usage);
+}
+
+void NullRenderDevice::UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data)
+{
+	m_Stats.calls++;
+	UpdateBuffer("VERTEX_BUFFER", vertexBuffer ? &static_cast<NullVertexBuffer *>(vertexBuffer)->storage : nullptr, offset, size, data);
+}
+
+void *NullRenderDevice::MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	m_Stats.calls++;
+	return MapBuffer("VERTEX_BUFFER", vertexBuffer ? &static_cast<NullVertexBuffer *>(vertexBuffer)->storage : nullptr, offset, size, mapFlags);
+}
+
+void NullRenderDevice::UnmapVertexBuffer(VertexBuffer *vertexBuffer)
+{
+	m_Stats.calls++;
+	UnmapBuffer("VERTEX_BUFFER", vertexBuffer ? &static_cast<NullVertexBuffer *>(vertexBuffer)->storage : nullptr);
+}
+
+void NullRenderDevice::CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	m_Stats.calls++;
+	CopyBuffer("VERTEX_BUFFER", destination ? &static_cast<NullVertexBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &static_cast<NullVertexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void NullRenderDevice::DestroyVertexBuffer(VertexBuffer *vertexBuffer)
+{
+	m_Stats.calls++;
+	if(vertexBuffer)
+		m_Stats.resourcesDestroyed++;
+	delete vertexBuffer;
+}
+
+VertexDescription *NullRenderDevice::CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements)
+{
+	m_Stats.calls++;
+	m_Stats.resourcesCreated++;
+	return new NullVertexDescription(numVertexElements, vertexElements);
+}
+
+void NullRenderDevice::DestroyVertexDescription(VertexDescription *vertexDescription)
+{
+	m_Stats.calls++;
+	if(vertexDescription)
+		m_Stats.resourcesDestroyed++;
+	delete vertexDescription;
+}
+
+VertexArray *NullRenderDevice::CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+{
+	m_Stats.calls++;
+	m_Stats.resourcesCreated++;
+	return new NullVertexArray(numVertexBuffers, vertexBuffers, vertexDescriptions);
+}
+
+void NullRenderDevice::DestroyVertexArray(VertexArray *vertexArray)
+{
+	m_Stats.calls++;
+	if(!vertexArray)
+		return;
+	if(vertexArray == m_VertexArray)
+		m_VertexArray = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete vertexArray;
+}
+
+void NullRenderDevice::SetVertexArray(VertexArray *vertexArray)
+{
+	m_Stats.calls++;
+	NullVertexArray *nullVertexArray = static_cast<NullVertexArray *>(vertexArray);
+	if(nullVertexArray == m_VertexArray)
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_VertexArray = nullVertexArray;
+}
+
+IndexBuffer *NullRenderDevice::CreateIndexBuffer(long long size, const void *data, BufferUsage usage, IndexFormat format)
+{
+	m_Stats.calls++;
+	if(!IsValidBuffer("INDEX_BUFFER", size, usage))
+		return nullptr;
+	if(format < 0 || format >= INDEXFORMAT_MAX)
+	{
+		Error("INDEX_BUFFER_INVALID_FORMAT");
+		return nullptr;
+	}
+	m_Stats.resourcesCreated++;
+	return new NullIndexBuffer(size, usage, format);
+}
+
+void NullRenderDevice::UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data)
+{
+	m_Stats.calls++;
+	UpdateBuffer("INDEX_BUFFER", indexBuffer ? &static_cast<NullIndexBuffer *>(indexBuffer)->storage : nullptr, offset, size, data);
+}
+
+void *NullRenderDevice::MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	m_Stats.calls++;
+	return MapBuffer("INDEX_BUFFER", indexBuffer ? &static_cast<NullIndexBuffer *>(indexBuffer)->storage : nullptr, offset, size, mapFlags);
+}
+
+void NullRenderDevice::UnmapIndexBuffer(IndexBuffer *indexBuffer)
+{
+	m_Stats.calls++;
+	UnmapBuffer("INDEX_BUFFER", indexBuffer ? &static_cast<NullIndexBuffer *>(indexBuffer)->storage : nullptr);
+}
+
+void NullRenderDevice::CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size)
+{
+	m_Stats.calls++;
+	CopyBuffer("INDEX_BUFFER", destination ? &static_cast<NullIndexBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &static_cast<NullIndexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void NullRenderDevice::DestroyIndexBuffer(IndexBuffer *indexBuffer)
+{
+	m_Stats.calls++;
+	if(!indexBuffer)
+		return;
+	if(indexBuffer == m_IndexBuffer)
+		m_IndexBuffer = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete indexBuffer;
+}
+
+void NullRenderDevice::SetIndexBuffer(IndexBuffer *indexBuffer)
+{
+	m_Stats.calls++;
+	NullIndexBuffer *nullIndexBuffer = static_cast<NullIndexBuffer *>(indexBuffer);
+	if(nullIndexBuffer == m_IndexBuffer)
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_IndexBuffer = nullIndexBuffer;
+}
+
+void NullRenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	m_Stats.calls++;
+	if(topology < 0 || topology >= PRIMITIVETOPOLOGY_MAX)
+		return Error("INVALID_PRIMITIVE_TOPOLOGY");
+	if(topology == m_Topology)
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_Topology = topology;
+}
+
+IndirectBuffer *NullRenderDevice::CreateIndirectBuffer(long long size, const void *data, BufferUsage usage)
+{
+	m_Stats.calls++;
+	if(!IsValidBuffer("INDIRECT_BUFFER", size, usage))
+		return nullptr;
+	m_Stats.resourcesCreated++;
+	return new NullIndirectBuffer(size, usage);
+}
+
+void NullRenderDevice::UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data)
+{
+	m_Stats.calls++;
+	UpdateBuffer("INDIRECT_BUFFER", indirectBuffer ? &static_cast<NullIndirectBuffer *>(indirectBuffer)->storage : nullptr, offset, size, data);
+}
+
+void NullRenderDevice::CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	m_Stats.calls++;
+	CopyBuffer("INDIRECT_BUFFER", destination ? &static_cast<NullIndirectBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &static_cast<NullVertexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void NullRenderDevice::DestroyIndirectBuffer(IndirectBuffer *indirectBuffer)
+{
+	m_Stats.calls++;
+	if(!indirectBuffer)
+		return;
+	m_Stats.resourcesDestroyed++;
+	delete indirectBuffer;
+}
+
+bool NullRenderDevice::IsValidTexture(const char *type, int width, int height, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	std::string prefix(type);
+	if(!IsTextureFormatSupported(format))
+	{
+		Error((prefix + "_UNSUPPORTED_FORMAT").c_str());
+		return false;
+	}
+	if(width <= 0 || height <= 0 || mipLevels < 0 || mipLevels > GetTextureMipLevels(width, height))
+	{
+		Error((prefix + "_INVALID_SIZE").c_str());
+		return false;
+	}
+	if(mipPolicy < 0 || mipPolicy >= MIPPOLICY_MAX)
+	{
+		Error((prefix + "_INVALID_MIP_POLICY").c_str());
+		return false;
+	}
+	return true;
+}
+
+Texture2D *NullRenderDevice::CreateTexture2D(int width, int height, const void *data, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	m_Stats.calls++;
+	if(!IsValidTexture("TEXTURE2D", width, height, format, mipLevels, mipPolicy))
+		return nullptr;
+
+	m_Stats.resourcesCreated++;
+	return new NullTexture2D(width, height, format, ResolveMipLevels(width, height, format, mipLevels, mipPolicy));
+}
+
+bool NullRenderDevice::IsTextureFormatSupported(TextureFormat format)
+{
+	// nothing is sampled, so every format is accepted
+	return format >= 0 && format < TEXTUREFORMAT_MAX;
+}
+
+void NullRenderDevice::UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async)
+{
+	m_Stats.calls++;
+	NullTexture2D *nullTexture2D = static_cast<NullTexture2D *>(texture2D);
+	if(!nullTexture2D || !data ||
+		!IsValidTextureRegion(nullTexture2D->width, nullTexture2D->height, nullTexture2D->format, nullTexture2D->mipLevels, mipLevel, x, y, width, height))
+		return Error("TEXTURE2D_INVALID_REGION");
+
+	m_Stats.textureUpdateBytes += GetTextureLevelSize(nullTexture2D->format, width, height);
+}
+
+void NullRenderDevice::DestroyTexture2D(Texture2D *texture2D)
+{
+	m_Stats.calls++;
+	if(!texture2D)
+		return;
+	for(auto &boundTexture2D : m_Texture2Ds)
+		if(boundTexture2D == texture2D)
+			boundTexture2D = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete texture2D;
+}
+
+void NullRenderDevice::SetTexture2D(unsigned int slot, Texture2D *texture2D)
+{
+	m_Stats.calls++;
+	if(slot >= m_Texture2Ds.size())
+		m_Texture2Ds.resize(slot + 1, nullptr);
+	NullTexture2D *nullTexture2D = static_cast<NullTexture2D *>(texture2D);
+	if(nullTexture2D == m_Texture2Ds[slot])
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_Texture2Ds[slot] = nullTexture2D;
+}
+
+Texture2DArray *NullRenderDevice::CreateTexture2DArray(int width, int height, int layers, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	m_Stats.calls++;
+	if(!IsValidTexture("TEXTURE2D_ARRAY", width, height, format, mipLevels, mipPolicy))
+		return nullptr;
+	if(layers <= 0 || layers > MAX_TEXTURE_LAYERS)
+	{
+		Error("TEXTURE2D_ARRAY_INVALID_LAYERS");
+		return nullptr;
+	}
+
+	int levels = ResolveMipLevels(width, height, format, mipLevels, mipPolicy);
+	m_Stats.resourcesCreated++;
+	return new NullTexture2DArray(width, height, layers, format, levels, mipLevels > 0 ? mipLevels : 1);
+}
+
+void NullRenderDevice::UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async)
+{
+	m_Stats.calls++;
+	NullTexture2DArray *nullTexture2DArray = static_cast<NullTexture2DArray *>(texture2DArray);
+	if(!nullTexture2DArray || !data || layer < 0 || layer >= nullTexture2DArray->layers)
+		return Error("TEXTURE2D_ARRAY_INVALID_LAYER");
+
+	m_Stats.textureUpdateBytes += GetTextureSize(nullTexture2DArray->format, nullTexture2DArray->width, nullTexture2DArray->height, nullTexture2DArray->suppliedLevels);
+}
+
+void NullRenderDevice::UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+	bool async)
+{
+	m_Stats.calls++;
+	NullTexture2DArray *nullTexture2DArray = static_cast<NullTexture2DArray *>(texture2DArray);
+	if(!nullTexture2DArray || !data || layer < 0 || layer >= nullTexture2DArray->layers ||
+		!IsValidTextureRegion(nullTexture2DArray->width, nullTexture2DArray->height, nullTexture2DArray->format, nullTexture2DArray->mipLevels, mipLevel, x, y, width, height))
+		return Error("TEXTURE2D_ARRAY_INVALID_REGION");
+
+	m_Stats.textureUpdateBytes += GetTextureLevelSize(nullTexture2DArray->format, width, height);
+}
+
+void NullRenderDevice::DestroyTexture2DArray(Texture2DArray *texture2DArray)
+{
+	m_Stats.calls++;
+	if(!texture2DArray)
+		return;
+	for(auto &boundTexture2DArray : m_Texture2DArrays)
+		if(boundTexture2DArray == texture2DArray)
+			boundTexture2DArray = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete texture2DArray;
+}
+
+void NullRenderDevice::SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray)
+{
+	m_Stats.calls++;
+	if(slot >= m_Texture2DArrays.size())
+		m_Texture2DArrays.resize(slot + 1, nullptr);
+	NullTexture2DArray *nullTexture2DArray = static_cast<NullTexture2DArray *>(texture2DArray);
+	if(nullTexture2DArray == m_Texture2DArrays[slot])
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_Texture2DArrays[slot] = nullTexture2DArray;
+}
+
+SamplerState *NullRenderDevice::CreateSamplerState(TextureFilter minFilter, TextureFilter magFilter, MipFilter mipFilter, TextureWrap wrapS, TextureWrap wrapT)
+{
+	m_Stats.calls++;
+	if(minFilter >= TEXTUREFILTER_MAX || magFilter >= TEXTUREFILTER_MAX || mipFilter >= MIPFILTER_MAX || wrapS >= TEXTUREWRAP_MAX || wrapT >= TEXTUREWRAP_MAX)
+	{
+		Error("SAMPLER_STATE_INVALID_DESCRIPTOR");
+		return nullptr;
+	}
+	m_Stats.resourcesCreated++;
+	return new NullSamplerState(minFilter, magFilter, mipFilter, wrapS, wrapT);
+}
+
+void NullRenderDevice::DestroySamplerState(SamplerState *samplerState)
+{
+	m_Stats.calls++;
+	if(!samplerState)
+		return;
+	for(auto &boundSamplerState : m_SamplerStates)
+		if(boundSamplerState == samplerState)
+			boundSamplerState = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete samplerState;
+}
+
+void NullRenderDevice::SetSamplerState(unsigned int slot, SamplerState *samplerState)
+{
+	m_Stats.calls++;
+	if(slot >= m_SamplerStates.size())
+		m_SamplerStates.resize(slot + 1, nullptr);
+	NullSamplerState *nullSamplerState = static_cast<NullSamplerState *>(samplerState);
+	if(nullSamplerState == m_SamplerStates[slot])
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_SamplerStates[slot] = nullSamplerState;
+}
+
+UniformBuffer *NullRenderDevice::CreateUniformBuffer(long long size, const void *data, BufferUsage usage)
+{
+	m_Stats.calls++;
+	if(size <= 0)
+	{
+		Error("UNIFORM_BUFFER_INVALID_SIZE");
+		return nullptr;
+	}
+	if(!IsValidBuffer("UNIFORM_BUFFER", size, usage))
+		return nullptr;
+	m_Stats.resourcesCreated++;
+	return new NullUniformBuffer(size, usage);
+}
+
+void NullRenderDevice::UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data)
+{
+	m_Stats.calls++;
+	UpdateBuffer("UNIFORM_BUFFER", uniformBuffer ? &static_cast<NullUniformBuffer *>(uniformBuffer)->storage : nullptr, offset, size, data);
+}
+
+void *NullRenderDevice::MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	m_Stats.calls++;
+	return MapBuffer("UNIFORM_BUFFER", uniformBuffer ? &static_cast<NullUniformBuffer *>(uniformBuffer)->storage : nullptr, offset, size, mapFlags);
+}
+
+void NullRenderDevice::UnmapUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	m_Stats.calls++;
+	UnmapBuffer("UNIFORM_BUFFER", uniformBuffer ? &static_cast<NullUniformBuffer *>(uniformBuffer)->storage : nullptr);
+}
+
+void NullRenderDevice::DestroyUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	m_Stats.calls++;
+	if(!uniformBuffer)
+		return;
+	for(auto &boundUniformBuffer : m_UniformBuffers)
+		if(boundUniformBuffer == uniformBuffer)
+			boundUniformBuffer = nullptr;
+	m_Stats.resourcesDestroyed++;
+	delete uniformBuffer;
+}
+
+void NullRenderDevice::SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer)
+{
+	m_Stats.calls++;
+	if(slot >= m_UniformBuffers.size())
+		m_UniformBuffers.resize(slot + 1, nullptr);
+	NullUniformBuffer *nullUniformBuffer = static_cast<NullUniformBuffer *>(uniformBuffer);
+	if(nullUniformBuffer == m_UniformBuffers[slot])
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_UniformBuffers[slot] = nullUniformBuffer;
+}
+
+long long NullRenderDevice::WriteUniformData(const void *data, long long size)
+{
+	m_Stats.calls++;
+	if(!data || size <= 0)
+	{
+		Error("UNIFORM_DATA_INVALID_SIZE");
+		return -1;
+	}
+
+	// the same alignment as the smallest GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT drivers commonly report
+	long long offset = m_UniformDataSize;
+	long long length = (size + 255) / 256 * 256;
+	if(offset + length > UNIFORM_DATA_FRAME_SIZE)
+	{
+		Error("UNIFORM_DATA_FRAME_TOO_LARGE");
+		return -1;
+	}
+
+	m_UniformDataSize += length;
+	m_Stats.uniformDataBytes += size;
+	return offset;
+}
+
+TransientVertices NullRenderDevice::WriteTransientVertices(const void *data, int count, int stride)
+{
+	m_Stats.calls++;
+	TransientVertices vertices = { nullptr, 0, 0 };
+	if(!data || count <= 0 || stride <= 0)
+	{
+		Error("TRANSIENT_VERTICES_INVALID_SIZE");
+		return vertices;
+	}
+
+	// aligned to the stride, as the OpenGL device does
+	long long offset = (m_TransientVertexSize + stride - 1) / stride * stride;
+	long long size = static_cast<long long>(count) * stride;
+	if(offset + size > TRANSIENT_VERTEX_FRAME_SIZE)
+	{
+		Error("TRANSIENT_VERTICES_FRAME_TOO_LARGE");
+		return vertices;
+	}
+
+	if(!m_TransientVertexBuffer)
+		m_TransientVertexBuffer = new NullVertexBuffer(TRANSIENT_VERTEX_FRAME_SIZE, BUFFERUSAGE_STREAM);
+	m_TransientVertexSize = offset + size;
+	m_Stats.transientBytes += size;
+
+	vertices.vertexBuffer = m_TransientVertexBuffer;
+	vertices.offset = offset;
+	vertices.firstVertex = static_cast<int>(offset / stride);
+	return vertices;
+}
+
+TransientIndices NullRenderDevice::WriteTransientIndices(const unsigned int *indices, int count, int baseVertex)
+{
+	m_Stats.calls++;
+	TransientIndices transientIndices = { nullptr, 0 };
+	if(!indices || count <= 0)
+	{
+		Error("TRANSIENT_INDICES_INVALID_SIZE");
+		return transientIndices;
+	}
+
+	long long offset = m_TransientIndexSize;
+	if(offset + count * 4ll > TRANSIENT_INDEX_FRAME_SIZE)
+	{
+		Error("TRANSIENT_INDICES_FRAME_TOO_LARGE");
+		return transientIndices;
+	}
+
+	if(!m_TransientIndexBuffer)
+		m_TransientIndexBuffer = new NullIndexBuffer(TRANSIENT_INDEX_FRAME_SIZE, BUFFERUSAGE_STREAM, INDEXFORMAT_32);
+	m_TransientIndexSize = offset + count * 4ll;
+	m_Stats.transientBytes += count * 4ll;
+
+	transientIndices.indexBuffer = m_TransientIndexBuffer;
+	transientIndices.offset = offset;
+	return transientIndices;
+}
+
+void NullRenderDevice::SetUniformData(unsigned int slot, long long offset, long long size)
+{
+	m_Stats.calls++;
+	if(offset < 0 || size <= 0 || offset + size > m_UniformDataSize)
+		return Error("UNIFORM_DATA_INVALID_RANGE");
+	if(slot >= m_UniformBuffers.size())
+		m_UniformBuffers.resize(slot + 1, nullptr);
+	m_UniformBuffers[slot] = nullptr;
+	m_Stats.stateChanges++;
+}
+
+RasterState *NullRenderDevice::CreateRasterState(bool cullEnabled, Winding frontFace, Face cullFace, RasterMode rasterMode)
+{
+	m_Stats.calls++;
+	m_Stats.resourcesCreated++;
+	return new NullRasterState(cullEnabled, frontFace, cullFace, rasterMode);
+}
+
+void NullRenderDevice::DestroyRasterState(RasterState *rasterState)
+{
+	m_Stats.calls++;
+	if(!rasterState)
+		return;
+	if(rasterState == m_RasterState)
+		m_RasterState = m_DefaultRasterState;
+	m_Stats.resourcesDestroyed++;
+	delete rasterState;
+}
+
+void NullRenderDevice::SetRasterState(RasterState *rasterState)
+{
+	m_Stats.calls++;
+	NullRasterState *nullRasterState = rasterState ? static_cast<NullRasterState *>(rasterState) : m_DefaultRasterState;
+	if(nullRasterState == m_RasterState)
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_RasterState = nullRasterState;
+}
+
+DepthStencilState *NullRenderDevice::CreateDepthStencilState(bool depthEnabled, bool depthWriteEnabled, float depthNear, float depthFar, Compare depthCompare,
+		bool frontFaceStencilEnabled, Compare frontFaceStencilCompare, StencilAction frontFaceStencilFail, StencilAction frontFaceStencilPass,
+		StencilAction frontFaceDepthFail, int frontFaceRef, unsigned int frontFaceReadMask, unsigned int frontFaceWriteMask, bool backFaceStencilEnabled,
+		Compare backFaceStencilCompare, StencilAction backFaceStencilFail, StencilAction backFaceStencilPass, StencilAction backFaceDepthFail,
+		int backFaceRef, unsigned int backFaceReadMask, unsigned int backFaceWriteMask)
+{
+	m_Stats.calls++;
+	m_Stats.resourcesCreated++;
+	return new NullDepthStencilState(depthEnabled, depthWriteEnabled, depthCompare, frontFaceStencilEnabled || backFaceStencilEnabled);
+}
+
+void NullRenderDevice::DestroyDepthStencilState(DepthStencilState *depthStencilState)
+{
+	m_Stats.calls++;
+	if(!depthStencilState)
+		return;
+	if(depthStencilState == m_DepthStencilState)
+		m_DepthStencilState = m_DefaultDepthStencilState;
+	m_Stats.resourcesDestroyed++;
+	delete depthStencilState;
+}
+
+void NullRenderDevice::SetDepthStencilState(DepthStencilState *depthStencilState)
+{
+	m_Stats.calls++;
+	NullDepthStencilState *nullDepthStencilState = depthStencilState ? static_cast<NullDepthStencilState *>(depthStencilState) : m_DefaultDepthStencilState;
+	if(nullDepthStencilState == m_DepthStencilState)
+	{
+		m_Stats.redundantStateChanges++;
+		return;
+	}
+	m_Stats.stateChanges++;
+	m_DepthStencilState = nullDepthStencilState;
+}
+
+void NullRenderDevice::Clear(float red, float green, float blue, float alpha, float depth, int stencil)
+{
+	m_Stats.calls++;
+	m_Stats.clears++;
+}
+
+void NullRenderDevice::DrawTriangles(int offset, int count)
+{
+	m_Stats.calls++;
+	DrawArrays(offset, count, 1);
+}
+
+void NullRenderDevice::DrawTrianglesIndexed32(long long offset, int count, int baseVertex)
+{
+	m_Stats.calls++;
+	DrawIndexed(INDEXFORMAT_32, offset, count, 1);
+}
+
+void NullRenderDevice::DrawTrianglesIndexed16(long long offset, int count, int baseVertex)
+{
+	m_Stats.calls++;
+	DrawIndexed(INDEXFORMAT_16, offset, count, 1);
+}
+
+void NullRenderDevice::DrawTrianglesInstanced(int offset, int count, int instanceCount)
+{
+	m_Stats.calls++;
+	DrawArrays(offset, count, instanceCount);
+}
+
+void NullRenderDevice::DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	m_Stats.calls++;
+	DrawIndexed(INDEXFORMAT_32, offset, count, instanceCount);
+}
+
+void NullRenderDevice::DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	m_Stats.calls++;
+	DrawIndexed(INDEXFORMAT_16, offset, count, instanceCount);
+}
+
+void NullRenderDevice::DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts)
+{
+	m_Stats.calls++;
+	if(drawCount < 0 || (drawCount && (!offsets || !counts)))
+		return Error("DRAW_INVALID_MULTI_DRAW");
+	m_Stats.multiDrawCalls++;
+	for(int i = 0; i < drawCount; i++)
+		DrawArrays(offsets[i], counts[i], 1);
+}
+
+void NullRenderDevice::DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices, IndexFormat format)
+{
+	m_Stats.calls++;
+	if(drawCount < 0 || (drawCount && (!offsets || !counts)))
+		return Error("DRAW_INVALID_MULTI_DRAW");
+	m_Stats.multiDrawCalls++;
+	for(int i = 0; i < drawCount; i++)
+		DrawIndexed(format, offsets[i], counts[i], 1);
+}
+
+void NullRenderDevice::DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount, IndexFormat format)
+{
+	m_Stats.calls++;
+	NullIndirectBuffer *nullIndirectBuffer = static_cast<NullIndirectBuffer *>(indirectBuffer);
+	if(!nullIndirectBuffer)
+		return Error("DRAW_WITHOUT_INDIRECT_BUFFER");
+	if(offset < 0 || drawCount < 0 || offset + drawCount * static_cast<long long>(sizeof(DrawIndexedIndirectCommand)) > nullIndirectBuffer->storage.size)
+		return Error("DRAW_INDIRECT_BUFFER_OVERRUN");
+	if(offset % 4)
+		return Error("DRAW_MISALIGNED_INDIRECT_OFFSET");
+	m_Stats.indirectDrawCalls++;
+
+	// the arguments are never read, so each draw is validated against the bound state only
+	for(int i = 0; i < drawCount; i++)
+		DrawIndexed(format, 0, 0, 0);
+}
+
+void NullRenderDevice::DrawArrays(int offset, int count, int instanceCount)
+{
+	if(!m_Pipeline)
+		return Error("DRAW_WITHOUT_PIPELINE");
+	if(!m_VertexArray)
+		return Error("DRAW_WITHOUT_VERTEX_ARRAY");
+	if(offset < 0 || count < 0)
+		return Error("DRAW_INVALID_RANGE");
+	if(instanceCount < 0)
+		return Error("DRAW_INVALID_INSTANCE_COUNT");
+	if(IsVertexArrayMapped())
+		return Error("DRAW_WITH_MAPPED_VERTEX_BUFFER");
+
+	m_Stats.drawCalls++;
+	m_Stats.instances += instanceCount;
+	CountPrimitives(count, instanceCount);
+}
+
+void NullRenderDevice::DrawIndexed(IndexFormat format, long long offset, int count, int instanceCount)
+{
+	if(!m_Pipeline)
+		return Error("DRAW_WITHOUT_PIPELINE");
+	if(!m_VertexArray)
+		return Error("DRAW_WITHOUT_VERTEX_ARRAY");
+	if(!m_IndexBuffer)
+		return Error("DRAW_WITHOUT_INDEX_BUFFER");
+	if(m_IndexBuffer->format != format)
+		return Error("DRAW_INDEX_FORMAT_MISMATCH");
+	if(offset < 0 || count < 0 || offset + count * static_cast<long long>(GetIndexSize(format)) > m_IndexBuffer->storage.size)
+		return Error("DRAW_INDEX_BUFFER_OVERRUN");
+	if(offset % GetIndexSize(format))
+		return Error("DRAW_MISALIGNED_INDEX_OFFSET");
+	if(instanceCount < 0)
+		return Error("DRAW_INVALID_INSTANCE_COUNT");
+	if(m_IndexBuffer->storage.mapped)
+		return Error("DRAW_WITH_MAPPED_INDEX_BUFFER");
+	if(IsVertexArrayMapped())
+		return Error("DRAW_WITH_MAPPED_VERTEX_BUFFER");
+
+	m_Stats.drawCalls++;
+	m_Stats.instances += instanceCount;
+	CountPrimitives(count, instanceCount);
+}
+
+void NullRenderDevice::CountPrimitives(int count, int instanceCount)
+{
+	unsigned long long instances = static_cast<unsigned long long>(instanceCount);
+	switch(m_Topology)
+	{
+	case PRIMITIVETOPOLOGY_TRIANGLE_LIST:
+		m_Stats.triangles += static_cast<unsigned long long>(count / 3) * instances;
+		break;
+	case PRIMITIVETOPOLOGY_TRIANGLE_STRIP:
+		m_Stats.triangles += static_cast<unsigned long long>(std::max(count - 2, 0)) * instances;
+		break;
+	case PRIMITIVETOPOLOGY_LINE_LIST:
+		m_Stats.lines += static_cast<unsigned long long>(count / 2) * instances;
+		break;
+	case PRIMITIVETOPOLOGY_LINE_STRIP:
+		m_Stats.lines += static_cast<unsigned long long>(std::max(count - 1, 0)) * instances;
+		break;
+	default:
+		m_Stats.points += static_cast<unsigned long long>(count) * instances;
+		break;
+	}
+}
+
+bool NullRenderDevice::IsVertexArrayMapped() const
+{
+	for(const NullVertexBuffer *vertexBuffer : m_VertexArray->vertexBuffers)
+		if(vertexBuffer && vertexBuffer->storage.mapped)
+			return true;
+	return false;
+}
+
+void NullRenderDevice::SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists)
+{
+	m_Stats.calls++;
+	for(unsigned int i = 0; i < numCommandLists; i++)
+		ExecuteCommandList(*commandLists[i], *this);
+}
+
+void NullRenderDevice::EndFrame()
+{
+	m_Stats.calls++;
+	m_Stats.frames++;
+	m_UniformDataSize = 0;
+	m_TransientVertexSize = 0;
+	m_TransientIndexSize = 0;
+	if(m_GpuScopeDepth)
+	{
+		Error("GPU_SCOPE_NOT_ENDED");
+		m_GpuScopeDepth = 0;
+	}
+}
+
+void NullRenderDevice::BeginGpuScope(const char *name)
+{
+	m_Stats.calls++;
+	if(!name)
+		return Error("GPU_SCOPE_WITHOUT_NAME");
+
+	m_Stats.gpuScopes++;
+	m_GpuScopeDepth++;
+}
+
+void NullRenderDevice::EndGpuScope()
+{
+	m_Stats.calls++;
+	if(!m_GpuScopeDepth)
+		return Error("GPU_SCOPE_END_WITHOUT_BEGIN");
+
+	m_GpuScopeDepth--;
+}
+
+unsigned int NullRenderDevice::GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats)
+{
+	return 0;
+}
+
+void NullRenderDevice::ResetGpuScopeStats()
+{
+}
+
+} // end namespace render
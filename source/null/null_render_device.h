@@ -0,0 +1,305 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <vector>
+
+namespace render
+{
+
+class NullPipeline;
+class NullBuffer;
+class NullVertexBuffer;
+class NullVertexArray;
+class NullIndexBuffer;
+class NullIndirectBuffer;
+class NullTexture2D;
+class NullTexture2DArray;
+class NullUniformBuffer;
+class NullSamplerState;
+class NullRasterState;
+class NullDepthStencilState;
+
+// Counters gathered by the NullRenderDevice as calls are made
+struct NullRenderDeviceStats
+{
+	unsigned long long calls = 0; // total number of RenderDevice calls
+	unsigned long long resourcesCreated = 0;
+	unsigned long long resourcesDestroyed = 0;
+	unsigned long long stateChanges = 0; // Set* calls that changed the bound state
+	unsigned long long redundantStateChanges = 0; // Set* calls that did not change the bound state
+	unsigned long long paramUpdates = 0;
+	unsigned long long uniformDataBytes = 0; // written with WriteUniformData
+	unsigned long long transientBytes = 0; // written with WriteTransientVertices and WriteTransientIndices
+	unsigned long long bufferUpdateBytes = 0; // written with Update*Buffer and Map*Buffer
+	unsigned long long bufferCopyBytes = 0; // copied with Copy*Buffer
+	unsigned long long textureUpdateBytes = 0; // written with UpdateTexture2D, UploadTexture2DArrayLayer and UpdateTexture2DArray
+	unsigned long long clears = 0;
+	unsigned long long frames = 0; // EndFrame calls
+	unsigned long long gpuScopes = 0; // BeginGpuScope calls
+	unsigned long long drawCalls = 0;
+	unsigned long long multiDrawCalls = 0; // Draw*Multi calls, each of whose draws is also counted in drawCalls
+	unsigned long long indirectDrawCalls = 0; // DrawTrianglesIndexedIndirect calls, whose draws are counted in drawCalls but not in instances or triangles
+	unsigned long long instances = 0; // drawn by every draw call, 1 for each draw that is not instanced
+	unsigned long long triangles = 0; // strips are counted as if they never restarted
+	unsigned long long lines = 0;
+	unsigned long long points = 0;
+	unsigned long long errors = 0; // invalid calls, such as drawing without a pipeline
+};
+
+// A RenderDevice that performs all of the bookkeeping of a real device (resource
+// tracking, bound state, validation) without issuing any graphics API calls.
+// Useful for measuring the CPU cost of submission code on its own.
+class NullRenderDevice final : public RenderDevice
+{
+public:
+
+	NullRenderDevice();
+
+	~NullRenderDevice() override;
+
+	VertexShader *CreateVertexShader(const char *code) override;
+
+	void DestroyVertexShader(VertexShader *vertexShader) override;
+
+	PixelShader *CreatePixelShader(const char *code) override;
+
+	void DestroyPixelShader(PixelShader *pixelShader) override;
+
+	Pipeline *CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader) override;
+
+	void DestroyPipeline(Pipeline *pipeline) override;
+
+	void SetPipeline(Pipeline *pipeline) override;
+
+	VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data) override;
+
+	// Mapped memory is scratch that is never read, so the contents of a buffer are not kept
+	void *MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	void CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	VertexDescription *CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements) override;
+
+	void DestroyVertexDescription(VertexDescription *vertexDescription) override;
+
+	VertexArray *CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions) override;
+
+	void DestroyVertexArray(VertexArray *vertexArray) override;
+
+	void SetVertexArray(VertexArray *vertexArray) override;
+
+	IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC, IndexFormat format = INDEXFORMAT_32) override;
+
+	void UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void SetIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+
+	IndirectBuffer *CreateIndirectBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data) override;
+
+	void CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndirectBuffer(IndirectBuffer *indirectBuffer) override;
+
+	Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	bool IsTextureFormatSupported(TextureFormat format) override;
+
+	void UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async = false) override;
+
+	void DestroyTexture2D(Texture2D *texture2D) override;
+
+	void SetTexture2D(unsigned int slot, Texture2D *texture2D) override;
+
+	Texture2DArray *CreateTexture2DArray(int width, int height, int layers, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	void UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async = false) override;
+
+	void UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+		bool async = false) override;
+
+	void DestroyTexture2DArray(Texture2DArray *texture2DArray) override;
+
+	void SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray) override;
+
+	SamplerState *CreateSamplerState(TextureFilter minFilter = TEXTUREFILTER_LINEAR, TextureFilter magFilter = TEXTUREFILTER_LINEAR,
+		MipFilter mipFilter = MIPFILTER_LINEAR, TextureWrap wrapS = TEXTUREWRAP_CLAMP_TO_EDGE, TextureWrap wrapT = TEXTUREWRAP_CLAMP_TO_EDGE) override;
+
+	void DestroySamplerState(SamplerState *samplerState) override;
+
+	void SetSamplerState(unsigned int slot, SamplerState *samplerState) override;
+
+	UniformBuffer *CreateUniformBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void DestroyUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer) override;
+
+	// Offsets are handed out as the OpenGL device would, but nothing is stored
+	long long WriteUniformData(const void *data, long long size) override;
+
+	void SetUniformData(unsigned int slot, long long offset, long long size) override;
+
+	// Offsets are handed out from the start of the frame, but nothing is stored
+	TransientVertices WriteTransientVertices(const void *data, int count, int stride) override;
+
+	TransientIndices WriteTransientIndices(const unsigned int *indices, int count, int baseVertex = 0) override;
+
+	RasterState *CreateRasterState(bool cullEnabled = true, Winding frontFace = WINDING_CCW, Face cullFace = FACE_BACK, RasterMode rasterMode = RASTERMODE_FILL) override;
+
+	void DestroyRasterState(RasterState *rasterState) override;
+
+	void SetRasterState(RasterState *rasterState) override;
+
+	DepthStencilState *CreateDepthStencilState(bool depthEnabled = true,
+		bool			depthWriteEnabled = true,
+		float			depthNear = 0,
+		float			depthFar = 1,
+		Compare			depthCompare = COMPARE_LESS,
+
+		bool			frontFaceStencilEnabled = false,
+		Compare			frontFaceStencilCompare = COMPARE_ALWAYS,
+		StencilAction	frontFaceStencilFail = STENCIL_KEEP,
+		StencilAction	frontFaceStencilPass = STENCIL_KEEP,
+		StencilAction	frontFaceDepthFail = STENCIL_KEEP,
+		int				frontFaceRef = 0,
+		unsigned int	frontFaceReadMask = 0xFFFFFFFF,
+		unsigned int	frontFaceWriteMask = 0xFFFFFFFF,
+
+		bool			backFaceStencilEnabled = false,
+		Compare			backFaceStencilCompare = COMPARE_ALWAYS,
+		StencilAction	backFaceStencilFail = STENCIL_KEEP,
+		StencilAction	backFaceStencilPass = STENCIL_KEEP,
+		StencilAction	backFaceDepthFail = STENCIL_KEEP,
+		int				backFaceRef = 0,
+		unsigned int	backFaceReadMask = 0xFFFFFFFF,
+		unsigned int	backFaceWriteMask = 0xFFFFFFFF) override;
+
+	void DestroyDepthStencilState(DepthStencilState *depthStencilState) override;
+
+	void SetDepthStencilState(DepthStencilState *depthStencilState) override;
+
+	void Clear(float red = 0.0f, float green = 0.0f, float blue = 0.0f, float alpha = 1.0f, float depth = 1.0f, int stencil = 0) override;
+
+	void DrawTriangles(int offset, int count) override;
+
+	void DrawTrianglesIndexed32(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesInstanced(int offset, int count, int instanceCount) override;
+
+	void DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts) override;
+
+	void DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices = nullptr,
+		IndexFormat format = INDEXFORMAT_32) override;
+
+	void DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount = 1, IndexFormat format = INDEXFORMAT_32) override;
+
+	void SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists) override;
+
+	void EndFrame() override;
+
+	// Scopes are validated for nesting, but nothing is timed
+	void BeginGpuScope(const char *name) override;
+
+	void EndGpuScope() override;
+
+	unsigned int GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats) override;
+
+	void ResetGpuScopeStats() override;
+
+	// Counters accumulated since the device was created
+	const NullRenderDeviceStats &GetStats() const { return m_Stats; }
+
+private:
+
+	// Report an invalid call
+	void Error(const char *message);
+
+	// Returns whether a texture of the given size, format and levels can be created, reporting
+	// an error prefixed with type if not
+	bool IsValidTexture(const char *type, int width, int height, TextureFormat format, int mipLevels, MipPolicy mipPolicy);
+
+	// Returns whether a buffer of size bytes with usage can be created, reporting an error
+	// prefixed with type if not
+	bool IsValidBuffer(const char *type, long long size, BufferUsage usage);
+
+	// Update, map, unmap or copy between vertex, index or uniform buffers, reporting errors prefixed with type
+	void UpdateBuffer(const char *type, NullBuffer *buffer, long long offset, long long size, const void *data);
+	void *MapBuffer(const char *type, NullBuffer *buffer, long long offset, long long size, unsigned int mapFlags);
+	void UnmapBuffer(const char *type, NullBuffer *buffer);
+	void CopyBuffer(const char *type, NullBuffer *destination, long long destinationOffset, NullBuffer *source, long long sourceOffset, long long size);
+
+	// Validate and count a draw of instanceCount instances of count vertices from offset
+	void DrawArrays(int offset, int count, int instanceCount);
+
+	// Validate and count a draw of instanceCount instances of count indices of format at offset bytes
+	// into the bound index buffer
+	void DrawIndexed(IndexFormat format, long long offset, int count, int instanceCount);
+
+	// Count the primitives of instanceCount instances of count vertices of the bound topology
+	void CountPrimitives(int count, int instanceCount);
+
+	// Returns whether a vertex buffer of the bound vertex array is mapped
+	bool IsVertexArrayMapped() const;
+
+	NullRenderDeviceStats m_Stats;
+
+	unsigned int m_GpuScopeDepth = 0;
+
+	NullPipeline *m_Pipeline = nullptr;
+	NullVertexArray *m_VertexArray = nullptr;
+	NullIndexBuffer *m_IndexBuffer = nullptr;
+	PrimitiveTopology m_Topology = PRIMITIVETOPOLOGY_TRIANGLE_LIST;
+	std::vector<NullTexture2D *> m_Texture2Ds;
+	std::vector<NullTexture2DArray *> m_Texture2DArrays;
+	std::vector<NullSamplerState *> m_SamplerStates;
+	std::vector<NullUniformBuffer *> m_UniformBuffers;
+
+	long long m_UniformDataSize = 0; // written this frame, aligned
+
+	// handed out by WriteTransientVertices and WriteTransientIndices, created on first use
+	NullVertexBuffer *m_TransientVertexBuffer = nullptr;
+	NullIndexBuffer *m_TransientIndexBuffer = nullptr;
+	long long m_TransientVertexSize = 0; // written this frame, aligned
+	long long m_TransientIndexSize = 0;
+
+	NullRasterState *m_RasterState = nullptr;
+	NullRasterState *m_DefaultRasterState = nullptr;
+
+	NullDepthStencilState *m_DepthStencilState = nullptr;
+	NullDepthStencilState *m_DefaultDepthStencilState = nullptr;
+};
+
+} // end namespace render
@@ -1,14 +1,57 @@
 #include "ogl_render_device.h"
 
+#include "command_list_commands.h"
+#include "mip_generator.h"
+#include "thread_pool.h"
+
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <string>
-#include <map>
+
+// persistently mapped buffers need OpenGL 4.4 or GL_ARB_buffer_storage, which older headers may lack
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+#define OPENGL_BUFFER_STORAGE 1
+#else
+#define OPENGL_BUFFER_STORAGE 0
+#endif
+
+// compressed formats that are extensions to OpenGL 4.1, and so may be missing from its headers
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
 
 namespace render
 {
 
+// GL internal format of each TextureFormat
+static const GLenum textureInternalFormats[TEXTUREFORMAT_MAX] = {
+	GL_RGB,
+	GL_RGBA8,
+	GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+	GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+	GL_COMPRESSED_RED_RGTC1,
+	GL_COMPRESSED_RG_RGTC2,
+	GL_COMPRESSED_RGBA_BPTC_UNORM,
+	GL_COMPRESSED_RGB8_ETC2,
+	GL_COMPRESSED_RGBA8_ETC2_EAC
+};
+
 class OpenGLVertexShader : public VertexShader
 {
 public:
@@ -70,13 +113,92 @@ public:
 	int fragmentShader = 0;
 };
 
-class OpenGLPipelineParam;
+class OpenGLPipeline;
+
+class OpenGLPipelineParam : public PipelineParam
+{
+public:
+
+	OpenGLPipelineParam(OpenGLPipeline *_pipeline, unsigned int _uniform, unsigned int _element) : pipeline(_pipeline), uniform(_uniform), element(_element) {}
+
+	void SetAsInt(int value) override
+	{
+		Set("SetAsInt", GL_INT, &value, 1);
+	}
+
+	void SetAsFloat(float value) override
+	{
+		Set("SetAsFloat", GL_FLOAT, &value, 1);
+	}
+
+	void SetAsMat4(const float *value) override
+	{
+		Set("SetAsMat4", GL_FLOAT_MAT4, value, 1);
+	}
+
+	void SetAsIntArray(int count, const int *values) override
+	{
+		if(count > 0)
+			Set("SetAsIntArray", GL_INT, values, count);
+	}
+
+	void SetAsFloatArray(int count, const float *values) override
+	{
+		if(count > 0)
+			Set("SetAsFloatArray", GL_FLOAT, values, count);
+	}
+
+	void SetAsMat4Array(int count, const float *values) override
+	{
+		if(count > 0)
+			Set("SetAsMat4Array", GL_FLOAT_MAT4, values, count);
+	}
+
+	// Pass count elements of values of type GL_INT, GL_FLOAT, or GL_FLOAT_MAT4 to the pipeline,
+	// printing an error instead if the uniform is of another type or has fewer elements left
+	void Set(const char *setter, GLenum type, const void *values, int count);
+
+	OpenGLPipeline *pipeline;
+	unsigned int uniform;
+	unsigned int element; // first array element set, for names such as "bones[4]"
+};
 
 class OpenGLPipeline : public Pipeline
 {
 public:
 
-	OpenGLPipeline(OpenGLVertexShader *vertexShader, OpenGLPixelShader *pixelShader)
+	// How a uniform's values are passed to GL
+	enum UniformKind
+	{
+		UNIFORM_FLOAT = 0,
+		UNIFORM_INT,
+		UNIFORM_UINT,
+		UNIFORM_MAT2,
+		UNIFORM_MAT3,
+		UNIFORM_MAT4
+	};
+
+	// An active uniform and where its values are kept in uniformData
+	struct Uniform
+	{
+		GLint location;
+		UniformKind kind;
+		unsigned int components; // 4-byte words per array element
+		unsigned int count; // array elements
+		unsigned int offset; // in words
+		unsigned int dirtyWords; // words from the start of the uniform changed since the last flush
+		unsigned int firstParam; // params of the uniform's elements are in params from here on
+	};
+
+	// An entry of the name table, for a name kept in uniformNames
+	struct UniformName
+	{
+		unsigned int begin;
+		unsigned int length;
+		unsigned int uniform;
+	};
+
+	OpenGLPipeline(OpenGLStateCache &_state, OpenGLVertexShader *vertexShader, OpenGLPixelShader *pixelShader) : state(_state)
 	{
 		// link shaders
 		shaderProgram = glCreateProgram();
@@ -92,98 +214,389 @@ public:
 		{
 			glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
 			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+			return;
 		}
+
+		AddUniforms();
+	}
+
+	~OpenGLPipeline() override;
+
+	PipelineParam *GetParam(const char *name) override
+	{
+		return ResolveParam(GetParamHandle(name));
+	}
+
+	ParamHandle GetParamHandle(const char *name) override;
+
+	PipelineParam *ResolveParam(ParamHandle handle) override
+	{
+		return handle >= 0 && handle < static_cast<ParamHandle>(params.size()) ? &params[handle] : nullptr;
 	}
 
-	~OpenGLPipeline() override
+	bool SetUniformBlockSlot(const char *name, unsigned int slot) override
 	{
-		glDeleteProgram(shaderProgram);
+		GLuint index = glGetUniformBlockIndex(shaderProgram, name);
+		if(index == GL_INVALID_INDEX)
+			return false;
+		glUniformBlockBinding(shaderProgram, index, slot);
+		return true;
 	}
 
-	PipelineParam *GetParam(const char *name) override;
+	// Copy words of values into element onwards of uniform index, marking them dirty if they changed
+	void SetUniform(unsigned int index, unsigned int element, const void *values, unsigned int words);
+
+	// Upload the uniforms changed since the last flush; the program must be bound
+	void FlushUniforms();
 
-	int shaderProgram = 0;
+	OpenGLStateCache &state;
 
-	std::map<std::string, OpenGLPipelineParam *> paramsByName;
+	GLuint shaderProgram = 0;
+
+	// CPU copy of every uniform, which GL only sees at the next draw with this pipeline
+	std::vector<Uniform> uniforms;
+	std::vector<uint32_t> uniformData; // zero, like GL's own uniforms after linking
+	std::vector<unsigned int> dirtyUniforms;
+
+	// a param for every element of every uniform, so a handle is simply an index
+	std::vector<OpenGLPipelineParam> params;
+
+	// uniform names, array names without their [0], sorted so they are found without allocating
+	std::vector<char> uniformNames;
+	std::vector<UniformName> uniformsByName;
+
+private:
+
+	// Build uniforms, params and the name table from the program's active uniforms
+	void AddUniforms();
+
+	// Returns the index of the uniform whose name is the first length characters of name, or -1
+	int FindUniform(const char *name, size_t length) const;
 };
 
-class OpenGLPipelineParam : public PipelineParam
+OpenGLPipeline::~OpenGLPipeline()
 {
-public:
+	state.DeleteProgram(shaderProgram);
+}
 
-	OpenGLPipelineParam(OpenGLPipeline *_pipeline, int _location) : pipeline(_pipeline), location(_location) {}
+void OpenGLPipelineParam::Set(const char *setter, GLenum type, const void *values, int count)
+{
+	// GL only takes a value of the uniform's own type; ints also set bools and samplers
+	const OpenGLPipeline::Uniform &target = pipeline->uniforms[uniform];
+	bool matches = type == GL_FLOAT_MAT4 ? target.kind == OpenGLPipeline::UNIFORM_MAT4 :
+		target.components == 1 && target.kind == (type == GL_INT ? OpenGLPipeline::UNIFORM_INT : OpenGLPipeline::UNIFORM_FLOAT);
+	if(!matches)
+	{
+		std::cout << "ERROR::PIPELINEPARAM::TYPE_MISMATCH\n" << setter << " on the uniform at location " << target.location << ", of "
+			<< target.components << " words per element" << std::endl;
+		return;
+	}
+	if(static_cast<unsigned int>(count) > target.count - element)
+	{
+		std::cout << "ERROR::PIPELINEPARAM::ARRAY_OVERRUN\n" << setter << " of " << count << " elements from element " << element << " of "
+			<< target.count << std::endl;
+		return;
+	}
 
-	void SetAsInt(int value) override
+	pipeline->SetUniform(uniform, element, values, count * target.components);
+}
+
+// Orders names as memcmp would order them padded with zeros
+static bool NameLess(const char *a, size_t aLength, const char *b, size_t bLength)
+{
+	int order = memcmp(a, b, std::min(aLength, bLength));
+	return order < 0 || (order == 0 && aLength < bLength);
+}
+
+void OpenGLPipeline::AddUniforms()
+{
+	GLint numUniforms = 0, maxNameLength = 0;
+	glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<char> name(maxNameLength + 1);
+	unsigned int offset = 0;
+
+	for(GLint i = 0; i < numUniforms; i++)
 	{
-		glUseProgram(pipeline->shaderProgram);
-		glUniform1i(location, value);
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(shaderProgram, i, static_cast<GLsizei>(name.size()), nullptr, &size, &type, &name[0]);
+
+		// uniforms in blocks have no location and are not set through params
+		Uniform uniform;
+		uniform.location = glGetUniformLocation(shaderProgram, &name[0]);
+		if(uniform.location < 0)
+			continue;
+
+		switch(type)
+		{
+		case GL_FLOAT: uniform.kind = UNIFORM_FLOAT; uniform.components = 1; break;
+		case GL_FLOAT_VEC2: uniform.kind = UNIFORM_FLOAT; uniform.components = 2; break;
+		case GL_FLOAT_VEC3: uniform.kind = UNIFORM_FLOAT; uniform.components = 3; break;
+		case GL_FLOAT_VEC4: uniform.kind = UNIFORM_FLOAT; uniform.components = 4; break;
+		case GL_INT: case GL_BOOL: uniform.kind = UNIFORM_INT; uniform.components = 1; break;
+		case GL_INT_VEC2: case GL_BOOL_VEC2: uniform.kind = UNIFORM_INT; uniform.components = 2; break;
+		case GL_INT_VEC3: case GL_BOOL_VEC3: uniform.kind = UNIFORM_INT; uniform.components = 3; break;
+		case GL_INT_VEC4: case GL_BOOL_VEC4: uniform.kind = UNIFORM_INT; uniform.components = 4; break;
+		case GL_UNSIGNED_INT: uniform.kind = UNIFORM_UINT; uniform.components = 1; break;
+		case GL_UNSIGNED_INT_VEC2: uniform.kind = UNIFORM_UINT; uniform.components = 2; break;
+		case GL_UNSIGNED_INT_VEC3: uniform.kind = UNIFORM_UINT; uniform.components = 3; break;
+		case GL_UNSIGNED_INT_VEC4: uniform.kind = UNIFORM_UINT; uniform.components = 4; break;
+		case GL_FLOAT_MAT2: uniform.kind = UNIFORM_MAT2; uniform.components = 4; break;
+		case GL_FLOAT_MAT3: uniform.kind = UNIFORM_MAT3; uniform.components = 9; break;
+		case GL_FLOAT_MAT4: uniform.kind = UNIFORM_MAT4; uniform.components = 16; break;
+
+		// samplers are set with SetAsInt
+		case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D:
+		case GL_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+			uniform.kind = UNIFORM_INT;
+			uniform.components = 1;
+			break;
+
+		default:
+			continue; // types that no param setter can produce, such as doubles
+		}
+
+		uniform.count = static_cast<unsigned int>(size);
+		uniform.offset = offset;
+		uniform.dirtyWords = 0;
+		uniform.firstParam = static_cast<unsigned int>(params.size());
+		offset += uniform.count * uniform.components;
+		for(unsigned int element = 0; element < uniform.count; element++)
+			params.push_back(OpenGLPipelineParam(this, static_cast<unsigned int>(uniforms.size()), element));
+
+		// arrays are reported as "name[0]"; params refer to them by their plain name
+		size_t length = strlen(&name[0]);
+		if(length > 3 && strcmp(&name[length - 3], "[0]") == 0)
+			length -= 3;
+
+		UniformName uniformName;
+		uniformName.begin = static_cast<unsigned int>(uniformNames.size());
+		uniformName.length = static_cast<unsigned int>(length);
+		uniformName.uniform = static_cast<unsigned int>(uniforms.size());
+		uniformNames.insert(uniformNames.end(), &name[0], &name[length]);
+		uniformsByName.push_back(uniformName);
+		uniforms.push_back(uniform);
 	}
 
-	void SetAsFloat(float value) override
+	uniformData.assign(offset, 0);
+
+	std::sort(uniformsByName.begin(), uniformsByName.end(), [this](const UniformName &a, const UniformName &b) {
+		return NameLess(&uniformNames[a.begin], a.length, &uniformNames[b.begin], b.length);
+	});
+}
+
+int OpenGLPipeline::FindUniform(const char *name, size_t length) const
+{
+	auto iter = std::lower_bound(uniformsByName.begin(), uniformsByName.end(), length, [this, name](const UniformName &entry, size_t length) {
+		return NameLess(&uniformNames[entry.begin], entry.length, name, length);
+	});
+	if(iter == uniformsByName.end() || iter->length != length || memcmp(&uniformNames[iter->begin], name, length) != 0)
+		return -1;
+	return static_cast<int>(iter->uniform);
+}
+
+ParamHandle OpenGLPipeline::GetParamHandle(const char *name)
+{
+	// names may pick an element of an array, as in "bones[4]"
+	size_t length = strlen(name);
+	unsigned int element = 0;
+	const char *bracket = length ? strrchr(name, '[') : nullptr;
+	if(bracket && name[length - 1] == ']')
 	{
-		glUseProgram(pipeline->shaderProgram);
-		glUniform1f(location, value);
+		element = static_cast<unsigned int>(strtoul(bracket + 1, nullptr, 10));
+		length = bracket - name;
 	}
 
-	void SetAsMat4(const float *value) override
+	int index = FindUniform(name, length);
+	if(index < 0 || element >= uniforms[index].count)
+		return INVALID_PARAM_HANDLE;
+	return static_cast<ParamHandle>(uniforms[index].firstParam + element);
+}
+
+void OpenGLPipeline::SetUniform(unsigned int index, unsigned int element, const void *values, unsigned int words)
+{
+	Uniform &uniform = uniforms[index];
+
+	unsigned int start = element * uniform.components;
+	unsigned int end = uniform.count * uniform.components;
+	if(words > end - start)
+		words = end - start;
+
+	// unchanged values never reach GL
+	uint32_t *storage = &uniformData[uniform.offset + start];
+	if(memcmp(storage, values, words * sizeof(uint32_t)) == 0)
+		return;
+	memcpy(storage, values, words * sizeof(uint32_t));
+
+	if(uniform.dirtyWords == 0)
+		dirtyUniforms.push_back(index);
+	uniform.dirtyWords = std::max(uniform.dirtyWords, start + words);
+}
+
+void OpenGLPipeline::FlushUniforms()
+{
+	for(unsigned int index : dirtyUniforms)
 	{
-		glUseProgram(pipeline->shaderProgram);
-		glUniformMatrix4fv(location, 1, /*transpose=*/GL_FALSE, value);
+		Uniform &uniform = uniforms[index];
+
+		// upload whole elements from the start of the uniform up to the last one changed
+		GLsizei count = static_cast<GLsizei>((uniform.dirtyWords + uniform.components - 1) / uniform.components);
+		const uint32_t *data = &uniformData[uniform.offset];
+		const GLfloat *floats = reinterpret_cast<const GLfloat *>(data);
+		const GLint *ints = reinterpret_cast<const GLint *>(data);
+
+		switch(uniform.kind)
+		{
+		case UNIFORM_FLOAT:
+			if(uniform.components == 1) glUniform1fv(uniform.location, count, floats);
+			else if(uniform.components == 2) glUniform2fv(uniform.location, count, floats);
+			else if(uniform.components == 3) glUniform3fv(uniform.location, count, floats);
+			else glUniform4fv(uniform.location, count, floats);
+			break;
+		case UNIFORM_INT:
+			if(uniform.components == 1) glUniform1iv(uniform.location, count, ints);
+			else if(uniform.components == 2) glUniform2iv(uniform.location, count, ints);
+			else if(uniform.components == 3) glUniform3iv(uniform.location, count, ints);
+			else glUniform4iv(uniform.location, count, ints);
+			break;
+		case UNIFORM_UINT:
+			if(uniform.components == 1) glUniform1uiv(uniform.location, count, data);
+			else if(uniform.components == 2) glUniform2uiv(uniform.location, count, data);
+			else if(uniform.components == 3) glUniform3uiv(uniform.location, count, data);
+			else glUniform4uiv(uniform.location, count, data);
+			break;
+		case UNIFORM_MAT2:
+			glUniformMatrix2fv(uniform.location, count, /*transpose=*/GL_FALSE, floats);
+			break;
+		case UNIFORM_MAT3:
+			glUniformMatrix3fv(uniform.location, count, /*transpose=*/GL_FALSE, floats);
+			break;
+		case UNIFORM_MAT4:
+			glUniformMatrix4fv(uniform.location, count, /*transpose=*/GL_FALSE, floats);
+			break;
+		}
+
+		uniform.dirtyWords = 0;
 	}
+	dirtyUniforms.clear();
+}
 
-	void SetAsIntArray(int count, const int *values) override
+static const GLenum bufferUsages[BUFFERUSAGE_MAX] = { GL_STATIC_DRAW, GL_DYNAMIC_DRAW, GL_STREAM_DRAW };
+
+// A GL buffer object of a vertex, index or uniform buffer, which are updated and mapped alike
+#if OPENGL_BUFFER_STORAGE
+// Transient rings are written through one coherent mapping, so writes need neither flushing nor unmapping before draws
+static const GLbitfield persistentBufferFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+#endif
+
+class OpenGLBuffer
+{
+public:
+
+	// target is the binding the buffer is filled through, which must not be one a draw reads from the bound vertex array
+	OpenGLBuffer(OpenGLStateCache &_state, GLenum _target, long long _size, const void *data, BufferUsage _usage) :
+		state(_state), target(_target), size(_size), usage(_usage)
 	{
-		glUseProgram(pipeline->shaderProgram);
-		glUniform1iv(location, count, values);
+		glGenBuffers(1, &buffer);
+		state.BindBuffer(target, buffer);
+		glBufferData(target, size, data, bufferUsages[usage]);
 	}
 
-	void SetAsFloatArray(int count, const float *values) override
+#if OPENGL_BUFFER_STORAGE
+	// Immutable storage that stays mapped for writing while the GPU reads from it, which is
+	// only ever written by the device
+	OpenGLBuffer(OpenGLStateCache &_state, GLenum _target, long long _size, GLbitfield storageFlags) :
+		state(_state), target(_target), size(_size), usage(BUFFERUSAGE_STREAM), transient(true)
 	{
-		glUseProgram(pipeline->shaderProgram);
-		glUniform1fv(location, count, values);
+		glGenBuffers(1, &buffer);
+		state.BindBuffer(target, buffer);
+		glBufferStorage(target, size, nullptr, storageFlags);
 	}
+#endif
 
-	void SetAsMat4Array(int count, const float *values) override
+	~OpenGLBuffer()
 	{
-		glUseProgram(pipeline->shaderProgram);
-		glUniformMatrix4fv(location, count, /*transpose=*/GL_FALSE, values);
+		state.DeleteBuffer(buffer);
 	}
 
-	OpenGLPipeline *pipeline;
-	int location;
-};
+	// Returns whether a range lies within the buffer
+	bool IsValidRange(long long offset, long long rangeSize) const
+	{
+		return offset >= 0 && rangeSize > 0 && offset + rangeSize <= size;
+	}
 
-PipelineParam *OpenGLPipeline::GetParam(const char *name)
-{
-	auto const &iter = paramsByName.find(name);
-	if(iter == paramsByName.end())
+	void Update(long long offset, long long rangeSize, const void *data)
 	{
-		int location = glGetUniformLocation(shaderProgram, name);
-		if(location < 0) return nullptr;
-		OpenGLPipelineParam *param = new OpenGLPipelineParam(this, location);
-		paramsByName.insert(iter, std::make_pair(name, param));
-		return param;
+		state.BindBuffer(target, buffer);
+
+		// a whole rewrite orphans the storage, which draws already made keep reading from
+		if(offset == 0 && rangeSize == size && usage != BUFFERUSAGE_STATIC)
+			glBufferData(target, size, data, bufferUsages[usage]);
+		else
+			glBufferSubData(target, offset, rangeSize, data);
 	}
-	return iter->second;
-}
 
-class OpenGLVertexBuffer : public VertexBuffer
-{
-public:
+	void *Map(long long offset, long long rangeSize, unsigned int mapFlags)
+	{
+		state.BindBuffer(target, buffer);
+
+		// orphaning is explicit, as not every driver replaces the storage for GL_MAP_INVALIDATE_BUFFER_BIT alone
+		GLbitfield access = GL_MAP_WRITE_BIT;
+		if(mapFlags & BUFFERMAP_DISCARD)
+		{
+			glBufferData(target, size, nullptr, bufferUsages[usage]);
+			access |= GL_MAP_INVALIDATE_BUFFER_BIT;
+		}
+		if(mapFlags & BUFFERMAP_UNSYNCHRONIZED)
+			access |= GL_MAP_UNSYNCHRONIZED_BIT;
 
-	OpenGLVertexBuffer(long long size, const void *data)
+		void *data = glMapBufferRange(target, offset, rangeSize, access);
+		mapped = data != nullptr;
+		return data;
+	}
+
+	// Returns false if the contents were lost while mapped, and must be written again
+	bool Unmap()
 	{
-		glGenBuffers(1, &VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW); // always assuming static, for now
+		state.BindBuffer(target, buffer);
+		mapped = false;
+		return glUnmapBuffer(target) == GL_TRUE;
 	}
 
-	~OpenGLVertexBuffer() override
+	void CopyFrom(long long offset, const OpenGLBuffer &source, long long sourceOffset, long long rangeSize)
 	{
-		glDeleteBuffers(1, &VBO);
+		state.BindBuffer(GL_COPY_READ_BUFFER, source.buffer);
+		state.BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, offset, rangeSize);
 	}
 
-	unsigned int VBO = 0;
+	OpenGLStateCache &state;
+
+	GLenum target;
+	unsigned int buffer = 0;
+
+	long long size;
+	BufferUsage usage;
+	bool mapped = false;
+	bool transient = false; // written by a transient ring of the device, never by the application
+};
+
+class OpenGLVertexBuffer : public VertexBuffer
+{
+public:
+
+	OpenGLVertexBuffer(OpenGLStateCache &state, long long size, const void *data, BufferUsage usage) :
+		storage(state, GL_ARRAY_BUFFER, size, data, usage) {}
+
+#if OPENGL_BUFFER_STORAGE
+	OpenGLVertexBuffer(OpenGLStateCache &state, long long size, GLbitfield storageFlags) :
+		storage(state, GL_ARRAY_BUFFER, size, storageFlags) {}
+#endif
+
+	OpenGLBuffer storage;
 };
 
 class OpenGLVertexDescription : public VertexDescription
@@ -198,6 +611,7 @@ public:
 		GLboolean normalized;
 		GLsizei stride;
 		const GLvoid *pointer;
+		GLuint divisor;
 	};
 
 	OpenGLVertexDescription(unsigned int _numVertexElements, const VertexElement *vertexElements) : numVertexElements(_numVertexElements)
@@ -216,6 +630,7 @@ public:
 			openGLVertexElements[i].normalized = toOpenGLNormalized[vertexElements[i].type];
 			openGLVertexElements[i].stride = vertexElements[i].stride;
 			openGLVertexElements[i].pointer = (char *)nullptr + vertexElements[i].offset;
+			openGLVertexElements[i].divisor = vertexElements[i].divisor;
 		}
 	}
 
@@ -232,32 +647,36 @@ class OpenGLVertexArray : public VertexArray
 {
 public:
 
-	OpenGLVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+	OpenGLVertexArray(OpenGLStateCache &_state, unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions) : state(_state)
 	{
 		glGenVertexArrays(1, &VAO);
-		glBindVertexArray(VAO);
+		state.BindVertexArray(VAO);
 
 		for(unsigned int i = 0; i < numVertexBuffers; i++)
 		{
 			OpenGLVertexBuffer *vertexBuffer = reinterpret_cast<OpenGLVertexBuffer *>(vertexBuffers[i]);
 			OpenGLVertexDescription *vertexDescription = reinterpret_cast<OpenGLVertexDescription *>(vertexDescriptions[i]);
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->VBO);
+			state.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer->storage.buffer);
 
 			for(unsigned int j = 0; j < vertexDescription->numVertexElements; j++)
 			{
 				glEnableVertexAttribArray(vertexDescription->openGLVertexElements[j].index);
 				glVertexAttribPointer(vertexDescription->openGLVertexElements[j].index, vertexDescription->openGLVertexElements[j].size, vertexDescription->openGLVertexElements[j].type,
 					vertexDescription->openGLVertexElements[j].normalized, vertexDescription->openGLVertexElements[j].stride, vertexDescription->openGLVertexElements[j].pointer);
+				if(vertexDescription->openGLVertexElements[j].divisor)
+					glVertexAttribDivisor(vertexDescription->openGLVertexElements[j].index, vertexDescription->openGLVertexElements[j].divisor);
 			}
 		}
 	}
 
 	~OpenGLVertexArray() override
 	{
-		glDeleteVertexArrays(1, &VAO);
+		state.DeleteVertexArray(VAO);
 	}
 
+	OpenGLStateCache &state;
+
 	unsigned int VAO = 0;
 };
 
@@ -265,40 +684,199 @@ class OpenGLIndexBuffer : public IndexBuffer
 {
 public:
 
-	OpenGLIndexBuffer(long long size, const void *data)
+	// filled through GL_ARRAY_BUFFER, as binding GL_ELEMENT_ARRAY_BUFFER would change the bound vertex array
+	OpenGLIndexBuffer(OpenGLStateCache &state, long long size, const void *data, BufferUsage usage, IndexFormat _format) :
+		storage(state, GL_ARRAY_BUFFER, size, data, usage), format(_format) {}
+
+#if OPENGL_BUFFER_STORAGE
+	OpenGLIndexBuffer(OpenGLStateCache &state, long long size, GLbitfield storageFlags, IndexFormat _format) :
+		storage(state, GL_ARRAY_BUFFER, size, storageFlags), format(_format) {}
+#endif
+
+	OpenGLBuffer storage;
+
+	IndexFormat format;
+};
+
+class OpenGLIndirectBuffer : public IndirectBuffer
+{
+public:
+
+	OpenGLIndirectBuffer(OpenGLStateCache &state, long long size, const void *data, BufferUsage usage) :
+		storage(state, GL_DRAW_INDIRECT_BUFFER, size, data, usage) {}
+
+	OpenGLBuffer storage;
+};
+
+// A GL texture object holding the levels of a 2D texture, or of every layer of a 2D
+// texture array; a 2D texture is treated as an array of one layer
+class OpenGLTextureStorage
+{
+public:
+
+	OpenGLTextureStorage(OpenGLStateCache &_state, GLenum _target, int _width, int _height, int _layers, TextureFormat _format, int mipLevels, MipPolicy _mipPolicy) :
+		state(_state), target(_target), width(_width), height(_height), layers(_layers), format(_format), mipPolicy(_mipPolicy)
+	{
+		// levels are either all supplied with each layer, or filled from its top level as the
+		// mip policy says; the driver cannot generate levels of compressed formats
+		if(mipLevels > 0 || IsCompressedTextureFormat(format) || mipPolicy == MIPPOLICY_NONE)
+		{
+			levels = mipLevels > 0 ? mipLevels : 1;
+			suppliedLevels = levels;
+			mipPolicy = MIPPOLICY_NONE;
+		}
+		else
+		{
+			levels = GetTextureMipLevels(width, height);
+			suppliedLevels = 1;
+		}
+
+		// any unit will do to fill the texture, so use whichever is active
+		glGenTextures(1, &texture);
+		Bind();
+		state.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		for(int i = 0; i < levels; i++)
+		{
+			int levelWidth = LevelWidth(i), levelHeight = LevelHeight(i);
+			GLsizei size = static_cast<GLsizei>(GetTextureLevelSize(format, levelWidth, levelHeight) * layers);
+			if(target == GL_TEXTURE_2D && IsCompressedTextureFormat(format))
+				glCompressedTexImage2D(target, i, textureInternalFormats[format], levelWidth, levelHeight, 0, size, nullptr);
+			else if(target == GL_TEXTURE_2D)
+				glTexImage2D(target, i, textureInternalFormats[format], levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			else if(IsCompressedTextureFormat(format))
+				glCompressedTexImage3D(target, i, textureInternalFormats[format], levelWidth, levelHeight, layers, 0, size, nullptr);
+			else
+				glTexImage3D(target, i, textureInternalFormats[format], levelWidth, levelHeight, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		}
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+		// the default sampler state, used on slots without a sampler object bound
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	~OpenGLTextureStorage()
+	{
+		state.DeleteTexture(texture);
+	}
+
+	// Bind to the active unit, for modifying the texture
+	void Bind() const
+	{
+		state.BindTexture(state.GetActiveTexture(), target, texture);
+	}
+
+	int LevelWidth(int mipLevel) const { return std::max(width >> mipLevel, 1); }
+
+	int LevelHeight(int mipLevel) const { return std::max(height >> mipLevel, 1); }
+
+	// Returns whether a region of a level of a layer can be updated; compressed formats are updated in whole blocks
+	bool IsValidRegion(int layer, int mipLevel, int x, int y, int regionWidth, int regionHeight) const
 	{
-		glGenBuffers(1, &IBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW); // always assuming static, for now
+		if(layer < 0 || layer >= layers || mipLevel < 0 || mipLevel >= levels)
+			return false;
+		int levelWidth = LevelWidth(mipLevel), levelHeight = LevelHeight(mipLevel);
+		if(x < 0 || y < 0 || regionWidth <= 0 || regionHeight <= 0 || x + regionWidth > levelWidth || y + regionHeight > levelHeight)
+			return false;
+		if(!IsCompressedTextureFormat(format))
+			return true;
+		return x % 4 == 0 && y % 4 == 0 && (regionWidth % 4 == 0 || x + regionWidth == levelWidth) && (regionHeight % 4 == 0 || y + regionHeight == levelHeight);
 	}
 
-	~OpenGLIndexBuffer() override
+	// Copy a region of texels into the bound texture, from data or from an offset into the bound pixel unpack buffer
+	void SubImage(int layer, int mipLevel, int x, int y, int regionWidth, int regionHeight, const void *data) const
 	{
-		glDeleteBuffers(1, &IBO);
+		GLsizei size = static_cast<GLsizei>(GetTextureLevelSize(format, regionWidth, regionHeight));
+		if(target == GL_TEXTURE_2D && IsCompressedTextureFormat(format))
+			glCompressedTexSubImage2D(target, mipLevel, x, y, regionWidth, regionHeight, textureInternalFormats[format], size, data);
+		else if(target == GL_TEXTURE_2D)
+			glTexSubImage2D(target, mipLevel, x, y, regionWidth, regionHeight, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		else if(IsCompressedTextureFormat(format))
+			glCompressedTexSubImage3D(target, mipLevel, x, y, layer, regionWidth, regionHeight, 1, textureInternalFormats[format], size, data);
+		else
+			glTexSubImage3D(target, mipLevel, x, y, layer, regionWidth, regionHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
 	}
 
-	unsigned int IBO = 0;
+	OpenGLStateCache &state;
+
+	GLenum target;
+	unsigned int texture = 0;
+
+	int width;
+	int height;
+	int layers;
+	TextureFormat format;
+	MipPolicy mipPolicy; // how levels past those supplied are filled; MIPPOLICY_NONE when all are supplied
+	int levels;
+	int suppliedLevels; // levels in the data of each layer
+	bool mipsDirty = false; // levels the driver generates are out of date
 };
 
 class OpenGLTexture2D : public Texture2D
 {
 public:
 
-	OpenGLTexture2D(int width, int height, const void *data = nullptr)
+	OpenGLTexture2D(OpenGLStateCache &state, int width, int height, TextureFormat format, int mipLevels, MipPolicy mipPolicy) :
+		storage(state, GL_TEXTURE_2D, width, height, 1, format, mipLevels, mipPolicy) {}
+
+	OpenGLTextureStorage storage;
+};
+
+class OpenGLTexture2DArray : public Texture2DArray
+{
+public:
+
+	OpenGLTexture2DArray(OpenGLStateCache &state, int width, int height, int layers, TextureFormat format, int mipLevels, MipPolicy mipPolicy) :
+		storage(state, GL_TEXTURE_2D_ARRAY, width, height, layers, format, mipLevels, mipPolicy) {}
+
+	OpenGLTextureStorage storage;
+};
+
+class OpenGLSamplerState : public SamplerState
+{
+public:
+
+	OpenGLSamplerState(OpenGLStateCache &_state, uint32_t _key, TextureFilter minFilter, TextureFilter magFilter, MipFilter mipFilter, TextureWrap wrapS, TextureWrap wrapT) :
+		state(_state), key(_key)
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		static const GLenum minFilters[MIPFILTER_MAX][TEXTUREFILTER_MAX] = {
+			{ GL_NEAREST, GL_LINEAR },
+			{ GL_NEAREST_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_NEAREST },
+			{ GL_NEAREST_MIPMAP_LINEAR, GL_LINEAR_MIPMAP_LINEAR }
+		};
+		static const GLenum wraps[] = { GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE };
+
+		glGenSamplers(1, &sampler);
+		glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilters[mipFilter][minFilter]);
+		glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter == TEXTUREFILTER_NEAREST ? GL_NEAREST : GL_LINEAR);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wraps[wrapS]);
+		glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wraps[wrapT]);
 	}
 
-	~OpenGLTexture2D() override
+	~OpenGLSamplerState() override
 	{
-		glDeleteTextures(1, &texture);
+		state.DeleteSampler(sampler);
 	}
 
-	unsigned int texture = 0;
+	OpenGLStateCache &state;
+
+	unsigned int sampler = 0;
+
+	uint32_t key; // descriptor it is interned under
+	unsigned int references = 1; // CreateSamplerState calls not yet matched by DestroySamplerState
+};
+
+class OpenGLUniformBuffer : public UniformBuffer
+{
+public:
+
+	OpenGLUniformBuffer(OpenGLStateCache &state, long long size, const void *data, BufferUsage usage) :
+		storage(state, GL_UNIFORM_BUFFER, size, data, usage) {}
+
+	OpenGLBuffer storage;
 };
 
 class OpenGLRasterState : public RasterState
@@ -414,6 +992,93 @@ OpenGLRenderDevice::OpenGLRenderDevice()
 
 	m_DefaultDepthStencilState = dynamic_cast<OpenGLDepthStencilState *>(CreateDepthStencilState());
 	SetDepthStencilState(m_DefaultDepthStencilState);
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if(alignment > 0)
+		m_UniformAlignment = alignment;
+
+	m_UniformRingSize = UNIFORM_RING_FRAMES * UNIFORM_DATA_FRAME_SIZE;
+	glGenBuffers(1, &m_UniformRing);
+	m_State.BindBuffer(GL_UNIFORM_BUFFER, m_UniformRing);
+	glBufferData(GL_UNIFORM_BUFFER, m_UniformRingSize, nullptr, GL_STREAM_DRAW);
+
+	// uncompressed and RGTC (BC4/BC5) textures are core in OpenGL 4.1; the other compressed
+	// formats need a later version, an extension, or the driver listing them as supported
+	m_TextureFormats[TEXTUREFORMAT_RGBX8] = true;
+	m_TextureFormats[TEXTUREFORMAT_RGBA8] = true;
+	m_TextureFormats[TEXTUREFORMAT_BC4] = true;
+	m_TextureFormats[TEXTUREFORMAT_BC5] = true;
+
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &numFormats);
+	std::vector<GLint> formats(numFormats > 0 ? numFormats : 1);
+	if(numFormats > 0)
+		glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, &formats[0]);
+	for(int format = 0; format < TEXTUREFORMAT_MAX; format++)
+		for(int i = 0; i < numFormats; i++)
+			if(static_cast<GLenum>(formats[i]) == textureInternalFormats[format])
+				m_TextureFormats[format] = true;
+
+	GLint majorVersion = 0, minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	int version = majorVersion * 10 + minorVersion;
+
+	bool s3tc = false, bptc = version >= 42, etc2 = version >= 43, bufferStorage = version >= 44;
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for(GLint i = 0; i < numExtensions; i++)
+	{
+		const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+		if(!extension)
+			continue;
+		if(strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+			s3tc = true;
+		else if(strcmp(extension, "GL_ARB_texture_compression_bptc") == 0)
+			bptc = true;
+		else if(strcmp(extension, "GL_ARB_ES3_compatibility") == 0)
+			etc2 = true;
+		else if(strcmp(extension, "GL_ARB_buffer_storage") == 0)
+			bufferStorage = true;
+	}
+	m_TextureFormats[TEXTUREFORMAT_BC1] |= s3tc;
+	m_TextureFormats[TEXTUREFORMAT_BC3] |= s3tc;
+	m_TextureFormats[TEXTUREFORMAT_BC7] |= bptc;
+	m_TextureFormats[TEXTUREFORMAT_ETC2_RGB8] |= etc2;
+	m_TextureFormats[TEXTUREFORMAT_ETC2_RGBA8] |= etc2;
+
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_MaxTextureLayers);
+
+	m_BufferStorage = OPENGL_BUFFER_STORAGE && bufferStorage;
+}
+
+OpenGLRenderDevice::~OpenGLRenderDevice()
+{
+	for(GpuQueryFrame &frame : m_GpuQueryFrames)
+		ReleaseGpuQueries(frame);
+	if(!m_FreeGpuQueries.empty())
+		glDeleteQueries(static_cast<GLsizei>(m_FreeGpuQueries.size()), &m_FreeGpuQueries[0]);
+
+	for(const RingFrame &frame : m_UniformRingFrames)
+		glDeleteSync(frame.fence);
+	m_State.DeleteBuffer(m_UniformRing);
+
+	ReleaseTransientRing(m_TransientVertices);
+	ReleaseTransientRing(m_TransientIndices);
+	delete m_TransientVertexBuffer;
+	delete m_TransientIndexBuffer;
+
+	for(const TextureUploadBuffer &upload : m_TextureUploadBuffers)
+	{
+		if(upload.fence)
+			glDeleteSync(upload.fence);
+		if(upload.buffer)
+			m_State.DeleteBuffer(upload.buffer);
+	}
+
+	delete m_DefaultRasterState;
+	delete m_DefaultDepthStencilState;
 }
 
 VertexShader *OpenGLRenderDevice::CreateVertexShader(const char *code)
@@ -438,88 +1103,866 @@ void OpenGLRenderDevice::DestroyPixelShader(PixelShader *pixelShader)
 
 Pipeline *OpenGLRenderDevice::CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader)
 {
-	return new OpenGLPipeline(reinterpret_cast<OpenGLVertexShader *>(vertexShader), reinterpret_cast<OpenGLPixelShader *>(pixelShader));
+	return new OpenGLPipeline(m_State, reinterpret_cast<OpenGLVertexShader *>(vertexShader), reinterpret_cast<OpenGLPixelShader *>(pixelShader));
 }
 
 void OpenGLRenderDevice::DestroyPipeline(Pipeline *pipeline)
 {
+	if(pipeline == m_Pipeline)
+		m_Pipeline = nullptr;
 	delete pipeline;
 }
 
 void OpenGLRenderDevice::SetPipeline(Pipeline *pipeline)
 {
-	glUseProgram(reinterpret_cast<OpenGLPipeline *>(pipeline)->shaderProgram);
+	m_Pipeline = reinterpret_cast<OpenGLPipeline *>(pipeline);
+	m_State.UseProgram(m_Pipeline ? m_Pipeline->shaderProgram : 0);
 }
 
-VertexBuffer *OpenGLRenderDevice::CreateVertexBuffer(long long size, const void *data)
+bool OpenGLRenderDevice::IsValidBuffer(const char *type, long long size, BufferUsage usage) const
 {
-	return new OpenGLVertexBuffer(size, data);
+	if(size < 0)
+	{
+		std::cout << "ERROR::" << type << "::INVALID_SIZE\n" << size << std::endl;
+		return false;
+	}
+	if(usage < 0 || usage >= BUFFERUSAGE_MAX)
+	{
+		std::cout << "ERROR::" << type << "::INVALID_USAGE\n" << usage << std::endl;
+		return false;
+	}
+	return true;
 }
 
-void OpenGLRenderDevice::DestroyVertexBuffer(VertexBuffer *vertexBuffer)
+void OpenGLRenderDevice::UpdateBuffer(const char *type, OpenGLBuffer *buffer, long long offset, long long size, const void *data)
 {
-	delete vertexBuffer;
+	if(!buffer || !data || !buffer->IsValidRange(offset, size))
+	{
+		std::cout << "ERROR::" << type << "::INVALID_RANGE\n" << offset << ", " << size << " bytes" << std::endl;
+		return;
+	}
+	if(buffer->mapped || buffer->transient)
+	{
+		std::cout << "ERROR::" << type << (buffer->transient ? "::TRANSIENT" : "::MAPPED") << std::endl;
+		return;
+	}
+	buffer->Update(offset, size, data);
 }
 
-VertexDescription *OpenGLRenderDevice::CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements)
+void *OpenGLRenderDevice::MapBuffer(const char *type, OpenGLBuffer *buffer, long long offset, long long size, unsigned int mapFlags)
 {
-	return new OpenGLVertexDescription(numVertexElements, vertexElements);
+	if(!buffer || !buffer->IsValidRange(offset, size))
+	{
+		std::cout << "ERROR::" << type << "::INVALID_RANGE\n" << offset << ", " << size << " bytes" << std::endl;
+		return nullptr;
+	}
+	if(buffer->mapped || buffer->transient)
+	{
+		std::cout << "ERROR::" << type << (buffer->transient ? "::TRANSIENT" : "::MAPPED") << std::endl;
+		return nullptr;
+	}
+
+	void *data = buffer->Map(offset, size, mapFlags);
+	if(!data)
+		std::cout << "ERROR::" << type << "::MAP_FAILED\n" << offset << ", " << size << " bytes" << std::endl;
+	return data;
 }
 
-void OpenGLRenderDevice::DestroyVertexDescription(VertexDescription *vertexDescription)
+void OpenGLRenderDevice::CopyBuffer(const char *type, OpenGLBuffer *destination, long long destinationOffset, OpenGLBuffer *source, long long sourceOffset, long long size)
 {
-	delete vertexDescription;
+	if(!destination || !source || !destination->IsValidRange(destinationOffset, size) || !source->IsValidRange(sourceOffset, size))
+	{
+		std::cout << "ERROR::" << type << "::INVALID_RANGE\n" << sourceOffset << " to " << destinationOffset << ", " << size << " bytes" << std::endl;
+		return;
+	}
+	if(destination == source && destinationOffset < sourceOffset + size && sourceOffset < destinationOffset + size)
+	{
+		std::cout << "ERROR::" << type << "::OVERLAPPING_COPY\n" << sourceOffset << " to " << destinationOffset << ", " << size << " bytes" << std::endl;
+		return;
+	}
+	if(destination->mapped || source->mapped || destination->transient)
+	{
+		std::cout << "ERROR::" << type << (destination->transient ? "::TRANSIENT" : "::MAPPED") << std::endl;
+		return;
+	}
+	destination->CopyFrom(destinationOffset, *source, sourceOffset, size);
 }
 
-VertexArray *OpenGLRenderDevice::CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+void OpenGLRenderDevice::UnmapBuffer(const char *type, OpenGLBuffer *buffer)
 {
-	return new OpenGLVertexArray(numVertexBuffers, vertexBuffers, vertexDescriptions);
+	if(!buffer || !buffer->mapped)
+	{
+		std::cout << "ERROR::" << type << "::NOT_MAPPED" << std::endl;
+		return;
+	}
+	if(!buffer->Unmap())
+		std::cout << "ERROR::" << type << "::CONTENTS_LOST" << std::endl;
 }
 
-void OpenGLRenderDevice::DestroyVertexArray(VertexArray *vertexArray)
+VertexBuffer *OpenGLRenderDevice::CreateVertexBuffer(long long size, const void *data, BufferUsage usage)
 {
-	delete vertexArray;
+	if(!IsValidBuffer("VERTEXBUFFER", size, usage))
+		return nullptr;
+	return new OpenGLVertexBuffer(m_State, size, data, usage);
 }
 
-void OpenGLRenderDevice::SetVertexArray(VertexArray *vertexArray)
+void OpenGLRenderDevice::UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data)
 {
-	glBindVertexArray(reinterpret_cast<OpenGLVertexArray *>(vertexArray)->VAO);
+	UpdateBuffer("VERTEXBUFFER", vertexBuffer ? &reinterpret_cast<OpenGLVertexBuffer *>(vertexBuffer)->storage : nullptr, offset, size, data);
 }
 
-IndexBuffer *OpenGLRenderDevice::CreateIndexBuffer(long long size, const void *data)
+void *OpenGLRenderDevice::MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags)
 {
-	return new OpenGLIndexBuffer(size, data);
+	return MapBuffer("VERTEXBUFFER", vertexBuffer ? &reinterpret_cast<OpenGLVertexBuffer *>(vertexBuffer)->storage : nullptr, offset, size, mapFlags);
 }
 
-void OpenGLRenderDevice::DestroyIndexBuffer(IndexBuffer *indexBuffer)
+void OpenGLRenderDevice::UnmapVertexBuffer(VertexBuffer *vertexBuffer)
 {
-	delete indexBuffer;
+	UnmapBuffer("VERTEXBUFFER", vertexBuffer ? &reinterpret_cast<OpenGLVertexBuffer *>(vertexBuffer)->storage : nullptr);
 }
-    
-void OpenGLRenderDevice::SetIndexBuffer(IndexBuffer *indexBuffer)
+
+void OpenGLRenderDevice::CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, reinterpret_cast<OpenGLIndexBuffer *>(indexBuffer)->IBO);
+	CopyBuffer("VERTEXBUFFER", destination ? &reinterpret_cast<OpenGLVertexBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &reinterpret_cast<OpenGLVertexBuffer *>(source)->storage : nullptr, sourceOffset, size);
 }
 
-Texture2D *OpenGLRenderDevice::CreateTexture2D(int width, int height, const void *data)
+void OpenGLRenderDevice::DestroyVertexBuffer(VertexBuffer *vertexBuffer)
 {
-	return new OpenGLTexture2D(width, height, data);
+	delete vertexBuffer;
 }
 
-void OpenGLRenderDevice::DestroyTexture2D(Texture2D *texture2D)
+VertexDescription *OpenGLRenderDevice::CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements)
+{
+	return new OpenGLVertexDescription(numVertexElements, vertexElements);
+}
+
+void OpenGLRenderDevice::DestroyVertexDescription(VertexDescription *vertexDescription)
+{
+	delete vertexDescription;
+}
+
+VertexArray *OpenGLRenderDevice::CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+{
+	return new OpenGLVertexArray(m_State, numVertexBuffers, vertexBuffers, vertexDescriptions);
+}
+
+void OpenGLRenderDevice::DestroyVertexArray(VertexArray *vertexArray)
+{
+	delete vertexArray;
+}
+
+void OpenGLRenderDevice::SetVertexArray(VertexArray *vertexArray)
+{
+	m_State.BindVertexArray(vertexArray ? reinterpret_cast<OpenGLVertexArray *>(vertexArray)->VAO : 0);
+}
+
+IndexBuffer *OpenGLRenderDevice::CreateIndexBuffer(long long size, const void *data, BufferUsage usage, IndexFormat format)
+{
+	if(!IsValidBuffer("INDEXBUFFER", size, usage))
+		return nullptr;
+	if(format < 0 || format >= INDEXFORMAT_MAX)
+	{
+		std::cout << "ERROR::INDEXBUFFER::INVALID_FORMAT\n" << format << std::endl;
+		return nullptr;
+	}
+	return new OpenGLIndexBuffer(m_State, size, data, usage, format);
+}
+
+void OpenGLRenderDevice::UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data)
+{
+	UpdateBuffer("INDEXBUFFER", indexBuffer ? &reinterpret_cast<OpenGLIndexBuffer *>(indexBuffer)->storage : nullptr, offset, size, data);
+}
+
+void *OpenGLRenderDevice::MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	return MapBuffer("INDEXBUFFER", indexBuffer ? &reinterpret_cast<OpenGLIndexBuffer *>(indexBuffer)->storage : nullptr, offset, size, mapFlags);
+}
+
+void OpenGLRenderDevice::UnmapIndexBuffer(IndexBuffer *indexBuffer)
+{
+	UnmapBuffer("INDEXBUFFER", indexBuffer ? &reinterpret_cast<OpenGLIndexBuffer *>(indexBuffer)->storage : nullptr);
+}
+
+void OpenGLRenderDevice::CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size)
+{
+	CopyBuffer("INDEXBUFFER", destination ? &reinterpret_cast<OpenGLIndexBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &reinterpret_cast<OpenGLIndexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void OpenGLRenderDevice::DestroyIndexBuffer(IndexBuffer *indexBuffer)
+{
+	if(indexBuffer == m_IndexBuffer)
+		m_IndexBuffer = nullptr;
+	delete indexBuffer;
+}
+    
+void OpenGLRenderDevice::SetIndexBuffer(IndexBuffer *indexBuffer)
+{
+	m_IndexBuffer = reinterpret_cast<OpenGLIndexBuffer *>(indexBuffer);
+	m_State.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer ? m_IndexBuffer->storage.buffer : 0);
+}
+
+void OpenGLRenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	static const GLenum modes[] = { GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_LINES, GL_LINE_STRIP, GL_POINTS };
+
+	if(topology < 0 || topology >= PRIMITIVETOPOLOGY_MAX)
+	{
+		std::cout << "ERROR::PRIMITIVETOPOLOGY::INVALID\n" << topology << std::endl;
+		return;
+	}
+
+	m_PrimitiveMode = modes[topology];
+	m_PrimitiveRestart = topology == PRIMITIVETOPOLOGY_TRIANGLE_STRIP || topology == PRIMITIVETOPOLOGY_LINE_STRIP;
+	m_State.Enable(GL_PRIMITIVE_RESTART, m_PrimitiveRestart);
+}
+
+IndirectBuffer *OpenGLRenderDevice::CreateIndirectBuffer(long long size, const void *data, BufferUsage usage)
+{
+	if(!IsValidBuffer("INDIRECTBUFFER", size, usage))
+		return nullptr;
+	return new OpenGLIndirectBuffer(m_State, size, data, usage);
+}
+
+void OpenGLRenderDevice::UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data)
+{
+	UpdateBuffer("INDIRECTBUFFER", indirectBuffer ? &reinterpret_cast<OpenGLIndirectBuffer *>(indirectBuffer)->storage : nullptr, offset, size, data);
+}
+
+void OpenGLRenderDevice::CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	CopyBuffer("INDIRECTBUFFER", destination ? &reinterpret_cast<OpenGLIndirectBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &reinterpret_cast<OpenGLVertexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void OpenGLRenderDevice::DestroyIndirectBuffer(IndirectBuffer *indirectBuffer)
+{
+	delete indirectBuffer;
+}
+
+bool OpenGLRenderDevice::IsValidTexture(const char *type, int width, int height, TextureFormat format, int mipLevels, MipPolicy mipPolicy) const
+{
+	if(format < 0 || format >= TEXTUREFORMAT_MAX || !m_TextureFormats[format])
+	{
+		std::cout << "ERROR::" << type << "::UNSUPPORTED_FORMAT\n" << format << std::endl;
+		return false;
+	}
+	if(width <= 0 || height <= 0 || mipLevels < 0 || mipLevels > GetTextureMipLevels(width, height))
+	{
+		std::cout << "ERROR::" << type << "::INVALID_SIZE\n" << width << "x" << height << ", " << mipLevels << " levels" << std::endl;
+		return false;
+	}
+	if(mipPolicy < 0 || mipPolicy >= MIPPOLICY_MAX)
+	{
+		std::cout << "ERROR::" << type << "::INVALID_MIP_POLICY\n" << mipPolicy << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void OpenGLRenderDevice::UploadTextureRegion(const OpenGLTextureStorage &storage, int layer, int mipLevel, int x, int y, int width, int height, const void *data, bool async)
+{
+	long long offset = async ? StageTextureUpload(data, GetTextureLevelSize(storage.format, width, height)) : -1;
+	if(offset < 0)
+		m_State.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// a staged update is copied by the GPU in order with the draws around it
+	storage.Bind();
+	storage.SubImage(layer, mipLevel, x, y, width, height, offset < 0 ? data : reinterpret_cast<const void *>(static_cast<intptr_t>(offset)));
+}
+
+void OpenGLRenderDevice::UploadTextureLayer(OpenGLTextureStorage &storage, int layer, const void *data, bool async)
+{
+	int levels = storage.suppliedLevels;
+	if(storage.mipPolicy == MIPPOLICY_CPU)
+	{
+		// filter every level before uploading them all at once
+		if(!m_MipThreadPool)
+			m_MipThreadPool.reset(new ThreadPool);
+		levels = storage.levels;
+		m_MipChain.resize(static_cast<size_t>(GetTextureSize(storage.format, storage.width, storage.height, levels) / 4));
+		memcpy(&m_MipChain[0], data, static_cast<size_t>(GetTextureLevelSize(storage.format, storage.width, storage.height)));
+		GenerateMipChain(*m_MipThreadPool, storage.width, storage.height, levels, &m_MipChain[0]);
+		data = &m_MipChain[0];
+	}
+
+	const char *level = static_cast<const char *>(data);
+	for(int i = 0; i < levels; i++)
+	{
+		int levelWidth = storage.LevelWidth(i), levelHeight = storage.LevelHeight(i);
+		UploadTextureRegion(storage, layer, i, 0, 0, levelWidth, levelHeight, level, async);
+		level += GetTextureLevelSize(storage.format, levelWidth, levelHeight);
+	}
+
+	// the levels of arrays are generated at the next draw, so that uploading many layers generates them once
+	if(storage.mipPolicy != MIPPOLICY_DRIVER || storage.levels == 1)
+		return;
+	if(storage.target == GL_TEXTURE_2D)
+		glGenerateMipmap(storage.target);
+	else
+		MarkMipsDirty(storage);
+}
+
+void OpenGLRenderDevice::MarkMipsDirty(OpenGLTextureStorage &storage)
+{
+	if(storage.mipsDirty)
+		return;
+	storage.mipsDirty = true;
+	m_DirtyMipTextures.push_back(&storage);
+}
+
+void OpenGLRenderDevice::UpdateTextureRegion(OpenGLTextureStorage &storage, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+	bool async)
+{
+	// generate pending levels first, so that they do not overwrite the update
+	if(mipLevel > 0 && storage.mipsDirty)
+		GenerateMips(storage);
+	UploadTextureRegion(storage, layer, mipLevel, x, y, width, height, data, async);
+
+	// the levels below an updated top level are generated again at the next draw, so that
+	// updating many regions generates them once; the driver generates them for textures
+	// filtered on the CPU too, as only their top level is at hand
+	if(mipLevel == 0 && storage.mipPolicy != MIPPOLICY_NONE && storage.levels > 1)
+		MarkMipsDirty(storage);
+}
+
+void OpenGLRenderDevice::GenerateMips(OpenGLTextureStorage &storage)
+{
+	storage.Bind();
+	glGenerateMipmap(storage.target);
+	storage.mipsDirty = false;
+	m_DirtyMipTextures.erase(std::find(m_DirtyMipTextures.begin(), m_DirtyMipTextures.end(), &storage));
+}
+
+void OpenGLRenderDevice::GenerateDirtyMips()
+{
+	for(OpenGLTextureStorage *storage : m_DirtyMipTextures)
+	{
+		m_State.GenerateMipmap(storage->target, storage->texture);
+		storage->mipsDirty = false;
+	}
+	m_DirtyMipTextures.clear();
+}
+
+Texture2D *OpenGLRenderDevice::CreateTexture2D(int width, int height, const void *data, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	if(!IsValidTexture("TEXTURE2D", width, height, format, mipLevels, mipPolicy))
+		return nullptr;
+
+	OpenGLTexture2D *texture = new OpenGLTexture2D(m_State, width, height, format, mipLevels, mipPolicy);
+	if(data)
+		UploadTextureLayer(texture->storage, 0, data, false);
+	return texture;
+}
+
+bool OpenGLRenderDevice::IsTextureFormatSupported(TextureFormat format)
+{
+	return format >= 0 && format < TEXTUREFORMAT_MAX && m_TextureFormats[format];
+}
+
+void OpenGLRenderDevice::UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async)
 {
+	OpenGLTexture2D *texture = reinterpret_cast<OpenGLTexture2D *>(texture2D);
+	if(!texture || !data || !texture->storage.IsValidRegion(0, mipLevel, x, y, width, height))
+	{
+		std::cout << "ERROR::TEXTURE2D::INVALID_REGION\n" << mipLevel << ": " << x << ", " << y << ", " << width << "x" << height << std::endl;
+		return;
+	}
+
+	UpdateTextureRegion(texture->storage, 0, mipLevel, x, y, width, height, data, async);
+}
+
+void OpenGLRenderDevice::DestroyTexture2D(Texture2D *texture2D)
+{
+	if(!texture2D)
+		return;
+
+	OpenGLTextureStorage &storage = reinterpret_cast<OpenGLTexture2D *>(texture2D)->storage;
+	if(storage.mipsDirty)
+		m_DirtyMipTextures.erase(std::find(m_DirtyMipTextures.begin(), m_DirtyMipTextures.end(), &storage));
 	delete texture2D;
 }
 
 void OpenGLRenderDevice::SetTexture2D(unsigned int slot, Texture2D *texture2D)
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, texture2D ? reinterpret_cast<OpenGLTexture2D *>(texture2D)->texture : 0);
+	m_State.BindTexture(slot, GL_TEXTURE_2D, texture2D ? reinterpret_cast<OpenGLTexture2D *>(texture2D)->storage.texture : 0);
+}
+
+Texture2DArray *OpenGLRenderDevice::CreateTexture2DArray(int width, int height, int layers, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	if(!IsValidTexture("TEXTURE2DARRAY", width, height, format, mipLevels, mipPolicy))
+		return nullptr;
+	if(layers <= 0 || layers > m_MaxTextureLayers)
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_LAYERS\n" << layers << " of at most " << m_MaxTextureLayers << std::endl;
+		return nullptr;
+	}
+
+	return new OpenGLTexture2DArray(m_State, width, height, layers, format, mipLevels, mipPolicy);
+}
+
+void OpenGLRenderDevice::UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async)
+{
+	OpenGLTexture2DArray *textureArray = reinterpret_cast<OpenGLTexture2DArray *>(texture2DArray);
+	if(!textureArray || !data || layer < 0 || layer >= textureArray->storage.layers)
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_LAYER\n" << layer << std::endl;
+		return;
+	}
+
+	UploadTextureLayer(textureArray->storage, layer, data, async);
+}
+
+void OpenGLRenderDevice::UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+	bool async)
+{
+	OpenGLTexture2DArray *textureArray = reinterpret_cast<OpenGLTexture2DArray *>(texture2DArray);
+	if(!textureArray || !data || !textureArray->storage.IsValidRegion(layer, mipLevel, x, y, width, height))
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_REGION\n" << layer << ", " << mipLevel << ": " << x << ", " << y << ", " << width << "x" << height << std::endl;
+		return;
+	}
+
+	UpdateTextureRegion(textureArray->storage, layer, mipLevel, x, y, width, height, data, async);
+}
+
+void OpenGLRenderDevice::DestroyTexture2DArray(Texture2DArray *texture2DArray)
+{
+	if(!texture2DArray)
+		return;
+
+	OpenGLTextureStorage &storage = reinterpret_cast<OpenGLTexture2DArray *>(texture2DArray)->storage;
+	if(storage.mipsDirty)
+		m_DirtyMipTextures.erase(std::find(m_DirtyMipTextures.begin(), m_DirtyMipTextures.end(), &storage));
+	delete texture2DArray;
+}
+
+void OpenGLRenderDevice::SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray)
+{
+	m_State.BindTexture(slot, GL_TEXTURE_2D_ARRAY, texture2DArray ? reinterpret_cast<OpenGLTexture2DArray *>(texture2DArray)->storage.texture : 0);
+}
+
+SamplerState *OpenGLRenderDevice::CreateSamplerState(TextureFilter minFilter, TextureFilter magFilter, MipFilter mipFilter, TextureWrap wrapS, TextureWrap wrapT)
+{
+	if(minFilter >= TEXTUREFILTER_MAX || magFilter >= TEXTUREFILTER_MAX || mipFilter >= MIPFILTER_MAX || wrapS >= TEXTUREWRAP_MAX || wrapT >= TEXTUREWRAP_MAX)
+	{
+		std::cout << "ERROR::SAMPLERSTATE::INVALID_DESCRIPTOR" << std::endl;
+		return nullptr;
+	}
+
+	// identical descriptors share one GL sampler object
+	uint32_t key = minFilter | magFilter << 4 | mipFilter << 8 | wrapS << 12 | wrapT << 16;
+	auto iter = m_SamplerStates.find(key);
+	if(iter != m_SamplerStates.end())
+	{
+		iter->second->references++;
+		return iter->second;
+	}
+
+	OpenGLSamplerState *samplerState = new OpenGLSamplerState(m_State, key, minFilter, magFilter, mipFilter, wrapS, wrapT);
+	m_SamplerStates.insert(std::make_pair(key, samplerState));
+	return samplerState;
+}
+
+void OpenGLRenderDevice::DestroySamplerState(SamplerState *samplerState)
+{
+	OpenGLSamplerState *oglSamplerState = reinterpret_cast<OpenGLSamplerState *>(samplerState);
+	if(!oglSamplerState || --oglSamplerState->references)
+		return;
+
+	m_SamplerStates.erase(oglSamplerState->key);
+	delete oglSamplerState;
+}
+
+void OpenGLRenderDevice::SetSamplerState(unsigned int slot, SamplerState *samplerState)
+{
+	// sampler 0 leaves the texture's own parameters, which are the defaults, in effect
+	m_State.BindSampler(slot, samplerState ? reinterpret_cast<OpenGLSamplerState *>(samplerState)->sampler : 0);
+}
+
+UniformBuffer *OpenGLRenderDevice::CreateUniformBuffer(long long size, const void *data, BufferUsage usage)
+{
+	if(!IsValidBuffer("UNIFORMBUFFER", size, usage))
+		return nullptr;
+	return new OpenGLUniformBuffer(m_State, size, data, usage);
+}
+
+void OpenGLRenderDevice::UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data)
+{
+	UpdateBuffer("UNIFORMBUFFER", uniformBuffer ? &reinterpret_cast<OpenGLUniformBuffer *>(uniformBuffer)->storage : nullptr, offset, size, data);
+}
+
+void *OpenGLRenderDevice::MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	return MapBuffer("UNIFORMBUFFER", uniformBuffer ? &reinterpret_cast<OpenGLUniformBuffer *>(uniformBuffer)->storage : nullptr, offset, size, mapFlags);
+}
+
+void OpenGLRenderDevice::UnmapUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	UnmapBuffer("UNIFORMBUFFER", uniformBuffer ? &reinterpret_cast<OpenGLUniformBuffer *>(uniformBuffer)->storage : nullptr);
+}
+
+void OpenGLRenderDevice::DestroyUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	delete uniformBuffer;
+}
+
+void OpenGLRenderDevice::SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer)
+{
+	m_State.BindBufferRange(GL_UNIFORM_BUFFER, slot, uniformBuffer ? reinterpret_cast<OpenGLUniformBuffer *>(uniformBuffer)->storage.buffer : 0, 0, 0);
+}
+
+// Whether length bytes at offset overlap size bytes at begin, which may wrap around the end of the ring
+static bool RingOverlaps(long long begin, long long size, long long offset, long long length, long long ringSize)
+{
+	if(size == 0)
+		return false;
+	return (offset - begin + ringSize) % ringSize < size || (begin - offset + ringSize) % ringSize < length;
+}
+
+void OpenGLRenderDevice::WaitForRingFrames(std::deque<RingFrame> &frames, long long offset, long long length, long long ringSize)
+{
+	for(;;)
+	{
+		bool overlaps = false;
+		for(const RingFrame &frame : frames)
+			overlaps = overlaps || RingOverlaps(frame.begin, frame.size, offset, length, ringSize);
+		if(!overlaps)
+			break;
+
+		RingFrame &oldest = frames.front();
+		while(glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(oldest.fence);
+		frames.pop_front();
+	}
+}
+
+void OpenGLRenderDevice::FenceRingFrame(RingFrame &frame, std::deque<RingFrame> &frames)
+{
+	if(frame.size)
+	{
+		frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		frames.push_back(frame);
+		frame = RingFrame();
+	}
+	while(!frames.empty())
+	{
+		GLenum status = glClientWaitSync(frames.front().fence, 0, 0);
+		if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(frames.front().fence);
+		frames.pop_front();
+	}
+}
+
+long long OpenGLRenderDevice::WriteUniformData(const void *data, long long size)
+{
+	if(!data || size <= 0)
+	{
+		std::cout << "ERROR::UNIFORMDATA::INVALID_SIZE\n" << size << std::endl;
+		return -1;
+	}
+
+	// every write starts on an offset glBindBufferRange accepts, and never wraps around the end of the ring
+	long long length = (size + m_UniformAlignment - 1) / m_UniformAlignment * m_UniformAlignment;
+	long long offset = m_UniformRingHead;
+	long long skipped = 0;
+	if(offset + length > m_UniformRingSize)
+	{
+		skipped = m_UniformRingSize - offset;
+		offset = 0;
+	}
+
+	// the frame cannot overwrite its own data, which its draws may not have read yet
+	long long frameSize = m_UniformFrame.size ? m_UniformFrame.size + skipped + length : length;
+	if(frameSize > m_UniformRingSize)
+	{
+		std::cout << "ERROR::UNIFORMDATA::FRAME_TOO_LARGE\n" << frameSize << " bytes written this frame" << std::endl;
+		return -1;
+	}
+
+	// wait for earlier frames still using the space, which only happens when more than
+	// UNIFORM_RING_FRAMES frames are in flight or a frame writes more than UNIFORM_DATA_FRAME_SIZE
+	WaitForRingFrames(m_UniformRingFrames, offset, length, m_UniformRingSize);
+
+	// staged data is uploaded with one map, so it must be contiguous in the ring
+	if(!m_UniformStaging.empty() && offset != m_UniformStagingBegin + static_cast<long long>(m_UniformStaging.size()))
+		FlushUniformData();
+	if(m_UniformStaging.empty())
+		m_UniformStagingBegin = offset;
+	m_UniformStaging.resize(static_cast<size_t>(offset + length - m_UniformStagingBegin));
+	memcpy(&m_UniformStaging[static_cast<size_t>(offset - m_UniformStagingBegin)], data, static_cast<size_t>(size));
+
+	if(!m_UniformFrame.size)
+		m_UniformFrame.begin = offset;
+	m_UniformFrame.size = frameSize;
+	m_UniformRingHead = (offset + length) % m_UniformRingSize;
+
+	return offset;
+}
+
+void OpenGLRenderDevice::SetUniformData(unsigned int slot, long long offset, long long size)
+{
+	if(offset < 0 || size <= 0 || offset + size > m_UniformRingSize)
+	{
+		std::cout << "ERROR::UNIFORMDATA::INVALID_RANGE\n" << offset << ", " << size << std::endl;
+		return;
+	}
+
+	m_State.BindBufferRange(GL_UNIFORM_BUFFER, slot, m_UniformRing, offset, size);
+}
+
+TransientVertices OpenGLRenderDevice::WriteTransientVertices(const void *data, int count, int stride)
+{
+	TransientVertices vertices = { nullptr, 0, 0 };
+	if(!data || count <= 0 || stride <= 0)
+	{
+		std::cout << "ERROR::TRANSIENTVERTICES::INVALID_SIZE\n" << count << " vertices of " << stride << " bytes" << std::endl;
+		return vertices;
+	}
+
+	if(!m_TransientVertexBuffer)
+	{
+		long long ringSize = TRANSIENT_RING_FRAMES * TRANSIENT_VERTEX_FRAME_SIZE;
+#if OPENGL_BUFFER_STORAGE
+		if(m_BufferStorage)
+			m_TransientVertexBuffer = new OpenGLVertexBuffer(m_State, ringSize, persistentBufferFlags);
+		else
+#endif
+			m_TransientVertexBuffer = new OpenGLVertexBuffer(m_State, ringSize, nullptr, BUFFERUSAGE_STREAM);
+		InitTransientRing(m_TransientVertices, m_TransientVertexBuffer->storage);
+	}
+
+	// aligned to the stride, so that the vertices can be drawn from a vertex array starting at the beginning of the ring
+	long long size = static_cast<long long>(count) * stride;
+	long long offset = 0;
+	char *destination = AllocateTransient(m_TransientVertices, "TRANSIENTVERTICES", size, stride, offset);
+	if(!destination)
+		return vertices;
+
+	memcpy(destination, data, static_cast<size_t>(size));
+	CommitTransient(m_TransientVertices);
+
+	vertices.vertexBuffer = m_TransientVertexBuffer;
+	vertices.offset = offset;
+	vertices.firstVertex = static_cast<int>(offset / stride);
+	return vertices;
+}
+
+TransientIndices OpenGLRenderDevice::WriteTransientIndices(const unsigned int *indices, int count, int baseVertex)
+{
+	TransientIndices transientIndices = { nullptr, 0 };
+	if(!indices || count <= 0)
+	{
+		std::cout << "ERROR::TRANSIENTINDICES::INVALID_SIZE\n" << count << " indices" << std::endl;
+		return transientIndices;
+	}
+
+	if(!m_TransientIndexBuffer)
+	{
+		long long ringSize = TRANSIENT_RING_FRAMES * TRANSIENT_INDEX_FRAME_SIZE;
+#if OPENGL_BUFFER_STORAGE
+		if(m_BufferStorage)
+			m_TransientIndexBuffer = new OpenGLIndexBuffer(m_State, ringSize, persistentBufferFlags, INDEXFORMAT_32);
+		else
+#endif
+			m_TransientIndexBuffer = new OpenGLIndexBuffer(m_State, ringSize, nullptr, BUFFERUSAGE_STREAM, INDEXFORMAT_32);
+		InitTransientRing(m_TransientIndices, m_TransientIndexBuffer->storage);
+	}
+
+	long long offset = 0;
+	uint32_t *destination = reinterpret_cast<uint32_t *>(AllocateTransient(m_TransientIndices, "TRANSIENTINDICES", count * 4ll, 4, offset));
+	if(!destination)
+		return transientIndices;
+
+	if(baseVertex)
+	{
+		for(int i = 0; i < count; i++)
+			destination[i] = indices[i] + baseVertex;
+	}
+	else
+		memcpy(destination, indices, count * 4u);
+	CommitTransient(m_TransientIndices);
+
+	transientIndices.indexBuffer = m_TransientIndexBuffer;
+	transientIndices.offset = offset;
+	return transientIndices;
+}
+
+void OpenGLRenderDevice::InitTransientRing(TransientRing &ring, OpenGLBuffer &buffer)
+{
+	buffer.transient = true;
+	ring.buffer = &buffer;
+	ring.size = buffer.size;
+
+#if OPENGL_BUFFER_STORAGE
+	// persistent storage is mapped once, for good; if that fails, each write maps its own range instead
+	if(m_BufferStorage)
+	{
+		m_State.BindBuffer(buffer.target, buffer.buffer);
+		ring.mapping = static_cast<char *>(glMapBufferRange(buffer.target, 0, buffer.size, persistentBufferFlags));
+	}
+#endif
+}
+
+void OpenGLRenderDevice::ReleaseTransientRing(TransientRing &ring)
+{
+	for(const RingFrame &frame : ring.frames)
+		glDeleteSync(frame.fence);
+	if(ring.mapping)
+	{
+		m_State.BindBuffer(ring.buffer->target, ring.buffer->buffer);
+		glUnmapBuffer(ring.buffer->target);
+	}
+}
+
+char *OpenGLRenderDevice::AllocateTransient(TransientRing &ring, const char *type, long long size, long long alignment, long long &offset)
+{
+	// writes never wrap around the end of the ring
+	offset = (ring.head + alignment - 1) / alignment * alignment;
+	long long skipped = offset - ring.head;
+	if(offset + size > ring.size)
+	{
+		skipped = ring.size - ring.head;
+		offset = 0;
+	}
+
+	// the frame cannot overwrite its own geometry, which its draws may not have read yet
+	long long frameSize = ring.frame.size ? ring.frame.size + skipped + size : size;
+	if(frameSize > ring.size)
+	{
+		std::cout << "ERROR::" << type << "::FRAME_TOO_LARGE\n" << frameSize << " bytes written this frame" << std::endl;
+		return nullptr;
+	}
+
+	// only waits when more than TRANSIENT_RING_FRAMES frames are in flight or a frame writes more than its frame size
+	WaitForRingFrames(ring.frames, offset, size, ring.size);
+
+	if(!ring.frame.size)
+		ring.frame.begin = offset;
+	ring.frame.size = frameSize;
+	ring.head = (offset + size) % ring.size;
+
+	if(ring.mapping)
+		return ring.mapping + offset;
+
+	// nothing the GPU may still read lies in the range, so there is no need for GL to synchronize
+	m_State.BindBuffer(ring.buffer->target, ring.buffer->buffer);
+	char *mapped = static_cast<char *>(glMapBufferRange(ring.buffer->target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if(!mapped)
+		std::cout << "ERROR::" << type << "::MAP_FAILED\n" << offset << ", " << size << " bytes" << std::endl;
+	return mapped;
+}
+
+void OpenGLRenderDevice::CommitTransient(TransientRing &ring)
+{
+	// a coherent persistent mapping makes writes visible to later draws without unmapping
+	if(ring.mapping)
+		return;
+	m_State.BindBuffer(ring.buffer->target, ring.buffer->buffer);
+	glUnmapBuffer(ring.buffer->target);
+}
+
+void OpenGLRenderDevice::FlushUniformData()
+{
+	if(m_UniformStaging.empty())
+		return;
+
+	// nothing the GPU may still read lies in the range, so there is no need for GL to synchronize
+	GLsizeiptr size = static_cast<GLsizeiptr>(m_UniformStaging.size());
+	m_State.BindBuffer(GL_COPY_WRITE_BUFFER, m_UniformRing);
+	void *mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, m_UniformStagingBegin, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if(mapped)
+	{
+		memcpy(mapped, &m_UniformStaging[0], m_UniformStaging.size());
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+	else
+		glBufferSubData(GL_COPY_WRITE_BUFFER, m_UniformStagingBegin, size, &m_UniformStaging[0]);
+
+	m_UniformStaging.clear();
+}
+
+long long OpenGLRenderDevice::StageTextureUpload(const void *data, long long size)
+{
+	if(size > TEXTURE_UPLOAD_BUFFER_SIZE)
+		return -1;
+
+	// keep offsets aligned to more than any texel or block needs
+	long long offset = (m_TextureUploadHead + 15) & ~15LL;
+	if(offset + size > TEXTURE_UPLOAD_BUFFER_SIZE)
+	{
+		NextTextureUploadBuffer();
+		offset = 0;
+	}
+
+	TextureUploadBuffer &upload = m_TextureUploadBuffers[m_TextureUploadBuffer];
+	if(!upload.buffer)
+	{
+		glGenBuffers(1, &upload.buffer);
+		m_State.BindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, TEXTURE_UPLOAD_BUFFER_SIZE, nullptr, GL_STREAM_DRAW);
+	}
+	else
+		m_State.BindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer);
+
+	// only waits when the GPU is more than TEXTURE_UPLOAD_BUFFERS buffers behind
+	if(upload.fence)
+	{
+		while(glClientWaitSync(upload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(upload.fence);
+		upload.fence = nullptr;
+	}
+
+	// nothing the GPU may still read lies in the range, so there is no need for GL to synchronize
+	void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if(mapped)
+	{
+		memcpy(mapped, data, static_cast<size_t>(size));
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+		glBufferSubData(GL_PIXEL_UNPACK_BUFFER, offset, size, data);
+
+	m_TextureUploadHead = offset + size;
+	return offset;
+}
+
+void OpenGLRenderDevice::NextTextureUploadBuffer()
+{
+	m_TextureUploadBuffers[m_TextureUploadBuffer].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_TextureUploadBuffer = (m_TextureUploadBuffer + 1) % TEXTURE_UPLOAD_BUFFERS;
+	m_TextureUploadHead = 0;
+}
+
+void OpenGLRenderDevice::PrepareDraw()
+{
+	if(!m_DirtyMipTextures.empty())
+		GenerateDirtyMips();
+	FlushUniformData();
+	if(m_Pipeline)
+		m_Pipeline->FlushUniforms();
+}
+
+bool OpenGLRenderDevice::PrepareIndexedDraw(IndexFormat format)
+{
+	// GL would read the buffer's indices as the other width, drawing garbage or reading past its end
+	if(m_IndexBuffer && m_IndexBuffer->format != format)
+	{
+		std::cout << "ERROR::INDEXBUFFER::FORMAT_MISMATCH\n" << GetIndexSize(format) * 8 << "-bit draw from a "
+			<< GetIndexSize(m_IndexBuffer->format) * 8 << "-bit index buffer" << std::endl;
+		return false;
+	}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	PrepareDraw();
+
+	// restarts are only ever the largest index of the format, which GetNarrowestIndexFormat keeps free
+	if(m_PrimitiveRestart)
+		m_State.PrimitiveRestartIndex(format == INDEXFORMAT_16 ? PRIMITIVE_RESTART_INDEX16 : PRIMITIVE_RESTART_INDEX32);
+	return true;
 }
 
 RasterState *OpenGLRenderDevice::CreateRasterState(bool cullEnabled, Winding frontFace, Face cullFace, RasterMode rasterMode)
@@ -543,13 +1986,10 @@ void OpenGLRenderDevice::SetRasterState(RasterState *rasterState)
 
 	if(m_RasterState != oldRasterState)
 	{
-		if(m_RasterState->cullEnabled)
-			glEnable(GL_CULL_FACE);
-		else
-			glDisable(GL_CULL_FACE);
-		glFrontFace(m_RasterState->frontFace);
-		glCullFace(m_RasterState->cullFace);
-		glPolygonMode(GL_FRONT_AND_BACK, m_RasterState->polygonMode);
+		m_State.Enable(GL_CULL_FACE, m_RasterState->cullEnabled);
+		m_State.FrontFace(m_RasterState->frontFace);
+		m_State.CullFace(m_RasterState->cullFace);
+		m_State.PolygonMode(m_RasterState->polygonMode);
 	}
 }
 
@@ -580,47 +2020,279 @@ void OpenGLRenderDevice::SetDepthStencilState(DepthStencilState *depthStencilSta
 
 	if(m_DepthStencilState != oldDepthStencilState)
 	{
-		if(m_DepthStencilState->depthEnabled)
-			glEnable(GL_DEPTH_TEST);
-		else
-			glDisable(GL_DEPTH_TEST);
-		glDepthFunc(m_DepthStencilState->depthFunc);
-		glDepthMask(m_DepthStencilState->depthWriteEnabled ? GL_TRUE : GL_FALSE);
-		glDepthRange(m_DepthStencilState->depthNear, m_DepthStencilState->depthFar);
+		m_State.Enable(GL_DEPTH_TEST, m_DepthStencilState->depthEnabled);
+		m_State.DepthFunc(m_DepthStencilState->depthFunc);
+		m_State.DepthMask(m_DepthStencilState->depthWriteEnabled);
+		m_State.DepthRange(m_DepthStencilState->depthNear, m_DepthStencilState->depthFar);
 
-		if(m_DepthStencilState->frontFaceStencilEnabled || m_DepthStencilState->backFaceStencilEnabled)
-			glEnable(GL_STENCIL_TEST);
-		else
-			glDisable(GL_STENCIL_TEST);
+		m_State.Enable(GL_STENCIL_TEST, m_DepthStencilState->frontFaceStencilEnabled || m_DepthStencilState->backFaceStencilEnabled);
 
 		// front face
-		glStencilFuncSeparate(GL_FRONT, m_DepthStencilState->frontStencilFunc, m_DepthStencilState->frontFaceRef, m_DepthStencilState->frontFaceReadMask);
-		glStencilMaskSeparate(GL_FRONT, m_DepthStencilState->frontFaceWriteMask);
-		glStencilOpSeparate(GL_FRONT, m_DepthStencilState->frontFaceStencilFail, m_DepthStencilState->frontFaceDepthFail, m_DepthStencilState->frontFaceStencilPass);
+		m_State.StencilFuncSeparate(GL_FRONT, m_DepthStencilState->frontStencilFunc, m_DepthStencilState->frontFaceRef, m_DepthStencilState->frontFaceReadMask);
+		m_State.StencilMaskSeparate(GL_FRONT, m_DepthStencilState->frontFaceWriteMask);
+		m_State.StencilOpSeparate(GL_FRONT, m_DepthStencilState->frontFaceStencilFail, m_DepthStencilState->frontFaceDepthFail, m_DepthStencilState->frontFaceStencilPass);
 
 		// back face
-		glStencilFuncSeparate(GL_BACK, m_DepthStencilState->backStencilFunc, m_DepthStencilState->backFaceRef, m_DepthStencilState->backFaceReadMask);
-		glStencilMaskSeparate(GL_BACK, m_DepthStencilState->backFaceWriteMask);
-		glStencilOpSeparate(GL_BACK, m_DepthStencilState->backFaceStencilFail, m_DepthStencilState->backFaceDepthFail, m_DepthStencilState->backFaceStencilPass);
+		m_State.StencilFuncSeparate(GL_BACK, m_DepthStencilState->backStencilFunc, m_DepthStencilState->backFaceRef, m_DepthStencilState->backFaceReadMask);
+		m_State.StencilMaskSeparate(GL_BACK, m_DepthStencilState->backFaceWriteMask);
+		m_State.StencilOpSeparate(GL_BACK, m_DepthStencilState->backFaceStencilFail, m_DepthStencilState->backFaceDepthFail, m_DepthStencilState->backFaceStencilPass);
 	}
 }
 
 void OpenGLRenderDevice::Clear(float red, float green, float blue, float alpha, float depth, int stencil)
 {
-	glClearColor(red, green, blue, alpha);
-	glClearDepth(depth);
-	glClearStencil(stencil);
+	m_State.ClearColor(red, green, blue, alpha);
+	m_State.ClearDepth(depth);
+	m_State.ClearStencil(stencil);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT| GL_STENCIL_BUFFER_BIT);
 }
 
 void OpenGLRenderDevice::DrawTriangles(int offset, int count)
 {
-	glDrawArrays(GL_TRIANGLES, offset, count);
+	PrepareDraw();
+	glDrawArrays(m_PrimitiveMode, offset, count);
+}
+
+void OpenGLRenderDevice::DrawTrianglesIndexed32(long long offset, int count, int baseVertex)
+{
+	if(!PrepareIndexedDraw(INDEXFORMAT_32))
+		return;
+	if(baseVertex)
+		glDrawElementsBaseVertex(m_PrimitiveMode, count, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset), baseVertex);
+	else
+		glDrawElements(m_PrimitiveMode, count, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset));
+}
+
+void OpenGLRenderDevice::DrawTrianglesIndexed16(long long offset, int count, int baseVertex)
+{
+	if(!PrepareIndexedDraw(INDEXFORMAT_16))
+		return;
+	if(baseVertex)
+		glDrawElementsBaseVertex(m_PrimitiveMode, count, GL_UNSIGNED_SHORT, reinterpret_cast<const void *>(offset), baseVertex);
+	else
+		glDrawElements(m_PrimitiveMode, count, GL_UNSIGNED_SHORT, reinterpret_cast<const void *>(offset));
+}
+
+void OpenGLRenderDevice::DrawTrianglesInstanced(int offset, int count, int instanceCount)
+{
+	PrepareDraw();
+	glDrawArraysInstanced(m_PrimitiveMode, offset, count, instanceCount);
+}
+
+void OpenGLRenderDevice::DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	if(!PrepareIndexedDraw(INDEXFORMAT_32))
+		return;
+	if(baseVertex)
+		glDrawElementsInstancedBaseVertex(m_PrimitiveMode, count, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset), instanceCount, baseVertex);
+	else
+		glDrawElementsInstanced(m_PrimitiveMode, count, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset), instanceCount);
 }
 
-void OpenGLRenderDevice::DrawTrianglesIndexed32(long long offset, int count)
+void OpenGLRenderDevice::DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex)
 {
-	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset));
+	if(!PrepareIndexedDraw(INDEXFORMAT_16))
+		return;
+	if(baseVertex)
+		glDrawElementsInstancedBaseVertex(m_PrimitiveMode, count, GL_UNSIGNED_SHORT, reinterpret_cast<const void *>(offset), instanceCount, baseVertex);
+	else
+		glDrawElementsInstanced(m_PrimitiveMode, count, GL_UNSIGNED_SHORT, reinterpret_cast<const void *>(offset), instanceCount);
+}
+
+void OpenGLRenderDevice::DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts)
+{
+	if(drawCount <= 0)
+		return;
+	PrepareDraw();
+	glMultiDrawArrays(m_PrimitiveMode, offsets, counts, drawCount);
+}
+
+void OpenGLRenderDevice::DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices, IndexFormat format)
+{
+	if(drawCount <= 0)
+		return;
+
+	m_MultiDrawIndices.resize(drawCount);
+	for(int i = 0; i < drawCount; i++)
+		m_MultiDrawIndices[i] = reinterpret_cast<const void *>(offsets[i]);
+
+	if(!PrepareIndexedDraw(format))
+		return;
+	GLenum type = format == INDEXFORMAT_16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	if(baseVertices)
+		glMultiDrawElementsBaseVertex(m_PrimitiveMode, counts, type, &m_MultiDrawIndices[0], drawCount, baseVertices);
+	else
+		glMultiDrawElements(m_PrimitiveMode, counts, type, &m_MultiDrawIndices[0], drawCount);
+}
+
+void OpenGLRenderDevice::DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount, IndexFormat format)
+{
+	OpenGLBuffer *storage = indirectBuffer ? &reinterpret_cast<OpenGLIndirectBuffer *>(indirectBuffer)->storage : nullptr;
+	if(!storage || drawCount < 0 || offset % 4 || (drawCount && !storage->IsValidRange(offset, drawCount * static_cast<long long>(sizeof(DrawIndexedIndirectCommand)))))
+	{
+		std::cout << "ERROR::INDIRECTBUFFER::INVALID_RANGE\n" << offset << ", " << drawCount << " draws" << std::endl;
+		return;
+	}
+
+	if(!PrepareIndexedDraw(format))
+		return;
+	m_State.BindBuffer(GL_DRAW_INDIRECT_BUFFER, storage->buffer);
+
+	// glMultiDrawElementsIndirect needs OpenGL 4.3, so the draws are made one by one; the
+	// driver still reads their arguments from GPU memory
+	GLenum type = format == INDEXFORMAT_16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	for(int i = 0; i < drawCount; i++)
+		glDrawElementsIndirect(m_PrimitiveMode, type, reinterpret_cast<const void *>(offset + i * static_cast<long long>(sizeof(DrawIndexedIndirectCommand))));
+}
+
+void OpenGLRenderDevice::SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists)
+{
+	for(unsigned int i = 0; i < numCommandLists; i++)
+		ExecuteCommandList(*commandLists[i], *this);
+}
+
+// marks a scope that is not being timed because its frame's queries are still in flight
+static const unsigned int GPU_SCOPE_NOT_TIMED = ~0u;
+
+void OpenGLRenderDevice::EndFrame()
+{
+	if(!m_GpuScopeStack.empty())
+	{
+		std::cout << "ERROR::GPUSCOPE::NOT_ENDED\n" << m_GpuScopeStack.size() << " scopes were still open at the end of the frame" << std::endl;
+		while(!m_GpuScopeStack.empty())
+			EndGpuScope();
+	}
+
+	GpuQueryFrame &frame = m_GpuQueryFrames[m_GpuQueryFrame];
+	if(!frame.pending && !frame.queries.empty())
+		frame.pending = true;
+
+	m_GpuQueryFrame = (m_GpuQueryFrame + 1) % GPU_QUERY_FRAMES;
+
+	ResolveGpuQueries();
+
+	// fence the frame's uniform data and transient geometry, and retire the frames the GPU has finished with
+	FlushUniformData();
+	FenceRingFrame(m_UniformFrame, m_UniformRingFrames);
+	FenceRingFrame(m_TransientVertices.frame, m_TransientVertices.frames);
+	FenceRingFrame(m_TransientIndices.frame, m_TransientIndices.frames);
+
+	// staged texture updates are fenced by frame, so that a buffer is reused a few frames later
+	if(m_TextureUploadHead)
+		NextTextureUploadBuffer();
+
+	m_StateStats = m_State.GetStats();
+	m_State.ResetStats();
+}
+
+void OpenGLRenderDevice::BeginGpuScope(const char *name)
+{
+	// when the GPU is more than GPU_QUERY_FRAMES frames behind, this frame goes untimed rather than waiting
+	GpuQueryFrame &frame = m_GpuQueryFrames[m_GpuQueryFrame];
+	if(frame.pending)
+	{
+		m_GpuScopeStack.push_back(GPU_SCOPE_NOT_TIMED);
+		return;
+	}
+
+	GpuScopeQuery query;
+	query.scope = m_GpuScopes.Find(name, static_cast<unsigned int>(m_GpuScopeStack.size()));
+	query.begin = AllocateGpuQuery();
+	query.end = 0;
+	glQueryCounter(query.begin, GL_TIMESTAMP);
+
+	m_GpuScopeStack.push_back(static_cast<unsigned int>(frame.queries.size()));
+	frame.queries.push_back(query);
+}
+
+void OpenGLRenderDevice::EndGpuScope()
+{
+	if(m_GpuScopeStack.empty())
+	{
+		std::cout << "ERROR::GPUSCOPE::END_WITHOUT_BEGIN" << std::endl;
+		return;
+	}
+
+	unsigned int index = m_GpuScopeStack.back();
+	m_GpuScopeStack.pop_back();
+	if(index == GPU_SCOPE_NOT_TIMED)
+		return;
+
+	GpuScopeQuery &query = m_GpuQueryFrames[m_GpuQueryFrame].queries[index];
+	query.end = AllocateGpuQuery();
+	glQueryCounter(query.end, GL_TIMESTAMP);
+}
+
+unsigned int OpenGLRenderDevice::GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats)
+{
+	return m_GpuScopes.GetStats(maxScopes, stats);
+}
+
+void OpenGLRenderDevice::ResetGpuScopeStats()
+{
+	// queries in flight refer to the old scopes, so drop their results along with them
+	for(GpuQueryFrame &frame : m_GpuQueryFrames)
+		ReleaseGpuQueries(frame);
+	m_GpuScopeStack.clear();
+	m_GpuScopes.Reset();
+}
+
+void OpenGLRenderDevice::ResolveGpuQueries()
+{
+	// m_GpuQueryFrame is now the oldest frame in the ring
+	for(unsigned int i = 0; i < GPU_QUERY_FRAMES; i++)
+	{
+		GpuQueryFrame &frame = m_GpuQueryFrames[(m_GpuQueryFrame + i) % GPU_QUERY_FRAMES];
+		if(!frame.pending)
+			continue;
+
+		// frames complete in order, so stop at the first one still in flight
+		for(const GpuScopeQuery &query : frame.queries)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!available)
+				return;
+		}
+
+		for(const GpuScopeQuery &query : frame.queries)
+		{
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+			m_GpuScopes.Accumulate(query.scope, (end - begin) / 1.0e6);
+		}
+		m_GpuScopes.ResolveFrame();
+
+		ReleaseGpuQueries(frame);
+	}
+}
+
+void OpenGLRenderDevice::ReleaseGpuQueries(GpuQueryFrame &frame)
+{
+	for(const GpuScopeQuery &query : frame.queries)
+	{
+		m_FreeGpuQueries.push_back(query.begin);
+		if(query.end)
+			m_FreeGpuQueries.push_back(query.end);
+	}
+	frame.queries.clear();
+	frame.pending = false;
+}
+
+unsigned int OpenGLRenderDevice::AllocateGpuQuery()
+{
+	if(m_FreeGpuQueries.empty())
+	{
+		// create queries in batches; they are recycled once read back
+		GLuint queries[64];
+		glGenQueries(64, queries);
+		m_FreeGpuQueries.insert(m_FreeGpuQueries.end(), queries, queries + 64);
+	}
+
+	unsigned int query = m_FreeGpuQueries.back();
+	m_FreeGpuQueries.pop_back();
+	return query;
 }
 
 } // end namespace render
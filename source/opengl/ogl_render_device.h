@@ -2,18 +2,36 @@
 
 #include "render_device/render_device.h"
 
+#include "gpu_scope_table.h"
+#include "ogl_state_cache.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 namespace render
 {
 
+class ThreadPool;
+class OpenGLPipeline;
+class OpenGLBuffer;
+class OpenGLVertexBuffer;
+class OpenGLIndexBuffer;
+class OpenGLTextureStorage;
+class OpenGLSamplerState;
 class OpenGLRasterState;
 class OpenGLDepthStencilState;
 
-class OpenGLRenderDevice : public RenderDevice
+class OpenGLRenderDevice final : public RenderDevice
 {
 public:
 
 	OpenGLRenderDevice();
 
+	~OpenGLRenderDevice() override;
+
 	VertexShader *CreateVertexShader(const char *code) override;
 
 	void DestroyVertexShader(VertexShader *vertexShader) override;
@@ -28,7 +46,15 @@ public:
 
 	void SetPipeline(Pipeline *pipeline) override;
 
-	VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr) override;
+	VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	void CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
 
 	void DestroyVertexBuffer(VertexBuffer *vertexBuffer) override;
 
@@ -42,18 +68,81 @@ public:
 
 	void SetVertexArray(VertexArray *vertexArray) override;
 
-	IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr) override;
+	IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC, IndexFormat format = INDEXFORMAT_32) override;
+
+	void UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size) override;
 
     void DestroyIndexBuffer(IndexBuffer *indexBuffer) override;
     
     void SetIndexBuffer(IndexBuffer *indexBuffer) override;
 
-    Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr) override;
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+
+	IndirectBuffer *CreateIndirectBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data) override;
+
+	void CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndirectBuffer(IndirectBuffer *indirectBuffer) override;
+
+    Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	bool IsTextureFormatSupported(TextureFormat format) override;
+
+	void UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async = false) override;
 
     void DestroyTexture2D(Texture2D *texture2D) override;
     
 	void SetTexture2D(unsigned int slot, Texture2D *texture2D) override;
 
+	Texture2DArray *CreateTexture2DArray(int width, int height, int layers, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	void UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async = false) override;
+
+	void UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+		bool async = false) override;
+
+	void DestroyTexture2DArray(Texture2DArray *texture2DArray) override;
+
+	void SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray) override;
+
+	SamplerState *CreateSamplerState(TextureFilter minFilter = TEXTUREFILTER_LINEAR, TextureFilter magFilter = TEXTUREFILTER_LINEAR,
+		MipFilter mipFilter = MIPFILTER_LINEAR, TextureWrap wrapS = TEXTUREWRAP_CLAMP_TO_EDGE, TextureWrap wrapT = TEXTUREWRAP_CLAMP_TO_EDGE) override;
+
+	void DestroySamplerState(SamplerState *samplerState) override;
+
+	void SetSamplerState(unsigned int slot, SamplerState *samplerState) override;
+
+	UniformBuffer *CreateUniformBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void DestroyUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer) override;
+
+	long long WriteUniformData(const void *data, long long size) override;
+
+	void SetUniformData(unsigned int slot, long long offset, long long size) override;
+
+	// Persistently mapped where GL_ARB_buffer_storage is supported, and mapped unsynchronized a write at a time otherwise
+	TransientVertices WriteTransientVertices(const void *data, int count, int stride) override;
+
+	TransientIndices WriteTransientIndices(const unsigned int *indices, int count, int baseVertex = 0) override;
+
 	RasterState *CreateRasterState(bool cullEnabled = true, Winding frontFace = WINDING_CCW, Face cullFace = FACE_BACK, RasterMode rasterMode = RASTERMODE_FILL) override;
 
 	void DestroyRasterState(RasterState *rasterState) override;
@@ -92,16 +181,238 @@ public:
 
 	void DrawTriangles(int offset, int count) override;
 
-	void DrawTrianglesIndexed32(long long offset, int count) override;
+	void DrawTrianglesIndexed32(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesInstanced(int offset, int count, int instanceCount) override;
+
+	void DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts) override;
+
+	void DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices = nullptr,
+		IndexFormat format = INDEXFORMAT_32) override;
+
+	void DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount = 1, IndexFormat format = INDEXFORMAT_32) override;
+
+	void SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists) override;
+
+	void EndFrame() override;
+
+	void BeginGpuScope(const char *name) override;
+
+	void EndGpuScope() override;
+
+	unsigned int GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats) override;
+
+	void ResetGpuScopeStats() override;
+
+	// GL state changes made and skipped as redundant in the last frame ended with EndFrame
+	const OpenGLStateCacheStats &GetStateStats() const { return m_StateStats; }
+
+	// Number of frames of GPU timestamp queries kept in flight before their results are read
+	static const unsigned int GPU_QUERY_FRAMES = 4;
+
+	// Number of frames of UNIFORM_DATA_FRAME_SIZE bytes the streaming uniform ring holds
+	static const unsigned int UNIFORM_RING_FRAMES = 3;
+
+	// Number of frames of TRANSIENT_VERTEX_FRAME_SIZE and TRANSIENT_INDEX_FRAME_SIZE bytes the transient geometry rings hold
+	static const unsigned int TRANSIENT_RING_FRAMES = 3;
+
+	// Number and size of the pixel unpack buffers asynchronous texture updates are staged
+	// in; larger updates are made synchronously
+	static const unsigned int TEXTURE_UPLOAD_BUFFERS = 4;
+	static const long long TEXTURE_UPLOAD_BUFFER_SIZE = 4 * 1024 * 1024;
 
 private:
 
+	// A pair of timestamp queries around one GPU scope
+	struct GpuScopeQuery
+	{
+		unsigned int scope;
+		unsigned int begin;
+		unsigned int end;
+	};
+
+	// The timestamp queries issued in one frame
+	struct GpuQueryFrame
+	{
+		std::vector<GpuScopeQuery> queries;
+		bool pending = false; // issued and not yet read back
+	};
+
+	// Data written to a streaming ring in one frame; size counts from begin, wrapping around the end of the ring
+	struct RingFrame
+	{
+		GLsync fence = nullptr;
+		long long begin = 0;
+		long long size = 0;
+	};
+
+	// A ring of transient vertices or indices in the storage of one buffer
+	struct TransientRing
+	{
+		OpenGLBuffer *buffer = nullptr;
+		char *mapping = nullptr; // all of the ring, when it is persistently mapped
+		long long size = 0;
+		long long head = 0; // where the next write goes
+		RingFrame frame; // being written
+		std::deque<RingFrame> frames; // in flight, oldest first
+	};
+
+	// A pixel unpack buffer that texture updates are staged in. Once filled, or at the end
+	// of the frame, it is fenced and only written again after the GPU has read it.
+	struct TextureUploadBuffer
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	// Returns whether a buffer of size bytes with usage can be created, printing an error under type if not
+	bool IsValidBuffer(const char *type, long long size, BufferUsage usage) const;
+
+	// Update, map, unmap or copy between vertex, index or uniform buffers, printing errors under type
+	void UpdateBuffer(const char *type, OpenGLBuffer *buffer, long long offset, long long size, const void *data);
+	void *MapBuffer(const char *type, OpenGLBuffer *buffer, long long offset, long long size, unsigned int mapFlags);
+	void UnmapBuffer(const char *type, OpenGLBuffer *buffer);
+	void CopyBuffer(const char *type, OpenGLBuffer *destination, long long destinationOffset, OpenGLBuffer *source, long long sourceOffset, long long size);
+
+	// Wait for the frames of a ring that use any of length bytes at offset to be finished with by the GPU
+	void WaitForRingFrames(std::deque<RingFrame> &frames, long long offset, long long length, long long ringSize);
+
+	// Fence the frame written to a ring, if anything was, and retire the frames the GPU has finished with
+	void FenceRingFrame(RingFrame &frame, std::deque<RingFrame> &frames);
+
+	// Set up a transient ring to be written to buffer, which the application may then no longer update or map
+	void InitTransientRing(TransientRing &ring, OpenGLBuffer &buffer);
+
+	// Unmap a transient ring and delete its fences, before its buffer is deleted
+	void ReleaseTransientRing(TransientRing &ring);
+
+	// Returns where to write size bytes of a transient ring, at an offset aligned to alignment, or nullptr after printing
+	// an error under type if they do not fit; the write is finished with CommitTransient
+	char *AllocateTransient(TransientRing &ring, const char *type, long long size, long long alignment, long long &offset);
+	void CommitTransient(TransientRing &ring);
+
+	// Upload the uniform data staged since the last upload with one unsynchronized map
+	void FlushUniformData();
+
+	// Copy size bytes of data to the current texture upload buffer and leave it bound to
+	// GL_PIXEL_UNPACK_BUFFER, returning the offset they were copied to, or -1 if they do not fit
+	long long StageTextureUpload(const void *data, long long size);
+
+	// Fence the current texture upload buffer and move on to the next
+	void NextTextureUploadBuffer();
+
+	// Returns whether textures of the given size, format and levels can be created, printing
+	// an error under type if not
+	bool IsValidTexture(const char *type, int width, int height, TextureFormat format, int mipLevels, MipPolicy mipPolicy) const;
+
+	// Copy a region of one level of one layer of a texture, staging it first if async
+	void UploadTextureRegion(const OpenGLTextureStorage &storage, int layer, int mipLevel, int x, int y, int width, int height, const void *data, bool async);
+
+	// Copy every level of one layer of a texture, filling those not in data as its mip policy says
+	void UploadTextureLayer(OpenGLTextureStorage &storage, int layer, const void *data, bool async);
+
+	// Copy a region of texels into a level of a layer, keeping the levels the mip policy
+	// fills from the top level up to date
+	void UpdateTextureRegion(OpenGLTextureStorage &storage, int layer, int mipLevel, int x, int y, int width, int height, const void *data, bool async);
+
+	// Have the driver generate the levels of a texture whose top level changed at the next draw
+	void MarkMipsDirty(OpenGLTextureStorage &storage);
+
+	// Generate the levels of a texture whose top levels changed, now rather than at the next draw
+	void GenerateMips(OpenGLTextureStorage &storage);
+
+	// Generate the levels of every texture whose top levels changed since its levels were last generated
+	void GenerateDirtyMips();
+
+	// Upload everything the next draw reads
+	void PrepareDraw();
+
+	// PrepareDraw, and restart strips at the restart index of format; returns false, printing
+	// an error, if the bound index buffer holds indices of another format
+	bool PrepareIndexedDraw(IndexFormat format);
+
+	// Read back the timings of every pending frame whose queries have completed, oldest first
+	void ResolveGpuQueries();
+
+	// Return the queries of a frame to the free list
+	void ReleaseGpuQueries(GpuQueryFrame &frame);
+
+	unsigned int AllocateGpuQuery();
+
+	// declared first so that it is constructed before the default states are set through it
+	OpenGLStateCache m_State;
+	OpenGLStateCacheStats m_StateStats;
+
+	// uniforms set on the bound pipeline are uploaded when it is next drawn with
+	OpenGLPipeline *m_Pipeline = nullptr;
+
+	// index buffer last set, whose format indexed draws must match
+	OpenGLIndexBuffer *m_IndexBuffer = nullptr;
+
+	// texture formats the driver can sample, queried at creation
+	bool m_TextureFormats[TEXTUREFORMAT_MAX] = {};
+
+	// number of layers a texture array can have
+	GLint m_MaxTextureLayers = 0;
+
+	// mip chains filtered on the CPU, and the threads that filter them, created on first use
+	std::vector<uint32_t> m_MipChain;
+	std::unique_ptr<ThreadPool> m_MipThreadPool;
+
+	// textures whose levels the driver generates at the next draw, so that uploading many
+	// layers or regions generates them once
+	std::vector<OpenGLTextureStorage *> m_DirtyMipTextures;
+
+	// sampler states by descriptor, so that identical ones share a GL sampler object
+	std::unordered_map<uint32_t, OpenGLSamplerState *> m_SamplerStates;
+
 	OpenGLRasterState *m_RasterState = nullptr;
 	OpenGLRasterState *m_DefaultRasterState = nullptr;
 
 	OpenGLDepthStencilState *m_DepthStencilState = nullptr;
 	OpenGLDepthStencilState *m_DefaultDepthStencilState = nullptr;
 
+	// mode draws are made with, and whether their indices restart strips
+	GLenum m_PrimitiveMode = GL_TRIANGLES;
+	bool m_PrimitiveRestart = false;
+
+	// streaming uniform ring; frames of data are fenced so that only space the GPU is done with is reused
+	GLuint m_UniformRing = 0;
+	long long m_UniformRingSize = 0;
+	long long m_UniformAlignment = 256;
+	long long m_UniformRingHead = 0; // where the next write goes
+	RingFrame m_UniformFrame; // being written
+	std::deque<RingFrame> m_UniformRingFrames; // in flight, oldest first
+	std::vector<char> m_UniformStaging; // written since the last upload
+	long long m_UniformStagingBegin = 0; // ring offset of m_UniformStaging
+
+	// transient geometry rings and the buffers they are handed out as, created on first use
+	OpenGLVertexBuffer *m_TransientVertexBuffer = nullptr;
+	OpenGLIndexBuffer *m_TransientIndexBuffer = nullptr;
+	TransientRing m_TransientVertices;
+	TransientRing m_TransientIndices;
+	bool m_BufferStorage = false; // whether rings can be persistently mapped
+
+	// index buffer offsets of the draws of DrawTrianglesIndexedMulti, as the pointers GL takes them as
+	std::vector<const void *> m_MultiDrawIndices;
+
+	// ring of buffers that asynchronous texture updates are staged in, created on first use
+	TextureUploadBuffer m_TextureUploadBuffers[TEXTURE_UPLOAD_BUFFERS];
+	unsigned int m_TextureUploadBuffer = 0; // being written
+	long long m_TextureUploadHead = 0; // bytes written to it
+
+	// GPU scope timing; queries live in a ring of frames so results are only read once available
+	GpuScopeTable m_GpuScopes;
+	GpuQueryFrame m_GpuQueryFrames[GPU_QUERY_FRAMES];
+	unsigned int m_GpuQueryFrame = 0; // frame being recorded
+	std::vector<unsigned int> m_GpuScopeStack; // indices of open scopes in the recorded frame's queries
+	std::vector<unsigned int> m_FreeGpuQueries;
 };
 
 } // end namespace render
@@ -0,0 +1,401 @@
+#include "ogl_state_cache.h"
+
+#include <limits>
+
+namespace render
+{
+
+// binding points tracked by the cache; binds to any other target always reach GL
+static const GLenum bufferTargets[] = { GL_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+	GL_UNIFORM_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_TEXTURE_BUFFER };
+static const GLenum textureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_3D };
+static const GLenum caps[] = { GL_CULL_FACE, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_BLEND, GL_SCISSOR_TEST, GL_PRIMITIVE_RESTART };
+
+static const unsigned int NUM_BUFFER_TARGETS = sizeof(bufferTargets) / sizeof(bufferTargets[0]);
+static const unsigned int NUM_TEXTURE_TARGETS = sizeof(textureTargets) / sizeof(textureTargets[0]);
+static const unsigned int NUM_CAPS = sizeof(caps) / sizeof(caps[0]);
+
+// stands for a name or enum whose value is unknown; no object or enum has it
+static const GLuint UNKNOWN = ~0u;
+
+// never equal to anything, itself included
+static const float UNKNOWN_FLOAT = std::numeric_limits<float>::quiet_NaN();
+
+template<unsigned int N> static int FindIndex(const GLenum (&values)[N], GLenum value)
+{
+	for(unsigned int i = 0; i < N; i++)
+	{
+		if(values[i] == value)
+			return static_cast<int>(i);
+	}
+	return -1;
+}
+
+OpenGLStateCache::OpenGLStateCache()
+{
+	GLint numUnits = 0, numUniformBuffers = 0;
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &numUnits);
+	glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &numUniformBuffers);
+
+	m_Program = UNKNOWN;
+	m_VertexArray = UNKNOWN;
+	m_ElementArrayBuffer = UNKNOWN;
+	m_Buffers.assign(NUM_BUFFER_TARGETS, UNKNOWN);
+	m_UniformBuffers.assign(numUniformBuffers, BufferRange{ UNKNOWN, 0, 0 });
+
+	m_ActiveTexture = UNKNOWN;
+	m_Textures.assign(numUnits * NUM_TEXTURE_TARGETS, UNKNOWN);
+	m_Samplers.assign(numUnits, UNKNOWN);
+
+	m_Caps.assign(NUM_CAPS, -1);
+
+	m_FrontFace = UNKNOWN;
+	m_CullFace = UNKNOWN;
+	m_PolygonMode = UNKNOWN;
+
+	m_DepthFunc = UNKNOWN;
+	m_DepthMask = -1;
+	m_DepthNear = m_DepthFar = UNKNOWN_FLOAT;
+
+	for(StencilFace &face : m_StencilFaces)
+	{
+		face.func = UNKNOWN;
+		face.ref = 0;
+		face.readMask = 0;
+		face.writeMask = -1;
+		face.stencilFail = face.depthFail = face.depthPass = UNKNOWN;
+	}
+
+	for(float &value : m_ClearColor)
+		value = UNKNOWN_FLOAT;
+	m_ClearDepth = UNKNOWN_FLOAT;
+	m_ClearStencil = std::numeric_limits<long long>::min();
+
+	m_PrimitiveRestartIndex = -1;
+}
+
+void OpenGLStateCache::UseProgram(GLuint program)
+{
+	if(Changed(m_Program, program))
+		glUseProgram(program);
+}
+
+void OpenGLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	GLuint oldVertexArray = m_VertexArray;
+	if(!Changed(m_VertexArray, vertexArray))
+		return;
+
+	glBindVertexArray(vertexArray);
+
+	// the element array buffer binding belongs to the vertex array, so swap it along with it
+	if(oldVertexArray != UNKNOWN)
+		m_ElementArrayBuffers[oldVertexArray] = m_ElementArrayBuffer;
+	auto iter = m_ElementArrayBuffers.find(vertexArray);
+	m_ElementArrayBuffer = iter != m_ElementArrayBuffers.end() ? iter->second : 0; // new vertex arrays have none
+}
+
+void OpenGLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+	if(target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		if(Changed(m_ElementArrayBuffer, buffer))
+			glBindBuffer(target, buffer);
+		return;
+	}
+
+	int index = FindIndex(bufferTargets, target);
+	if(index < 0)
+	{
+		m_Stats.calls++;
+		glBindBuffer(target, buffer);
+	}
+	else if(Changed(m_Buffers[index], buffer))
+		glBindBuffer(target, buffer);
+}
+
+void OpenGLStateCache::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	BufferRange *binding = target == GL_UNIFORM_BUFFER && index < m_UniformBuffers.size() ? &m_UniformBuffers[index] : nullptr;
+	if(binding && binding->buffer == buffer && binding->offset == offset && binding->size == size)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+
+	if(binding)
+	{
+		binding->buffer = buffer;
+		binding->offset = offset;
+		binding->size = size;
+	}
+	m_Stats.calls++;
+
+	if(size)
+		glBindBufferRange(target, index, buffer, offset, size);
+	else
+		glBindBufferBase(target, index, buffer);
+
+	int generic = FindIndex(bufferTargets, target);
+	if(generic >= 0)
+		m_Buffers[generic] = buffer;
+}
+
+void OpenGLStateCache::ActiveTexture(unsigned int unit)
+{
+	if(Changed(m_ActiveTexture, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void OpenGLStateCache::BindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+	int index = FindIndex(textureTargets, target);
+	if(index < 0 || unit * NUM_TEXTURE_TARGETS >= m_Textures.size())
+	{
+		ActiveTexture(unit);
+		m_Stats.calls++;
+		glBindTexture(target, texture);
+	}
+	else if(Changed(m_Textures[unit * NUM_TEXTURE_TARGETS + index], texture))
+	{
+		ActiveTexture(unit);
+		glBindTexture(target, texture);
+	}
+}
+
+void OpenGLStateCache::GenerateMipmap(GLenum target, GLuint texture)
+{
+	unsigned int unit = m_ActiveTexture;
+	int index = FindIndex(textureTargets, target);
+	GLuint previous = index >= 0 && unit * NUM_TEXTURE_TARGETS < m_Textures.size() ? m_Textures[unit * NUM_TEXTURE_TARGETS + index] : UNKNOWN;
+
+	BindTexture(unit, target, texture);
+	glGenerateMipmap(target);
+	if(previous != UNKNOWN)
+		BindTexture(unit, target, previous);
+}
+
+void OpenGLStateCache::BindSampler(unsigned int unit, GLuint sampler)
+{
+	// samplers are bound to a unit directly, without selecting it
+	if(unit >= m_Samplers.size())
+	{
+		m_Stats.calls++;
+		glBindSampler(unit, sampler);
+	}
+	else if(Changed(m_Samplers[unit], sampler))
+		glBindSampler(unit, sampler);
+}
+
+void OpenGLStateCache::Enable(GLenum cap, bool enabled)
+{
+	int index = FindIndex(caps, cap);
+	if(index < 0)
+		m_Stats.calls++;
+	else if(!Changed(m_Caps[index], enabled ? 1 : 0))
+		return;
+
+	if(enabled)
+		glEnable(cap);
+	else
+		glDisable(cap);
+}
+
+void OpenGLStateCache::FrontFace(GLenum mode)
+{
+	if(Changed(m_FrontFace, mode))
+		glFrontFace(mode);
+}
+
+void OpenGLStateCache::CullFace(GLenum mode)
+{
+	if(Changed(m_CullFace, mode))
+		glCullFace(mode);
+}
+
+void OpenGLStateCache::PolygonMode(GLenum mode)
+{
+	if(Changed(m_PolygonMode, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void OpenGLStateCache::DepthFunc(GLenum func)
+{
+	if(Changed(m_DepthFunc, func))
+		glDepthFunc(func);
+}
+
+void OpenGLStateCache::DepthMask(bool enabled)
+{
+	if(Changed(m_DepthMask, enabled ? 1 : 0))
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void OpenGLStateCache::DepthRange(float depthNear, float depthFar)
+{
+	if(m_DepthNear == depthNear && m_DepthFar == depthFar)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+
+	m_DepthNear = depthNear;
+	m_DepthFar = depthFar;
+	m_Stats.calls++;
+	glDepthRange(depthNear, depthFar);
+}
+
+void OpenGLStateCache::StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
+{
+	StencilFace &shadow = m_StencilFaces[face == GL_FRONT ? 0 : 1];
+	if(shadow.func == func && shadow.ref == ref && shadow.readMask == mask)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+
+	shadow.func = func;
+	shadow.ref = ref;
+	shadow.readMask = mask;
+	m_Stats.calls++;
+	glStencilFuncSeparate(face, func, ref, mask);
+}
+
+void OpenGLStateCache::StencilMaskSeparate(GLenum face, GLuint mask)
+{
+	StencilFace &shadow = m_StencilFaces[face == GL_FRONT ? 0 : 1];
+	if(shadow.writeMask == mask)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+
+	shadow.writeMask = mask;
+	m_Stats.calls++;
+	glStencilMaskSeparate(face, mask);
+}
+
+void OpenGLStateCache::StencilOpSeparate(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+	StencilFace &shadow = m_StencilFaces[face == GL_FRONT ? 0 : 1];
+	if(shadow.stencilFail == stencilFail && shadow.depthFail == depthFail && shadow.depthPass == depthPass)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+
+	shadow.stencilFail = stencilFail;
+	shadow.depthFail = depthFail;
+	shadow.depthPass = depthPass;
+	m_Stats.calls++;
+	glStencilOpSeparate(face, stencilFail, depthFail, depthPass);
+}
+
+void OpenGLStateCache::ClearColor(float red, float green, float blue, float alpha)
+{
+	if(m_ClearColor[0] == red && m_ClearColor[1] == green && m_ClearColor[2] == blue && m_ClearColor[3] == alpha)
+	{
+		m_Stats.skipped++;
+		return;
+	}
+
+	m_ClearColor[0] = red;
+	m_ClearColor[1] = green;
+	m_ClearColor[2] = blue;
+	m_ClearColor[3] = alpha;
+	m_Stats.calls++;
+	glClearColor(red, green, blue, alpha);
+}
+
+void OpenGLStateCache::ClearDepth(float depth)
+{
+	if(Changed(m_ClearDepth, depth))
+		glClearDepth(depth);
+}
+
+void OpenGLStateCache::ClearStencil(GLint stencil)
+{
+	if(Changed(m_ClearStencil, static_cast<long long>(stencil)))
+		glClearStencil(stencil);
+}
+
+void OpenGLStateCache::PrimitiveRestartIndex(GLuint index)
+{
+	if(Changed(m_PrimitiveRestartIndex, static_cast<long long>(index)))
+		glPrimitiveRestartIndex(index);
+}
+
+void OpenGLStateCache::DeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+
+	// a deleted program stays in use until another replaces it, but its name may be handed out again
+	if(m_Program == program)
+		m_Program = UNKNOWN;
+}
+
+void OpenGLStateCache::DeleteVertexArray(GLuint vertexArray)
+{
+	glDeleteVertexArrays(1, &vertexArray);
+
+	// deleting the bound vertex array binds vertex array 0
+	if(m_VertexArray == vertexArray)
+	{
+		m_VertexArray = 0;
+		auto iter = m_ElementArrayBuffers.find(0);
+		m_ElementArrayBuffer = iter != m_ElementArrayBuffers.end() ? iter->second : 0;
+	}
+	m_ElementArrayBuffers.erase(vertexArray);
+}
+
+void OpenGLStateCache::DeleteBuffer(GLuint buffer)
+{
+	glDeleteBuffers(1, &buffer);
+
+	// deleting a buffer unbinds it from every target of the context and from the bound vertex array
+	for(GLuint &binding : m_Buffers)
+	{
+		if(binding == buffer)
+			binding = 0;
+	}
+	for(BufferRange &binding : m_UniformBuffers)
+	{
+		if(binding.buffer == buffer)
+			binding = BufferRange{ 0, 0, 0 };
+	}
+	if(m_ElementArrayBuffer == buffer)
+		m_ElementArrayBuffer = 0;
+
+	// vertex arrays that are not bound keep it until rebound, and its name may be handed out again
+	for(auto &iter : m_ElementArrayBuffers)
+	{
+		if(iter.second == buffer)
+			iter.second = UNKNOWN;
+	}
+}
+
+void OpenGLStateCache::DeleteTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+
+	// deleting a texture unbinds it from every unit
+	for(GLuint &binding : m_Textures)
+	{
+		if(binding == texture)
+			binding = 0;
+	}
+}
+
+void OpenGLStateCache::DeleteSampler(GLuint sampler)
+{
+	glDeleteSamplers(1, &sampler);
+
+	// deleting a sampler unbinds it from every unit
+	for(GLuint &binding : m_Samplers)
+	{
+		if(binding == sampler)
+			binding = 0;
+	}
+}
+
+} // end namespace render
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace render
+{
+
+// Counters gathered by an OpenGLStateCache
+struct OpenGLStateCacheStats
+{
+	unsigned long long calls = 0; // state changes passed on to GL
+	unsigned long long skipped = 0; // state changes dropped because GL was already in that state
+};
+
+// A shadow copy of the GL state set by the OpenGLRenderDevice and its resources.
+// Every state change goes through here and only reaches GL when it differs from the
+// shadow. Binds that GL undoes itself, such as when a bound object is deleted, are
+// tracked by deleting objects through the cache too.
+//
+// Every value starts out unknown, so the first change of each always reaches GL. The
+// cache assumes that nothing else changes the state of the context.
+class OpenGLStateCache
+{
+public:
+
+	// Must be created with the context current
+	OpenGLStateCache();
+
+	void UseProgram(GLuint program);
+
+	// Also switches to the element array buffer last bound while vertexArray was bound
+	void BindVertexArray(GLuint vertexArray);
+
+	// GL_ELEMENT_ARRAY_BUFFER is part of the bound vertex array's state and is tracked per vertex array
+	void BindBuffer(GLenum target, GLuint buffer);
+
+	// Bind a range of buffer to an indexed binding point, or all of it when size is 0; this
+	// also binds it to target, as GL does
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+	void ActiveTexture(unsigned int unit);
+
+	void BindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+	// Generate the levels of a texture through the active unit, then bind back the texture
+	// the unit had, so that generating levels before a draw keeps the draw's bindings
+	void GenerateMipmap(GLenum target, GLuint texture);
+
+	void BindSampler(unsigned int unit, GLuint sampler);
+
+	// Unit selected by the last ActiveTexture, for binds that only need some unit to modify a texture
+	unsigned int GetActiveTexture() const { return m_ActiveTexture; }
+
+	void Enable(GLenum cap, bool enabled);
+
+	void FrontFace(GLenum mode);
+
+	void CullFace(GLenum mode);
+
+	void PolygonMode(GLenum mode);
+
+	void DepthFunc(GLenum func);
+
+	void DepthMask(bool enabled);
+
+	void DepthRange(float depthNear, float depthFar);
+
+	// face is GL_FRONT or GL_BACK
+	void StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask);
+
+	void StencilMaskSeparate(GLenum face, GLuint mask);
+
+	void StencilOpSeparate(GLenum face, GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+
+	void ClearColor(float red, float green, float blue, float alpha);
+
+	void ClearDepth(float depth);
+
+	void ClearStencil(GLint stencil);
+
+	void PrimitiveRestartIndex(GLuint index);
+
+	// Delete objects and forget any binds of them
+	void DeleteProgram(GLuint program);
+
+	void DeleteVertexArray(GLuint vertexArray);
+
+	void DeleteBuffer(GLuint buffer);
+
+	void DeleteTexture(GLuint texture);
+
+	void DeleteSampler(GLuint sampler);
+
+	// Counters accumulated since the last ResetStats
+	const OpenGLStateCacheStats &GetStats() const { return m_Stats; }
+
+	void ResetStats() { m_Stats = OpenGLStateCacheStats(); }
+
+private:
+
+	// Returns true and updates shadow when value differs from it, counting the call either way
+	template<class T> bool Changed(T &shadow, const T &value)
+	{
+		if(shadow == value)
+		{
+			m_Stats.skipped++;
+			return false;
+		}
+		shadow = value;
+		m_Stats.calls++;
+		return true;
+	}
+
+	struct BufferRange
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	struct StencilFace
+	{
+		GLenum func;
+		GLint ref;
+		GLuint readMask;
+		long long writeMask; // wider than GLuint so that -1 can stand for unknown
+		GLenum stencilFail;
+		GLenum depthFail;
+		GLenum depthPass;
+	};
+
+	OpenGLStateCacheStats m_Stats;
+
+	GLuint m_Program;
+	GLuint m_VertexArray;
+	GLuint m_ElementArrayBuffer; // of m_VertexArray
+	std::unordered_map<GLuint, GLuint> m_ElementArrayBuffers; // by vertex array, for those not bound
+	std::vector<GLuint> m_Buffers; // by target other than GL_ELEMENT_ARRAY_BUFFER
+	std::vector<BufferRange> m_UniformBuffers; // by GL_UNIFORM_BUFFER index
+
+	unsigned int m_ActiveTexture;
+	std::vector<GLuint> m_Textures; // by unit * texture target + target
+	std::vector<GLuint> m_Samplers; // by unit
+
+	std::vector<int> m_Caps; // 0 disabled, 1 enabled, -1 unknown
+
+	GLenum m_FrontFace;
+	GLenum m_CullFace;
+	GLenum m_PolygonMode;
+
+	GLenum m_DepthFunc;
+	int m_DepthMask;
+	float m_DepthNear, m_DepthFar;
+
+	StencilFace m_StencilFaces[2]; // front, back
+
+	float m_ClearColor[4];
+	float m_ClearDepth;
+	long long m_ClearStencil; // wider than GLint so that an unknown value can be told apart
+
+	long long m_PrimitiveRestartIndex; // wider than GLuint so that -1 can stand for unknown
+};
+
+} // end namespace render
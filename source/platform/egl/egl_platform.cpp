@@ -0,0 +1,305 @@
+#include "render_device/platform.h"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace platform
+{
+
+// Offscreen platform for render servers and CI. An OpenGL 4.1 core context is created
+// through EGL without any windowing system: surfaceless with an offscreen framebuffer
+// when the implementation allows it (e.g. Mesa llvmpipe), otherwise on a pbuffer.
+// There is no input, so the platform runs a fixed number of frames and reports the
+// time per frame, like the GLFW platform does for RenderDevices that need no context.
+
+static float s_Width;
+static float s_Height;
+static glm::mat4 s_Projection(glm::uninitialize);
+
+static glm::mat4 s_Model(1);
+static glm::mat4 s_View = glm::translate(glm::mat4(1), glm::vec3(0, 0, -3));
+
+static bool s_UseContext = false;
+static EGLDisplay s_Display = EGL_NO_DISPLAY;
+static EGLContext s_Context = EGL_NO_CONTEXT;
+static EGLSurface s_Surface = EGL_NO_SURFACE;
+
+// offscreen framebuffer used in place of the default framebuffer of a surfaceless context
+static GLuint s_Framebuffer = 0;
+static GLuint s_Renderbuffers[2] = { 0, 0 };
+
+static int s_Frames = 1000;
+static int s_Frame = 0;
+static std::chrono::steady_clock::time_point s_Start;
+
+static bool HasExtension(const char *extensions, const char *name)
+{
+	if(!extensions)
+		return false;
+
+	size_t length = strlen(name);
+	for(const char *found = strstr(extensions, name); found; found = strstr(found + length, name))
+	{
+		if((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+			return true;
+	}
+
+	return false;
+}
+
+static EGLDisplay GetDisplay()
+{
+	// prefer a display that needs no windowing system at all
+	const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if(HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if(eglGetPlatformDisplayEXT)
+		{
+			EGLDisplay display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if(display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+// Write the framebuffer of the current context to path as a binary PPM image
+static void SaveFramebuffer(const char *path)
+{
+	int width = static_cast<int>(s_Width), height = static_cast<int>(s_Height);
+	std::vector<unsigned char> pixels(width * height * 3);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+	FILE *file = fopen(path, "wb");
+	if(!file)
+	{
+		std::cout << "ERROR::PLATFORM::OUTPUT_FAILED\n" << path << std::endl;
+		return;
+	}
+
+	// GL rows are bottom-up, PPM rows are top-down
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	for(int y = height - 1; y >= 0; y--)
+		fwrite(&pixels[y * width * 3], 1, width * 3, file);
+
+	fclose(file);
+}
+
+void InitPlatform()
+{
+	// the number of frames to run can be overridden for profiling
+	const char *frames = getenv("PLATFORM_HEADLESS_FRAMES");
+	if(frames)
+		s_Frames = atoi(frames);
+
+	// RenderDevices that do not render through OpenGL need no context
+	s_UseContext = render::GetRenderDeviceType() == render::RENDERDEVICETYPE_OPENGL;
+	if(!s_UseContext)
+		return;
+
+	s_Display = GetDisplay();
+	if(s_Display == EGL_NO_DISPLAY || !eglInitialize(s_Display, NULL, NULL))
+	{
+		std::cout << "Failed to initialize EGL" << std::endl;
+		s_Display = EGL_NO_DISPLAY;
+		return;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+}
+
+static void set_viewport_size(int width, int height)
+{
+	s_Width = static_cast<float>(width);
+	s_Height = static_cast<float>(height);
+
+	s_Projection = glm::perspective(glm::radians(45.0f), static_cast<float>(s_Width) / static_cast<float>(s_Height), 0.1f, 100.f);
+}
+
+// Create and bind a framebuffer with the same formats a window would have
+static bool CreateFramebuffer(int width, int height)
+{
+	glGenRenderbuffers(2, s_Renderbuffers);
+	glBindRenderbuffer(GL_RENDERBUFFER, s_Renderbuffers[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, s_Renderbuffers[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &s_Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, s_Framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, s_Renderbuffers[0]);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, s_Renderbuffers[1]);
+
+	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+PLATFORM_WINDOW_REF CreatePlatformWindow(int width, int height, const char *title)
+{
+	set_viewport_size(width, height);
+
+	s_Frame = 0;
+
+	if(!s_UseContext)
+	{
+		s_Start = std::chrono::steady_clock::now();
+		return (PLATFORM_WINDOW_REF)&s_Frames;
+	}
+
+	if(s_Display == EGL_NO_DISPLAY)
+		return 0;
+
+	bool surfaceless = HasExtension(eglQueryString(s_Display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, surfaceless ? 0 : 24,
+		EGL_STENCIL_SIZE, surfaceless ? 0 : 8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if(!eglChooseConfig(s_Display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+	{
+		std::cout << "Failed to choose an EGL config" << std::endl;
+		return 0;
+	}
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 1,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	s_Context = eglCreateContext(s_Display, config, EGL_NO_CONTEXT, contextAttribs);
+	if(s_Context == EGL_NO_CONTEXT)
+	{
+		std::cout << "Failed to create an OpenGL 4.1 context through EGL" << std::endl;
+		return 0;
+	}
+
+	if(!surfaceless)
+	{
+		const EGLint surfaceAttribs[] = {
+			EGL_WIDTH, width,
+			EGL_HEIGHT, height,
+			EGL_NONE
+		};
+
+		s_Surface = eglCreatePbufferSurface(s_Display, config, surfaceAttribs);
+		if(s_Surface == EGL_NO_SURFACE)
+		{
+			std::cout << "Failed to create an EGL pbuffer" << std::endl;
+			return 0;
+		}
+	}
+
+	eglMakeCurrent(s_Display, s_Surface, s_Surface, s_Context);
+
+	// glad: load all OpenGL function pointers
+	// ---------------------------------------
+	if(!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return 0;
+	}
+
+	// the RenderDevice never binds framebuffers, so this stays bound in place of the default one
+	if(surfaceless && !CreateFramebuffer(width, height))
+	{
+		std::cout << "Failed to create an offscreen framebuffer" << std::endl;
+		return 0;
+	}
+
+	glViewport(0, 0, width, height);
+
+	s_Start = std::chrono::steady_clock::now();
+
+	return (PLATFORM_WINDOW_REF)s_Context;
+}
+
+bool PollPlatformWindow(PLATFORM_WINDOW_REF window)
+{
+	return s_Frame++ < s_Frames;
+}
+
+void GetPlatformViewport(glm::mat4 &model, glm::mat4 &view, glm::mat4 &projection)
+{
+	model = s_Model;
+	view = s_View;
+	projection = s_Projection;
+}
+
+void PresentPlatformWindow(PLATFORM_WINDOW_REF window)
+{
+	if(!s_UseContext)
+		return;
+
+	// nothing is displayed; wait for the frame so the reported time covers rendering it
+	if(s_Surface != EGL_NO_SURFACE)
+		eglSwapBuffers(s_Display, s_Surface);
+	glFinish();
+}
+
+void TerminatePlatform()
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_Start).count();
+	int frames = s_Frame < s_Frames ? s_Frame : s_Frames;
+	if(frames > 0)
+		std::cout << "Headless: " << frames << " frames in " << seconds << " s (" << (seconds * 1000.0 / frames) << " ms/frame)" << std::endl;
+
+	if(s_Context != EGL_NO_CONTEXT)
+	{
+		// the last frame can be saved for inspection, as the software RenderDevice does
+		const char *output = getenv("RENDER_DEVICE_OUTPUT");
+		if(output)
+			SaveFramebuffer(output);
+
+		if(s_Framebuffer)
+		{
+			glDeleteFramebuffers(1, &s_Framebuffer);
+			glDeleteRenderbuffers(2, s_Renderbuffers);
+			s_Framebuffer = 0;
+		}
+
+		eglMakeCurrent(s_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(s_Display, s_Context);
+		s_Context = EGL_NO_CONTEXT;
+	}
+
+	if(s_Surface != EGL_NO_SURFACE)
+	{
+		eglDestroySurface(s_Display, s_Surface);
+		s_Surface = EGL_NO_SURFACE;
+	}
+
+	if(s_Display != EGL_NO_DISPLAY)
+	{
+		eglTerminate(s_Display);
+		s_Display = EGL_NO_DISPLAY;
+	}
+}
+
+} // end namespace platform
@@ -10,6 +10,8 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 namespace platform
@@ -32,6 +34,13 @@ static bool s_isDragging = false;
 
 static glm::mat4 s_View = glm::translate(glm::mat4(1), glm::vec3(0, 0, -3));
 
+// When the selected RenderDevice does not render through OpenGL, no window or
+// context is needed; the platform then runs a fixed number of frames headless.
+static bool s_Headless = false;
+static int s_HeadlessFrames = 1000;
+static int s_HeadlessFrame = 0;
+static std::chrono::steady_clock::time_point s_HeadlessStart;
+
 static void SetBounds(float width, float height)
 {
 	// Set adjustment factor for width/height
@@ -76,6 +85,16 @@ static void MapToSphere(const glm::vec2 &pt, glm::vec3 &vec)
 
 void InitPlatform()
 {
+	s_Headless = render::GetRenderDeviceType() != render::RENDERDEVICETYPE_OPENGL;
+	if(s_Headless)
+	{
+		// the number of frames to run can be overridden for profiling
+		const char *frames = getenv("PLATFORM_HEADLESS_FRAMES");
+		if(frames)
+			s_HeadlessFrames = atoi(frames);
+		return;
+	}
+
 	// glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -173,6 +192,13 @@ PLATFORM_WINDOW_REF CreatePlatformWindow(int width, int height, const char *titl
 {
 	set_viewport_size(width, height);
 
+	if(s_Headless)
+	{
+		s_HeadlessFrame = 0;
+		s_HeadlessStart = std::chrono::steady_clock::now();
+		return (PLATFORM_WINDOW_REF)&s_HeadlessFrames;
+	}
+
 	// glfw window creation
     // --------------------
     GLFWwindow *window = glfwCreateWindow(width, height, title, NULL, NULL);
@@ -201,6 +227,9 @@ PLATFORM_WINDOW_REF CreatePlatformWindow(int width, int height, const char *titl
 
 bool PollPlatformWindow(PLATFORM_WINDOW_REF window)
 {
+	if(s_Headless)
+		return s_HeadlessFrame++ < s_HeadlessFrames;
+
 	// glfw: poll IO events (keys pressed/released, mouse moved etc.)
 	glfwPollEvents();
 
@@ -220,6 +249,9 @@ void GetPlatformViewport(glm::mat4 &model, glm::mat4 &view, glm::mat4 &projectio
 
 void PresentPlatformWindow(PLATFORM_WINDOW_REF window)
 {
+	if(s_Headless)
+		return;
+
 	// glfw: swap buffers
     // -------------------------------------------------------------------------------
     glfwSwapBuffers((GLFWwindow *)window);
@@ -227,6 +259,16 @@ void PresentPlatformWindow(PLATFORM_WINDOW_REF window)
 
 void TerminatePlatform()
 {
+	if(s_Headless)
+	{
+		// report the CPU cost per frame of everything that ran between window creation and now
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_HeadlessStart).count();
+		int frames = s_HeadlessFrame < s_HeadlessFrames ? s_HeadlessFrame : s_HeadlessFrames;
+		if(frames > 0)
+			std::cout << "Headless: " << frames << " frames in " << seconds << " s (" << (seconds * 1000.0 / frames) << " ms/frame)" << std::endl;
+		return;
+	}
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -1,15 +1,194 @@
 #include "render_device/render_device.h"
+#include "render_device/trace.h"
 
 #include "opengl/ogl_render_device.h"
+#include "null/null_render_device.h"
+#include "software/sw_render_device.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INDEX_SSE2
+#endif
 
 namespace render
 {
 
-RenderDevice *CreateRenderDevice()
+RenderDeviceType GetRenderDeviceType(const char *config)
+{
+	static const char *names[] = { "opengl", "null", "software" };
+
+	if(!config)
+		config = getenv("RENDER_DEVICE");
+	if(!config || !*config)
+		return RENDERDEVICETYPE_OPENGL;
+
+	for(int i = 0; i < RENDERDEVICETYPE_MAX; i++)
+	{
+		if(strcmp(config, names[i]) == 0)
+			return static_cast<RenderDeviceType>(i);
+	}
+
+	std::cout << "ERROR::RENDERDEVICE::UNKNOWN_TYPE\n" << config << std::endl;
+	return RENDERDEVICETYPE_OPENGL;
+}
+
+bool IsCompressedTextureFormat(TextureFormat format)
+{
+	return format != TEXTUREFORMAT_RGBX8 && format != TEXTUREFORMAT_RGBA8;
+}
+
+int GetTextureMipLevels(int width, int height)
+{
+	int size = width > height ? width : height;
+	int levels = 1;
+	while(size > 1)
+	{
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+long long GetTextureLevelSize(TextureFormat format, int width, int height)
+{
+	switch(format)
+	{
+	case TEXTUREFORMAT_RGBX8:
+	case TEXTUREFORMAT_RGBA8:
+		return 4LL * width * height;
+	case TEXTUREFORMAT_BC1:
+	case TEXTUREFORMAT_BC4:
+	case TEXTUREFORMAT_ETC2_RGB8:
+		return 8LL * ((width + 3) / 4) * ((height + 3) / 4);
+	default:
+		return 16LL * ((width + 3) / 4) * ((height + 3) / 4);
+	}
+}
+
+long long GetTextureSize(TextureFormat format, int width, int height, int mipLevels)
+{
+	long long size = 0;
+	for(int level = 0; level < mipLevels; level++)
+	{
+		size += GetTextureLevelSize(format, width, height);
+		width = width > 1 ? width >> 1 : 1;
+		height = height > 1 ? height >> 1 : 1;
+	}
+	return size;
+}
+
+int GetIndexSize(IndexFormat format)
 {
-	// Eventually, we will parse a config, command-line argument, or global setting, in order to retrieve which RenderDevice should be instantiated.
-	// Right now, we only have OpenGL.
-	return new OpenGLRenderDevice;
+	return format == INDEXFORMAT_16 ? 2 : 4;
+}
+
+#if defined(INDEX_SSE2)
+// Per-lane maximum of signed 32-bit integers, which SSE2 lacks an instruction for
+static inline __m128i MaxInt32(__m128i a, __m128i b)
+{
+	__m128i greater = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+#endif
+
+// Returns the largest of count 32-bit indices, each plus add, wrapping around, so that an
+// add of 1 turns restart indices into the smallest value rather than the largest
+static unsigned int GetMaxIndexPlus(long long count, const unsigned int *indices, unsigned int add)
+{
+	long long i = 0;
+	unsigned int maxIndex = 0;
+
+#if defined(INDEX_SSE2)
+	// SSE2 only compares signed integers, so indices are biased by 2^31 to order them as
+	// signed; two accumulators of four lanes each keep the compares independent
+	const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+	const __m128i addend = _mm_set1_epi32(static_cast<int>(add));
+	__m128i max0 = bias, max1 = bias;
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i indices0 = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)), addend);
+		__m128i indices1 = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i + 4)), addend);
+		max0 = MaxInt32(max0, _mm_xor_si128(indices0, bias));
+		max1 = MaxInt32(max1, _mm_xor_si128(indices1, bias));
+	}
+	max0 = MaxInt32(max0, max1);
+	max0 = MaxInt32(max0, _mm_shuffle_epi32(max0, _MM_SHUFFLE(1, 0, 3, 2)));
+	max0 = MaxInt32(max0, _mm_shuffle_epi32(max0, _MM_SHUFFLE(2, 3, 0, 1)));
+	maxIndex = static_cast<unsigned int>(_mm_cvtsi128_si32(max0)) ^ 0x80000000u;
+#endif
+
+	for(; i < count; i++)
+		maxIndex = std::max(maxIndex, indices[i] + add);
+	return maxIndex;
+}
+
+unsigned int GetMaxIndex(long long count, const unsigned int *indices)
+{
+	return GetMaxIndexPlus(count, indices, 0);
+}
+
+IndexFormat GetNarrowestIndexFormat(long long count, const unsigned int *indices)
+{
+	// restarts wrap around to 0, and every other index must stay below 0xFFFF
+	return count > 0 && indices && GetMaxIndexPlus(count, indices, 1) <= 0xFFFF ? INDEXFORMAT_16 : INDEXFORMAT_32;
+}
+
+void NarrowIndices(long long count, const unsigned int *indices, unsigned short *narrowed)
+{
+	long long i = 0;
+
+#if defined(INDEX_SSE2)
+	// the pack saturates signed values, so indices are moved into signed 16-bit range for it
+	// and back after it; the bias of 0x7FFF keeps restarts in range, where they wrap back to
+	// 0xFFFF like the scalar truncation below
+	const __m128i bias32 = _mm_set1_epi32(0x7FFF);
+	const __m128i bias16 = _mm_set1_epi16(0x7FFF);
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)), bias32);
+		__m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i + 4)), bias32);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(narrowed + i), _mm_add_epi16(_mm_packs_epi32(low, high), bias16));
+	}
+#endif
+
+	for(; i < count; i++)
+		narrowed[i] = static_cast<unsigned short>(indices[i]);
+}
+
+RenderDevice *CreateRenderDevice(int width, int height)
+{
+	RenderDevice *renderDevice = CreateRenderDevice(GetRenderDeviceType(), width, height);
+
+	// record every call made to the device when a capture file is named
+	const char *capture = getenv("RENDER_DEVICE_CAPTURE");
+	if(capture && *capture)
+	{
+		RenderDevice *captureDevice = CreateCaptureRenderDevice(renderDevice, capture);
+		if(captureDevice)
+			renderDevice = captureDevice;
+	}
+
+	return renderDevice;
+}
+
+RenderDevice *CreateRenderDevice(RenderDeviceType type, int width, int height)
+{
+	switch(type)
+	{
+	case RENDERDEVICETYPE_NULL:
+		return new NullRenderDevice;
+	case RENDERDEVICETYPE_SOFTWARE:
+		return new SoftwareRenderDevice(width, height);
+	case RENDERDEVICETYPE_OPENGL:
+	default:
+		return new OpenGLRenderDevice;
+	}
 }
 
 void DestroyRenderDevice(RenderDevice *renderDevice)
@@ -17,4 +196,15 @@ void DestroyRenderDevice(RenderDevice *renderDevice)
 	delete renderDevice;
 }
 
+IndexBuffer *CreateNarrowedIndexBuffer(RenderDevice *renderDevice, long long count, const unsigned int *indices, IndexFormat &format, BufferUsage usage)
+{
+	format = GetNarrowestIndexFormat(count, indices);
+	if(format == INDEXFORMAT_32)
+		return renderDevice->CreateIndexBuffer(count * 4, indices, usage);
+
+	std::vector<unsigned short> narrowed(static_cast<size_t>(count));
+	NarrowIndices(count, indices, narrowed.data());
+	return renderDevice->CreateIndexBuffer(count * 2, narrowed.data(), usage, INDEXFORMAT_16);
+}
+
 } // end namespace render
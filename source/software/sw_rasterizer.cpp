@@ -0,0 +1,521 @@
+#include "sw_rasterizer.h"
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SW_SSE2
+#endif
+
+namespace render
+{
+
+// Thin wrappers over the widest SIMD instruction set available, so the rasterization
+// loops are written once. simd_float holds SW_SIMD_WIDTH floats; simd_mask holds a
+// per-lane comparison result.
+#if defined(__AVX2__)
+
+#define SW_SIMD_WIDTH 8
+typedef __m256 simd_float;
+typedef __m256 simd_mask;
+
+static inline simd_float SimdSet1(float value) { return _mm256_set1_ps(value); }
+static inline simd_float SimdRamp() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+static inline simd_float SimdAdd(simd_float a, simd_float b) { return _mm256_add_ps(a, b); }
+static inline simd_float SimdMul(simd_float a, simd_float b) { return _mm256_mul_ps(a, b); }
+#if defined(__FMA__)
+static inline simd_float SimdMulAdd(simd_float a, simd_float b, simd_float c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+static inline simd_float SimdMulAdd(simd_float a, simd_float b, simd_float c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+static inline simd_float SimdLoad(const float *p) { return _mm256_loadu_ps(p); }
+static inline void SimdStore(float *p, simd_float a) { _mm256_storeu_ps(p, a); }
+static inline simd_mask SimdLess(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline simd_mask SimdLessEqual(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline simd_mask SimdEqual(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline simd_mask SimdNotEqual(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+static inline simd_mask SimdMaskAnd(simd_mask a, simd_mask b) { return _mm256_and_ps(a, b); }
+static inline simd_mask SimdMaskAndNot(simd_mask a, simd_mask b) { return _mm256_andnot_ps(a, b); }
+static inline simd_mask SimdMaskFromBits(unsigned int bits)
+{
+	const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	__m256i value = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lanes);
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(value, lanes));
+}
+static inline unsigned int SimdMaskBits(simd_mask a) { return static_cast<unsigned int>(_mm256_movemask_ps(a)); }
+static inline simd_float SimdSelect(simd_float a, simd_float b, simd_mask mask) { return _mm256_blendv_ps(a, b, mask); }
+
+#elif defined(SW_SSE2)
+
+#define SW_SIMD_WIDTH 4
+typedef __m128 simd_float;
+typedef __m128 simd_mask;
+
+static inline simd_float SimdSet1(float value) { return _mm_set1_ps(value); }
+static inline simd_float SimdRamp() { return _mm_setr_ps(0, 1, 2, 3); }
+static inline simd_float SimdAdd(simd_float a, simd_float b) { return _mm_add_ps(a, b); }
+static inline simd_float SimdMul(simd_float a, simd_float b) { return _mm_mul_ps(a, b); }
+static inline simd_float SimdMulAdd(simd_float a, simd_float b, simd_float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline simd_float SimdLoad(const float *p) { return _mm_loadu_ps(p); }
+static inline void SimdStore(float *p, simd_float a) { _mm_storeu_ps(p, a); }
+static inline simd_mask SimdLess(simd_float a, simd_float b) { return _mm_cmplt_ps(a, b); }
+static inline simd_mask SimdLessEqual(simd_float a, simd_float b) { return _mm_cmple_ps(a, b); }
+static inline simd_mask SimdEqual(simd_float a, simd_float b) { return _mm_cmpeq_ps(a, b); }
+static inline simd_mask SimdNotEqual(simd_float a, simd_float b) { return _mm_cmpneq_ps(a, b); }
+static inline simd_mask SimdMaskAnd(simd_mask a, simd_mask b) { return _mm_and_ps(a, b); }
+static inline simd_mask SimdMaskAndNot(simd_mask a, simd_mask b) { return _mm_andnot_ps(a, b); }
+static inline simd_mask SimdMaskFromBits(unsigned int bits)
+{
+	const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+	__m128i value = _mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes);
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(value, lanes));
+}
+static inline unsigned int SimdMaskBits(simd_mask a) { return static_cast<unsigned int>(_mm_movemask_ps(a)); }
+static inline simd_float SimdSelect(simd_float a, simd_float b, simd_mask mask) { return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)); }
+
+#else
+
+#define SW_SIMD_WIDTH 1
+typedef float simd_float;
+typedef bool simd_mask;
+
+static inline simd_float SimdSet1(float value) { return value; }
+static inline simd_float SimdRamp() { return 0.0f; }
+static inline simd_float SimdAdd(simd_float a, simd_float b) { return a + b; }
+static inline simd_float SimdMul(simd_float a, simd_float b) { return a * b; }
+static inline simd_float SimdMulAdd(simd_float a, simd_float b, simd_float c) { return a * b + c; }
+static inline simd_float SimdLoad(const float *p) { return *p; }
+static inline void SimdStore(float *p, simd_float a) { *p = a; }
+static inline simd_mask SimdLess(simd_float a, simd_float b) { return a < b; }
+static inline simd_mask SimdLessEqual(simd_float a, simd_float b) { return a <= b; }
+static inline simd_mask SimdEqual(simd_float a, simd_float b) { return a == b; }
+static inline simd_mask SimdNotEqual(simd_float a, simd_float b) { return a != b; }
+static inline simd_mask SimdMaskAnd(simd_mask a, simd_mask b) { return a && b; }
+static inline simd_mask SimdMaskAndNot(simd_mask a, simd_mask b) { return !a && b; }
+static inline simd_mask SimdMaskFromBits(unsigned int bits) { return (bits & 1) != 0; }
+static inline unsigned int SimdMaskBits(simd_mask a) { return a ? 1u : 0u; }
+static inline simd_float SimdSelect(simd_float a, simd_float b, simd_mask mask) { return mask ? b : a; }
+
+#endif
+
+// Evaluate a depth or stencil comparison; passes when incoming compares favorably to stored
+static inline simd_mask SimdCompare(Compare compare, simd_float incoming, simd_float stored)
+{
+	switch(compare)
+	{
+	case COMPARE_NEVER: return SimdMaskFromBits(0);
+	case COMPARE_LESS: return SimdLess(incoming, stored);
+	case COMPARE_EQUAL: return SimdEqual(incoming, stored);
+	case COMPARE_LEQUAL: return SimdLessEqual(incoming, stored);
+	case COMPARE_GREATER: return SimdLess(stored, incoming);
+	case COMPARE_NOTEQUAL: return SimdNotEqual(incoming, stored);
+	case COMPARE_GEQUAL: return SimdLessEqual(stored, incoming);
+	default: return SimdMaskFromBits(~0u);
+	}
+}
+
+template<class T>
+static inline bool ScalarCompare(Compare compare, T incoming, T stored)
+{
+	switch(compare)
+	{
+	case COMPARE_NEVER: return false;
+	case COMPARE_LESS: return incoming < stored;
+	case COMPARE_EQUAL: return incoming == stored;
+	case COMPARE_LEQUAL: return incoming <= stored;
+	case COMPARE_GREATER: return incoming > stored;
+	case COMPARE_NOTEQUAL: return incoming != stored;
+	case COMPARE_GEQUAL: return incoming >= stored;
+	default: return true;
+	}
+}
+
+static inline uint8_t ApplyStencilAction(StencilAction action, uint8_t value, int ref, unsigned int writeMask)
+{
+	unsigned int result;
+	switch(action)
+	{
+	case STENCIL_ZERO: result = 0; break;
+	case STENCIL_REPLACE: result = static_cast<unsigned int>(ref); break;
+	case STENCIL_INCR: result = value < 255 ? value + 1 : 255; break;
+	case STENCIL_INCR_WRAP: result = value + 1; break;
+	case STENCIL_DECR: result = value > 0 ? value - 1 : 0; break;
+	case STENCIL_DECR_WRAP: result = value - 1; break;
+	case STENCIL_INVERT: result = ~static_cast<unsigned int>(value); break;
+	default: return value;
+	}
+	return static_cast<uint8_t>((value & ~writeMask) | (result & writeMask));
+}
+
+static inline uint8_t PackColorComponent(float value)
+{
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return static_cast<uint8_t>(value * 255.0f + 0.5f);
+}
+
+static inline uint32_t PackColor(const float *color)
+{
+	return PackColorComponent(color[0]) | (PackColorComponent(color[1]) << 8) | (PackColorComponent(color[2]) << 16) | (static_cast<uint32_t>(PackColorComponent(color[3])) << 24);
+}
+
+// Compute the plane a * x + b * y + c through three window-space values
+static inline void ComputePlane(const float *x, const float *y, float invArea, float a0, float a1, float a2, float *plane)
+{
+	float da1 = a1 - a0, da2 = a2 - a0;
+	plane[0] = (da1 * (y[2] - y[0]) - da2 * (y[1] - y[0])) * invArea;
+	plane[1] = (da2 * (x[1] - x[0]) - da1 * (x[2] - x[0])) * invArea;
+	plane[2] = a0 - plane[0] * x[0] - plane[1] * y[0];
+}
+
+SoftwareRasterizer::SoftwareRasterizer(ThreadPool &threadPool) : m_ThreadPool(threadPool)
+{
+}
+
+const char *SoftwareRasterizer::GetSimdName()
+{
+#if defined(__AVX2__)
+	return "AVX2";
+#elif defined(SW_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+void SoftwareRasterizer::Resize(int width, int height)
+{
+	m_Width = width;
+	m_Height = height;
+	m_TilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_TilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	m_Stride = m_TilesX * TILE_SIZE;
+
+	// pad to whole tiles so SIMD loads and stores never need bounds checks
+	size_t numPixels = static_cast<size_t>(m_Stride) * m_TilesY * TILE_SIZE;
+	m_Color.assign(numPixels, 0);
+	m_Depth.assign(numPixels, 1.0f);
+	m_Stencil.assign(numPixels, 0);
+	m_Bins.assign(m_TilesX * m_TilesY, std::vector<unsigned int>());
+}
+
+void SoftwareRasterizer::Clear(float red, float green, float blue, float alpha, float depth, int stencil)
+{
+	float color[4] = { red, green, blue, alpha };
+	std::fill(m_Color.begin(), m_Color.end(), PackColor(color));
+	std::fill(m_Depth.begin(), m_Depth.end(), depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth));
+	std::fill(m_Stencil.begin(), m_Stencil.end(), static_cast<uint8_t>(stencil));
+}
+
+void SoftwareRasterizer::DrawTriangles(const SoftwareDrawState &state, const float *vertices, unsigned int vertexStride, const unsigned int *indices, unsigned int numTriangles)
+{
+	m_Triangles.clear();
+	m_Planes.clear();
+
+	for(unsigned int i = 0; i < numTriangles; i++)
+		SetupTriangle(state, vertices + indices[i * 3] * vertexStride, vertices + indices[i * 3 + 1] * vertexStride, vertices + indices[i * 3 + 2] * vertexStride);
+
+	m_Stats.trianglesSubmitted += numTriangles;
+	m_Stats.trianglesRasterized += m_Triangles.size();
+	if(m_Triangles.empty())
+		return;
+
+	// bin triangles to every tile their bounds overlap, preserving submission order within each bin
+	for(std::vector<unsigned int> &bin : m_Bins)
+		bin.clear();
+	for(unsigned int i = 0; i < m_Triangles.size(); i++)
+	{
+		const Triangle &triangle = m_Triangles[i];
+		for(int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+			for(int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+				m_Bins[ty * m_TilesX + tx].push_back(i);
+	}
+
+	m_ActiveTiles.clear();
+	for(unsigned int tile = 0; tile < m_Bins.size(); tile++)
+		if(!m_Bins[tile].empty())
+			m_ActiveTiles.push_back(tile);
+
+	// one job per tile; tiles touch disjoint pixels so they need no synchronization
+	std::atomic<unsigned long long> pixelsShaded(0);
+	m_ThreadPool.ParallelFor(static_cast<unsigned int>(m_ActiveTiles.size()), [&](unsigned int index) {
+		unsigned long long tilePixelsShaded = 0;
+		RasterizeTile(state, m_ActiveTiles[index], tilePixelsShaded);
+		pixelsShaded += tilePixelsShaded;
+	});
+	m_Stats.pixelsShaded += pixelsShaded;
+}
+
+void SoftwareRasterizer::SetupTriangle(const SoftwareDrawState &state, const float *v0, const float *v1, const float *v2)
+{
+	// distance of each vertex inside the near (z >= -w) and far (z <= w) planes
+	const float *in[3] = { v0, v1, v2 };
+	float nearDistance[3], farDistance[3];
+	bool clipped = false;
+	for(int i = 0; i < 3; i++)
+	{
+		nearDistance[i] = in[i][2] + in[i][3];
+		farDistance[i] = in[i][3] - in[i][2];
+		if(nearDistance[i] < 0.0f || farDistance[i] < 0.0f)
+			clipped = true;
+	}
+
+	if(!clipped)
+	{
+		SetupClipped(state, v0, v1, v2);
+		return;
+	}
+
+	// Sutherland-Hodgman against both planes; a triangle becomes a polygon of at most five vertices
+	const unsigned int components = 4 + state.numVaryings;
+	float storage[2][5][4 + SOFTWARE_MAX_VARYINGS];
+	float temp[5][4 + SOFTWARE_MAX_VARYINGS];
+	const float *polygon[5] = { v0, v1, v2 };
+	int count = 3;
+
+	for(int plane = 0; plane < 2; plane++)
+	{
+		float distance[5];
+		for(int i = 0; i < count; i++)
+			distance[i] = plane == 0 ? polygon[i][2] + polygon[i][3] : polygon[i][3] - polygon[i][2];
+
+		int outCount = 0;
+		for(int i = 0; i < count && outCount < 5; i++)
+		{
+			int j = (i + 1) % count;
+			if(distance[i] >= 0.0f)
+			{
+				for(unsigned int c = 0; c < components; c++)
+					temp[outCount][c] = polygon[i][c];
+				outCount++;
+			}
+			if((distance[i] >= 0.0f) != (distance[j] >= 0.0f) && outCount < 5)
+			{
+				float t = distance[i] / (distance[i] - distance[j]);
+				for(unsigned int c = 0; c < components; c++)
+					temp[outCount][c] = polygon[i][c] + (polygon[j][c] - polygon[i][c]) * t;
+				outCount++;
+			}
+		}
+
+		count = outCount;
+		if(count < 3)
+			return;
+		for(int i = 0; i < count; i++)
+		{
+			for(unsigned int c = 0; c < components; c++)
+				storage[plane][i][c] = temp[i][c];
+			polygon[i] = storage[plane][i];
+		}
+	}
+
+	for(int i = 1; i + 1 < count; i++)
+		SetupClipped(state, polygon[0], polygon[i], polygon[i + 1]);
+}
+
+void SoftwareRasterizer::SetupClipped(const SoftwareDrawState &state, const float *v0, const float *v1, const float *v2)
+{
+	const float *in[3] = { v0, v1, v2 };
+
+	// project to window space with the origin at the bottom left, as OpenGL does
+	float x[3], y[3], z[3], invW[3];
+	for(int i = 0; i < 3; i++)
+	{
+		if(in[i][3] <= 0.0f)
+			return;
+		invW[i] = 1.0f / in[i][3];
+		x[i] = (in[i][0] * invW[i] * 0.5f + 0.5f) * m_Width;
+		y[i] = (in[i][1] * invW[i] * 0.5f + 0.5f) * m_Height;
+		z[i] = state.depthNear + (state.depthFar - state.depthNear) * (in[i][2] * invW[i] * 0.5f + 0.5f);
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if(area == 0.0f)
+		return;
+
+	bool backFacing = (area > 0.0f) != state.frontFaceCCW;
+	if(state.cullEnabled)
+	{
+		if(state.cullFace == FACE_FRONT_AND_BACK)
+			return;
+		if(backFacing == (state.cullFace == FACE_BACK))
+			return;
+	}
+
+	Triangle triangle;
+
+	float minX = std::min(x[0], std::min(x[1], x[2]));
+	float maxX = std::max(x[0], std::max(x[1], x[2]));
+	float minY = std::min(y[0], std::min(y[1], y[2]));
+	float maxY = std::max(y[0], std::max(y[1], y[2]));
+	if(maxX < 0.0f || maxY < 0.0f || minX >= m_Width || minY >= m_Height)
+		return;
+	triangle.minX = std::max(0, static_cast<int>(std::floor(minX)));
+	triangle.minY = std::max(0, static_cast<int>(std::floor(minY)));
+	triangle.maxX = std::min(m_Width - 1, static_cast<int>(std::ceil(maxX)));
+	triangle.maxY = std::min(m_Height - 1, static_cast<int>(std::ceil(maxY)));
+
+	// edge i is opposite vertex i; orient every edge so the inside is positive
+	float sign = area > 0.0f ? 1.0f : -1.0f;
+	triangle.exclusiveEdges = 0;
+	for(int i = 0; i < 3; i++)
+	{
+		int a = (i + 1) % 3, b = (i + 2) % 3;
+		triangle.edgeA[i] = (y[a] - y[b]) * sign;
+		triangle.edgeB[i] = (x[b] - x[a]) * sign;
+		triangle.edgeC[i] = (x[a] * y[b] - x[b] * y[a]) * sign;
+
+		// pixels exactly on a shared edge belong to just one of the two triangles
+		if(!(triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] < 0.0f)))
+			triangle.exclusiveEdges |= 1 << i;
+	}
+
+	float invArea = 1.0f / area;
+	ComputePlane(x, y, invArea, z[0], z[1], z[2], triangle.zPlane);
+	triangle.backFacing = backFacing;
+
+	// 1/w and varyings/w are linear in window space, which gives perspective-correct interpolation
+	size_t planeBase = m_Planes.size();
+	m_Planes.resize(planeBase + (1 + state.numVaryings) * 3);
+	float *planes = &m_Planes[planeBase];
+	ComputePlane(x, y, invArea, invW[0], invW[1], invW[2], planes);
+	for(unsigned int i = 0; i < state.numVaryings; i++)
+		ComputePlane(x, y, invArea, in[0][4 + i] * invW[0], in[1][4 + i] * invW[1], in[2][4 + i] * invW[2], planes + (1 + i) * 3);
+
+	m_Triangles.push_back(triangle);
+}
+
+void SoftwareRasterizer::RasterizeTile(const SoftwareDrawState &state, unsigned int tile, unsigned long long &pixelsShaded)
+{
+	const int tileX0 = (tile % m_TilesX) * TILE_SIZE;
+	const int tileY0 = (tile / m_TilesX) * TILE_SIZE;
+	const unsigned int planeCount = 1 + state.numVaryings;
+	const simd_float ramp = SimdAdd(SimdRamp(), SimdSet1(0.5f));
+	const simd_float zero = SimdSet1(0.0f);
+	const bool vectorDepth = state.depthEnabled && !state.stencilEnabled;
+
+	float varyings[SOFTWARE_MAX_VARYINGS];
+	float color[4];
+
+	for(unsigned int triangleIndex : m_Bins[tile])
+	{
+		const Triangle &triangle = m_Triangles[triangleIndex];
+		const float *planes = &m_Planes[triangleIndex * planeCount * 3];
+		const SoftwareStencilFace &stencilFace = triangle.backFacing ? state.stencilBack : state.stencilFront;
+
+		const int x0 = std::max(tileX0, triangle.minX) & ~(SW_SIMD_WIDTH - 1);
+		const int x1 = std::min(tileX0 + TILE_SIZE - 1, triangle.maxX);
+		const int y0 = std::max(tileY0, triangle.minY);
+		const int y1 = std::min(tileY0 + TILE_SIZE - 1, triangle.maxY);
+		const int xFirst = std::max(tileX0, triangle.minX);
+
+		simd_float edgeA[3];
+		simd_mask exclusive[3];
+		for(int e = 0; e < 3; e++)
+		{
+			edgeA[e] = SimdSet1(triangle.edgeA[e]);
+			exclusive[e] = SimdMaskFromBits((triangle.exclusiveEdges >> e) & 1 ? ~0u : 0u);
+		}
+		const simd_float zA = SimdSet1(triangle.zPlane[0]);
+
+		for(int y = y0; y <= y1; y++)
+		{
+			const float py = y + 0.5f;
+			float edgeRow[3];
+			for(int e = 0; e < 3; e++)
+				edgeRow[e] = triangle.edgeB[e] * py + triangle.edgeC[e];
+			const float zRow = triangle.zPlane[1] * py + triangle.zPlane[2];
+
+			for(int x = x0; x <= x1; x += SW_SIMD_WIDTH)
+			{
+				const simd_float px = SimdAdd(SimdSet1(static_cast<float>(x)), ramp);
+
+				// a pixel is covered when it is inside all three edges; pixels exactly on an
+				// exclusive edge are left for the neighbouring triangle
+				simd_mask covered = SimdMaskFromBits(~0u);
+				for(int e = 0; e < 3; e++)
+				{
+					simd_float value = SimdMulAdd(edgeA[e], px, SimdSet1(edgeRow[e]));
+					simd_mask inside = SimdMaskAndNot(SimdMaskAnd(SimdEqual(value, zero), exclusive[e]), SimdLessEqual(zero, value));
+					covered = SimdMaskAnd(covered, inside);
+				}
+
+				unsigned int bits = SimdMaskBits(covered);
+
+				// trim lanes outside the triangle's bounds within this tile
+				if(x < xFirst)
+					bits &= ~0u << (xFirst - x);
+				if(x + SW_SIMD_WIDTH - 1 > x1)
+					bits &= (1u << (x1 - x + 1)) - 1;
+				if(!bits)
+					continue;
+
+				const int pixel = y * m_Stride + x;
+				const simd_float z = SimdMulAdd(zA, px, SimdSet1(zRow));
+
+				if(vectorDepth)
+				{
+					simd_float depth = SimdLoad(&m_Depth[pixel]);
+					simd_mask pass = SimdMaskAnd(SimdCompare(state.depthCompare, z, depth), SimdMaskFromBits(bits));
+					bits = SimdMaskBits(pass);
+					if(!bits)
+						continue;
+					if(state.depthWriteEnabled)
+						SimdStore(&m_Depth[pixel], SimdSelect(depth, z, pass));
+				}
+
+				float zLanes[SW_SIMD_WIDTH];
+				SimdStore(zLanes, z);
+
+				for(int lane = 0; lane < SW_SIMD_WIDTH; lane++)
+				{
+					if(!(bits & (1u << lane)))
+						continue;
+
+					const int index = pixel + lane;
+
+					if(state.stencilEnabled)
+					{
+						uint8_t &stencil = m_Stencil[index];
+						unsigned int readMask = stencilFace.readMask;
+						if(!ScalarCompare(stencilFace.compare, static_cast<unsigned int>(stencilFace.ref) & readMask, stencil & readMask))
+						{
+							stencil = ApplyStencilAction(stencilFace.fail, stencil, stencilFace.ref, stencilFace.writeMask);
+							continue;
+						}
+						if(state.depthEnabled)
+						{
+							if(!ScalarCompare(state.depthCompare, zLanes[lane], m_Depth[index]))
+							{
+								stencil = ApplyStencilAction(stencilFace.depthFail, stencil, stencilFace.ref, stencilFace.writeMask);
+								continue;
+							}
+							if(state.depthWriteEnabled)
+								m_Depth[index] = zLanes[lane];
+						}
+						stencil = ApplyStencilAction(stencilFace.pass, stencil, stencilFace.ref, stencilFace.writeMask);
+					}
+
+					const float fx = x + lane + 0.5f;
+					const float w = 1.0f / (planes[0] * fx + planes[1] * py + planes[2]);
+					for(unsigned int i = 0; i < state.numVaryings; i++)
+					{
+						const float *plane = planes + (1 + i) * 3;
+						varyings[i] = (plane[0] * fx + plane[1] * py + plane[2]) * w;
+					}
+
+					state.pixelShader(state.uniforms, *state.sampler, varyings, color);
+					m_Color[index] = PackColor(color);
+					pixelsShaded++;
+				}
+			}
+		}
+	}
+}
+
+} // end namespace render
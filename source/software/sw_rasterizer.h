@@ -0,0 +1,135 @@
+#pragma once
+
+#include "render_device/render_device.h"
+#include "render_device/software_shader.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace render
+{
+
+class ThreadPool;
+
+// Stencil test configuration for one face
+struct SoftwareStencilFace
+{
+	Compare compare;
+	StencilAction fail;
+	StencilAction depthFail;
+	StencilAction pass;
+	int ref;
+	unsigned int readMask;
+	unsigned int writeMask;
+};
+
+// Fixed-function and pixel shader state for a draw
+struct SoftwareDrawState
+{
+	bool cullEnabled;
+	bool frontFaceCCW;
+	Face cullFace;
+
+	bool depthEnabled;
+	bool depthWriteEnabled;
+	float depthNear;
+	float depthFar;
+	Compare depthCompare;
+
+	bool stencilEnabled;
+	SoftwareStencilFace stencilFront;
+	SoftwareStencilFace stencilBack;
+
+	SoftwarePixelShaderFunc pixelShader;
+	const void *uniforms;
+	const SoftwareSampler *sampler;
+	unsigned int numVaryings;
+};
+
+// Counters accumulated by the rasterizer
+struct SoftwareRasterizerStats
+{
+	unsigned long long trianglesSubmitted = 0; // triangles passed to DrawTriangles
+	unsigned long long trianglesRasterized = 0; // triangles left after clipping and culling
+	unsigned long long pixelsShaded = 0; // pixels that passed the depth/stencil tests
+};
+
+// Tile-binning triangle rasterizer. Each draw sets up its triangles, bins them into
+// screen tiles, then rasterizes every non-empty tile as a separate job on the thread
+// pool. Coverage, depth interpolation and depth testing are evaluated a SIMD register
+// of pixels at a time (AVX2 when compiled for it, otherwise SSE2, otherwise scalar).
+class SoftwareRasterizer
+{
+public:
+
+	// Pixel width and height of a tile; a multiple of every SIMD width
+	static const int TILE_SIZE = 64;
+
+	SoftwareRasterizer(ThreadPool &threadPool);
+
+	// Resize the color, depth, and stencil buffers
+	void Resize(int width, int height);
+
+	int GetWidth() const { return m_Width; }
+
+	int GetHeight() const { return m_Height; }
+
+	// Clear the color, depth, and stencil buffers
+	void Clear(float red, float green, float blue, float alpha, float depth, int stencil);
+
+	// Rasterize numTriangles triangles. vertices holds clip-space position (x, y, z, w)
+	// followed by state.numVaryings floats for each vertex, vertexStride floats apart;
+	// indices holds three vertex indices per triangle.
+	void DrawTriangles(const SoftwareDrawState &state, const float *vertices, unsigned int vertexStride, const unsigned int *indices, unsigned int numTriangles);
+
+	// Color buffer row y (bottom row first), one RGBA8 pixel per 32-bit value with red in the lowest byte
+	const uint32_t *GetColorRow(int y) const { return &m_Color[y * m_Stride]; }
+
+	const SoftwareRasterizerStats &GetStats() const { return m_Stats; }
+
+	// Name of the SIMD instruction set compiled in
+	static const char *GetSimdName();
+
+private:
+
+	// A triangle ready for rasterization: edge functions and interpolation planes in window space
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3];
+		unsigned int exclusiveEdges; // bit set for edges that do not own pixels exactly on them
+		float zPlane[3];
+		int minX, minY, maxX, maxY;
+		bool backFacing;
+	};
+
+	// Clip a triangle against the near and far planes and set up the pieces that survive culling
+	void SetupTriangle(const SoftwareDrawState &state, const float *v0, const float *v1, const float *v2);
+
+	// Project and set up a single clip-space triangle
+	void SetupClipped(const SoftwareDrawState &state, const float *v0, const float *v1, const float *v2);
+
+	// Rasterize every triangle binned to tile
+	void RasterizeTile(const SoftwareDrawState &state, unsigned int tile, unsigned long long &pixelsShaded);
+
+	ThreadPool &m_ThreadPool;
+
+	int m_Width = 0;
+	int m_Height = 0;
+	int m_Stride = 0; // width padded to a whole number of tiles
+	int m_TilesX = 0;
+	int m_TilesY = 0;
+
+	std::vector<uint32_t> m_Color;
+	std::vector<float> m_Depth;
+	std::vector<uint8_t> m_Stencil;
+
+	// per-draw setup output; planes holds (1/w, varyings/w) planes for each triangle
+	std::vector<Triangle> m_Triangles;
+	std::vector<float> m_Planes;
+	std::vector<std::vector<unsigned int> > m_Bins;
+	std::vector<unsigned int> m_ActiveTiles;
+
+	SoftwareRasterizerStats m_Stats;
+};
+
+} // end namespace render
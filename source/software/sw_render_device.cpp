@@ -0,0 +1,1630 @@
+#include "sw_render_device.h"
+
+#include "command_list_commands.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <map>
+
+namespace render
+{
+
+static std::map<std::string, const SoftwareVertexShaderDesc *> &GetVertexShaderRegistry()
+{
+	static std::map<std::string, const SoftwareVertexShaderDesc *> registry;
+	return registry;
+}
+
+static std::map<std::string, const SoftwarePixelShaderDesc *> &GetPixelShaderRegistry()
+{
+	static std::map<std::string, const SoftwarePixelShaderDesc *> registry;
+	return registry;
+}
+
+void RegisterSoftwareVertexShader(const char *code, const SoftwareVertexShaderDesc *desc)
+{
+	GetVertexShaderRegistry()[code] = desc;
+}
+
+void RegisterSoftwarePixelShader(const char *code, const SoftwarePixelShaderDesc *desc)
+{
+	GetPixelShaderRegistry()[code] = desc;
+}
+
+class SoftwareVertexShader : public VertexShader
+{
+public:
+
+	SoftwareVertexShader(const char *code)
+	{
+		auto iter = GetVertexShaderRegistry().find(code);
+		if(iter == GetVertexShaderRegistry().end() || iter->second->numVaryings > SOFTWARE_MAX_VARYINGS)
+			std::cout << "ERROR::SHADER::VERTEX::NOT_REGISTERED\n" << code << std::endl;
+		else
+			desc = iter->second;
+	}
+
+	const SoftwareVertexShaderDesc *desc = nullptr;
+};
+
+class SoftwarePixelShader : public PixelShader
+{
+public:
+
+	SoftwarePixelShader(const char *code)
+	{
+		auto iter = GetPixelShaderRegistry().find(code);
+		if(iter == GetPixelShaderRegistry().end())
+			std::cout << "ERROR::SHADER::FRAGMENT::NOT_REGISTERED\n" << code << std::endl;
+		else
+			desc = iter->second;
+	}
+
+	const SoftwarePixelShaderDesc *desc = nullptr;
+};
+
+class SoftwarePipelineParam : public PipelineParam
+{
+public:
+
+	// Where a uniform lives in one shader stage's uniform block
+	struct Target
+	{
+		char *data;
+		size_t size; // bytes available for the uniform's elements
+	};
+
+	void SetAsInt(int value) override
+	{
+		Store(&value, sizeof(value));
+	}
+
+	void SetAsFloat(float value) override
+	{
+		Store(&value, sizeof(value));
+	}
+
+	void SetAsMat4(const float *value) override
+	{
+		Store(value, 16 * sizeof(float));
+	}
+
+	void SetAsIntArray(int count, const int *values) override
+	{
+		Store(values, count * sizeof(int));
+	}
+
+	void SetAsFloatArray(int count, const float *values) override
+	{
+		Store(values, count * sizeof(float));
+	}
+
+	void SetAsMat4Array(int count, const float *values) override
+	{
+		Store(values, count * 16 * sizeof(float));
+	}
+
+	void Store(const void *data, size_t size) const
+	{
+		for(unsigned int i = 0; i < numTargets; i++)
+			memcpy(targets[i].data, data, std::min(size, targets[i].size));
+	}
+
+	const char *name = nullptr; // from the shader descs
+
+	// a uniform may be declared by both the vertex and the pixel shader
+	Target targets[2];
+	unsigned int numTargets = 0;
+};
+
+class SoftwarePipeline : public Pipeline
+{
+public:
+
+	SoftwarePipeline(SoftwareVertexShader *vertexShader, SoftwarePixelShader *pixelShader) : vertexDesc(vertexShader->desc), pixelDesc(pixelShader->desc)
+	{
+		if(!vertexDesc || !pixelDesc)
+		{
+			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\nmissing software shader" << std::endl;
+			vertexDesc = nullptr;
+			pixelDesc = nullptr;
+			return;
+		}
+
+		vertexUniforms.resize(vertexDesc->uniformBlockSize);
+		pixelUniforms.resize(pixelDesc->uniformBlockSize);
+		AddParams(vertexDesc->numUniforms, vertexDesc->uniforms, vertexUniforms);
+		AddParams(pixelDesc->numUniforms, pixelDesc->uniforms, pixelUniforms);
+		std::sort(params.begin(), params.end(), [](const SoftwarePipelineParam &a, const SoftwarePipelineParam &b) { return strcmp(a.name, b.name) < 0; });
+	}
+
+	PipelineParam *GetParam(const char *name) override
+	{
+		return ResolveParam(GetParamHandle(name));
+	}
+
+	ParamHandle GetParamHandle(const char *name) override;
+
+	PipelineParam *ResolveParam(ParamHandle handle) override
+	{
+		return handle >= 0 && handle < static_cast<ParamHandle>(params.size()) ? &params[handle] : nullptr;
+	}
+
+	bool SetUniformBlockSlot(const char *name, unsigned int slot) override;
+
+	bool IsValid() const { return vertexDesc != nullptr; }
+
+	const SoftwareVertexShaderDesc *vertexDesc;
+	const SoftwarePixelShaderDesc *pixelDesc;
+
+	std::vector<char> vertexUniforms;
+	std::vector<char> pixelUniforms;
+
+	// a param per uniform name, sorted by name; a handle is an index
+	std::vector<SoftwarePipelineParam> params;
+
+	// A uniform block and the uniform buffer slot it is read from
+	struct UniformBlock
+	{
+		unsigned int slot;
+		SoftwarePipelineParam param;
+	};
+
+	std::vector<UniformBlock> uniformBlocks;
+
+private:
+
+	// Add a param target for each of one stage's uniforms that fits in its block
+	void AddParams(unsigned int numUniforms, const SoftwareUniform *uniforms, std::vector<char> &block);
+};
+
+static size_t GetSoftwareUniformSize(const SoftwareUniform &uniform)
+{
+	static const size_t elementSize[] = { sizeof(int), sizeof(float), 16 * sizeof(float) };
+	return elementSize[uniform.type] * uniform.count;
+}
+
+void SoftwarePipeline::AddParams(unsigned int numUniforms, const SoftwareUniform *uniforms, std::vector<char> &block)
+{
+	for(unsigned int i = 0; i < numUniforms; i++)
+	{
+		const SoftwareUniform &uniform = uniforms[i];
+		if(uniform.offset + GetSoftwareUniformSize(uniform) > block.size())
+			continue;
+
+		// a stage declaring a name twice keeps the first
+		bool duplicate = false;
+		for(unsigned int j = 0; j < i; j++)
+			duplicate = duplicate || strcmp(uniforms[j].name, uniform.name) == 0;
+		if(duplicate)
+			continue;
+
+		// the other stage may have declared it already
+		SoftwarePipelineParam *param = nullptr;
+		for(SoftwarePipelineParam &existing : params)
+			if(strcmp(existing.name, uniform.name) == 0)
+				param = &existing;
+		if(!param)
+		{
+			params.push_back(SoftwarePipelineParam());
+			param = &params.back();
+			param->name = uniform.name;
+		}
+
+		param->targets[param->numTargets].data = &block[uniform.offset];
+		param->targets[param->numTargets++].size = GetSoftwareUniformSize(uniform);
+	}
+}
+
+ParamHandle SoftwarePipeline::GetParamHandle(const char *name)
+{
+	auto iter = std::lower_bound(params.begin(), params.end(), name, [](const SoftwarePipelineParam &param, const char *name) { return strcmp(param.name, name) < 0; });
+	if(iter == params.end() || strcmp(iter->name, name) != 0)
+		return INVALID_PARAM_HANDLE;
+	return static_cast<ParamHandle>(iter - params.begin());
+}
+
+bool SoftwarePipeline::SetUniformBlockSlot(const char *name, unsigned int slot)
+{
+	// a block is declared as a uniform of the same name, so it is found like any other uniform
+	SoftwarePipelineParam *param = static_cast<SoftwarePipelineParam *>(GetParam(name));
+	if(!param)
+		return false;
+
+	for(UniformBlock &block : uniformBlocks)
+	{
+		if(block.param.targets[0].data == param->targets[0].data)
+		{
+			block.slot = slot;
+			return true;
+		}
+	}
+
+	UniformBlock block;
+	block.slot = slot;
+	block.param = *param;
+	uniformBlocks.push_back(block);
+	return true;
+}
+
+// Returns whether a buffer of size bytes with usage can be created, printing an error under type if not;
+// buffers live in memory either way, so the usage is only validated
+static bool IsValidBuffer(const char *type, long long size, BufferUsage usage)
+{
+	if(size < 0)
+	{
+		std::cout << "ERROR::" << type << "::INVALID_SIZE\n" << size << std::endl;
+		return false;
+	}
+	if(usage < 0 || usage >= BUFFERUSAGE_MAX)
+	{
+		std::cout << "ERROR::" << type << "::INVALID_USAGE\n" << usage << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Returns the size bytes of storage at offset, or nullptr after printing an error under type if they are out of range
+static char *GetBufferRange(const char *type, std::vector<char> *storage, long long offset, long long size)
+{
+	if(!storage || offset < 0 || size <= 0 || offset + size > static_cast<long long>(storage->size()))
+	{
+		std::cout << "ERROR::" << type << "::INVALID_RANGE\n" << offset << ", " << size << " bytes" << std::endl;
+		return nullptr;
+	}
+	return &(*storage)[static_cast<size_t>(offset)];
+}
+
+// Copy size bytes between storage, or print an error under type if either range is out of bounds or they overlap
+static void CopyBufferRange(const char *type, std::vector<char> *destination, long long destinationOffset, std::vector<char> *source, long long sourceOffset, long long size)
+{
+	char *destinationRange = GetBufferRange(type, destination, destinationOffset, size);
+	char *sourceRange = GetBufferRange(type, source, sourceOffset, size);
+	if(!destinationRange || !sourceRange)
+		return;
+	if(destination == source && destinationOffset < sourceOffset + size && sourceOffset < destinationOffset + size)
+	{
+		std::cout << "ERROR::" << type << "::OVERLAPPING_COPY\n" << sourceOffset << " to " << destinationOffset << ", " << size << " bytes" << std::endl;
+		return;
+	}
+	memcpy(destinationRange, sourceRange, static_cast<size_t>(size));
+}
+
+class SoftwareVertexBuffer : public VertexBuffer
+{
+public:
+
+	SoftwareVertexBuffer(long long size, const void *data) : storage(static_cast<size_t>(size))
+	{
+		if(data && size > 0)
+			memcpy(&storage[0], data, static_cast<size_t>(size));
+	}
+
+	std::vector<char> storage;
+};
+
+static int GetVertexElementSize(const VertexElement &element)
+{
+	static const int typeSize[] = { 1, 2, 4, 1, 2, 4, 1, 2, 4, 1, 2, 4, 2, 4, 8 };
+	return element.size * typeSize[element.type];
+}
+
+class SoftwareVertexDescription : public VertexDescription
+{
+public:
+
+	SoftwareVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements) : elements(vertexElements, vertexElements + numVertexElements)
+	{
+		// a zero stride means tightly packed elements
+		for(VertexElement &element : elements)
+			if(element.stride == 0)
+				element.stride = GetVertexElementSize(element);
+	}
+
+	std::vector<VertexElement> elements;
+};
+
+class SoftwareVertexArray : public VertexArray
+{
+public:
+
+	SoftwareVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+	{
+		for(unsigned int i = 0; i < numVertexBuffers; i++)
+		{
+			SoftwareVertexBuffer *vertexBuffer = static_cast<SoftwareVertexBuffer *>(vertexBuffers[i]);
+			SoftwareVertexDescription *vertexDescription = static_cast<SoftwareVertexDescription *>(vertexDescriptions[i]);
+			for(const VertexElement &element : vertexDescription->elements)
+			{
+				if(element.index < SOFTWARE_MAX_ATTRIBUTES)
+					attributes.push_back(std::make_pair(vertexBuffer, element));
+			}
+		}
+	}
+
+	// every enabled attribute with the buffer it is fetched from
+	std::vector<std::pair<SoftwareVertexBuffer *, VertexElement> > attributes;
+};
+
+class SoftwareIndexBuffer : public IndexBuffer
+{
+public:
+
+	SoftwareIndexBuffer(long long size, const void *data, IndexFormat _format) : storage(static_cast<size_t>(size)), format(_format)
+	{
+		if(data && size > 0)
+			memcpy(&storage[0], data, static_cast<size_t>(size));
+	}
+
+	std::vector<char> storage;
+
+	IndexFormat format;
+};
+
+class SoftwareIndirectBuffer : public IndirectBuffer
+{
+public:
+
+	SoftwareIndirectBuffer(long long size, const void *data) : storage(static_cast<size_t>(size))
+	{
+		if(data && size > 0)
+			memcpy(&storage[0], data, static_cast<size_t>(size));
+	}
+
+	std::vector<char> storage;
+};
+
+class SoftwareTexture2D : public Texture2D
+{
+public:
+
+	SoftwareTexture2D(int _width, int _height, const void *data, TextureFormat _format, int _mipLevels) :
+		width(_width), height(_height), format(_format), mipLevels(_mipLevels), pixels(static_cast<size_t>(_width) * _height, 0xFF000000)
+	{
+		// only the top level is kept, as the sampler does not filter between mip levels
+		if(data)
+			Update(0, 0, width, height, data);
+	}
+
+	// Returns whether a region of a level lies within it
+	bool IsValidRegion(int mipLevel, int x, int y, int regionWidth, int regionHeight) const
+	{
+		if(mipLevel < 0 || mipLevel >= mipLevels)
+			return false;
+		int levelWidth = std::max(width >> mipLevel, 1), levelHeight = std::max(height >> mipLevel, 1);
+		return x >= 0 && y >= 0 && regionWidth > 0 && regionHeight > 0 && x + regionWidth <= levelWidth && y + regionHeight <= levelHeight;
+	}
+
+	// Copy a region of the top level from data. The most significant byte of RGBX sources
+	// is ignored, like the RGB texture the OpenGL device creates.
+	void Update(int x, int y, int regionWidth, int regionHeight, const void *data)
+	{
+		const uint32_t *source = static_cast<const uint32_t *>(data);
+		uint32_t alpha = format == TEXTUREFORMAT_RGBX8 ? 0xFF000000 : 0;
+		for(int row = 0; row < regionHeight; row++)
+		{
+			uint32_t *destination = &pixels[static_cast<size_t>(y + row) * width + x];
+			for(int column = 0; column < regionWidth; column++)
+				destination[column] = *source++ | alpha;
+		}
+	}
+
+	int width;
+	int height;
+	TextureFormat format;
+	int mipLevels;
+	std::vector<uint32_t> pixels;
+};
+
+class SoftwareTexture2DArray : public Texture2DArray
+{
+public:
+
+	SoftwareTexture2DArray(int width, int height, int numLayers, TextureFormat format, int mipLevels)
+	{
+		layers.reserve(numLayers);
+		for(int i = 0; i < numLayers; i++)
+			layers.emplace_back(width, height, nullptr, format, mipLevels);
+	}
+
+	std::vector<SoftwareTexture2D> layers;
+};
+
+// The number of layers OpenGL 4.1 guarantees a texture array can have
+static const int MAX_TEXTURE_LAYERS = 2048;
+
+class SoftwareUniformBuffer : public UniformBuffer
+{
+public:
+
+	SoftwareUniformBuffer(long long size, const void *data) : storage(static_cast<size_t>(size))
+	{
+		if(data && size > 0)
+			memcpy(&storage[0], data, static_cast<size_t>(size));
+	}
+
+	std::vector<char> storage;
+};
+
+class SoftwareSamplerState : public SamplerState
+{
+public:
+
+	SoftwareSamplerState(bool _linear, TextureWrap _wrapS, TextureWrap _wrapT) : linear(_linear), wrapS(_wrapS), wrapT(_wrapT) {}
+
+	bool linear;
+	TextureWrap wrapS;
+	TextureWrap wrapT;
+};
+
+class SoftwareTextureSampler final : public SoftwareSampler
+{
+public:
+
+	static const unsigned int MAX_SLOTS = 16;
+
+	SoftwareTextureSampler() : defaultSamplerState(true, TEXTUREWRAP_CLAMP_TO_EDGE, TEXTUREWRAP_CLAMP_TO_EDGE)
+	{
+		for(const SoftwareSamplerState *&samplerState : samplerStates)
+			samplerState = &defaultSamplerState;
+	}
+
+	void Sample(unsigned int slot, float u, float v, float *rgba) const override
+	{
+		if(slot < MAX_SLOTS)
+			SampleTexture(textures[slot], *samplerStates[slot], u, v, rgba);
+		else
+			SampleTexture(nullptr, defaultSamplerState, u, v, rgba);
+	}
+
+	void SampleArray(unsigned int slot, float u, float v, float layer, float *rgba) const override
+	{
+		const SoftwareTexture2DArray *textureArray = slot < MAX_SLOTS ? textureArrays[slot] : nullptr;
+		if(!textureArray)
+			return SampleTexture(nullptr, defaultSamplerState, u, v, rgba);
+
+		int last = static_cast<int>(textureArray->layers.size()) - 1;
+		int index = std::min(std::max(static_cast<int>(std::floor(layer + 0.5f)), 0), last);
+		SampleTexture(&textureArray->layers[index], *samplerStates[slot], u, v, rgba);
+	}
+
+	// Sample the top level of a texture; missing textures are opaque black
+	static void SampleTexture(const SoftwareTexture2D *texture, const SoftwareSamplerState &samplerState, float u, float v, float *rgba)
+	{
+		if(!texture)
+		{
+			rgba[0] = rgba[1] = rgba[2] = 0.0f;
+			rgba[3] = 1.0f;
+			return;
+		}
+
+		if(!samplerState.linear)
+		{
+			uint32_t p = texture->pixels[Wrap(static_cast<int>(std::floor(v * texture->height)), texture->height, samplerState.wrapT) * texture->width +
+				Wrap(static_cast<int>(std::floor(u * texture->width)), texture->width, samplerState.wrapS)];
+			for(int c = 0; c < 4; c++)
+				rgba[c] = ((p >> (c * 8)) & 0xFF) * (1.0f / 255.0f);
+			return;
+		}
+
+		// bilinear filtering; row 0 is at v = 0
+		float x = u * texture->width - 0.5f;
+		float y = v * texture->height - 0.5f;
+		float fx = std::floor(x), fy = std::floor(y);
+		float tx = x - fx, ty = y - fy;
+		int x0 = Wrap(static_cast<int>(fx), texture->width, samplerState.wrapS), x1 = Wrap(static_cast<int>(fx) + 1, texture->width, samplerState.wrapS);
+		int y0 = Wrap(static_cast<int>(fy), texture->height, samplerState.wrapT), y1 = Wrap(static_cast<int>(fy) + 1, texture->height, samplerState.wrapT);
+
+		const uint32_t *row0 = &texture->pixels[y0 * texture->width];
+		const uint32_t *row1 = &texture->pixels[y1 * texture->width];
+		uint32_t p00 = row0[x0], p10 = row0[x1], p01 = row1[x0], p11 = row1[x1];
+		for(int c = 0; c < 4; c++)
+		{
+			int shift = c * 8;
+			float top = ((p00 >> shift) & 0xFF) * (1.0f - tx) + ((p10 >> shift) & 0xFF) * tx;
+			float bottom = ((p01 >> shift) & 0xFF) * (1.0f - tx) + ((p11 >> shift) & 0xFF) * tx;
+			rgba[c] = (top * (1.0f - ty) + bottom * ty) * (1.0f / 255.0f);
+		}
+	}
+
+	static int Wrap(int value, int size, TextureWrap wrap)
+	{
+		if(wrap == TEXTUREWRAP_REPEAT)
+			return (value % size + size) % size;
+		if(wrap == TEXTUREWRAP_MIRRORED_REPEAT)
+		{
+			int mirrored = (value % (2 * size) + 2 * size) % (2 * size);
+			return mirrored < size ? mirrored : 2 * size - 1 - mirrored;
+		}
+		return value < 0 ? 0 : (value >= size ? size - 1 : value);
+	}
+
+	const SoftwareTexture2D *textures[MAX_SLOTS] = {};
+	const SoftwareTexture2DArray *textureArrays[MAX_SLOTS] = {};
+	const SoftwareSamplerState *samplerStates[MAX_SLOTS]; // never null
+
+	SoftwareSamplerState defaultSamplerState;
+};
+
+class SoftwareRasterState : public RasterState
+{
+public:
+
+	SoftwareRasterState(bool _cullEnabled, Winding _frontFace, Face _cullFace, RasterMode _rasterMode) :
+		cullEnabled(_cullEnabled), frontFace(_frontFace), cullFace(_cullFace), rasterMode(_rasterMode) {}
+
+	bool cullEnabled;
+	Winding frontFace;
+	Face cullFace;
+	RasterMode rasterMode;
+};
+
+class SoftwareDepthStencilState : public DepthStencilState
+{
+public:
+
+	bool depthEnabled;
+	bool depthWriteEnabled;
+	float depthNear;
+	float depthFar;
+	Compare depthCompare;
+
+	bool frontFaceStencilEnabled;
+	bool backFaceStencilEnabled;
+	SoftwareStencilFace front;
+	SoftwareStencilFace back;
+};
+
+// Convert one vertex element to floats, as the GL would when feeding a float attribute
+static void FetchAttribute(const char *source, VertexElementType type, int size, float *out)
+{
+	for(int i = 0; i < size && i < 4; i++)
+	{
+		switch(type)
+		{
+		case VERTEXELEMENTTYPE_BYTE: out[i] = reinterpret_cast<const int8_t *>(source)[i]; break;
+		case VERTEXELEMENTTYPE_SHORT: out[i] = reinterpret_cast<const int16_t *>(source)[i]; break;
+		case VERTEXELEMENTTYPE_INT: out[i] = static_cast<float>(reinterpret_cast<const int32_t *>(source)[i]); break;
+		case VERTEXELEMENTTYPE_UNSIGNED_BYTE: out[i] = reinterpret_cast<const uint8_t *>(source)[i]; break;
+		case VERTEXELEMENTTYPE_UNSIGNED_SHORT: out[i] = reinterpret_cast<const uint16_t *>(source)[i]; break;
+		case VERTEXELEMENTTYPE_UNSIGNED_INT: out[i] = static_cast<float>(reinterpret_cast<const uint32_t *>(source)[i]); break;
+		case VERTEXELEMENTTYPE_BYTE_NORMALIZE: out[i] = std::max(reinterpret_cast<const int8_t *>(source)[i] / 127.0f, -1.0f); break;
+		case VERTEXELEMENTTYPE_SHORT_NORMALIZE: out[i] = std::max(reinterpret_cast<const int16_t *>(source)[i] / 32767.0f, -1.0f); break;
+		case VERTEXELEMENTTYPE_INT_NORMALIZE: out[i] = std::max(static_cast<float>(reinterpret_cast<const int32_t *>(source)[i] / 2147483647.0), -1.0f); break;
+		case VERTEXELEMENTTYPE_UNSIGNED_BYTE_NORMALIZE: out[i] = reinterpret_cast<const uint8_t *>(source)[i] / 255.0f; break;
+		case VERTEXELEMENTTYPE_UNSIGNED_SHORT_NORMALIZE: out[i] = reinterpret_cast<const uint16_t *>(source)[i] / 65535.0f; break;
+		case VERTEXELEMENTTYPE_UNSIGNED_INT_NORMALIZE: out[i] = static_cast<float>(reinterpret_cast<const uint32_t *>(source)[i] / 4294967295.0); break;
+		case VERTEXELEMENTTYPE_HALF_FLOAT:
+		{
+			uint16_t half = reinterpret_cast<const uint16_t *>(source)[i];
+			int exponent = (half >> 10) & 0x1F, mantissa = half & 0x3FF;
+			float value = exponent == 0 ? std::ldexp(static_cast<float>(mantissa), -24) :
+				(exponent == 31 ? (mantissa ? NAN : INFINITY) : std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25));
+			out[i] = (half & 0x8000) ? -value : value;
+			break;
+		}
+		case VERTEXELEMENTTYPE_FLOAT: out[i] = reinterpret_cast<const float *>(source)[i]; break;
+		case VERTEXELEMENTTYPE_DOUBLE: out[i] = static_cast<float>(reinterpret_cast<const double *>(source)[i]); break;
+		}
+	}
+}
+
+SoftwareRenderDevice::SoftwareRenderDevice(int width, int height, unsigned int numThreads) : m_ThreadPool(numThreads), m_Rasterizer(m_ThreadPool)
+{
+	m_Rasterizer.Resize(width, height);
+	m_Sampler = new SoftwareTextureSampler;
+
+	m_DefaultRasterState = static_cast<SoftwareRasterState *>(CreateRasterState());
+	m_RasterState = m_DefaultRasterState;
+
+	m_DefaultDepthStencilState = static_cast<SoftwareDepthStencilState *>(CreateDepthStencilState());
+	m_DepthStencilState = m_DefaultDepthStencilState;
+}
+
+SoftwareRenderDevice::~SoftwareRenderDevice()
+{
+	if(m_DrawCalls)
+	{
+		const SoftwareRasterizerStats &stats = m_Rasterizer.GetStats();
+		double seconds = std::chrono::duration<double>(m_DrawTime).count();
+		std::cout << "SoftwareRenderDevice (" << SoftwareRasterizer::GetSimdName() << ", " << m_ThreadPool.GetNumThreads() << " threads): "
+			<< m_Frames << " frames, " << m_DrawCalls << " draws, " << stats.trianglesSubmitted << " triangles ("
+			<< stats.trianglesRasterized << " rasterized), " << stats.pixelsShaded << " pixels in " << seconds * 1000.0 << " ms" << std::endl;
+		if(seconds > 0.0)
+			std::cout << "SoftwareRenderDevice: " << stats.trianglesSubmitted / seconds / 1.0e6 << " Mtriangles/s, "
+				<< stats.pixelsShaded / seconds / 1.0e6 << " Mpixels/s" << std::endl;
+	}
+
+	// keep the last frame for automated image comparisons
+	const char *output = getenv("RENDER_DEVICE_OUTPUT");
+	if(output && *output && !SaveColorBuffer(output))
+		std::cout << "ERROR::SOFTWARERENDERDEVICE::OUTPUT_FAILED\n" << output << std::endl;
+
+	delete m_DefaultRasterState;
+	delete m_DefaultDepthStencilState;
+	delete m_Sampler;
+	delete m_TransientVertexBuffer;
+	delete m_TransientIndexBuffer;
+}
+
+bool SoftwareRenderDevice::SaveColorBuffer(const char *path) const
+{
+	FILE *file = fopen(path, "wb");
+	if(!file)
+		return false;
+
+	int width = m_Rasterizer.GetWidth(), height = m_Rasterizer.GetHeight();
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+	// images are stored top row first
+	std::vector<unsigned char> row(width * 3);
+	for(int y = height - 1; y >= 0; y--)
+	{
+		const uint32_t *pixels = m_Rasterizer.GetColorRow(y);
+		for(int x = 0; x < width; x++)
+		{
+			row[x * 3 + 0] = static_cast<unsigned char>(pixels[x]);
+			row[x * 3 + 1] = static_cast<unsigned char>(pixels[x] >> 8);
+			row[x * 3 + 2] = static_cast<unsigned char>(pixels[x] >> 16);
+		}
+		fwrite(&row[0], 1, row.size(), file);
+	}
+
+	return fclose(file) == 0;
+}
+
+VertexShader *SoftwareRenderDevice::CreateVertexShader(const char *code)
+{
+	return new SoftwareVertexShader(code);
+}
+
+void SoftwareRenderDevice::DestroyVertexShader(VertexShader *vertexShader)
+{
+	delete vertexShader;
+}
+
+PixelShader *SoftwareRenderDevice::CreatePixelShader(const char *code)
+{
+	return new SoftwarePixelShader(code);
+}
+
+void SoftwareRenderDevice::DestroyPixelShader(PixelShader *pixelShader)
+{
+	delete pixelShader;
+}
+
+Pipeline *SoftwareRenderDevice::CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader)
+{
+	return new SoftwarePipeline(static_cast<SoftwareVertexShader *>(vertexShader), static_cast<SoftwarePixelShader *>(pixelShader));
+}
+
+void SoftwareRenderDevice::DestroyPipeline(Pipeline *pipeline)
+{
+	if(pipeline == m_Pipeline)
+		m_Pipeline = nullptr;
+	delete pipeline;
+}
+
+void SoftwareRenderDevice::SetPipeline(Pipeline *pipeline)
+{
+	m_Pipeline = static_cast<SoftwarePipeline *>(pipeline);
+}
+
+VertexBuffer *SoftwareRenderDevice::CreateVertexBuffer(long long size, const void *data, BufferUsage usage)
+{
+	if(!IsValidBuffer("VERTEXBUFFER", size, usage))
+		return nullptr;
+	return new SoftwareVertexBuffer(size, data);
+}
+
+void SoftwareRenderDevice::UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data)
+{
+	char *range = GetBufferRange("VERTEXBUFFER", vertexBuffer ? &static_cast<SoftwareVertexBuffer *>(vertexBuffer)->storage : nullptr, offset, size);
+	if(range && data)
+		memcpy(range, data, static_cast<size_t>(size));
+}
+
+void *SoftwareRenderDevice::MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	// draws are rasterized before they return, so nothing can be reading the buffer and the storage is handed out
+	// directly, whatever the flags
+	return GetBufferRange("VERTEXBUFFER", vertexBuffer ? &static_cast<SoftwareVertexBuffer *>(vertexBuffer)->storage : nullptr, offset, size);
+}
+
+void SoftwareRenderDevice::UnmapVertexBuffer(VertexBuffer *vertexBuffer)
+{
+}
+
+void SoftwareRenderDevice::CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	CopyBufferRange("VERTEXBUFFER", destination ? &static_cast<SoftwareVertexBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &static_cast<SoftwareVertexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void SoftwareRenderDevice::DestroyVertexBuffer(VertexBuffer *vertexBuffer)
+{
+	delete vertexBuffer;
+}
+
+VertexDescription *SoftwareRenderDevice::CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements)
+{
+	return new SoftwareVertexDescription(numVertexElements, vertexElements);
+}
+
+void SoftwareRenderDevice::DestroyVertexDescription(VertexDescription *vertexDescription)
+{
+	delete vertexDescription;
+}
+
+VertexArray *SoftwareRenderDevice::CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+{
+	return new SoftwareVertexArray(numVertexBuffers, vertexBuffers, vertexDescriptions);
+}
+
+void SoftwareRenderDevice::DestroyVertexArray(VertexArray *vertexArray)
+{
+	if(vertexArray == m_VertexArray)
+		m_VertexArray = nullptr;
+	delete vertexArray;
+}
+
+void SoftwareRenderDevice::SetVertexArray(VertexArray *vertexArray)
+{
+	m_VertexArray = static_cast<SoftwareVertexArray *>(vertexArray);
+}
+
+IndexBuffer *SoftwareRenderDevice::CreateIndexBuffer(long long size, const void *data, BufferUsage usage, IndexFormat format)
+{
+	if(!IsValidBuffer("INDEXBUFFER", size, usage))
+		return nullptr;
+	if(format < 0 || format >= INDEXFORMAT_MAX)
+	{
+		std::cout << "ERROR::INDEXBUFFER::INVALID_FORMAT\n" << format << std::endl;
+		return nullptr;
+	}
+	return new SoftwareIndexBuffer(size, data, format);
+}
+
+
+void SoftwareRenderDevice::UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data)
+{
+	char *range = GetBufferRange("INDEXBUFFER", indexBuffer ? &static_cast<SoftwareIndexBuffer *>(indexBuffer)->storage : nullptr, offset, size);
+	if(range && data)
+		memcpy(range, data, static_cast<size_t>(size));
+}
+
+void *SoftwareRenderDevice::MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	return GetBufferRange("INDEXBUFFER", indexBuffer ? &static_cast<SoftwareIndexBuffer *>(indexBuffer)->storage : nullptr, offset, size);
+}
+
+void SoftwareRenderDevice::UnmapIndexBuffer(IndexBuffer *indexBuffer)
+{
+}
+
+void SoftwareRenderDevice::CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size)
+{
+	CopyBufferRange("INDEXBUFFER", destination ? &static_cast<SoftwareIndexBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &static_cast<SoftwareIndexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void SoftwareRenderDevice::DestroyIndexBuffer(IndexBuffer *indexBuffer)
+{
+	if(indexBuffer == m_IndexBuffer)
+		m_IndexBuffer = nullptr;
+	delete indexBuffer;
+}
+
+void SoftwareRenderDevice::SetIndexBuffer(IndexBuffer *indexBuffer)
+{
+	m_IndexBuffer = static_cast<SoftwareIndexBuffer *>(indexBuffer);
+}
+
+void SoftwareRenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	if(topology < 0 || topology >= PRIMITIVETOPOLOGY_MAX)
+	{
+		std::cout << "ERROR::PRIMITIVETOPOLOGY::INVALID\n" << topology << std::endl;
+		return;
+	}
+	m_Topology = topology;
+}
+
+IndirectBuffer *SoftwareRenderDevice::CreateIndirectBuffer(long long size, const void *data, BufferUsage usage)
+{
+	if(!IsValidBuffer("INDIRECTBUFFER", size, usage))
+		return nullptr;
+	return new SoftwareIndirectBuffer(size, data);
+}
+
+void SoftwareRenderDevice::UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data)
+{
+	char *range = GetBufferRange("INDIRECTBUFFER", indirectBuffer ? &static_cast<SoftwareIndirectBuffer *>(indirectBuffer)->storage : nullptr, offset, size);
+	if(range && data)
+		memcpy(range, data, static_cast<size_t>(size));
+}
+
+void SoftwareRenderDevice::CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	CopyBufferRange("INDIRECTBUFFER", destination ? &static_cast<SoftwareIndirectBuffer *>(destination)->storage : nullptr, destinationOffset,
+		source ? &static_cast<SoftwareVertexBuffer *>(source)->storage : nullptr, sourceOffset, size);
+}
+
+void SoftwareRenderDevice::DestroyIndirectBuffer(IndirectBuffer *indirectBuffer)
+{
+	delete indirectBuffer;
+}
+
+Texture2D *SoftwareRenderDevice::CreateTexture2D(int width, int height, const void *data, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	if(!IsTextureFormatSupported(format))
+	{
+		std::cout << "ERROR::TEXTURE2D::UNSUPPORTED_FORMAT\n" << format << std::endl;
+		return nullptr;
+	}
+	if(width <= 0 || height <= 0 || mipLevels < 0 || mipLevels > GetTextureMipLevels(width, height))
+	{
+		std::cout << "ERROR::TEXTURE2D::INVALID_SIZE\n" << width << "x" << height << ", " << mipLevels << " levels" << std::endl;
+		return nullptr;
+	}
+
+	// only the top level is sampled, so no chain is ever filled
+	if(mipLevels == 0)
+		mipLevels = mipPolicy == MIPPOLICY_NONE ? 1 : GetTextureMipLevels(width, height);
+
+	return new SoftwareTexture2D(width, height, data, format, mipLevels);
+}
+
+bool SoftwareRenderDevice::IsTextureFormatSupported(TextureFormat format)
+{
+	// block-compressed formats are not decoded
+	return format == TEXTUREFORMAT_RGBX8 || format == TEXTUREFORMAT_RGBA8;
+}
+
+void SoftwareRenderDevice::UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async)
+{
+	SoftwareTexture2D *texture = static_cast<SoftwareTexture2D *>(texture2D);
+	if(!texture || !data || !texture->IsValidRegion(mipLevel, x, y, width, height))
+	{
+		std::cout << "ERROR::TEXTURE2D::INVALID_REGION\n" << mipLevel << ": " << x << ", " << y << ", " << width << "x" << height << std::endl;
+		return;
+	}
+
+	// draws are rasterized before they return, so updates never have to wait and async changes nothing;
+	// only the top level is sampled, so updates of the others are dropped
+	if(mipLevel == 0)
+		texture->Update(x, y, width, height, data);
+}
+
+void SoftwareRenderDevice::DestroyTexture2D(Texture2D *texture2D)
+{
+	for(const SoftwareTexture2D *&boundTexture2D : m_Sampler->textures)
+		if(boundTexture2D == texture2D)
+			boundTexture2D = nullptr;
+	delete texture2D;
+}
+
+void SoftwareRenderDevice::SetTexture2D(unsigned int slot, Texture2D *texture2D)
+{
+	if(slot < SoftwareTextureSampler::MAX_SLOTS)
+		m_Sampler->textures[slot] = static_cast<SoftwareTexture2D *>(texture2D);
+}
+
+Texture2DArray *SoftwareRenderDevice::CreateTexture2DArray(int width, int height, int layers, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	if(!IsTextureFormatSupported(format))
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::UNSUPPORTED_FORMAT\n" << format << std::endl;
+		return nullptr;
+	}
+	if(width <= 0 || height <= 0 || mipLevels < 0 || mipLevels > GetTextureMipLevels(width, height))
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_SIZE\n" << width << "x" << height << ", " << mipLevels << " levels" << std::endl;
+		return nullptr;
+	}
+	if(layers <= 0 || layers > MAX_TEXTURE_LAYERS)
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_LAYERS\n" << layers << " of at most " << MAX_TEXTURE_LAYERS << std::endl;
+		return nullptr;
+	}
+
+	if(mipLevels == 0)
+		mipLevels = mipPolicy == MIPPOLICY_NONE ? 1 : GetTextureMipLevels(width, height);
+
+	return new SoftwareTexture2DArray(width, height, layers, format, mipLevels);
+}
+
+void SoftwareRenderDevice::UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async)
+{
+	SoftwareTexture2DArray *textureArray = static_cast<SoftwareTexture2DArray *>(texture2DArray);
+	if(!textureArray || !data || layer < 0 || layer >= static_cast<int>(textureArray->layers.size()))
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_LAYER\n" << layer << std::endl;
+		return;
+	}
+
+	// the top level leads the data of each layer, and is the only one sampled
+	SoftwareTexture2D &texture = textureArray->layers[layer];
+	texture.Update(0, 0, texture.width, texture.height, data);
+}
+
+void SoftwareRenderDevice::UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+	bool async)
+{
+	SoftwareTexture2DArray *textureArray = static_cast<SoftwareTexture2DArray *>(texture2DArray);
+	if(!textureArray || !data || layer < 0 || layer >= static_cast<int>(textureArray->layers.size()) ||
+		!textureArray->layers[layer].IsValidRegion(mipLevel, x, y, width, height))
+	{
+		std::cout << "ERROR::TEXTURE2DARRAY::INVALID_REGION\n" << layer << ", " << mipLevel << ": " << x << ", " << y << ", " << width << "x" << height << std::endl;
+		return;
+	}
+
+	if(mipLevel == 0)
+		textureArray->layers[layer].Update(x, y, width, height, data);
+}
+
+void SoftwareRenderDevice::DestroyTexture2DArray(Texture2DArray *texture2DArray)
+{
+	for(const SoftwareTexture2DArray *&boundTexture2DArray : m_Sampler->textureArrays)
+		if(boundTexture2DArray == texture2DArray)
+			boundTexture2DArray = nullptr;
+	delete texture2DArray;
+}
+
+void SoftwareRenderDevice::SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray)
+{
+	if(slot < SoftwareTextureSampler::MAX_SLOTS)
+		m_Sampler->textureArrays[slot] = static_cast<SoftwareTexture2DArray *>(texture2DArray);
+}
+
+SamplerState *SoftwareRenderDevice::CreateSamplerState(TextureFilter minFilter, TextureFilter magFilter, MipFilter mipFilter, TextureWrap wrapS, TextureWrap wrapT)
+{
+	return new SoftwareSamplerState(magFilter == TEXTUREFILTER_LINEAR, wrapS, wrapT);
+}
+
+void SoftwareRenderDevice::DestroySamplerState(SamplerState *samplerState)
+{
+	for(const SoftwareSamplerState *&boundSamplerState : m_Sampler->samplerStates)
+		if(boundSamplerState == samplerState)
+			boundSamplerState = &m_Sampler->defaultSamplerState;
+	delete samplerState;
+}
+
+void SoftwareRenderDevice::SetSamplerState(unsigned int slot, SamplerState *samplerState)
+{
+	if(slot < SoftwareTextureSampler::MAX_SLOTS)
+		m_Sampler->samplerStates[slot] = samplerState ? static_cast<SoftwareSamplerState *>(samplerState) : &m_Sampler->defaultSamplerState;
+}
+
+UniformBuffer *SoftwareRenderDevice::CreateUniformBuffer(long long size, const void *data, BufferUsage usage)
+{
+	if(!IsValidBuffer("UNIFORMBUFFER", size, usage))
+		return nullptr;
+	return new SoftwareUniformBuffer(size, data);
+}
+
+
+void SoftwareRenderDevice::UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data)
+{
+	char *range = GetBufferRange("UNIFORMBUFFER", uniformBuffer ? &static_cast<SoftwareUniformBuffer *>(uniformBuffer)->storage : nullptr, offset, size);
+	if(range && data)
+		memcpy(range, data, static_cast<size_t>(size));
+}
+
+void *SoftwareRenderDevice::MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	return GetBufferRange("UNIFORMBUFFER", uniformBuffer ? &static_cast<SoftwareUniformBuffer *>(uniformBuffer)->storage : nullptr, offset, size);
+}
+
+void SoftwareRenderDevice::UnmapUniformBuffer(UniformBuffer *uniformBuffer)
+{
+}
+
+void SoftwareRenderDevice::DestroyUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	for(UniformBinding &binding : m_UniformBindings)
+		if(binding.buffer == uniformBuffer)
+			binding = UniformBinding{ nullptr, 0, 0 };
+	delete uniformBuffer;
+}
+
+void SoftwareRenderDevice::SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer)
+{
+	if(slot >= m_UniformBindings.size())
+		m_UniformBindings.resize(slot + 1, UniformBinding{ nullptr, 0, 0 });
+	SoftwareUniformBuffer *softwareUniformBuffer = static_cast<SoftwareUniformBuffer *>(uniformBuffer);
+	m_UniformBindings[slot] = UniformBinding{ softwareUniformBuffer, 0, softwareUniformBuffer ? static_cast<long long>(softwareUniformBuffer->storage.size()) : 0 };
+}
+
+long long SoftwareRenderDevice::WriteUniformData(const void *data, long long size)
+{
+	if(!data || size <= 0)
+	{
+		std::cout << "ERROR::UNIFORMDATA::INVALID_SIZE\n" << size << std::endl;
+		return -1;
+	}
+
+	long long offset = static_cast<long long>(m_UniformData.size());
+	m_UniformData.resize(static_cast<size_t>(offset + (size + 15) / 16 * 16));
+	memcpy(&m_UniformData[static_cast<size_t>(offset)], data, static_cast<size_t>(size));
+	return offset;
+}
+
+void SoftwareRenderDevice::SetUniformData(unsigned int slot, long long offset, long long size)
+{
+	if(offset < 0 || size <= 0 || offset + size > static_cast<long long>(m_UniformData.size()))
+	{
+		std::cout << "ERROR::UNIFORMDATA::INVALID_RANGE\n" << offset << ", " << size << std::endl;
+		return;
+	}
+
+	if(slot >= m_UniformBindings.size())
+		m_UniformBindings.resize(slot + 1, UniformBinding{ nullptr, 0, 0 });
+	m_UniformBindings[slot] = UniformBinding{ nullptr, offset, size };
+}
+
+TransientVertices SoftwareRenderDevice::WriteTransientVertices(const void *data, int count, int stride)
+{
+	TransientVertices vertices = { nullptr, 0, 0 };
+	if(!data || count <= 0 || stride <= 0)
+	{
+		std::cout << "ERROR::TRANSIENTVERTICES::INVALID_SIZE\n" << count << " vertices of " << stride << " bytes" << std::endl;
+		return vertices;
+	}
+
+	// draws are rasterized before they return, so a frame's worth of storage is enough and is simply reused the next frame
+	long long offset = (m_TransientVertexSize + stride - 1) / stride * stride;
+	long long size = static_cast<long long>(count) * stride;
+	if(offset + size > TRANSIENT_VERTEX_FRAME_SIZE)
+	{
+		std::cout << "ERROR::TRANSIENTVERTICES::FRAME_TOO_LARGE\n" << offset + size << " bytes written this frame" << std::endl;
+		return vertices;
+	}
+
+	if(!m_TransientVertexBuffer)
+		m_TransientVertexBuffer = new SoftwareVertexBuffer(TRANSIENT_VERTEX_FRAME_SIZE, nullptr);
+	memcpy(&m_TransientVertexBuffer->storage[static_cast<size_t>(offset)], data, static_cast<size_t>(size));
+	m_TransientVertexSize = offset + size;
+
+	vertices.vertexBuffer = m_TransientVertexBuffer;
+	vertices.offset = offset;
+	vertices.firstVertex = static_cast<int>(offset / stride);
+	return vertices;
+}
+
+TransientIndices SoftwareRenderDevice::WriteTransientIndices(const unsigned int *indices, int count, int baseVertex)
+{
+	TransientIndices transientIndices = { nullptr, 0 };
+	if(!indices || count <= 0)
+	{
+		std::cout << "ERROR::TRANSIENTINDICES::INVALID_SIZE\n" << count << " indices" << std::endl;
+		return transientIndices;
+	}
+
+	long long offset = m_TransientIndexSize;
+	if(offset + count * 4ll > TRANSIENT_INDEX_FRAME_SIZE)
+	{
+		std::cout << "ERROR::TRANSIENTINDICES::FRAME_TOO_LARGE\n" << offset + count * 4ll << " bytes written this frame" << std::endl;
+		return transientIndices;
+	}
+
+	if(!m_TransientIndexBuffer)
+		m_TransientIndexBuffer = new SoftwareIndexBuffer(TRANSIENT_INDEX_FRAME_SIZE, nullptr, INDEXFORMAT_32);
+	uint32_t *destination = reinterpret_cast<uint32_t *>(&m_TransientIndexBuffer->storage[static_cast<size_t>(offset)]);
+	for(int i = 0; i < count; i++)
+		destination[i] = indices[i] + baseVertex;
+	m_TransientIndexSize = offset + count * 4ll;
+
+	transientIndices.indexBuffer = m_TransientIndexBuffer;
+	transientIndices.offset = offset;
+	return transientIndices;
+}
+
+void SoftwareRenderDevice::ApplyUniformBlocks()
+{
+	for(const SoftwarePipeline::UniformBlock &block : m_Pipeline->uniformBlocks)
+	{
+		if(block.slot >= m_UniformBindings.size() || !m_UniformBindings[block.slot].size)
+			continue;
+
+		const UniformBinding &binding = m_UniformBindings[block.slot];
+		const std::vector<char> &storage = binding.buffer ? binding.buffer->storage : m_UniformData;
+		block.param.Store(&storage[static_cast<size_t>(binding.offset)], static_cast<size_t>(binding.size));
+	}
+}
+
+RasterState *SoftwareRenderDevice::CreateRasterState(bool cullEnabled, Winding frontFace, Face cullFace, RasterMode rasterMode)
+{
+	return new SoftwareRasterState(cullEnabled, frontFace, cullFace, rasterMode);
+}
+
+void SoftwareRenderDevice::DestroyRasterState(RasterState *rasterState)
+{
+	if(rasterState == m_RasterState)
+		m_RasterState = m_DefaultRasterState;
+	delete rasterState;
+}
+
+void SoftwareRenderDevice::SetRasterState(RasterState *rasterState)
+{
+	m_RasterState = rasterState ? static_cast<SoftwareRasterState *>(rasterState) : m_DefaultRasterState;
+}
+
+DepthStencilState *SoftwareRenderDevice::CreateDepthStencilState(bool depthEnabled, bool depthWriteEnabled, float depthNear, float depthFar, Compare depthCompare,
+		bool frontFaceStencilEnabled, Compare frontFaceStencilCompare, StencilAction frontFaceStencilFail, StencilAction frontFaceStencilPass,
+		StencilAction frontFaceDepthFail, int frontFaceRef, unsigned int frontFaceReadMask, unsigned int frontFaceWriteMask, bool backFaceStencilEnabled,
+		Compare backFaceStencilCompare, StencilAction backFaceStencilFail, StencilAction backFaceStencilPass, StencilAction backFaceDepthFail,
+		int backFaceRef, unsigned int backFaceReadMask, unsigned int backFaceWriteMask)
+{
+	SoftwareDepthStencilState *state = new SoftwareDepthStencilState;
+	state->depthEnabled = depthEnabled;
+	state->depthWriteEnabled = depthWriteEnabled;
+	state->depthNear = depthNear;
+	state->depthFar = depthFar;
+	state->depthCompare = depthCompare;
+
+	state->frontFaceStencilEnabled = frontFaceStencilEnabled;
+	state->front.compare = frontFaceStencilCompare;
+	state->front.fail = frontFaceStencilFail;
+	state->front.depthFail = frontFaceDepthFail;
+	state->front.pass = frontFaceStencilPass;
+	state->front.ref = frontFaceRef;
+	state->front.readMask = frontFaceReadMask & 0xFF;
+	state->front.writeMask = frontFaceWriteMask & 0xFF;
+
+	state->backFaceStencilEnabled = backFaceStencilEnabled;
+	state->back.compare = backFaceStencilCompare;
+	state->back.fail = backFaceStencilFail;
+	state->back.depthFail = backFaceDepthFail;
+	state->back.pass = backFaceStencilPass;
+	state->back.ref = backFaceRef;
+	state->back.readMask = backFaceReadMask & 0xFF;
+	state->back.writeMask = backFaceWriteMask & 0xFF;
+	return state;
+}
+
+void SoftwareRenderDevice::DestroyDepthStencilState(DepthStencilState *depthStencilState)
+{
+	if(depthStencilState == m_DepthStencilState)
+		m_DepthStencilState = m_DefaultDepthStencilState;
+	delete depthStencilState;
+}
+
+void SoftwareRenderDevice::SetDepthStencilState(DepthStencilState *depthStencilState)
+{
+	m_DepthStencilState = depthStencilState ? static_cast<SoftwareDepthStencilState *>(depthStencilState) : m_DefaultDepthStencilState;
+}
+
+void SoftwareRenderDevice::Clear(float red, float green, float blue, float alpha, float depth, int stencil)
+{
+	m_Rasterizer.Clear(red, green, blue, alpha, depth, stencil);
+}
+
+// Vertices a draw of topology needs to form a primitive
+static int GetMinVertices(PrimitiveTopology topology)
+{
+	switch(topology)
+	{
+	case PRIMITIVETOPOLOGY_LINE_LIST:
+	case PRIMITIVETOPOLOGY_LINE_STRIP:
+		return 2;
+	case PRIMITIVETOPOLOGY_POINT_LIST:
+		return 1;
+	default:
+		return 3;
+	}
+}
+
+void SoftwareRenderDevice::ShadeVertices(unsigned int first, unsigned int count, unsigned int instanceCount)
+{
+	const SoftwareVertexShaderDesc *desc = m_Pipeline->vertexDesc;
+	const unsigned int stride = 4 + desc->numVaryings;
+	const void *uniforms = m_Pipeline->vertexUniforms.empty() ? nullptr : &m_Pipeline->vertexUniforms[0];
+	const SoftwareVertexArray *vertexArray = m_VertexArray;
+	const unsigned int total = count * instanceCount;
+
+	m_ShadedVertices.resize(static_cast<size_t>(total) * stride);
+	float *shaded = m_ShadedVertices.empty() ? nullptr : &m_ShadedVertices[0];
+
+	// vertices of every instance are shaded in batches across the thread pool
+	const unsigned int batchSize = 256;
+	m_ThreadPool.ParallelFor((total + batchSize - 1) / batchSize, [&](unsigned int batch) {
+		float attributes[SOFTWARE_MAX_ATTRIBUTES][4];
+		unsigned int end = std::min(total, (batch + 1) * batchSize);
+		for(unsigned int i = batch * batchSize; i < end; i++)
+		{
+			unsigned int instance = i / count, vertexIndex = first + (i - instance * count);
+
+			for(unsigned int a = 0; a < SOFTWARE_MAX_ATTRIBUTES; a++)
+			{
+				attributes[a][0] = attributes[a][1] = attributes[a][2] = 0.0f;
+				attributes[a][3] = 1.0f;
+			}
+
+			for(const auto &attribute : vertexArray->attributes)
+			{
+				const VertexElement &element = attribute.second;
+				const std::vector<char> &storage = attribute.first->storage;
+				// per-instance elements ignore the first vertex, as base vertices do not apply to them
+				unsigned int elementIndex = element.divisor ? instance / element.divisor : vertexIndex;
+				long long offset = element.offset + static_cast<long long>(elementIndex) * element.stride;
+				if(offset >= 0 && offset + GetVertexElementSize(element) <= static_cast<long long>(storage.size()))
+					FetchAttribute(&storage[static_cast<size_t>(offset)], element.type, element.size, attributes[element.index]);
+			}
+
+			float *vertex = shaded + static_cast<size_t>(i) * stride;
+			desc->main(uniforms, attributes, vertex, vertex + 4);
+		}
+	});
+}
+
+void SoftwareRenderDevice::RepeatTriangleIndices(unsigned int numIndices, unsigned int vertexCount, unsigned int instanceCount)
+{
+	for(unsigned int instance = 1; instance < instanceCount; instance++)
+	{
+		unsigned int *destination = &m_TriangleIndices[static_cast<size_t>(instance) * numIndices];
+		for(unsigned int i = 0; i < numIndices; i++)
+			destination[i] = m_TriangleIndices[i] + instance * vertexCount;
+	}
+}
+
+unsigned int SoftwareRenderDevice::AssemblePrimitives(unsigned int numIndices, unsigned int vertexCount, unsigned int instanceCount)
+{
+	const unsigned int stride = 4 + m_Pipeline->vertexDesc->numVaryings;
+	const unsigned int *indices = m_PrimitiveIndices.empty() ? nullptr : &m_PrimitiveIndices[0];
+
+	// lines and points are a pixel wide, as OpenGL draws them by default
+	const float pixelWidth = 2.0f / m_Rasterizer.GetWidth(), pixelHeight = 2.0f / m_Rasterizer.GetHeight();
+
+	m_TriangleIndices.clear();
+	for(unsigned int instance = 0; instance < instanceCount; instance++)
+	{
+		const unsigned int base = instance * vertexCount;
+
+		// strips count the vertices since the last restart
+		unsigned int stripVertices = 0;
+		for(unsigned int i = 0; i < numIndices; i++)
+		{
+			if(indices[i] == PRIMITIVE_RESTART_INDEX32)
+			{
+				stripVertices = 0;
+				continue;
+			}
+			stripVertices++;
+
+			if(m_Topology == PRIMITIVETOPOLOGY_TRIANGLE_STRIP && stripVertices >= 3)
+			{
+				// every other triangle swaps its first two vertices to keep the winding of the first
+				bool odd = stripVertices % 2 == 0;
+				m_TriangleIndices.push_back(base + indices[odd ? i - 1 : i - 2]);
+				m_TriangleIndices.push_back(base + indices[odd ? i - 2 : i - 1]);
+				m_TriangleIndices.push_back(base + indices[i]);
+			}
+			else if((m_Topology == PRIMITIVETOPOLOGY_LINE_LIST && stripVertices % 2 == 0) ||
+				(m_Topology == PRIMITIVETOPOLOGY_LINE_STRIP && stripVertices >= 2))
+			{
+				unsigned int v0 = base + indices[i - 1], v1 = base + indices[i];
+				const float *p0 = &m_ShadedVertices[static_cast<size_t>(v0) * stride];
+				const float *p1 = &m_ShadedVertices[static_cast<size_t>(v1) * stride];
+
+				// lines crossing the eye plane are dropped rather than clipped
+				if(p0[3] <= 0.0f || p1[3] <= 0.0f)
+					continue;
+
+				// a quad reaching half a pixel to either side of the line along its minor axis, as
+				// OpenGL widens lines, so that it covers one pixel per column or row
+				float dx = (p1[0] / p1[3] - p0[0] / p0[3]) / pixelWidth, dy = (p1[1] / p1[3] - p0[1] / p0[3]) / pixelHeight;
+				if(dx == 0.0f && dy == 0.0f)
+					continue;
+				bool xMajor = std::fabs(dx) >= std::fabs(dy);
+				float nx = xMajor ? 0.0f : 0.5f * pixelWidth, ny = xMajor ? 0.5f * pixelHeight : 0.0f;
+
+				const unsigned int corners[4] = { v0, v0, v1, v1 };
+				const float offsets[4][2] = { { nx, ny }, { -nx, -ny }, { -nx, -ny }, { nx, ny } };
+				AddQuad(corners, offsets);
+			}
+			else if(m_Topology == PRIMITIVETOPOLOGY_POINT_LIST)
+			{
+				unsigned int v = base + indices[i];
+				if(m_ShadedVertices[static_cast<size_t>(v) * stride + 3] <= 0.0f)
+					continue;
+
+				// a pixel-sized square centered on the point
+				float hx = 0.5f * pixelWidth, hy = 0.5f * pixelHeight;
+				const unsigned int corners[4] = { v, v, v, v };
+				const float offsets[4][2] = { { -hx, -hy }, { hx, -hy }, { hx, hy }, { -hx, hy } };
+				AddQuad(corners, offsets);
+			}
+		}
+	}
+	return static_cast<unsigned int>(m_TriangleIndices.size() / 3);
+}
+
+void SoftwareRenderDevice::AddQuad(const unsigned int corners[4], const float offsets[4][2])
+{
+	const unsigned int stride = 4 + m_Pipeline->vertexDesc->numVaryings;
+	const size_t first = m_ShadedVertices.size();
+	const unsigned int firstVertex = static_cast<unsigned int>(first / stride);
+
+	m_ShadedVertices.resize(first + 4 * stride);
+	for(int i = 0; i < 4; i++)
+	{
+		float *vertex = &m_ShadedVertices[first + i * stride];
+		const float *source = &m_ShadedVertices[static_cast<size_t>(corners[i]) * stride];
+		std::copy(source, source + stride, vertex);
+
+		// offsets are scaled by w to stay the same size in window space after the divide
+		vertex[0] += offsets[i][0] * vertex[3];
+		vertex[1] += offsets[i][1] * vertex[3];
+	}
+
+	const unsigned int triangles[6] = { 0, 1, 2, 0, 2, 3 };
+	for(unsigned int corner : triangles)
+		m_TriangleIndices.push_back(firstVertex + corner);
+}
+
+void SoftwareRenderDevice::Rasterize(unsigned int numTriangles)
+{
+	if(!numTriangles)
+		return;
+
+	SoftwareDrawState state;
+	// lines and points have no facing to cull by
+	state.cullEnabled = m_RasterState->cullEnabled && m_Topology != PRIMITIVETOPOLOGY_LINE_LIST && m_Topology != PRIMITIVETOPOLOGY_LINE_STRIP &&
+		m_Topology != PRIMITIVETOPOLOGY_POINT_LIST;
+	state.frontFaceCCW = m_RasterState->frontFace == WINDING_CCW;
+	state.cullFace = m_RasterState->cullFace;
+
+	state.depthEnabled = m_DepthStencilState->depthEnabled;
+	state.depthWriteEnabled = m_DepthStencilState->depthWriteEnabled;
+	state.depthNear = m_DepthStencilState->depthNear;
+	state.depthFar = m_DepthStencilState->depthFar;
+	state.depthCompare = m_DepthStencilState->depthCompare;
+
+	state.stencilEnabled = m_DepthStencilState->frontFaceStencilEnabled || m_DepthStencilState->backFaceStencilEnabled;
+	state.stencilFront = m_DepthStencilState->front;
+	state.stencilBack = m_DepthStencilState->back;
+
+	state.pixelShader = m_Pipeline->pixelDesc->main;
+	state.uniforms = m_Pipeline->pixelUniforms.empty() ? nullptr : &m_Pipeline->pixelUniforms[0];
+	state.sampler = m_Sampler;
+	state.numVaryings = m_Pipeline->vertexDesc->numVaryings;
+
+	m_Rasterizer.DrawTriangles(state, &m_ShadedVertices[0], 4 + state.numVaryings, &m_TriangleIndices[0], numTriangles);
+}
+
+void SoftwareRenderDevice::DrawTriangles(int offset, int count)
+{
+	DrawTrianglesInstanced(offset, count, 1);
+}
+
+void SoftwareRenderDevice::DrawTrianglesInstanced(int offset, int count, int instanceCount)
+{
+	if(!m_Pipeline || !m_Pipeline->IsValid() || !m_VertexArray || offset < 0 || count < GetMinVertices(m_Topology) || instanceCount <= 0)
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	ApplyUniformBlocks();
+	ShadeVertices(offset, count, instanceCount);
+
+	if(m_Topology == PRIMITIVETOPOLOGY_TRIANGLE_LIST)
+	{
+		unsigned int numTriangles = count / 3;
+		m_TriangleIndices.resize(static_cast<size_t>(numTriangles) * 3 * instanceCount);
+		for(unsigned int i = 0; i < numTriangles * 3; i++)
+			m_TriangleIndices[i] = i;
+		RepeatTriangleIndices(numTriangles * 3, count, instanceCount);
+
+		Rasterize(numTriangles * instanceCount);
+	}
+	else
+	{
+		m_PrimitiveIndices.resize(count);
+		for(int i = 0; i < count; i++)
+			m_PrimitiveIndices[i] = i;
+		Rasterize(AssemblePrimitives(count, count, instanceCount));
+	}
+
+	m_DrawCalls++;
+	m_DrawTime += std::chrono::steady_clock::now() - start;
+}
+
+void SoftwareRenderDevice::DrawTrianglesIndexed32(long long offset, int count, int baseVertex)
+{
+	DrawIndexed<uint32_t>(offset, count, 1, baseVertex);
+}
+
+void SoftwareRenderDevice::DrawTrianglesIndexed16(long long offset, int count, int baseVertex)
+{
+	DrawIndexed<uint16_t>(offset, count, 1, baseVertex);
+}
+
+void SoftwareRenderDevice::DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	DrawIndexed<uint32_t>(offset, count, instanceCount, baseVertex);
+}
+
+void SoftwareRenderDevice::DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	DrawIndexed<uint16_t>(offset, count, instanceCount, baseVertex);
+}
+
+void SoftwareRenderDevice::DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts)
+{
+	// draws are cheap to issue here, so they are made one by one
+	for(int i = 0; i < drawCount; i++)
+		DrawTrianglesInstanced(offsets[i], counts[i], 1);
+}
+
+void SoftwareRenderDevice::DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices, IndexFormat format)
+{
+	for(int i = 0; i < drawCount; i++)
+	{
+		if(format == INDEXFORMAT_16)
+			DrawIndexed<uint16_t>(offsets[i], counts[i], 1, baseVertices ? baseVertices[i] : 0);
+		else
+			DrawIndexed<uint32_t>(offsets[i], counts[i], 1, baseVertices ? baseVertices[i] : 0);
+	}
+}
+
+void SoftwareRenderDevice::DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount, IndexFormat format)
+{
+	if(drawCount <= 0)
+		return;
+	if(offset % 4)
+	{
+		std::cout << "ERROR::INDIRECTBUFFER::INVALID_RANGE\n" << offset << ", " << drawCount << " draws" << std::endl;
+		return;
+	}
+	const char *range = GetBufferRange("INDIRECTBUFFER", indirectBuffer ? &static_cast<SoftwareIndirectBuffer *>(indirectBuffer)->storage : nullptr,
+		offset, drawCount * static_cast<long long>(sizeof(DrawIndexedIndirectCommand)));
+	if(!range)
+		return;
+
+	// the arguments are in memory like any buffer's, so they are read as the draw is made
+	for(int i = 0; i < drawCount; i++)
+	{
+		DrawIndexedIndirectCommand command;
+		memcpy(&command, range + i * sizeof(DrawIndexedIndirectCommand), sizeof(command));
+		if(!command.count || !command.instanceCount || command.count > INT_MAX || command.instanceCount > INT_MAX)
+			continue;
+		long long indexOffset = static_cast<long long>(command.firstIndex) * GetIndexSize(format);
+		if(format == INDEXFORMAT_16)
+			DrawIndexed<uint16_t>(indexOffset, static_cast<int>(command.count), static_cast<int>(command.instanceCount), command.baseVertex);
+		else
+			DrawIndexed<uint32_t>(indexOffset, static_cast<int>(command.count), static_cast<int>(command.instanceCount), command.baseVertex);
+	}
+}
+
+template<typename Index>
+void SoftwareRenderDevice::DrawIndexed(long long offset, int count, int instanceCount, int baseVertex)
+{
+	if(!m_Pipeline || !m_Pipeline->IsValid() || !m_VertexArray || !m_IndexBuffer || count < GetMinVertices(m_Topology) || instanceCount <= 0)
+		return;
+	if(m_IndexBuffer->format != (sizeof(Index) == 2 ? INDEXFORMAT_16 : INDEXFORMAT_32))
+	{
+		std::cout << "ERROR::INDEXBUFFER::FORMAT_MISMATCH\n" << sizeof(Index) * 8 << "-bit draw from a "
+			<< GetIndexSize(m_IndexBuffer->format) * 8 << "-bit index buffer" << std::endl;
+		return;
+	}
+	if(offset < 0 || offset % sizeof(Index) || offset + count * static_cast<long long>(sizeof(Index)) > static_cast<long long>(m_IndexBuffer->storage.size()))
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	ApplyUniformBlocks();
+
+	const bool list = m_Topology == PRIMITIVETOPOLOGY_TRIANGLE_LIST;
+	const unsigned int numIndices = list ? count / 3 * 3 : count;
+	const Index *indices = reinterpret_cast<const Index *>(&m_IndexBuffer->storage[static_cast<size_t>(offset)]);
+
+	// strips restart at the largest index of the format, which references no vertex
+	const bool restart = m_Topology == PRIMITIVETOPOLOGY_TRIANGLE_STRIP || m_Topology == PRIMITIVETOPOLOGY_LINE_STRIP;
+	const Index restartIndex = static_cast<Index>(PRIMITIVE_RESTART_INDEX32);
+
+	// shade only the range of vertices the indices reference
+	uint32_t minIndex = ~0u, maxIndex = 0;
+	for(unsigned int i = 0; i < numIndices; i++)
+	{
+		if(restart && indices[i] == restartIndex)
+			continue;
+		minIndex = std::min<uint32_t>(minIndex, indices[i]);
+		maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+	}
+	if(minIndex > maxIndex)
+		return;
+	long long firstVertex = static_cast<long long>(minIndex) + baseVertex;
+	if(firstVertex < 0)
+		return;
+	unsigned int vertexCount = maxIndex - minIndex + 1;
+	ShadeVertices(static_cast<unsigned int>(firstVertex), vertexCount, instanceCount);
+
+	if(list)
+	{
+		m_TriangleIndices.resize(static_cast<size_t>(numIndices) * instanceCount);
+		for(unsigned int i = 0; i < numIndices; i++)
+			m_TriangleIndices[i] = indices[i] - minIndex;
+		RepeatTriangleIndices(numIndices, vertexCount, instanceCount);
+
+		Rasterize(numIndices / 3 * instanceCount);
+	}
+	else
+	{
+		m_PrimitiveIndices.resize(numIndices);
+		for(unsigned int i = 0; i < numIndices; i++)
+			m_PrimitiveIndices[i] = restart && indices[i] == restartIndex ? PRIMITIVE_RESTART_INDEX32 : indices[i] - minIndex;
+		Rasterize(AssemblePrimitives(numIndices, vertexCount, instanceCount));
+	}
+
+	m_DrawCalls++;
+	m_DrawTime += std::chrono::steady_clock::now() - start;
+}
+
+void SoftwareRenderDevice::SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists)
+{
+	for(unsigned int i = 0; i < numCommandLists; i++)
+		ExecuteCommandList(*commandLists[i], *this);
+}
+
+void SoftwareRenderDevice::EndFrame()
+{
+	if(!m_GpuScopeStack.empty())
+	{
+		std::cout << "ERROR::GPUSCOPE::NOT_ENDED\n" << m_GpuScopeStack.size() << " scopes were still open at the end of the frame" << std::endl;
+		while(!m_GpuScopeStack.empty())
+			EndGpuScope();
+	}
+
+	m_GpuScopes.ResolveFrame();
+	m_Frames++;
+
+	// bindings of this frame's uniform data do not outlive it
+	for(UniformBinding &binding : m_UniformBindings)
+		if(!binding.buffer)
+			binding = UniformBinding{ nullptr, 0, 0 };
+	m_UniformData.clear();
+
+	m_TransientVertexSize = 0;
+	m_TransientIndexSize = 0;
+}
+
+void SoftwareRenderDevice::BeginGpuScope(const char *name)
+{
+	GpuScope scope;
+	scope.index = m_GpuScopes.Find(name, static_cast<unsigned int>(m_GpuScopeStack.size()));
+	scope.start = std::chrono::steady_clock::now();
+	m_GpuScopeStack.push_back(scope);
+}
+
+void SoftwareRenderDevice::EndGpuScope()
+{
+	if(m_GpuScopeStack.empty())
+	{
+		std::cout << "ERROR::GPUSCOPE::END_WITHOUT_BEGIN" << std::endl;
+		return;
+	}
+
+	const GpuScope &scope = m_GpuScopeStack.back();
+	m_GpuScopes.Accumulate(scope.index, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scope.start).count());
+	m_GpuScopeStack.pop_back();
+}
+
+unsigned int SoftwareRenderDevice::GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats)
+{
+	return m_GpuScopes.GetStats(maxScopes, stats);
+}
+
+void SoftwareRenderDevice::ResetGpuScopeStats()
+{
+	m_GpuScopeStack.clear();
+	m_GpuScopes.Reset();
+}
+
+} // end namespace render
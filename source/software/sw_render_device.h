@@ -0,0 +1,312 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include "sw_rasterizer.h"
+#include "thread_pool.h"
+#include "gpu_scope_table.h"
+
+#include <chrono>
+#include <vector>
+
+namespace render
+{
+
+class SoftwarePipeline;
+class SoftwareVertexBuffer;
+class SoftwareVertexArray;
+class SoftwareIndexBuffer;
+class SoftwareTexture2D;
+class SoftwareTexture2DArray;
+class SoftwareUniformBuffer;
+class SoftwareRasterState;
+class SoftwareDepthStencilState;
+class SoftwareTextureSampler;
+class SoftwareSamplerState;
+
+// A RenderDevice that renders on the CPU with a multithreaded, tile-binning SIMD
+// rasterizer. Shaders are C++ functions registered with RegisterSoftwareVertexShader
+// and RegisterSoftwarePixelShader in place of GLSL. Triangles are always filled,
+// whatever the raster mode. Lines and points are drawn one pixel wide, as quads of two
+// triangles that are never culled; a line with an end at w <= 0, behind the eye, is
+// dropped rather than clipped, as is such a point. Textures are sampled from their top
+// level only, with the magnification filter and wrap modes of the slot's SamplerState.
+class SoftwareRenderDevice final : public RenderDevice
+{
+public:
+
+	// width and height give the size of the color, depth, and stencil buffers, which should
+	// be that of the window presented to; numThreads of zero uses one thread per hardware thread
+	SoftwareRenderDevice(int width, int height, unsigned int numThreads = 0);
+
+	~SoftwareRenderDevice() override;
+
+	VertexShader *CreateVertexShader(const char *code) override;
+
+	void DestroyVertexShader(VertexShader *vertexShader) override;
+
+	PixelShader *CreatePixelShader(const char *code) override;
+
+	void DestroyPixelShader(PixelShader *pixelShader) override;
+
+	Pipeline *CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader) override;
+
+	void DestroyPipeline(Pipeline *pipeline) override;
+
+	void SetPipeline(Pipeline *pipeline) override;
+
+	VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	void CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	VertexDescription *CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements) override;
+
+	void DestroyVertexDescription(VertexDescription *vertexDescription) override;
+
+	VertexArray *CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions) override;
+
+	void DestroyVertexArray(VertexArray *vertexArray) override;
+
+	void SetVertexArray(VertexArray *vertexArray) override;
+
+	IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC, IndexFormat format = INDEXFORMAT_32) override;
+
+	void UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void SetIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+
+	IndirectBuffer *CreateIndirectBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data) override;
+
+	void CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndirectBuffer(IndirectBuffer *indirectBuffer) override;
+
+	Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	bool IsTextureFormatSupported(TextureFormat format) override;
+
+	void UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async = false) override;
+
+	void DestroyTexture2D(Texture2D *texture2D) override;
+
+	void SetTexture2D(unsigned int slot, Texture2D *texture2D) override;
+
+	Texture2DArray *CreateTexture2DArray(int width, int height, int layers, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	void UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async = false) override;
+
+	void UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+		bool async = false) override;
+
+	void DestroyTexture2DArray(Texture2DArray *texture2DArray) override;
+
+	void SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray) override;
+
+	SamplerState *CreateSamplerState(TextureFilter minFilter = TEXTUREFILTER_LINEAR, TextureFilter magFilter = TEXTUREFILTER_LINEAR,
+		MipFilter mipFilter = MIPFILTER_LINEAR, TextureWrap wrapS = TEXTUREWRAP_CLAMP_TO_EDGE, TextureWrap wrapT = TEXTUREWRAP_CLAMP_TO_EDGE) override;
+
+	void DestroySamplerState(SamplerState *samplerState) override;
+
+	void SetSamplerState(unsigned int slot, SamplerState *samplerState) override;
+
+	UniformBuffer *CreateUniformBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void DestroyUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer) override;
+
+	long long WriteUniformData(const void *data, long long size) override;
+
+	void SetUniformData(unsigned int slot, long long offset, long long size) override;
+
+	TransientVertices WriteTransientVertices(const void *data, int count, int stride) override;
+
+	TransientIndices WriteTransientIndices(const unsigned int *indices, int count, int baseVertex = 0) override;
+
+	RasterState *CreateRasterState(bool cullEnabled = true, Winding frontFace = WINDING_CCW, Face cullFace = FACE_BACK, RasterMode rasterMode = RASTERMODE_FILL) override;
+
+	void DestroyRasterState(RasterState *rasterState) override;
+
+	void SetRasterState(RasterState *rasterState) override;
+
+	DepthStencilState *CreateDepthStencilState(bool depthEnabled = true,
+		bool			depthWriteEnabled = true,
+		float			depthNear = 0,
+		float			depthFar = 1,
+		Compare			depthCompare = COMPARE_LESS,
+
+		bool			frontFaceStencilEnabled = false,
+		Compare			frontFaceStencilCompare = COMPARE_ALWAYS,
+		StencilAction	frontFaceStencilFail = STENCIL_KEEP,
+		StencilAction	frontFaceStencilPass = STENCIL_KEEP,
+		StencilAction	frontFaceDepthFail = STENCIL_KEEP,
+		int				frontFaceRef = 0,
+		unsigned int	frontFaceReadMask = 0xFFFFFFFF,
+		unsigned int	frontFaceWriteMask = 0xFFFFFFFF,
+
+		bool			backFaceStencilEnabled = false,
+		Compare			backFaceStencilCompare = COMPARE_ALWAYS,
+		StencilAction	backFaceStencilFail = STENCIL_KEEP,
+		StencilAction	backFaceStencilPass = STENCIL_KEEP,
+		StencilAction	backFaceDepthFail = STENCIL_KEEP,
+		int				backFaceRef = 0,
+		unsigned int	backFaceReadMask = 0xFFFFFFFF,
+		unsigned int	backFaceWriteMask = 0xFFFFFFFF) override;
+
+	void DestroyDepthStencilState(DepthStencilState *depthStencilState) override;
+
+	void SetDepthStencilState(DepthStencilState *depthStencilState) override;
+
+	void Clear(float red = 0.0f, float green = 0.0f, float blue = 0.0f, float alpha = 1.0f, float depth = 1.0f, int stencil = 0) override;
+
+	void DrawTriangles(int offset, int count) override;
+
+	void DrawTrianglesIndexed32(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesInstanced(int offset, int count, int instanceCount) override;
+
+	void DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts) override;
+
+	void DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices = nullptr,
+		IndexFormat format = INDEXFORMAT_32) override;
+
+	void DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount = 1, IndexFormat format = INDEXFORMAT_32) override;
+
+	void SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists) override;
+
+	void EndFrame() override;
+
+	// Draws complete before returning, so GPU scopes are timed on the CPU
+	void BeginGpuScope(const char *name) override;
+
+	void EndGpuScope() override;
+
+	unsigned int GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats) override;
+
+	void ResetGpuScopeStats() override;
+
+	// Rasterizer holding the rendered color buffer
+	const SoftwareRasterizer &GetRasterizer() const { return m_Rasterizer; }
+
+	// Write the color buffer to a binary PPM image; returns false if the file could not be written
+	bool SaveColorBuffer(const char *path) const;
+
+private:
+
+	// Shade the vertices in [first, first + count) of each of instanceCount instances into
+	// m_ShadedVertices, one instance after another
+	void ShadeVertices(unsigned int first, unsigned int count, unsigned int instanceCount);
+
+	// Repeat the first numIndices of m_TriangleIndices for each of instanceCount instances, offset
+	// by the vertices shaded per instance
+	void RepeatTriangleIndices(unsigned int numIndices, unsigned int vertexCount, unsigned int instanceCount);
+
+	// Form the primitives of the bound strip, line or point topology from the first numIndices
+	// of m_PrimitiveIndices, repeated for each of instanceCount instances, into triangles in
+	// m_TriangleIndices; returns the number of triangles
+	unsigned int AssemblePrimitives(unsigned int numIndices, unsigned int vertexCount, unsigned int instanceCount);
+
+	// Add a triangle pair covering the quad of shaded vertices corners, each moved by its
+	// offsets in normalized device coordinates, as lines and points are rasterized
+	void AddQuad(const unsigned int corners[4], const float offsets[4][2]);
+
+	// Copy the bound uniform buffers into the blocks of the pipeline that read them
+	void ApplyUniformBlocks();
+
+	// Gather the current state and rasterize the triangles in m_TriangleIndices
+	void Rasterize(unsigned int numTriangles);
+
+	// Draw instanceCount instances of the triangles of count indices of type Index at offset bytes into
+	// the bound index buffer
+	template<typename Index>
+	void DrawIndexed(long long offset, int count, int instanceCount, int baseVertex);
+
+	ThreadPool m_ThreadPool;
+	SoftwareRasterizer m_Rasterizer;
+
+	SoftwarePipeline *m_Pipeline = nullptr;
+	SoftwareVertexArray *m_VertexArray = nullptr;
+	SoftwareIndexBuffer *m_IndexBuffer = nullptr;
+	SoftwareTextureSampler *m_Sampler = nullptr;
+
+	// what is bound to each uniform buffer slot; a null buffer with a size is a range of m_UniformData
+	struct UniformBinding
+	{
+		const SoftwareUniformBuffer *buffer;
+		long long offset;
+		long long size;
+	};
+
+	std::vector<UniformBinding> m_UniformBindings;
+	std::vector<char> m_UniformData; // written with WriteUniformData this frame
+
+	// handed out by WriteTransientVertices and WriteTransientIndices, created on first use
+	SoftwareVertexBuffer *m_TransientVertexBuffer = nullptr;
+	SoftwareIndexBuffer *m_TransientIndexBuffer = nullptr;
+	long long m_TransientVertexSize = 0; // written this frame, aligned
+	long long m_TransientIndexSize = 0;
+
+	SoftwareRasterState *m_RasterState = nullptr;
+	SoftwareRasterState *m_DefaultRasterState = nullptr;
+
+	SoftwareDepthStencilState *m_DepthStencilState = nullptr;
+	SoftwareDepthStencilState *m_DefaultDepthStencilState = nullptr;
+
+	PrimitiveTopology m_Topology = PRIMITIVETOPOLOGY_TRIANGLE_LIST;
+
+	// per-draw scratch space, kept to avoid reallocating every draw
+	std::vector<float> m_ShadedVertices;
+	std::vector<unsigned int> m_PrimitiveIndices; // of topologies other than triangle lists, with restarts
+	std::vector<unsigned int> m_TriangleIndices;
+
+	// open GPU scopes and the time each began
+	struct GpuScope
+	{
+		unsigned int index;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	GpuScopeTable m_GpuScopes;
+	std::vector<GpuScope> m_GpuScopeStack;
+
+	// throughput counters
+	unsigned long long m_DrawCalls = 0;
+	unsigned long long m_Frames = 0;
+	std::chrono::steady_clock::duration m_DrawTime = std::chrono::steady_clock::duration::zero();
+};
+
+} // end namespace render
@@ -0,0 +1,259 @@
+#include "render_device/texture_atlas.h"
+
+#include "mip_generator.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace render
+{
+
+TextureAtlas::TextureAtlas(RenderDevice *renderDevice, int pageSize, int mipLevels, int padding) :
+	m_RenderDevice(renderDevice), m_PageSize(pageSize), m_MipLevels(mipLevels), m_Padding(padding), m_ThreadPool(new ThreadPool(1))
+{
+	if(pageSize <= 0 || mipLevels < 1 || mipLevels > GetTextureMipLevels(pageSize, pageSize) || padding < 0)
+	{
+		std::cout << "ERROR::TEXTUREATLAS::INVALID_SIZE\n" << pageSize << ", " << mipLevels << " levels, " << padding << " padding" << std::endl;
+		m_PageSize = 0;
+		m_MipLevels = 1;
+	}
+
+	// a page holds whole cells, so its size is rounded down to the alignment
+	m_Alignment = 1 << (m_MipLevels - 1);
+	m_PageSize -= m_PageSize % m_Alignment;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	for(Page &page : m_Pages)
+		m_RenderDevice->DestroyTexture2D(page.texture);
+}
+
+AtlasHandle TextureAtlas::Insert(int width, int height, const void *data)
+{
+	int cellWidth = (width + 2 * m_Padding + m_Alignment - 1) / m_Alignment * m_Alignment;
+	int cellHeight = (height + 2 * m_Padding + m_Alignment - 1) / m_Alignment * m_Alignment;
+	if(!data || width <= 0 || height <= 0 || cellWidth > m_PageSize || cellHeight > m_PageSize)
+	{
+		std::cout << "ERROR::TEXTUREATLAS::INVALID_IMAGE\n" << width << "x" << height << std::endl;
+		return 0;
+	}
+
+	// the free rectangle the cell fills best, on any page; ties go to the shorter leftover side
+	size_t bestPage = m_Pages.size(), bestRect = 0;
+	long long bestArea = 0;
+	int bestSide = 0;
+	for(size_t i = 0; i < m_Pages.size(); i++)
+	{
+		const std::vector<Rect> &freeRects = m_Pages[i].freeRects;
+		for(size_t j = 0; j < freeRects.size(); j++)
+		{
+			const Rect &rect = freeRects[j];
+			if(cellWidth > rect.width || cellHeight > rect.height)
+				continue;
+			long long area = static_cast<long long>(rect.width) * rect.height - static_cast<long long>(cellWidth) * cellHeight;
+			int side = std::min(rect.width - cellWidth, rect.height - cellHeight);
+			if(bestPage == m_Pages.size() || area < bestArea || (area == bestArea && side < bestSide))
+			{
+				bestPage = i;
+				bestRect = j;
+				bestArea = area;
+				bestSide = side;
+			}
+		}
+	}
+
+	if(bestPage == m_Pages.size())
+	{
+		// the levels are all supplied by the atlas, so none are generated here
+		Texture2D *texture = m_RenderDevice->CreateTexture2D(m_PageSize, m_PageSize, nullptr, TEXTUREFORMAT_RGBA8, m_MipLevels, MIPPOLICY_NONE);
+		if(!texture)
+			return 0;
+
+		Page page;
+		page.texture = texture;
+		page.freeRects.push_back(Rect{0, 0, m_PageSize, m_PageSize});
+		page.entries = 0;
+		page.usedTexels = 0;
+		m_Pages.push_back(page);
+		bestRect = 0;
+	}
+
+	Page &page = m_Pages[bestPage];
+	Rect cell = {page.freeRects[bestRect].x, page.freeRects[bestRect].y, cellWidth, cellHeight};
+	SplitFreeRect(page, bestRect, cellWidth, cellHeight);
+	page.entries++;
+	page.usedTexels += static_cast<long long>(cellWidth) * cellHeight;
+
+	Upload(page, cell, width, height, static_cast<const uint32_t *>(data));
+
+	AtlasHandle handle;
+	if(!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else
+	{
+		m_Slots.push_back(Slot());
+		handle = static_cast<AtlasHandle>(m_Slots.size());
+	}
+
+	Slot &slot = m_Slots[handle - 1];
+	slot.cell = cell;
+	slot.used = true;
+	AtlasEntry &entry = slot.entry;
+	entry.page = static_cast<unsigned int>(bestPage);
+	entry.x = cell.x + m_Padding;
+	entry.y = cell.y + m_Padding;
+	entry.width = width;
+	entry.height = height;
+	entry.u0 = static_cast<float>(entry.x) / m_PageSize;
+	entry.v0 = static_cast<float>(entry.y) / m_PageSize;
+	entry.u1 = static_cast<float>(entry.x + width) / m_PageSize;
+	entry.v1 = static_cast<float>(entry.y + height) / m_PageSize;
+	return handle;
+}
+
+void TextureAtlas::Remove(AtlasHandle handle)
+{
+	if(handle == 0 || handle > m_Slots.size() || !m_Slots[handle - 1].used)
+	{
+		std::cout << "ERROR::TEXTUREATLAS::INVALID_HANDLE\n" << handle << std::endl;
+		return;
+	}
+
+	Slot &slot = m_Slots[handle - 1];
+	slot.used = false;
+	m_FreeHandles.push_back(handle);
+
+	Page &page = m_Pages[slot.entry.page];
+	page.usedTexels -= static_cast<long long>(slot.cell.width) * slot.cell.height;
+	if(--page.entries == 0)
+	{
+		// an empty page starts over as a single free rectangle, however fragmented it became
+		page.freeRects.clear();
+		page.freeRects.push_back(Rect{0, 0, m_PageSize, m_PageSize});
+		return;
+	}
+	FreeRect(page, slot.cell);
+}
+
+const AtlasEntry *TextureAtlas::GetEntry(AtlasHandle handle) const
+{
+	if(handle == 0 || handle > m_Slots.size() || !m_Slots[handle - 1].used)
+		return nullptr;
+	return &m_Slots[handle - 1].entry;
+}
+
+float TextureAtlas::GetPageOccupancy(unsigned int page) const
+{
+	if(page >= m_Pages.size())
+		return 0.0f;
+	return static_cast<float>(static_cast<double>(m_Pages[page].usedTexels) / (static_cast<double>(m_PageSize) * m_PageSize));
+}
+
+TextureAtlasStats TextureAtlas::GetStats() const
+{
+	TextureAtlasStats stats;
+	stats.pages = static_cast<unsigned int>(m_Pages.size());
+	for(const Slot &slot : m_Slots)
+	{
+		if(!slot.used)
+			continue;
+		stats.entries++;
+		stats.imageTexels += static_cast<long long>(slot.entry.width) * slot.entry.height;
+	}
+	for(const Page &page : m_Pages)
+		stats.usedTexels += page.usedTexels;
+	stats.pageTexels = static_cast<long long>(m_PageSize) * m_PageSize * m_Pages.size();
+	if(stats.pageTexels > 0)
+		stats.occupancy = static_cast<float>(static_cast<double>(stats.usedTexels) / stats.pageTexels);
+	return stats;
+}
+
+void TextureAtlas::SplitFreeRect(Page &page, size_t index, int width, int height)
+{
+	Rect rect = page.freeRects[index];
+	page.freeRects[index] = page.freeRects.back();
+	page.freeRects.pop_back();
+
+	// split along the shorter leftover side, which keeps the larger of the two rectangles as large as possible
+	Rect right, bottom;
+	if(rect.width - width < rect.height - height)
+	{
+		right = Rect{rect.x + width, rect.y, rect.width - width, height};
+		bottom = Rect{rect.x, rect.y + height, rect.width, rect.height - height};
+	}
+	else
+	{
+		right = Rect{rect.x + width, rect.y, rect.width - width, rect.height};
+		bottom = Rect{rect.x, rect.y + height, width, rect.height - height};
+	}
+	if(right.width > 0 && right.height > 0)
+		page.freeRects.push_back(right);
+	if(bottom.width > 0 && bottom.height > 0)
+		page.freeRects.push_back(bottom);
+}
+
+void TextureAtlas::FreeRect(Page &page, const Rect &cell)
+{
+	// merge rectangles that share a whole edge until none do
+	Rect merged = cell;
+	bool merging = true;
+	while(merging)
+	{
+		merging = false;
+		for(size_t i = 0; i < page.freeRects.size(); i++)
+		{
+			const Rect &rect = page.freeRects[i];
+			bool column = rect.x == merged.x && rect.width == merged.width && (rect.y + rect.height == merged.y || merged.y + merged.height == rect.y);
+			bool row = rect.y == merged.y && rect.height == merged.height && (rect.x + rect.width == merged.x || merged.x + merged.width == rect.x);
+			if(!column && !row)
+				continue;
+
+			if(column)
+			{
+				merged.y = std::min(merged.y, rect.y);
+				merged.height += rect.height;
+			}
+			else
+			{
+				merged.x = std::min(merged.x, rect.x);
+				merged.width += rect.width;
+			}
+			page.freeRects[i] = page.freeRects.back();
+			page.freeRects.pop_back();
+			merging = true;
+			break;
+		}
+	}
+	page.freeRects.push_back(merged);
+}
+
+void TextureAtlas::Upload(const Page &page, const Rect &cell, int width, int height, const uint32_t *data)
+{
+	// the image is centred on its padding, whose texels repeat the nearest edge texel of the image
+	m_Cell.resize(static_cast<size_t>(GetTextureSize(TEXTUREFORMAT_RGBA8, cell.width, cell.height, m_MipLevels) / 4));
+	for(int y = 0; y < cell.height; y++)
+	{
+		int sourceY = std::min(std::max(y - m_Padding, 0), height - 1);
+		const uint32_t *source = data + static_cast<size_t>(sourceY) * width;
+		uint32_t *destination = &m_Cell[static_cast<size_t>(y) * cell.width];
+		for(int x = 0; x < cell.width; x++)
+			destination[x] = source[std::min(std::max(x - m_Padding, 0), width - 1)];
+	}
+	GenerateMipChain(*m_ThreadPool, cell.width, cell.height, m_MipLevels, &m_Cell[0]);
+
+	// cells are aligned to the smallest level, so each level of the cell is exactly a region of the same level of the page
+	const uint32_t *level = &m_Cell[0];
+	for(int i = 0; i < m_MipLevels; i++)
+	{
+		int levelWidth = cell.width >> i, levelHeight = cell.height >> i;
+		m_RenderDevice->UpdateTexture2D(page.texture, i, cell.x >> i, cell.y >> i, levelWidth, levelHeight, level, true);
+		level += static_cast<size_t>(levelWidth) * levelHeight;
+	}
+}
+
+} // end namespace render
@@ -0,0 +1,101 @@
+#include "thread_pool.h"
+
+namespace render
+{
+
+ThreadPool::ThreadPool(unsigned int numThreads) : m_NextIndex(0)
+{
+	if(numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	for(unsigned int i = 1; i < numThreads; i++)
+		m_Workers.push_back(std::thread(&ThreadPool::WorkerMain, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_WorkAvailable.notify_all();
+	for(std::thread &worker : m_Workers)
+		worker.join();
+}
+
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)> &job)
+{
+	if(count == 0)
+		return;
+
+	// not worth waking the workers for a single job
+	if(count == 1 || m_Workers.empty())
+	{
+		for(unsigned int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	{
+		// workers that woke up late for the previous batch must leave before the counters are reset
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, [this]() { return m_Active == 0; });
+		m_Job = &job;
+		m_Count = count;
+		m_NextIndex = 0;
+		m_Finished = 0;
+		m_Generation++;
+	}
+	m_WorkAvailable.notify_all();
+
+	unsigned int finished = RunJobs(&job, count);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Finished += finished;
+	m_WorkDone.wait(lock, [this]() { return m_Finished == m_Count && m_Active == 0; });
+	m_Job = nullptr;
+}
+
+unsigned int ThreadPool::RunJobs(const std::function<void(unsigned int)> *job, unsigned int count)
+{
+	unsigned int finished = 0;
+	for(;;)
+	{
+		unsigned int index = m_NextIndex++;
+		if(index >= count)
+			break;
+		(*job)(index);
+		finished++;
+	}
+	return finished;
+}
+
+void ThreadPool::WorkerMain()
+{
+	unsigned long long generation = 0;
+	for(;;)
+	{
+		const std::function<void(unsigned int)> *job;
+		unsigned int count;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [&]() { return m_Quit || m_Generation != generation; });
+			if(m_Quit)
+				return;
+			generation = m_Generation;
+			job = m_Job;
+			count = m_Count;
+			m_Active++;
+		}
+
+		unsigned int finished = job ? RunJobs(job, count) : 0;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Finished += finished;
+			m_Active--;
+		}
+		m_WorkDone.notify_all();
+	}
+}
+
+} // end namespace render
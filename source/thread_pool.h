@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace render
+{
+
+// A fixed set of worker threads for running data-parallel jobs
+class ThreadPool
+{
+public:
+
+	// numThreads is the total number of threads that run jobs, including the calling
+	// thread; zero uses one thread per hardware thread
+	explicit ThreadPool(unsigned int numThreads = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	// Total number of threads that run jobs, including the calling thread
+	unsigned int GetNumThreads() const { return static_cast<unsigned int>(m_Workers.size()) + 1; }
+
+	// Run job(index) for every index in [0, count) on the workers and the calling thread,
+	// returning once every job has finished. Must not be called from inside a job.
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int)> &job);
+
+private:
+
+	void WorkerMain();
+
+	// Run jobs from the current batch until none are left; returns the number run
+	unsigned int RunJobs(const std::function<void(unsigned int)> *job, unsigned int count);
+
+	std::vector<std::thread> m_Workers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+
+	const std::function<void(unsigned int)> *m_Job = nullptr;
+	unsigned int m_Count = 0;
+	std::atomic<unsigned int> m_NextIndex;
+	unsigned int m_Finished = 0;
+	unsigned int m_Active = 0; // workers inside RunJobs
+	unsigned long long m_Generation = 0;
+	bool m_Quit = false;
+};
+
+} // end namespace render
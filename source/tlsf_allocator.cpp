@@ -0,0 +1,264 @@
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace render
+{
+
+const uint32_t TlsfAllocator::INVALID_BLOCK;
+
+// Index of the lowest and of the highest set bit of a non-zero value
+static int FindLowestBit(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+static int FindHighestBit(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, value);
+	return static_cast<int>(index);
+#else
+	return 31 - __builtin_clz(value);
+#endif
+}
+
+TlsfAllocator::TlsfAllocator(uint32_t size) : m_Size(size)
+{
+	std::fill(m_SecondLevelBits, m_SecondLevelBits + FIRST_LEVEL_COUNT, 0u);
+	for(int i = 0; i < FIRST_LEVEL_COUNT; i++)
+		std::fill(m_FreeLists[i], m_FreeLists[i] + SECOND_LEVEL_COUNT, INVALID_BLOCK);
+
+	if(!size)
+		return;
+
+	// the whole space starts as one free range
+	m_FirstBlock = NewBlock();
+	m_Blocks[m_FirstBlock].offset = 0;
+	m_Blocks[m_FirstBlock].size = size;
+	InsertFree(m_FirstBlock);
+}
+
+void TlsfAllocator::Mapping(uint32_t size, int &firstLevel, int &secondLevel)
+{
+	// sizes below SECOND_LEVEL_COUNT each have a class of their own; larger ones are split
+	// into SECOND_LEVEL_COUNT classes between consecutive powers of two
+	if(size < SECOND_LEVEL_COUNT)
+	{
+		firstLevel = 0;
+		secondLevel = static_cast<int>(size);
+		return;
+	}
+	int log2 = FindHighestBit(size);
+	firstLevel = log2 - SECOND_LEVEL_LOG2 + 1;
+	secondLevel = static_cast<int>(size >> (log2 - SECOND_LEVEL_LOG2)) - SECOND_LEVEL_COUNT;
+}
+
+uint32_t TlsfAllocator::Allocate(uint32_t size)
+{
+	if(!size || size > m_Size - m_Used)
+		return INVALID_BLOCK;
+
+	// search from the class above the size unless it starts a class, so that any range found is large enough
+	uint32_t block = INVALID_BLOCK;
+	uint32_t searchSize = size;
+	uint32_t round = size >= SECOND_LEVEL_COUNT ? (1u << (FindHighestBit(size) - SECOND_LEVEL_LOG2)) - 1 : 0;
+	if(size <= ~0u - round)
+	{
+		searchSize += round;
+
+		int firstLevel, secondLevel;
+		Mapping(searchSize, firstLevel, secondLevel);
+
+		uint32_t secondLevelBits = m_SecondLevelBits[firstLevel] & (~0u << secondLevel);
+		if(!secondLevelBits)
+		{
+			uint32_t firstLevelBits = firstLevel + 1 < FIRST_LEVEL_COUNT ? m_FirstLevelBits & (~0u << (firstLevel + 1)) : 0;
+			if(firstLevelBits)
+			{
+				firstLevel = FindLowestBit(firstLevelBits);
+				secondLevelBits = m_SecondLevelBits[firstLevel];
+			}
+		}
+		if(secondLevelBits)
+			block = m_FreeLists[firstLevel][FindLowestBit(secondLevelBits)];
+	}
+
+	// ranges of the size's own class may still be large enough, such as the whole space of an
+	// allocator whose size is not a power of two, so they are searched one by one before failing
+	if(block == INVALID_BLOCK)
+	{
+		int firstLevel, secondLevel;
+		Mapping(size, firstLevel, secondLevel);
+		for(block = m_FreeLists[firstLevel][secondLevel]; block != INVALID_BLOCK; block = m_Blocks[block].nextFree)
+			if(m_Blocks[block].size >= size)
+				break;
+		if(block == INVALID_BLOCK)
+			return INVALID_BLOCK;
+	}
+
+	Split(block, size);
+	return block;
+}
+
+uint32_t TlsfAllocator::AllocateLowest(uint32_t size, uint32_t limit)
+{
+	if(!size)
+		return INVALID_BLOCK;
+
+	for(uint32_t block = m_FirstBlock; block != INVALID_BLOCK && m_Blocks[block].offset < limit; block = m_Blocks[block].nextPhysical)
+	{
+		const Block &range = m_Blocks[block];
+		if(range.free && range.size >= size && range.offset + size <= limit)
+		{
+			Split(block, size);
+			return block;
+		}
+	}
+	return INVALID_BLOCK;
+}
+
+void TlsfAllocator::Free(uint32_t block)
+{
+	m_Used -= m_Blocks[block].size;
+
+	// merge with free neighbours, whose blocks are recycled
+	uint32_t prev = m_Blocks[block].prevPhysical;
+	if(prev != INVALID_BLOCK && m_Blocks[prev].free)
+	{
+		RemoveFree(prev);
+		m_Blocks[prev].size += m_Blocks[block].size;
+		m_Blocks[prev].nextPhysical = m_Blocks[block].nextPhysical;
+		if(m_Blocks[prev].nextPhysical != INVALID_BLOCK)
+			m_Blocks[m_Blocks[prev].nextPhysical].prevPhysical = prev;
+		m_UnusedBlocks.push_back(block);
+		block = prev;
+	}
+
+	uint32_t next = m_Blocks[block].nextPhysical;
+	if(next != INVALID_BLOCK && m_Blocks[next].free)
+	{
+		RemoveFree(next);
+		m_Blocks[block].size += m_Blocks[next].size;
+		m_Blocks[block].nextPhysical = m_Blocks[next].nextPhysical;
+		if(m_Blocks[block].nextPhysical != INVALID_BLOCK)
+			m_Blocks[m_Blocks[block].nextPhysical].prevPhysical = block;
+		m_UnusedBlocks.push_back(next);
+	}
+
+	InsertFree(block);
+}
+
+uint32_t TlsfAllocator::GetLargestFree() const
+{
+	if(!m_FirstLevelBits)
+		return 0;
+
+	// ranges in the highest non-empty class are the largest, but vary in size within it
+	int firstLevel = FindHighestBit(m_FirstLevelBits);
+	int secondLevel = FindHighestBit(m_SecondLevelBits[firstLevel]);
+	uint32_t largest = 0;
+	for(uint32_t block = m_FreeLists[firstLevel][secondLevel]; block != INVALID_BLOCK; block = m_Blocks[block].nextFree)
+		largest = std::max(largest, m_Blocks[block].size);
+	return largest;
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+	uint32_t block;
+	if(!m_UnusedBlocks.empty())
+	{
+		block = m_UnusedBlocks.back();
+		m_UnusedBlocks.pop_back();
+	}
+	else
+	{
+		block = static_cast<uint32_t>(m_Blocks.size());
+		m_Blocks.push_back(Block());
+	}
+
+	Block &newBlock = m_Blocks[block];
+	newBlock.offset = 0;
+	newBlock.size = 0;
+	newBlock.prevPhysical = newBlock.nextPhysical = INVALID_BLOCK;
+	newBlock.prevFree = newBlock.nextFree = INVALID_BLOCK;
+	newBlock.free = false;
+	return block;
+}
+
+void TlsfAllocator::Split(uint32_t block, uint32_t size)
+{
+	RemoveFree(block);
+
+	if(m_Blocks[block].size > size)
+	{
+		uint32_t rest = NewBlock();
+		Block &allocated = m_Blocks[block];
+		Block &remainder = m_Blocks[rest];
+		remainder.offset = allocated.offset + size;
+		remainder.size = allocated.size - size;
+		remainder.prevPhysical = block;
+		remainder.nextPhysical = allocated.nextPhysical;
+		if(remainder.nextPhysical != INVALID_BLOCK)
+			m_Blocks[remainder.nextPhysical].prevPhysical = rest;
+		allocated.nextPhysical = rest;
+		allocated.size = size;
+		InsertFree(rest);
+	}
+
+	m_Used += size;
+}
+
+void TlsfAllocator::InsertFree(uint32_t block)
+{
+	int firstLevel, secondLevel;
+	Mapping(m_Blocks[block].size, firstLevel, secondLevel);
+
+	uint32_t &head = m_FreeLists[firstLevel][secondLevel];
+	m_Blocks[block].free = true;
+	m_Blocks[block].prevFree = INVALID_BLOCK;
+	m_Blocks[block].nextFree = head;
+	if(head != INVALID_BLOCK)
+		m_Blocks[head].prevFree = block;
+	head = block;
+
+	m_FirstLevelBits |= 1u << firstLevel;
+	m_SecondLevelBits[firstLevel] |= 1u << secondLevel;
+	m_NumFreeRanges++;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t block)
+{
+	int firstLevel, secondLevel;
+	Mapping(m_Blocks[block].size, firstLevel, secondLevel);
+
+	Block &freeBlock = m_Blocks[block];
+	if(freeBlock.prevFree != INVALID_BLOCK)
+		m_Blocks[freeBlock.prevFree].nextFree = freeBlock.nextFree;
+	else
+		m_FreeLists[firstLevel][secondLevel] = freeBlock.nextFree;
+	if(freeBlock.nextFree != INVALID_BLOCK)
+		m_Blocks[freeBlock.nextFree].prevFree = freeBlock.prevFree;
+	freeBlock.free = false;
+
+	if(m_FreeLists[firstLevel][secondLevel] == INVALID_BLOCK)
+	{
+		m_SecondLevelBits[firstLevel] &= ~(1u << secondLevel);
+		if(!m_SecondLevelBits[firstLevel])
+			m_FirstLevelBits &= ~(1u << firstLevel);
+	}
+	m_NumFreeRanges--;
+}
+
+} // end namespace render
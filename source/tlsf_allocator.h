@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace render
+{
+
+// Sub-allocates ranges of a fixed-size space, such as a large GPU buffer, with the
+// two-level segregated fit (TLSF) scheme: free ranges are kept in lists by size class,
+// found through two levels of bitmaps, so that allocating and freeing take constant
+// time however many ranges there are. A freed range is merged with free neighbours.
+//
+// The allocator only does the bookkeeping; sizes and offsets are in whatever units the
+// caller chooses, such as vertices or indices.
+class TlsfAllocator
+{
+public:
+
+	// Returned by Allocate when no free range is large enough
+	static const uint32_t INVALID_BLOCK = ~0u;
+
+	explicit TlsfAllocator(uint32_t size);
+
+	// Returns a block of at least size units, or INVALID_BLOCK if no free range holds it. Block
+	// ids stay the same for as long as the block is allocated.
+	uint32_t Allocate(uint32_t size);
+
+	// Returns a block of size units at the start of the lowest free range that holds it and
+	// ends at or below limit, or INVALID_BLOCK. Takes time linear in the number of ranges;
+	// used to move blocks down when compacting, never to place new ones.
+	uint32_t AllocateLowest(uint32_t size, uint32_t limit);
+
+	void Free(uint32_t block);
+
+	uint32_t GetOffset(uint32_t block) const { return m_Blocks[block].offset; }
+
+	uint32_t GetSize() const { return m_Size; }
+
+	// Units in allocated blocks
+	uint32_t GetUsed() const { return m_Used; }
+
+	// Size of the largest free range, which is the largest block Allocate can return
+	uint32_t GetLargestFree() const;
+
+	unsigned int GetNumFreeRanges() const { return m_NumFreeRanges; }
+
+private:
+
+	static const int SECOND_LEVEL_LOG2 = 4;
+	static const int SECOND_LEVEL_COUNT = 1 << SECOND_LEVEL_LOG2;
+	static const int FIRST_LEVEL_COUNT = 32 - SECOND_LEVEL_LOG2 + 1;
+
+	struct Block
+	{
+		uint32_t offset;
+		uint32_t size;
+		uint32_t prevPhysical, nextPhysical; // neighbouring ranges of the space, in order
+		uint32_t prevFree, nextFree; // neighbours in the free list of the block's size class
+		bool free;
+	};
+
+	// Size class of a range of size units
+	static void Mapping(uint32_t size, int &firstLevel, int &secondLevel);
+
+	uint32_t NewBlock();
+
+	// Take size units from the start of a free block, returning the rest to the free lists
+	void Split(uint32_t block, uint32_t size);
+
+	void InsertFree(uint32_t block);
+
+	void RemoveFree(uint32_t block);
+
+	std::vector<Block> m_Blocks;
+	std::vector<uint32_t> m_UnusedBlocks;
+	uint32_t m_FirstBlock = INVALID_BLOCK; // the range at offset 0, which merges always keep
+
+	uint32_t m_FirstLevelBits = 0;
+	uint32_t m_SecondLevelBits[FIRST_LEVEL_COUNT];
+	uint32_t m_FreeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+
+	uint32_t m_Size;
+	uint32_t m_Used = 0;
+	unsigned int m_NumFreeRanges = 0;
+};
+
+} // end namespace render
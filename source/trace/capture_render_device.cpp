@@ -0,0 +1,1332 @@
+#include "capture_render_device.h"
+
+#include "trace_format.h"
+#include "command_list_commands.h"
+#include "render_device/trace.h"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+
+namespace render
+{
+
+// Size at which a buffered chunk is written to the file
+static const size_t CHUNK_SIZE = 1024 * 1024;
+
+// Wraps a resource of the captured device with the id it is recorded under
+template<class BASE>
+class CaptureResource : public BASE
+{
+public:
+
+	CaptureResource(BASE *_object, uint32_t _id) : object(_object), id(_id) {}
+
+	BASE *object;
+	uint32_t id;
+};
+
+typedef CaptureResource<VertexShader> CaptureVertexShader;
+typedef CaptureResource<PixelShader> CapturePixelShader;
+typedef CaptureResource<VertexDescription> CaptureVertexDescription;
+typedef CaptureResource<VertexArray> CaptureVertexArray;
+typedef CaptureResource<SamplerState> CaptureSamplerState;
+typedef CaptureResource<RasterState> CaptureRasterState;
+typedef CaptureResource<DepthStencilState> CaptureDepthStencilState;
+typedef CaptureResource<IndirectBuffer> CaptureIndirectBuffer;
+
+// Buffers also remember the range they are mapped with, which is recorded when they are unmapped
+template<class BASE>
+class CaptureBuffer : public CaptureResource<BASE>
+{
+public:
+
+	CaptureBuffer(BASE *_object, uint32_t _id) : CaptureResource<BASE>(_object, _id) {}
+
+	void *mapping = nullptr;
+	long long mapOffset = 0;
+	long long mapSize = 0;
+	unsigned int mapFlags = 0;
+};
+
+typedef CaptureBuffer<VertexBuffer> CaptureVertexBuffer;
+typedef CaptureBuffer<IndexBuffer> CaptureIndexBuffer;
+typedef CaptureBuffer<UniformBuffer> CaptureUniformBuffer;
+
+// Textures also remember their format, which sizes the data of their updates
+class CaptureTexture2D : public CaptureResource<Texture2D>
+{
+public:
+
+	CaptureTexture2D(Texture2D *_object, uint32_t _id, TextureFormat _format) : CaptureResource<Texture2D>(_object, _id), format(_format) {}
+
+	TextureFormat format;
+};
+
+// Texture arrays also remember the size of the data of each layer
+class CaptureTexture2DArray : public CaptureResource<Texture2DArray>
+{
+public:
+
+	CaptureTexture2DArray(Texture2DArray *_object, uint32_t _id, TextureFormat _format, long long _layerSize) :
+		CaptureResource<Texture2DArray>(_object, _id), format(_format), layerSize(_layerSize) {}
+
+	TextureFormat format;
+	long long layerSize;
+};
+
+// Returns the wrapped resource, or nullptr for a null wrapper
+template<class BASE>
+static BASE *Unwrap(BASE *resource)
+{
+	return resource ? static_cast<CaptureResource<BASE> *>(resource)->object : nullptr;
+}
+
+// Returns the id a resource is recorded under, or 0 for a null resource
+template<class BASE>
+static uint32_t IdOf(BASE *resource)
+{
+	return resource ? static_cast<CaptureResource<BASE> *>(resource)->id : 0;
+}
+
+class CapturePipelineParam : public PipelineParam
+{
+public:
+
+	CapturePipelineParam(CaptureRenderDevice *_device, PipelineParam *_object, uint32_t _id) : device(_device), object(_object), id(_id) {}
+
+	void SetAsInt(int value) override
+	{
+		device->BeginCall(TRACECALL_SET_PARAM_INT);
+		device->Write(id);
+		device->Write(int32_t(value));
+		device->EndCall();
+
+		object->SetAsInt(value);
+	}
+
+	void SetAsFloat(float value) override
+	{
+		device->BeginCall(TRACECALL_SET_PARAM_FLOAT);
+		device->Write(id);
+		device->Write(value);
+		device->EndCall();
+
+		object->SetAsFloat(value);
+	}
+
+	void SetAsMat4(const float *value) override
+	{
+		device->BeginCall(TRACECALL_SET_PARAM_MAT4);
+		device->Write(id);
+		device->WriteBytes(value, 16 * sizeof(float));
+		device->EndCall();
+
+		object->SetAsMat4(value);
+	}
+
+	void SetAsIntArray(int count, const int *values) override
+	{
+		SetArray(TRACECALL_SET_PARAM_INT_ARRAY, count, values, count * sizeof(int));
+
+		object->SetAsIntArray(count, values);
+	}
+
+	void SetAsFloatArray(int count, const float *values) override
+	{
+		SetArray(TRACECALL_SET_PARAM_FLOAT_ARRAY, count, values, count * sizeof(float));
+
+		object->SetAsFloatArray(count, values);
+	}
+
+	void SetAsMat4Array(int count, const float *values) override
+	{
+		SetArray(TRACECALL_SET_PARAM_MAT4_ARRAY, count, values, count * 16 * sizeof(float));
+
+		object->SetAsMat4Array(count, values);
+	}
+
+	void SetArray(uint32_t type, int count, const void *values, size_t size)
+	{
+		device->BeginCall(type);
+		device->Write(id);
+		device->Write(int32_t(count));
+		device->WriteBytes(values, size);
+		device->EndCall();
+	}
+
+	CaptureRenderDevice *device;
+	PipelineParam *object;
+	uint32_t id;
+};
+
+class CapturePipeline : public Pipeline
+{
+public:
+
+	CapturePipeline(CaptureRenderDevice *_device, Pipeline *_object, uint32_t _id) : device(_device), object(_object), id(_id) {}
+
+	~CapturePipeline() override
+	{
+		for(auto &iter : params)
+			delete iter.second;
+	}
+
+	PipelineParam *GetParam(const char *name) override
+	{
+		// devices return the same param for the same name, so wrap each only once
+		PipelineParam *param = object->GetParam(name);
+		CapturePipelineParam *captureParam = nullptr;
+		if(param)
+		{
+			auto iter = params.find(param);
+			if(iter == params.end())
+				iter = params.insert(iter, std::make_pair(param, new CapturePipelineParam(device, param, device->NewId())));
+			captureParam = iter->second;
+		}
+
+		// record the lookup so replay can resolve the param on its own device
+		device->BeginCall(TRACECALL_GET_PARAM);
+		device->Write(captureParam ? captureParam->id : uint32_t(0));
+		device->Write(id);
+		device->WriteString(name);
+		device->EndCall();
+
+		return captureParam;
+	}
+
+	ParamHandle GetParamHandle(const char *name) override
+	{
+		// handles are not recorded; the lookup by name is, and resolving returns its param
+		PipelineParam *param = GetParam(name);
+		ParamHandle handle = object->GetParamHandle(name);
+		if(param && handle != INVALID_PARAM_HANDLE)
+			handles[handle] = static_cast<CapturePipelineParam *>(param);
+		return handle;
+	}
+
+	PipelineParam *ResolveParam(ParamHandle handle) override
+	{
+		auto iter = handles.find(handle);
+		return iter != handles.end() ? iter->second : nullptr;
+	}
+
+	bool SetUniformBlockSlot(const char *name, unsigned int slot) override
+	{
+		device->BeginCall(TRACECALL_SET_UNIFORM_BLOCK_SLOT);
+		device->Write(id);
+		device->Write(uint32_t(slot));
+		device->WriteString(name);
+		device->EndCall();
+
+		return object->SetUniformBlockSlot(name, slot);
+	}
+
+	CaptureRenderDevice *device;
+	Pipeline *object;
+	uint32_t id;
+
+	std::map<PipelineParam *, CapturePipelineParam *> params;
+	std::map<ParamHandle, CapturePipelineParam *> handles;
+};
+
+CaptureRenderDevice::CaptureRenderDevice(RenderDevice *renderDevice, FILE *file) : m_RenderDevice(renderDevice), m_File(file)
+{
+	m_Chunk.reserve(CHUNK_SIZE + CHUNK_SIZE / 4);
+
+	TraceFileHeader header;
+	header.magic = TRACE_MAGIC;
+	header.version = TRACE_VERSION;
+	fwrite(&header, sizeof(header), 1, m_File);
+}
+
+CaptureRenderDevice::~CaptureRenderDevice()
+{
+	FlushChunk();
+	fclose(m_File);
+
+	// the wrapped transient buffers belong to the device
+	delete m_TransientVertexBuffer;
+	delete m_TransientIndexBuffer;
+	delete m_RenderDevice;
+}
+
+void CaptureRenderDevice::BeginCall(uint32_t type)
+{
+	m_CallStart = m_Chunk.size();
+
+	TraceCallHeader header;
+	header.type = type;
+	header.size = 0;
+	Write(header);
+}
+
+void CaptureRenderDevice::EndCall()
+{
+	// patch the argument size into the header
+	uint32_t size = static_cast<uint32_t>(m_Chunk.size() - m_CallStart - sizeof(TraceCallHeader));
+	memcpy(&m_Chunk[m_CallStart + offsetof(TraceCallHeader, size)], &size, sizeof(size));
+
+	m_ChunkCalls++;
+	if(m_Chunk.size() >= CHUNK_SIZE)
+		FlushChunk();
+}
+
+void CaptureRenderDevice::WriteBytes(const void *data, size_t size)
+{
+	size_t offset = m_Chunk.size();
+	m_Chunk.resize(offset + ((size + 3) & ~size_t(3)), 0);
+	if(size)
+		memcpy(&m_Chunk[offset], data, size);
+}
+
+void CaptureRenderDevice::WriteString(const char *string)
+{
+	uint32_t length = static_cast<uint32_t>(strlen(string) + 1);
+	Write(length);
+	WriteBytes(string, length);
+}
+
+void CaptureRenderDevice::WriteBlob(const void *data, long long size)
+{
+	// the call is still replayed with its size, so a size the device rejects is rejected there too
+	uint64_t blobSize = data && size > 0 ? static_cast<uint64_t>(size) : 0;
+	Write(blobSize);
+	WriteBytes(data, static_cast<size_t>(blobSize));
+}
+
+void CaptureRenderDevice::RecordMapping(uint32_t type, uint32_t id, long long offset, long long size, unsigned int mapFlags, const void *mapping)
+{
+	// what was written through the mapping is only known once it is unmapped, so the whole range is recorded
+	// then; reading it back from a write-only mapping is slow, but keeps the mapping the application writes to
+	// the device's own
+	BeginCall(type);
+	Write(id);
+	Write(int64_t(offset));
+	Write(int64_t(size));
+	Write(uint32_t(mapFlags));
+	WriteBlob(mapping, size);
+	EndCall();
+}
+
+void CaptureRenderDevice::FlushChunk()
+{
+	if(m_ChunkCalls == 0)
+		return;
+
+	TraceChunkHeader header;
+	header.magic = TRACE_CHUNK_MAGIC;
+	header.numCalls = m_ChunkCalls;
+	header.size = m_Chunk.size();
+	fwrite(&header, sizeof(header), 1, m_File);
+	fwrite(&m_Chunk[0], 1, m_Chunk.size(), m_File);
+
+	m_Chunk.clear();
+	m_ChunkCalls = 0;
+}
+
+VertexShader *CaptureRenderDevice::CreateVertexShader(const char *code)
+{
+	VertexShader *vertexShader = m_RenderDevice->CreateVertexShader(code);
+	if(!vertexShader)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_VERTEX_SHADER);
+	Write(id);
+	WriteString(code);
+	EndCall();
+
+	return new CaptureVertexShader(vertexShader, id);
+}
+
+void CaptureRenderDevice::DestroyVertexShader(VertexShader *vertexShader)
+{
+	BeginCall(TRACECALL_DESTROY_VERTEX_SHADER);
+	Write(IdOf(vertexShader));
+	EndCall();
+
+	m_RenderDevice->DestroyVertexShader(Unwrap(vertexShader));
+	delete vertexShader;
+}
+
+PixelShader *CaptureRenderDevice::CreatePixelShader(const char *code)
+{
+	PixelShader *pixelShader = m_RenderDevice->CreatePixelShader(code);
+	if(!pixelShader)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_PIXEL_SHADER);
+	Write(id);
+	WriteString(code);
+	EndCall();
+
+	return new CapturePixelShader(pixelShader, id);
+}
+
+void CaptureRenderDevice::DestroyPixelShader(PixelShader *pixelShader)
+{
+	BeginCall(TRACECALL_DESTROY_PIXEL_SHADER);
+	Write(IdOf(pixelShader));
+	EndCall();
+
+	m_RenderDevice->DestroyPixelShader(Unwrap(pixelShader));
+	delete pixelShader;
+}
+
+Pipeline *CaptureRenderDevice::CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader)
+{
+	Pipeline *pipeline = m_RenderDevice->CreatePipeline(Unwrap(vertexShader), Unwrap(pixelShader));
+	if(!pipeline)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_PIPELINE);
+	Write(id);
+	Write(IdOf(vertexShader));
+	Write(IdOf(pixelShader));
+	EndCall();
+
+	return new CapturePipeline(this, pipeline, id);
+}
+
+void CaptureRenderDevice::DestroyPipeline(Pipeline *pipeline)
+{
+	CapturePipeline *capturePipeline = static_cast<CapturePipeline *>(pipeline);
+
+	BeginCall(TRACECALL_DESTROY_PIPELINE);
+	Write(capturePipeline ? capturePipeline->id : uint32_t(0));
+	EndCall();
+
+	m_RenderDevice->DestroyPipeline(capturePipeline ? capturePipeline->object : nullptr);
+	delete capturePipeline;
+}
+
+void CaptureRenderDevice::SetPipeline(Pipeline *pipeline)
+{
+	CapturePipeline *capturePipeline = static_cast<CapturePipeline *>(pipeline);
+
+	BeginCall(TRACECALL_SET_PIPELINE);
+	Write(capturePipeline ? capturePipeline->id : uint32_t(0));
+	EndCall();
+
+	m_RenderDevice->SetPipeline(capturePipeline ? capturePipeline->object : nullptr);
+}
+
+VertexBuffer *CaptureRenderDevice::CreateVertexBuffer(long long size, const void *data, BufferUsage usage)
+{
+	VertexBuffer *vertexBuffer = m_RenderDevice->CreateVertexBuffer(size, data, usage);
+	if(!vertexBuffer)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_VERTEX_BUFFER_USAGE);
+	Write(id);
+	Write(int64_t(size));
+	Write(uint32_t(usage));
+	WriteBlob(data, size);
+	EndCall();
+
+	return new CaptureVertexBuffer(vertexBuffer, id);
+}
+
+void CaptureRenderDevice::UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data)
+{
+	BeginCall(TRACECALL_UPDATE_VERTEX_BUFFER);
+	Write(IdOf(vertexBuffer));
+	Write(int64_t(offset));
+	Write(int64_t(size));
+	WriteBlob(data, size);
+	EndCall();
+
+	m_RenderDevice->UpdateVertexBuffer(Unwrap(vertexBuffer), offset, size, data);
+}
+
+void *CaptureRenderDevice::MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	void *mapping = m_RenderDevice->MapVertexBuffer(Unwrap(vertexBuffer), offset, size, mapFlags);
+	if(mapping)
+	{
+		CaptureVertexBuffer *captureVertexBuffer = static_cast<CaptureVertexBuffer *>(vertexBuffer);
+		captureVertexBuffer->mapping = mapping;
+		captureVertexBuffer->mapOffset = offset;
+		captureVertexBuffer->mapSize = size;
+		captureVertexBuffer->mapFlags = mapFlags;
+	}
+	return mapping;
+}
+
+void CaptureRenderDevice::UnmapVertexBuffer(VertexBuffer *vertexBuffer)
+{
+	CaptureVertexBuffer *captureVertexBuffer = static_cast<CaptureVertexBuffer *>(vertexBuffer);
+	if(captureVertexBuffer && captureVertexBuffer->mapping)
+	{
+		RecordMapping(TRACECALL_MAP_VERTEX_BUFFER, captureVertexBuffer->id, captureVertexBuffer->mapOffset, captureVertexBuffer->mapSize, captureVertexBuffer->mapFlags, captureVertexBuffer->mapping);
+		captureVertexBuffer->mapping = nullptr;
+	}
+
+	m_RenderDevice->UnmapVertexBuffer(Unwrap(vertexBuffer));
+}
+
+void CaptureRenderDevice::CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	BeginCall(TRACECALL_COPY_VERTEX_BUFFER);
+	Write(IdOf(destination));
+	Write(int64_t(destinationOffset));
+	Write(IdOf(source));
+	Write(int64_t(sourceOffset));
+	Write(int64_t(size));
+	EndCall();
+
+	m_RenderDevice->CopyVertexBuffer(Unwrap(destination), destinationOffset, Unwrap(source), sourceOffset, size);
+}
+
+void CaptureRenderDevice::DestroyVertexBuffer(VertexBuffer *vertexBuffer)
+{
+	BeginCall(TRACECALL_DESTROY_VERTEX_BUFFER);
+	Write(IdOf(vertexBuffer));
+	EndCall();
+
+	m_RenderDevice->DestroyVertexBuffer(Unwrap(vertexBuffer));
+	delete vertexBuffer;
+}
+
+VertexDescription *CaptureRenderDevice::CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements)
+{
+	VertexDescription *vertexDescription = m_RenderDevice->CreateVertexDescription(numVertexElements, vertexElements);
+	if(!vertexDescription)
+		return nullptr;
+
+	// descriptions without per-instance elements are recorded as before, so those traces replay on older tools
+	bool hasDivisors = false;
+	for(unsigned int i = 0; i < numVertexElements; i++)
+		hasDivisors = hasDivisors || vertexElements[i].divisor;
+
+	uint32_t id = NewId();
+	BeginCall(hasDivisors ? TRACECALL_CREATE_VERTEX_DESCRIPTION_DIVISORS : TRACECALL_CREATE_VERTEX_DESCRIPTION);
+	Write(id);
+	Write(uint32_t(numVertexElements));
+	for(unsigned int i = 0; i < numVertexElements; i++)
+	{
+		TraceVertexElement element;
+		element.index = vertexElements[i].index;
+		element.type = vertexElements[i].type;
+		element.size = vertexElements[i].size;
+		element.stride = vertexElements[i].stride;
+		element.offset = vertexElements[i].offset;
+		Write(element);
+	}
+	if(hasDivisors)
+		for(unsigned int i = 0; i < numVertexElements; i++)
+			Write(uint32_t(vertexElements[i].divisor));
+	EndCall();
+
+	return new CaptureVertexDescription(vertexDescription, id);
+}
+
+void CaptureRenderDevice::DestroyVertexDescription(VertexDescription *vertexDescription)
+{
+	BeginCall(TRACECALL_DESTROY_VERTEX_DESCRIPTION);
+	Write(IdOf(vertexDescription));
+	EndCall();
+
+	m_RenderDevice->DestroyVertexDescription(Unwrap(vertexDescription));
+	delete vertexDescription;
+}
+
+VertexArray *CaptureRenderDevice::CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions)
+{
+	std::vector<VertexBuffer *> buffers(numVertexBuffers);
+	std::vector<VertexDescription *> descriptions(numVertexBuffers);
+	for(unsigned int i = 0; i < numVertexBuffers; i++)
+	{
+		buffers[i] = Unwrap(vertexBuffers[i]);
+		descriptions[i] = Unwrap(vertexDescriptions[i]);
+	}
+
+	VertexArray *vertexArray = m_RenderDevice->CreateVertexArray(numVertexBuffers, buffers.data(), descriptions.data());
+	if(!vertexArray)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_VERTEX_ARRAY);
+	Write(id);
+	Write(uint32_t(numVertexBuffers));
+	for(unsigned int i = 0; i < numVertexBuffers; i++)
+		Write(IdOf(vertexBuffers[i]));
+	for(unsigned int i = 0; i < numVertexBuffers; i++)
+		Write(IdOf(vertexDescriptions[i]));
+	EndCall();
+
+	return new CaptureVertexArray(vertexArray, id);
+}
+
+void CaptureRenderDevice::DestroyVertexArray(VertexArray *vertexArray)
+{
+	BeginCall(TRACECALL_DESTROY_VERTEX_ARRAY);
+	Write(IdOf(vertexArray));
+	EndCall();
+
+	m_RenderDevice->DestroyVertexArray(Unwrap(vertexArray));
+	delete vertexArray;
+}
+
+void CaptureRenderDevice::SetVertexArray(VertexArray *vertexArray)
+{
+	BeginCall(TRACECALL_SET_VERTEX_ARRAY);
+	Write(IdOf(vertexArray));
+	EndCall();
+
+	m_RenderDevice->SetVertexArray(Unwrap(vertexArray));
+}
+
+IndexBuffer *CaptureRenderDevice::CreateIndexBuffer(long long size, const void *data, BufferUsage usage, IndexFormat format)
+{
+	IndexBuffer *indexBuffer = m_RenderDevice->CreateIndexBuffer(size, data, usage, format);
+	if(!indexBuffer)
+		return nullptr;
+
+	// 32-bit index buffers are recorded as before, so those traces replay on older tools
+	uint32_t id = NewId();
+	BeginCall(format != INDEXFORMAT_32 ? TRACECALL_CREATE_INDEX_BUFFER_FORMAT : TRACECALL_CREATE_INDEX_BUFFER_USAGE);
+	Write(id);
+	Write(int64_t(size));
+	Write(uint32_t(usage));
+	if(format != INDEXFORMAT_32)
+		Write(uint32_t(format));
+	WriteBlob(data, size);
+	EndCall();
+
+	return new CaptureIndexBuffer(indexBuffer, id);
+}
+
+void CaptureRenderDevice::UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data)
+{
+	BeginCall(TRACECALL_UPDATE_INDEX_BUFFER);
+	Write(IdOf(indexBuffer));
+	Write(int64_t(offset));
+	Write(int64_t(size));
+	WriteBlob(data, size);
+	EndCall();
+
+	m_RenderDevice->UpdateIndexBuffer(Unwrap(indexBuffer), offset, size, data);
+}
+
+void *CaptureRenderDevice::MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	void *mapping = m_RenderDevice->MapIndexBuffer(Unwrap(indexBuffer), offset, size, mapFlags);
+	if(mapping)
+	{
+		CaptureIndexBuffer *captureIndexBuffer = static_cast<CaptureIndexBuffer *>(indexBuffer);
+		captureIndexBuffer->mapping = mapping;
+		captureIndexBuffer->mapOffset = offset;
+		captureIndexBuffer->mapSize = size;
+		captureIndexBuffer->mapFlags = mapFlags;
+	}
+	return mapping;
+}
+
+void CaptureRenderDevice::UnmapIndexBuffer(IndexBuffer *indexBuffer)
+{
+	CaptureIndexBuffer *captureIndexBuffer = static_cast<CaptureIndexBuffer *>(indexBuffer);
+	if(captureIndexBuffer && captureIndexBuffer->mapping)
+	{
+		RecordMapping(TRACECALL_MAP_INDEX_BUFFER, captureIndexBuffer->id, captureIndexBuffer->mapOffset, captureIndexBuffer->mapSize, captureIndexBuffer->mapFlags, captureIndexBuffer->mapping);
+		captureIndexBuffer->mapping = nullptr;
+	}
+
+	m_RenderDevice->UnmapIndexBuffer(Unwrap(indexBuffer));
+}
+
+void CaptureRenderDevice::CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size)
+{
+	BeginCall(TRACECALL_COPY_INDEX_BUFFER);
+	Write(IdOf(destination));
+	Write(int64_t(destinationOffset));
+	Write(IdOf(source));
+	Write(int64_t(sourceOffset));
+	Write(int64_t(size));
+	EndCall();
+
+	m_RenderDevice->CopyIndexBuffer(Unwrap(destination), destinationOffset, Unwrap(source), sourceOffset, size);
+}
+
+void CaptureRenderDevice::DestroyIndexBuffer(IndexBuffer *indexBuffer)
+{
+	BeginCall(TRACECALL_DESTROY_INDEX_BUFFER);
+	Write(IdOf(indexBuffer));
+	EndCall();
+
+	m_RenderDevice->DestroyIndexBuffer(Unwrap(indexBuffer));
+	delete indexBuffer;
+}
+
+void CaptureRenderDevice::SetIndexBuffer(IndexBuffer *indexBuffer)
+{
+	BeginCall(TRACECALL_SET_INDEX_BUFFER);
+	Write(IdOf(indexBuffer));
+	EndCall();
+
+	m_RenderDevice->SetIndexBuffer(Unwrap(indexBuffer));
+}
+
+void CaptureRenderDevice::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+	BeginCall(TRACECALL_SET_PRIMITIVE_TOPOLOGY);
+	Write(uint32_t(topology));
+	EndCall();
+
+	m_RenderDevice->SetPrimitiveTopology(topology);
+}
+
+IndirectBuffer *CaptureRenderDevice::CreateIndirectBuffer(long long size, const void *data, BufferUsage usage)
+{
+	IndirectBuffer *indirectBuffer = m_RenderDevice->CreateIndirectBuffer(size, data, usage);
+	if(!indirectBuffer)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_INDIRECT_BUFFER);
+	Write(id);
+	Write(int64_t(size));
+	Write(uint32_t(usage));
+	WriteBlob(data, size);
+	EndCall();
+
+	return new CaptureIndirectBuffer(indirectBuffer, id);
+}
+
+void CaptureRenderDevice::UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data)
+{
+	BeginCall(TRACECALL_UPDATE_INDIRECT_BUFFER);
+	Write(IdOf(indirectBuffer));
+	Write(int64_t(offset));
+	Write(int64_t(size));
+	WriteBlob(data, size);
+	EndCall();
+
+	m_RenderDevice->UpdateIndirectBuffer(Unwrap(indirectBuffer), offset, size, data);
+}
+
+void CaptureRenderDevice::CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size)
+{
+	BeginCall(TRACECALL_COPY_INDIRECT_BUFFER);
+	Write(IdOf(destination));
+	Write(int64_t(destinationOffset));
+	Write(IdOf(source));
+	Write(int64_t(sourceOffset));
+	Write(int64_t(size));
+	EndCall();
+
+	m_RenderDevice->CopyIndirectBuffer(Unwrap(destination), destinationOffset, Unwrap(source), sourceOffset, size);
+}
+
+void CaptureRenderDevice::DestroyIndirectBuffer(IndirectBuffer *indirectBuffer)
+{
+	BeginCall(TRACECALL_DESTROY_INDIRECT_BUFFER);
+	Write(IdOf(indirectBuffer));
+	EndCall();
+
+	m_RenderDevice->DestroyIndirectBuffer(Unwrap(indirectBuffer));
+	delete indirectBuffer;
+}
+
+Texture2D *CaptureRenderDevice::CreateTexture2D(int width, int height, const void *data, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	Texture2D *texture2D = m_RenderDevice->CreateTexture2D(width, height, data, format, mipLevels, mipPolicy);
+	if(!texture2D)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_TEXTURE2D_FORMAT);
+	Write(id);
+	Write(int32_t(width));
+	Write(int32_t(height));
+	Write(uint32_t(format));
+	Write(int32_t(mipLevels));
+	Write(uint32_t(mipPolicy));
+	WriteBlob(data, GetTextureSize(format, width, height, mipLevels > 0 ? mipLevels : 1));
+	EndCall();
+
+	return new CaptureTexture2D(texture2D, id, format);
+}
+
+bool CaptureRenderDevice::IsTextureFormatSupported(TextureFormat format)
+{
+	// queries are not recorded; the creation calls that follow them are
+	return m_RenderDevice->IsTextureFormatSupported(format);
+}
+
+void CaptureRenderDevice::UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async)
+{
+	BeginCall(TRACECALL_UPDATE_TEXTURE2D);
+	Write(IdOf(texture2D));
+	Write(int32_t(mipLevel));
+	Write(int32_t(x));
+	Write(int32_t(y));
+	Write(int32_t(width));
+	Write(int32_t(height));
+	Write(uint32_t(async));
+	WriteBlob(data, texture2D && width > 0 && height > 0 ? GetTextureLevelSize(static_cast<CaptureTexture2D *>(texture2D)->format, width, height) : 0);
+	EndCall();
+
+	m_RenderDevice->UpdateTexture2D(Unwrap(texture2D), mipLevel, x, y, width, height, data, async);
+}
+
+void CaptureRenderDevice::DestroyTexture2D(Texture2D *texture2D)
+{
+	BeginCall(TRACECALL_DESTROY_TEXTURE2D);
+	Write(IdOf(texture2D));
+	EndCall();
+
+	m_RenderDevice->DestroyTexture2D(Unwrap(texture2D));
+	delete texture2D;
+}
+
+void CaptureRenderDevice::SetTexture2D(unsigned int slot, Texture2D *texture2D)
+{
+	BeginCall(TRACECALL_SET_TEXTURE2D);
+	Write(uint32_t(slot));
+	Write(IdOf(texture2D));
+	EndCall();
+
+	m_RenderDevice->SetTexture2D(slot, Unwrap(texture2D));
+}
+
+Texture2DArray *CaptureRenderDevice::CreateTexture2DArray(int width, int height, int layers, TextureFormat format, int mipLevels, MipPolicy mipPolicy)
+{
+	Texture2DArray *texture2DArray = m_RenderDevice->CreateTexture2DArray(width, height, layers, format, mipLevels, mipPolicy);
+	if(!texture2DArray)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_TEXTURE2D_ARRAY);
+	Write(id);
+	Write(int32_t(width));
+	Write(int32_t(height));
+	Write(int32_t(layers));
+	Write(uint32_t(format));
+	Write(int32_t(mipLevels));
+	Write(uint32_t(mipPolicy));
+	EndCall();
+
+	return new CaptureTexture2DArray(texture2DArray, id, format, GetTextureSize(format, width, height, mipLevels > 0 ? mipLevels : 1));
+}
+
+void CaptureRenderDevice::UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async)
+{
+	BeginCall(TRACECALL_UPLOAD_TEXTURE2D_ARRAY_LAYER);
+	Write(IdOf(texture2DArray));
+	Write(int32_t(layer));
+	Write(uint32_t(async));
+	WriteBlob(data, texture2DArray ? static_cast<CaptureTexture2DArray *>(texture2DArray)->layerSize : 0);
+	EndCall();
+
+	m_RenderDevice->UploadTexture2DArrayLayer(Unwrap(texture2DArray), layer, data, async);
+}
+
+void CaptureRenderDevice::UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+	bool async)
+{
+	BeginCall(TRACECALL_UPDATE_TEXTURE2D_ARRAY);
+	Write(IdOf(texture2DArray));
+	Write(int32_t(layer));
+	Write(int32_t(mipLevel));
+	Write(int32_t(x));
+	Write(int32_t(y));
+	Write(int32_t(width));
+	Write(int32_t(height));
+	Write(uint32_t(async));
+	WriteBlob(data, texture2DArray && width > 0 && height > 0 ? GetTextureLevelSize(static_cast<CaptureTexture2DArray *>(texture2DArray)->format, width, height) : 0);
+	EndCall();
+
+	m_RenderDevice->UpdateTexture2DArray(Unwrap(texture2DArray), layer, mipLevel, x, y, width, height, data, async);
+}
+
+void CaptureRenderDevice::DestroyTexture2DArray(Texture2DArray *texture2DArray)
+{
+	BeginCall(TRACECALL_DESTROY_TEXTURE2D_ARRAY);
+	Write(IdOf(texture2DArray));
+	EndCall();
+
+	m_RenderDevice->DestroyTexture2DArray(Unwrap(texture2DArray));
+	delete texture2DArray;
+}
+
+void CaptureRenderDevice::SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray)
+{
+	BeginCall(TRACECALL_SET_TEXTURE2D_ARRAY);
+	Write(uint32_t(slot));
+	Write(IdOf(texture2DArray));
+	EndCall();
+
+	m_RenderDevice->SetTexture2DArray(slot, Unwrap(texture2DArray));
+}
+
+SamplerState *CaptureRenderDevice::CreateSamplerState(TextureFilter minFilter, TextureFilter magFilter, MipFilter mipFilter, TextureWrap wrapS, TextureWrap wrapT)
+{
+	SamplerState *samplerState = m_RenderDevice->CreateSamplerState(minFilter, magFilter, mipFilter, wrapS, wrapT);
+	if(!samplerState)
+		return nullptr;
+
+	TraceSamplerState state;
+	state.minFilter = minFilter;
+	state.magFilter = magFilter;
+	state.mipFilter = mipFilter;
+	state.wrapS = wrapS;
+	state.wrapT = wrapT;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_SAMPLER_STATE);
+	Write(id);
+	Write(state);
+	EndCall();
+
+	return new CaptureSamplerState(samplerState, id);
+}
+
+void CaptureRenderDevice::DestroySamplerState(SamplerState *samplerState)
+{
+	BeginCall(TRACECALL_DESTROY_SAMPLER_STATE);
+	Write(IdOf(samplerState));
+	EndCall();
+
+	m_RenderDevice->DestroySamplerState(Unwrap(samplerState));
+	delete samplerState;
+}
+
+void CaptureRenderDevice::SetSamplerState(unsigned int slot, SamplerState *samplerState)
+{
+	BeginCall(TRACECALL_SET_SAMPLER_STATE);
+	Write(uint32_t(slot));
+	Write(IdOf(samplerState));
+	EndCall();
+
+	m_RenderDevice->SetSamplerState(slot, Unwrap(samplerState));
+}
+
+UniformBuffer *CaptureRenderDevice::CreateUniformBuffer(long long size, const void *data, BufferUsage usage)
+{
+	UniformBuffer *uniformBuffer = m_RenderDevice->CreateUniformBuffer(size, data, usage);
+	if(!uniformBuffer)
+		return nullptr;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_UNIFORM_BUFFER_USAGE);
+	Write(id);
+	Write(int64_t(size));
+	Write(uint32_t(usage));
+	WriteBlob(data, size);
+	EndCall();
+
+	return new CaptureUniformBuffer(uniformBuffer, id);
+}
+
+void CaptureRenderDevice::UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data)
+{
+	BeginCall(TRACECALL_UPDATE_UNIFORM_BUFFER);
+	Write(IdOf(uniformBuffer));
+	Write(int64_t(offset));
+	Write(int64_t(size));
+	WriteBlob(data, size);
+	EndCall();
+
+	m_RenderDevice->UpdateUniformBuffer(Unwrap(uniformBuffer), offset, size, data);
+}
+
+void *CaptureRenderDevice::MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags)
+{
+	void *mapping = m_RenderDevice->MapUniformBuffer(Unwrap(uniformBuffer), offset, size, mapFlags);
+	if(mapping)
+	{
+		CaptureUniformBuffer *captureUniformBuffer = static_cast<CaptureUniformBuffer *>(uniformBuffer);
+		captureUniformBuffer->mapping = mapping;
+		captureUniformBuffer->mapOffset = offset;
+		captureUniformBuffer->mapSize = size;
+		captureUniformBuffer->mapFlags = mapFlags;
+	}
+	return mapping;
+}
+
+void CaptureRenderDevice::UnmapUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	CaptureUniformBuffer *captureUniformBuffer = static_cast<CaptureUniformBuffer *>(uniformBuffer);
+	if(captureUniformBuffer && captureUniformBuffer->mapping)
+	{
+		RecordMapping(TRACECALL_MAP_UNIFORM_BUFFER, captureUniformBuffer->id, captureUniformBuffer->mapOffset, captureUniformBuffer->mapSize, captureUniformBuffer->mapFlags, captureUniformBuffer->mapping);
+		captureUniformBuffer->mapping = nullptr;
+	}
+
+	m_RenderDevice->UnmapUniformBuffer(Unwrap(uniformBuffer));
+}
+
+void CaptureRenderDevice::DestroyUniformBuffer(UniformBuffer *uniformBuffer)
+{
+	BeginCall(TRACECALL_DESTROY_UNIFORM_BUFFER);
+	Write(IdOf(uniformBuffer));
+	EndCall();
+
+	m_RenderDevice->DestroyUniformBuffer(Unwrap(uniformBuffer));
+	delete uniformBuffer;
+}
+
+void CaptureRenderDevice::SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer)
+{
+	BeginCall(TRACECALL_SET_UNIFORM_BUFFER);
+	Write(uint32_t(slot));
+	Write(IdOf(uniformBuffer));
+	EndCall();
+
+	m_RenderDevice->SetUniformBuffer(slot, Unwrap(uniformBuffer));
+}
+
+long long CaptureRenderDevice::WriteUniformData(const void *data, long long size)
+{
+	long long offset = m_RenderDevice->WriteUniformData(data, size);
+
+	// the offset is recorded so replay can map it to the one its own device returns
+	BeginCall(TRACECALL_WRITE_UNIFORM_DATA);
+	Write(int64_t(offset));
+	WriteBlob(data, size);
+	EndCall();
+
+	return offset;
+}
+
+TransientVertices CaptureRenderDevice::WriteTransientVertices(const void *data, int count, int stride)
+{
+	TransientVertices vertices = m_RenderDevice->WriteTransientVertices(data, count, stride);
+
+	// the device hands out the same buffer every frame, so it is wrapped once
+	if(vertices.vertexBuffer && !m_TransientVertexBuffer)
+		m_TransientVertexBuffer = new CaptureVertexBuffer(vertices.vertexBuffer, NewId());
+
+	// the first vertex is recorded so replay can map draws from it to the one its own device returns
+	BeginCall(TRACECALL_WRITE_TRANSIENT_VERTICES);
+	Write(vertices.vertexBuffer ? IdOf<VertexBuffer>(m_TransientVertexBuffer) : uint32_t(0));
+	Write(int32_t(count));
+	Write(int32_t(stride));
+	Write(int32_t(vertices.firstVertex));
+	WriteBlob(vertices.vertexBuffer ? data : nullptr, static_cast<long long>(count) * stride);
+	EndCall();
+
+	if(vertices.vertexBuffer)
+		vertices.vertexBuffer = m_TransientVertexBuffer;
+	return vertices;
+}
+
+TransientIndices CaptureRenderDevice::WriteTransientIndices(const unsigned int *indices, int count, int baseVertex)
+{
+	TransientIndices transientIndices = m_RenderDevice->WriteTransientIndices(indices, count, baseVertex);
+
+	if(transientIndices.indexBuffer && !m_TransientIndexBuffer)
+		m_TransientIndexBuffer = new CaptureIndexBuffer(transientIndices.indexBuffer, NewId());
+
+	BeginCall(TRACECALL_WRITE_TRANSIENT_INDICES);
+	Write(transientIndices.indexBuffer ? IdOf<IndexBuffer>(m_TransientIndexBuffer) : uint32_t(0));
+	Write(int32_t(count));
+	Write(int32_t(baseVertex));
+	Write(int64_t(transientIndices.offset));
+	WriteBlob(transientIndices.indexBuffer ? indices : nullptr, count * 4ll);
+	EndCall();
+
+	if(transientIndices.indexBuffer)
+		transientIndices.indexBuffer = m_TransientIndexBuffer;
+	return transientIndices;
+}
+
+void CaptureRenderDevice::SetUniformData(unsigned int slot, long long offset, long long size)
+{
+	BeginCall(TRACECALL_SET_UNIFORM_DATA);
+	Write(uint32_t(slot));
+	Write(int64_t(offset));
+	Write(int64_t(size));
+	EndCall();
+
+	m_RenderDevice->SetUniformData(slot, offset, size);
+}
+
+RasterState *CaptureRenderDevice::CreateRasterState(bool cullEnabled, Winding frontFace, Face cullFace, RasterMode rasterMode)
+{
+	RasterState *rasterState = m_RenderDevice->CreateRasterState(cullEnabled, frontFace, cullFace, rasterMode);
+	if(!rasterState)
+		return nullptr;
+
+	TraceRasterState state;
+	state.cullEnabled = cullEnabled;
+	state.frontFace = frontFace;
+	state.cullFace = cullFace;
+	state.rasterMode = rasterMode;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_RASTER_STATE);
+	Write(id);
+	Write(state);
+	EndCall();
+
+	return new CaptureRasterState(rasterState, id);
+}
+
+void CaptureRenderDevice::DestroyRasterState(RasterState *rasterState)
+{
+	BeginCall(TRACECALL_DESTROY_RASTER_STATE);
+	Write(IdOf(rasterState));
+	EndCall();
+
+	m_RenderDevice->DestroyRasterState(Unwrap(rasterState));
+	delete rasterState;
+}
+
+void CaptureRenderDevice::SetRasterState(RasterState *rasterState)
+{
+	BeginCall(TRACECALL_SET_RASTER_STATE);
+	Write(IdOf(rasterState));
+	EndCall();
+
+	m_RenderDevice->SetRasterState(Unwrap(rasterState));
+}
+
+DepthStencilState *CaptureRenderDevice::CreateDepthStencilState(bool depthEnabled, bool depthWriteEnabled, float depthNear, float depthFar, Compare depthCompare,
+	bool frontFaceStencilEnabled, Compare frontFaceStencilCompare, StencilAction frontFaceStencilFail, StencilAction frontFaceStencilPass, StencilAction frontFaceDepthFail,
+	int frontFaceRef, unsigned int frontFaceReadMask, unsigned int frontFaceWriteMask,
+	bool backFaceStencilEnabled, Compare backFaceStencilCompare, StencilAction backFaceStencilFail, StencilAction backFaceStencilPass, StencilAction backFaceDepthFail,
+	int backFaceRef, unsigned int backFaceReadMask, unsigned int backFaceWriteMask)
+{
+	DepthStencilState *depthStencilState = m_RenderDevice->CreateDepthStencilState(depthEnabled, depthWriteEnabled, depthNear, depthFar, depthCompare,
+		frontFaceStencilEnabled, frontFaceStencilCompare, frontFaceStencilFail, frontFaceStencilPass, frontFaceDepthFail, frontFaceRef, frontFaceReadMask, frontFaceWriteMask,
+		backFaceStencilEnabled, backFaceStencilCompare, backFaceStencilFail, backFaceStencilPass, backFaceDepthFail, backFaceRef, backFaceReadMask, backFaceWriteMask);
+	if(!depthStencilState)
+		return nullptr;
+
+	TraceDepthStencilState state;
+	state.depthEnabled = depthEnabled;
+	state.depthWriteEnabled = depthWriteEnabled;
+	state.depthNear = depthNear;
+	state.depthFar = depthFar;
+	state.depthCompare = depthCompare;
+	state.front.enabled = frontFaceStencilEnabled;
+	state.front.compare = frontFaceStencilCompare;
+	state.front.fail = frontFaceStencilFail;
+	state.front.pass = frontFaceStencilPass;
+	state.front.depthFail = frontFaceDepthFail;
+	state.front.ref = frontFaceRef;
+	state.front.readMask = frontFaceReadMask;
+	state.front.writeMask = frontFaceWriteMask;
+	state.back.enabled = backFaceStencilEnabled;
+	state.back.compare = backFaceStencilCompare;
+	state.back.fail = backFaceStencilFail;
+	state.back.pass = backFaceStencilPass;
+	state.back.depthFail = backFaceDepthFail;
+	state.back.ref = backFaceRef;
+	state.back.readMask = backFaceReadMask;
+	state.back.writeMask = backFaceWriteMask;
+
+	uint32_t id = NewId();
+	BeginCall(TRACECALL_CREATE_DEPTH_STENCIL_STATE);
+	Write(id);
+	Write(state);
+	EndCall();
+
+	return new CaptureDepthStencilState(depthStencilState, id);
+}
+
+void CaptureRenderDevice::DestroyDepthStencilState(DepthStencilState *depthStencilState)
+{
+	BeginCall(TRACECALL_DESTROY_DEPTH_STENCIL_STATE);
+	Write(IdOf(depthStencilState));
+	EndCall();
+
+	m_RenderDevice->DestroyDepthStencilState(Unwrap(depthStencilState));
+	delete depthStencilState;
+}
+
+void CaptureRenderDevice::SetDepthStencilState(DepthStencilState *depthStencilState)
+{
+	BeginCall(TRACECALL_SET_DEPTH_STENCIL_STATE);
+	Write(IdOf(depthStencilState));
+	EndCall();
+
+	m_RenderDevice->SetDepthStencilState(Unwrap(depthStencilState));
+}
+
+void CaptureRenderDevice::Clear(float red, float green, float blue, float alpha, float depth, int stencil)
+{
+	BeginCall(TRACECALL_CLEAR);
+	Write(red);
+	Write(green);
+	Write(blue);
+	Write(alpha);
+	Write(depth);
+	Write(int32_t(stencil));
+	EndCall();
+
+	m_RenderDevice->Clear(red, green, blue, alpha, depth, stencil);
+}
+
+void CaptureRenderDevice::DrawTriangles(int offset, int count)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES);
+	Write(int32_t(offset));
+	Write(int32_t(count));
+	EndCall();
+
+	m_RenderDevice->DrawTriangles(offset, count);
+}
+
+void CaptureRenderDevice::DrawTrianglesIndexed32(long long offset, int count, int baseVertex)
+{
+	// draws without a base vertex are recorded as before, so those traces replay on older tools
+	BeginCall(baseVertex ? TRACECALL_DRAW_TRIANGLES_INDEXED32_BASE_VERTEX : TRACECALL_DRAW_TRIANGLES_INDEXED32);
+	Write(int64_t(offset));
+	Write(int32_t(count));
+	if(baseVertex)
+		Write(int32_t(baseVertex));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesIndexed32(offset, count, baseVertex);
+}
+
+void CaptureRenderDevice::DrawTrianglesIndexed16(long long offset, int count, int baseVertex)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_INDEXED16);
+	Write(int64_t(offset));
+	Write(int32_t(count));
+	Write(int32_t(baseVertex));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesIndexed16(offset, count, baseVertex);
+}
+
+void CaptureRenderDevice::DrawTrianglesInstanced(int offset, int count, int instanceCount)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_INSTANCED);
+	Write(int32_t(offset));
+	Write(int32_t(count));
+	Write(int32_t(instanceCount));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesInstanced(offset, count, instanceCount);
+}
+
+void CaptureRenderDevice::DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_INDEXED32_INSTANCED);
+	Write(int64_t(offset));
+	Write(int32_t(count));
+	Write(int32_t(instanceCount));
+	Write(int32_t(baseVertex));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesIndexed32Instanced(offset, count, instanceCount, baseVertex);
+}
+
+void CaptureRenderDevice::DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_INDEXED16_INSTANCED);
+	Write(int64_t(offset));
+	Write(int32_t(count));
+	Write(int32_t(instanceCount));
+	Write(int32_t(baseVertex));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesIndexed16Instanced(offset, count, instanceCount, baseVertex);
+}
+
+void CaptureRenderDevice::DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_MULTI);
+	Write(int32_t(drawCount));
+	for(int i = 0; i < drawCount; i++)
+		Write(int32_t(offsets[i]));
+	for(int i = 0; i < drawCount; i++)
+		Write(int32_t(counts[i]));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesMulti(drawCount, offsets, counts);
+}
+
+void CaptureRenderDevice::DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices, IndexFormat format)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_INDEXED_MULTI);
+	Write(uint32_t(format));
+	Write(int32_t(drawCount));
+	for(int i = 0; i < drawCount; i++)
+		Write(int64_t(offsets[i]));
+	for(int i = 0; i < drawCount; i++)
+		Write(int32_t(counts[i]));
+	for(int i = 0; i < drawCount; i++)
+		Write(int32_t(baseVertices ? baseVertices[i] : 0));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesIndexedMulti(drawCount, offsets, counts, baseVertices, format);
+}
+
+void CaptureRenderDevice::DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount, IndexFormat format)
+{
+	BeginCall(TRACECALL_DRAW_TRIANGLES_INDEXED_INDIRECT);
+	Write(IdOf(indirectBuffer));
+	Write(int64_t(offset));
+	Write(int32_t(drawCount));
+	Write(uint32_t(format));
+	EndCall();
+
+	m_RenderDevice->DrawTrianglesIndexedIndirect(Unwrap(indirectBuffer), offset, drawCount, format);
+}
+
+void CaptureRenderDevice::SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists)
+{
+	// the lists hold capture resources, so execute them here, recording each call as if made directly
+	for(unsigned int i = 0; i < numCommandLists; i++)
+		ExecuteCommandList(*commandLists[i], *this);
+}
+
+void CaptureRenderDevice::EndFrame()
+{
+	BeginCall(TRACECALL_END_FRAME);
+	EndCall();
+
+	m_RenderDevice->EndFrame();
+}
+
+void CaptureRenderDevice::BeginGpuScope(const char *name)
+{
+	BeginCall(TRACECALL_BEGIN_GPU_SCOPE);
+	WriteString(name);
+	EndCall();
+
+	m_RenderDevice->BeginGpuScope(name);
+}
+
+void CaptureRenderDevice::EndGpuScope()
+{
+	BeginCall(TRACECALL_END_GPU_SCOPE);
+	EndCall();
+
+	m_RenderDevice->EndGpuScope();
+}
+
+unsigned int CaptureRenderDevice::GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats)
+{
+	// queries are not recorded; they do not change what is rendered
+	return m_RenderDevice->GetGpuScopeStats(maxScopes, stats);
+}
+
+void CaptureRenderDevice::ResetGpuScopeStats()
+{
+	m_RenderDevice->ResetGpuScopeStats();
+}
+
+RenderDevice *CreateCaptureRenderDevice(RenderDevice *renderDevice, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if(!file)
+	{
+		std::cout << "ERROR::CAPTURE::FILE_OPEN_FAILED\n" << path << std::endl;
+		return nullptr;
+	}
+
+	return new CaptureRenderDevice(renderDevice, file);
+}
+
+} // end namespace render
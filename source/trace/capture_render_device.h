@@ -0,0 +1,244 @@
+#pragma once
+
+#include "render_device/render_device.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace render
+{
+
+// A RenderDevice that records every call to a binary trace (see trace_format.h)
+// before forwarding it to the device it wraps. Calls are buffered into chunks in
+// memory and written out a chunk at a time.
+class CaptureRenderDevice final : public RenderDevice
+{
+public:
+
+	// Takes ownership of renderDevice; file must be open for binary writing and is closed by the device
+	CaptureRenderDevice(RenderDevice *renderDevice, FILE *file);
+
+	~CaptureRenderDevice() override;
+
+	VertexShader *CreateVertexShader(const char *code) override;
+
+	void DestroyVertexShader(VertexShader *vertexShader) override;
+
+	PixelShader *CreatePixelShader(const char *code) override;
+
+	void DestroyPixelShader(PixelShader *pixelShader) override;
+
+	Pipeline *CreatePipeline(VertexShader *vertexShader, PixelShader *pixelShader) override;
+
+	void DestroyPipeline(Pipeline *pipeline) override;
+
+	void SetPipeline(Pipeline *pipeline) override;
+
+	VertexBuffer *CreateVertexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapVertexBuffer(VertexBuffer *vertexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	void CopyVertexBuffer(VertexBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyVertexBuffer(VertexBuffer *vertexBuffer) override;
+
+	VertexDescription *CreateVertexDescription(unsigned int numVertexElements, const VertexElement *vertexElements) override;
+
+	void DestroyVertexDescription(VertexDescription *vertexDescription) override;
+
+	VertexArray *CreateVertexArray(unsigned int numVertexBuffers, VertexBuffer **vertexBuffers, VertexDescription **vertexDescriptions) override;
+
+	void DestroyVertexArray(VertexArray *vertexArray) override;
+
+	void SetVertexArray(VertexArray *vertexArray) override;
+
+	IndexBuffer *CreateIndexBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC, IndexFormat format = INDEXFORMAT_32) override;
+
+	void UpdateIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapIndexBuffer(IndexBuffer *indexBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void CopyIndexBuffer(IndexBuffer *destination, long long destinationOffset, IndexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void SetIndexBuffer(IndexBuffer *indexBuffer) override;
+
+	void SetPrimitiveTopology(PrimitiveTopology topology) override;
+
+	IndirectBuffer *CreateIndirectBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateIndirectBuffer(IndirectBuffer *indirectBuffer, long long offset, long long size, const void *data) override;
+
+	void CopyIndirectBuffer(IndirectBuffer *destination, long long destinationOffset, VertexBuffer *source, long long sourceOffset, long long size) override;
+
+	void DestroyIndirectBuffer(IndirectBuffer *indirectBuffer) override;
+
+	Texture2D *CreateTexture2D(int width, int height, const void *data = nullptr, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	bool IsTextureFormatSupported(TextureFormat format) override;
+
+	void UpdateTexture2D(Texture2D *texture2D, int mipLevel, int x, int y, int width, int height, const void *data, bool async = false) override;
+
+	void DestroyTexture2D(Texture2D *texture2D) override;
+
+	void SetTexture2D(unsigned int slot, Texture2D *texture2D) override;
+
+	Texture2DArray *CreateTexture2DArray(int width, int height, int layers, TextureFormat format = TEXTUREFORMAT_RGBX8, int mipLevels = 0,
+		MipPolicy mipPolicy = MIPPOLICY_DRIVER) override;
+
+	void UploadTexture2DArrayLayer(Texture2DArray *texture2DArray, int layer, const void *data, bool async = false) override;
+
+	void UpdateTexture2DArray(Texture2DArray *texture2DArray, int layer, int mipLevel, int x, int y, int width, int height, const void *data,
+		bool async = false) override;
+
+	void DestroyTexture2DArray(Texture2DArray *texture2DArray) override;
+
+	void SetTexture2DArray(unsigned int slot, Texture2DArray *texture2DArray) override;
+
+	SamplerState *CreateSamplerState(TextureFilter minFilter = TEXTUREFILTER_LINEAR, TextureFilter magFilter = TEXTUREFILTER_LINEAR,
+		MipFilter mipFilter = MIPFILTER_LINEAR, TextureWrap wrapS = TEXTUREWRAP_CLAMP_TO_EDGE, TextureWrap wrapT = TEXTUREWRAP_CLAMP_TO_EDGE) override;
+
+	void DestroySamplerState(SamplerState *samplerState) override;
+
+	void SetSamplerState(unsigned int slot, SamplerState *samplerState) override;
+
+	UniformBuffer *CreateUniformBuffer(long long size, const void *data = nullptr, BufferUsage usage = BUFFERUSAGE_STATIC) override;
+
+	void UpdateUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, const void *data) override;
+
+	void *MapUniformBuffer(UniformBuffer *uniformBuffer, long long offset, long long size, unsigned int mapFlags = 0) override;
+
+	void UnmapUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void DestroyUniformBuffer(UniformBuffer *uniformBuffer) override;
+
+	void SetUniformBuffer(unsigned int slot, UniformBuffer *uniformBuffer) override;
+
+	long long WriteUniformData(const void *data, long long size) override;
+
+	void SetUniformData(unsigned int slot, long long offset, long long size) override;
+
+	TransientVertices WriteTransientVertices(const void *data, int count, int stride) override;
+
+	TransientIndices WriteTransientIndices(const unsigned int *indices, int count, int baseVertex = 0) override;
+
+	RasterState *CreateRasterState(bool cullEnabled = true, Winding frontFace = WINDING_CCW, Face cullFace = FACE_BACK, RasterMode rasterMode = RASTERMODE_FILL) override;
+
+	void DestroyRasterState(RasterState *rasterState) override;
+
+	void SetRasterState(RasterState *rasterState) override;
+
+	DepthStencilState *CreateDepthStencilState(bool depthEnabled = true,
+		bool			depthWriteEnabled = true,
+		float			depthNear = 0,
+		float			depthFar = 1,
+		Compare			depthCompare = COMPARE_LESS,
+
+		bool			frontFaceStencilEnabled = false,
+		Compare			frontFaceStencilCompare = COMPARE_ALWAYS,
+		StencilAction	frontFaceStencilFail = STENCIL_KEEP,
+		StencilAction	frontFaceStencilPass = STENCIL_KEEP,
+		StencilAction	frontFaceDepthFail = STENCIL_KEEP,
+		int				frontFaceRef = 0,
+		unsigned int	frontFaceReadMask = 0xFFFFFFFF,
+		unsigned int	frontFaceWriteMask = 0xFFFFFFFF,
+
+		bool			backFaceStencilEnabled = false,
+		Compare			backFaceStencilCompare = COMPARE_ALWAYS,
+		StencilAction	backFaceStencilFail = STENCIL_KEEP,
+		StencilAction	backFaceStencilPass = STENCIL_KEEP,
+		StencilAction	backFaceDepthFail = STENCIL_KEEP,
+		int				backFaceRef = 0,
+		unsigned int	backFaceReadMask = 0xFFFFFFFF,
+		unsigned int	backFaceWriteMask = 0xFFFFFFFF) override;
+
+	void DestroyDepthStencilState(DepthStencilState *depthStencilState) override;
+
+	void SetDepthStencilState(DepthStencilState *depthStencilState) override;
+
+	void Clear(float red = 0.0f, float green = 0.0f, float blue = 0.0f, float alpha = 1.0f, float depth = 1.0f, int stencil = 0) override;
+
+	void DrawTriangles(int offset, int count) override;
+
+	void DrawTrianglesIndexed32(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16(long long offset, int count, int baseVertex = 0) override;
+
+	void DrawTrianglesInstanced(int offset, int count, int instanceCount) override;
+
+	void DrawTrianglesIndexed32Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesIndexed16Instanced(long long offset, int count, int instanceCount, int baseVertex = 0) override;
+
+	void DrawTrianglesMulti(int drawCount, const int *offsets, const int *counts) override;
+
+	void DrawTrianglesIndexedMulti(int drawCount, const long long *offsets, const int *counts, const int *baseVertices = nullptr,
+		IndexFormat format = INDEXFORMAT_32) override;
+
+	void DrawTrianglesIndexedIndirect(IndirectBuffer *indirectBuffer, long long offset, int drawCount = 1, IndexFormat format = INDEXFORMAT_32) override;
+
+	void SubmitCommandLists(unsigned int numCommandLists, CommandList **commandLists) override;
+
+	void EndFrame() override;
+
+	void BeginGpuScope(const char *name) override;
+
+	void EndGpuScope() override;
+
+	unsigned int GetGpuScopeStats(unsigned int maxScopes, GpuScopeStats *stats) override;
+
+	void ResetGpuScopeStats() override;
+
+	// Start recording a call; arguments are appended with the Write functions
+	void BeginCall(uint32_t type);
+
+	// Finish the call started by BeginCall
+	void EndCall();
+
+	// Append a fixed-size argument
+	template<class T> void Write(const T &value) { WriteBytes(&value, sizeof(value)); }
+
+	// Append raw bytes, padded to 4 bytes
+	void WriteBytes(const void *data, size_t size);
+
+	// Append a null-terminated string
+	void WriteString(const char *string);
+
+	// Append a sized blob; a null data pointer or a size below 1 is recorded as an empty blob
+	void WriteBlob(const void *data, long long size);
+
+	// Record a call of type with the range of a buffer written through a mapping
+	void RecordMapping(uint32_t type, uint32_t id, long long offset, long long size, unsigned int mapFlags, const void *mapping);
+
+	// Returns a new, never before used resource id
+	uint32_t NewId() { return m_NextId++; }
+
+private:
+
+	// Write the chunk buffered so far to the file
+	void FlushChunk();
+
+	RenderDevice *m_RenderDevice;
+	FILE *m_File;
+
+	std::vector<char> m_Chunk;
+	uint32_t m_ChunkCalls = 0;
+	size_t m_CallStart = 0;
+
+	uint32_t m_NextId = 1;
+
+	// wrappers of the device's transient buffers, created the first time each is handed out
+	VertexBuffer *m_TransientVertexBuffer = nullptr;
+	IndexBuffer *m_TransientIndexBuffer = nullptr;
+};
+
+} // end namespace render
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+
+namespace render
+{
+
+// Binary trace of RenderDevice calls, written by CaptureRenderDevice and read by
+// TraceReplay. Values are stored in the byte order of the capturing machine.
+//
+// A trace is a TraceFileHeader followed by any number of chunks. Each chunk is a
+// TraceChunkHeader followed by its calls back to back; each call is a TraceCallHeader
+// followed by its arguments. Every size is a multiple of 4 bytes, so float and int
+// arrays in a memory-mapped trace can be passed to the device in place.
+//
+// Resources are referred to by ids, which are assigned in creation order starting at
+// 1 and never reused; id 0 stands for a null pointer.
+
+const uint32_t TRACE_MAGIC = 0x43525452; // "RTRC"
+const uint32_t TRACE_CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct TraceChunkHeader
+{
+	uint32_t magic;
+	uint32_t numCalls;
+	uint64_t size; // bytes of calls following this header
+};
+
+struct TraceCallHeader
+{
+	uint32_t type; // TraceCallType
+	uint32_t size; // bytes of arguments following this header
+};
+
+// Recorded calls; the arguments of each are listed in the order they are stored.
+// Strings are stored as a uint32 length including the terminating null, then the
+// characters padded to 4 bytes. Blobs are stored as a uint64 size (0 for a null
+// pointer), then the bytes padded to 4 bytes.
+enum TraceCallType
+{
+	TRACECALL_CREATE_VERTEX_SHADER = 0, // id, code string
+	TRACECALL_DESTROY_VERTEX_SHADER, // id
+	TRACECALL_CREATE_PIXEL_SHADER, // id, code string
+	TRACECALL_DESTROY_PIXEL_SHADER, // id
+	TRACECALL_CREATE_PIPELINE, // id, vertex shader id, pixel shader id
+	TRACECALL_DESTROY_PIPELINE, // id
+	TRACECALL_SET_PIPELINE, // id
+	TRACECALL_GET_PARAM, // param id (0 if not found), pipeline id, name string
+	TRACECALL_SET_PARAM_INT, // param id, int32
+	TRACECALL_SET_PARAM_FLOAT, // param id, float
+	TRACECALL_SET_PARAM_MAT4, // param id, 16 floats
+	TRACECALL_SET_PARAM_INT_ARRAY, // param id, int32 count, count int32s
+	TRACECALL_SET_PARAM_FLOAT_ARRAY, // param id, int32 count, count floats
+	TRACECALL_SET_PARAM_MAT4_ARRAY, // param id, int32 count, count * 16 floats
+	TRACECALL_CREATE_VERTEX_BUFFER, // id, int64 size, data blob; replayed from older traces only
+	TRACECALL_DESTROY_VERTEX_BUFFER, // id
+	TRACECALL_CREATE_VERTEX_DESCRIPTION, // id, uint32 count, count TraceVertexElements
+	TRACECALL_DESTROY_VERTEX_DESCRIPTION, // id
+	TRACECALL_CREATE_VERTEX_ARRAY, // id, uint32 count, count vertex buffer ids, count vertex description ids
+	TRACECALL_DESTROY_VERTEX_ARRAY, // id
+	TRACECALL_SET_VERTEX_ARRAY, // id
+	TRACECALL_CREATE_INDEX_BUFFER, // id, int64 size, data blob; replayed from older traces only
+	TRACECALL_DESTROY_INDEX_BUFFER, // id
+	TRACECALL_SET_INDEX_BUFFER, // id
+	TRACECALL_CREATE_TEXTURE2D, // id, int32 width, int32 height, RGBX8 data blob; replayed from older traces only
+	TRACECALL_DESTROY_TEXTURE2D, // id
+	TRACECALL_SET_TEXTURE2D, // uint32 slot, id
+	TRACECALL_CREATE_RASTER_STATE, // id, TraceRasterState
+	TRACECALL_DESTROY_RASTER_STATE, // id
+	TRACECALL_SET_RASTER_STATE, // id
+	TRACECALL_CREATE_DEPTH_STENCIL_STATE, // id, TraceDepthStencilState
+	TRACECALL_DESTROY_DEPTH_STENCIL_STATE, // id
+	TRACECALL_SET_DEPTH_STENCIL_STATE, // id
+	TRACECALL_CLEAR, // 4 floats color, float depth, int32 stencil
+	TRACECALL_DRAW_TRIANGLES, // int32 offset, int32 count
+	TRACECALL_DRAW_TRIANGLES_INDEXED32, // int64 offset, int32 count
+	TRACECALL_END_FRAME, // no arguments
+	TRACECALL_BEGIN_GPU_SCOPE, // name string
+	TRACECALL_END_GPU_SCOPE, // no arguments
+	TRACECALL_SET_UNIFORM_BLOCK_SLOT, // pipeline id, uint32 slot, name string
+	TRACECALL_CREATE_UNIFORM_BUFFER, // id, int64 size, data blob; replayed from older traces only
+	TRACECALL_DESTROY_UNIFORM_BUFFER, // id
+	TRACECALL_SET_UNIFORM_BUFFER, // uint32 slot, id
+	TRACECALL_WRITE_UNIFORM_DATA, // int64 offset returned when recorded, data blob
+	TRACECALL_SET_UNIFORM_DATA, // uint32 slot, int64 offset as recorded, int64 size
+	TRACECALL_CREATE_SAMPLER_STATE, // id, TraceSamplerState
+	TRACECALL_DESTROY_SAMPLER_STATE, // id
+	TRACECALL_SET_SAMPLER_STATE, // uint32 slot, id
+	TRACECALL_CREATE_TEXTURE2D_FORMAT, // id, int32 width, int32 height, uint32 format, int32 mip levels, uint32 mip policy, data blob
+	TRACECALL_UPDATE_TEXTURE2D, // id, int32 mip level, int32 x, int32 y, int32 width, int32 height, uint32 async, data blob
+	TRACECALL_CREATE_TEXTURE2D_ARRAY, // id, int32 width, int32 height, int32 layers, uint32 format, int32 mip levels, uint32 mip policy
+	TRACECALL_DESTROY_TEXTURE2D_ARRAY, // id
+	TRACECALL_UPLOAD_TEXTURE2D_ARRAY_LAYER, // id, int32 layer, uint32 async, data blob
+	TRACECALL_UPDATE_TEXTURE2D_ARRAY, // id, int32 layer, int32 mip level, int32 x, int32 y, int32 width, int32 height, uint32 async, data blob
+	TRACECALL_SET_TEXTURE2D_ARRAY, // uint32 slot, id
+	TRACECALL_CREATE_VERTEX_BUFFER_USAGE, // id, int64 size, uint32 usage, data blob
+	TRACECALL_UPDATE_VERTEX_BUFFER, // id, int64 offset, int64 size, data blob
+	TRACECALL_MAP_VERTEX_BUFFER, // id, int64 offset, int64 size, uint32 map flags, blob of the mapped range; recorded when unmapped
+	TRACECALL_CREATE_INDEX_BUFFER_USAGE, // id, int64 size, uint32 usage, data blob
+	TRACECALL_UPDATE_INDEX_BUFFER, // id, int64 offset, int64 size, data blob
+	TRACECALL_MAP_INDEX_BUFFER, // id, int64 offset, int64 size, uint32 map flags, blob of the mapped range; recorded when unmapped
+	TRACECALL_CREATE_UNIFORM_BUFFER_USAGE, // id, int64 size, uint32 usage, data blob
+	TRACECALL_UPDATE_UNIFORM_BUFFER, // id, int64 offset, int64 size, data blob
+	TRACECALL_MAP_UNIFORM_BUFFER, // id, int64 offset, int64 size, uint32 map flags, blob of the mapped range; recorded when unmapped
+	TRACECALL_WRITE_TRANSIENT_VERTICES, // vertex buffer id (0 if the write failed), int32 count, int32 stride, int32 first vertex returned when recorded, data blob
+	TRACECALL_WRITE_TRANSIENT_INDICES, // index buffer id (0 if the write failed), int32 count, int32 base vertex, int64 offset returned when recorded, blob of the indices as passed
+	TRACECALL_DRAW_TRIANGLES_INDEXED32_BASE_VERTEX, // int64 offset, int32 count, int32 base vertex; draws without a base vertex are recorded as DRAW_TRIANGLES_INDEXED32
+	TRACECALL_COPY_VERTEX_BUFFER, // destination id, int64 destination offset, source id, int64 source offset, int64 size
+	TRACECALL_COPY_INDEX_BUFFER, // destination id, int64 destination offset, source id, int64 source offset, int64 size
+	TRACECALL_CREATE_INDEX_BUFFER_FORMAT, // id, int64 size, uint32 usage, uint32 index format, data blob; 32-bit index buffers are recorded as CREATE_INDEX_BUFFER_USAGE
+	TRACECALL_DRAW_TRIANGLES_INDEXED16, // int64 offset, int32 count, int32 base vertex
+	TRACECALL_CREATE_VERTEX_DESCRIPTION_DIVISORS, // id, uint32 count, count TraceVertexElements, count uint32 divisors; descriptions without divisors are recorded as CREATE_VERTEX_DESCRIPTION
+	TRACECALL_DRAW_TRIANGLES_INSTANCED, // int32 offset, int32 count, int32 instance count
+	TRACECALL_DRAW_TRIANGLES_INDEXED32_INSTANCED, // int64 offset, int32 count, int32 instance count, int32 base vertex
+	TRACECALL_DRAW_TRIANGLES_INDEXED16_INSTANCED, // int64 offset, int32 count, int32 instance count, int32 base vertex
+	TRACECALL_DRAW_TRIANGLES_MULTI, // int32 draw count, draw count int32 offsets, draw count int32 counts
+	TRACECALL_DRAW_TRIANGLES_INDEXED_MULTI, // uint32 index format, int32 draw count, draw count int64 offsets, draw count int32 counts, draw count int32 base vertices
+	TRACECALL_CREATE_INDIRECT_BUFFER, // id, int64 size, uint32 usage, data blob
+	TRACECALL_UPDATE_INDIRECT_BUFFER, // id, int64 offset, int64 size, data blob
+	TRACECALL_COPY_INDIRECT_BUFFER, // destination id, int64 destination offset, source vertex buffer id, int64 source offset, int64 size
+	TRACECALL_DESTROY_INDIRECT_BUFFER, // id
+	TRACECALL_DRAW_TRIANGLES_INDEXED_INDIRECT, // id, int64 offset, int32 draw count, uint32 index format; the arguments are replayed as recorded, unlike the offsets of direct draws from transient buffers
+	TRACECALL_SET_PRIMITIVE_TOPOLOGY, // uint32 topology
+	TRACECALL_MAX
+};
+
+// VertexElement with fixed-size fields
+struct TraceVertexElement
+{
+	uint32_t index;
+	uint32_t type;
+	int32_t size;
+	int32_t stride;
+	int64_t offset;
+};
+
+struct TraceRasterState
+{
+	uint32_t cullEnabled;
+	uint32_t frontFace;
+	uint32_t cullFace;
+	uint32_t rasterMode;
+};
+
+struct TraceSamplerState
+{
+	uint32_t minFilter;
+	uint32_t magFilter;
+	uint32_t mipFilter;
+	uint32_t wrapS;
+	uint32_t wrapT;
+};
+
+struct TraceStencilFace
+{
+	uint32_t enabled;
+	uint32_t compare;
+	uint32_t fail;
+	uint32_t pass;
+	uint32_t depthFail;
+	int32_t ref;
+	uint32_t readMask;
+	uint32_t writeMask;
+};
+
+struct TraceDepthStencilState
+{
+	uint32_t depthEnabled;
+	uint32_t depthWriteEnabled;
+	float depthNear;
+	float depthFar;
+	uint32_t depthCompare;
+	TraceStencilFace front;
+	TraceStencilFace back;
+};
+
+} // end namespace render
@@ -0,0 +1,1063 @@
+#include "render_device/trace.h"
+
+#include "trace_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace render
+{
+
+// Decodes the arguments of a call in place; see trace_format.h for the layout
+class TraceReader
+{
+public:
+
+	explicit TraceReader(const char *args) : m_Args(args) {}
+
+	template<class T> T Read()
+	{
+		T value;
+		memcpy(&value, m_Args, sizeof(value));
+		m_Args += (sizeof(value) + 3) & ~size_t(3);
+		return value;
+	}
+
+	// Returns a pointer to size bytes of inline data and skips over them
+	const void *ReadBytes(size_t size)
+	{
+		const char *data = m_Args;
+		m_Args += (size + 3) & ~size_t(3);
+		return data;
+	}
+
+	const char *ReadString()
+	{
+		uint32_t length = Read<uint32_t>();
+		return static_cast<const char *>(ReadBytes(length));
+	}
+
+	// Returns nullptr for an empty blob
+	const void *ReadBlob()
+	{
+		uint64_t size = Read<uint64_t>();
+		return size ? ReadBytes(static_cast<size_t>(size)) : nullptr;
+	}
+
+private:
+
+	const char *m_Args;
+};
+
+TraceReplay::TraceReplay(RenderDevice *renderDevice) : m_RenderDevice(renderDevice)
+{
+}
+
+TraceReplay::~TraceReplay()
+{
+	Close();
+}
+
+bool TraceReplay::Open(const char *path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if(GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		{
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if(mapping)
+			{
+				m_Data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				if(m_Data)
+				{
+					m_Size = static_cast<size_t>(size.QuadPart);
+					m_Mapping = mapping;
+				}
+				else
+					CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	int file = open(path, O_RDONLY);
+	if(file >= 0)
+	{
+		struct stat status;
+		if(fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			void *data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if(data != MAP_FAILED)
+			{
+				// calls are read front to back
+				madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+				m_Data = static_cast<const char *>(data);
+				m_Size = static_cast<size_t>(status.st_size);
+			}
+		}
+		close(file);
+	}
+#endif
+
+	if(!m_Data)
+	{
+		std::cout << "ERROR::TRACE::FILE_OPEN_FAILED\n" << path << std::endl;
+		return false;
+	}
+
+	TraceFileHeader header;
+	if(m_Size < sizeof(header))
+		memset(&header, 0, sizeof(header));
+	else
+		memcpy(&header, m_Data, sizeof(header));
+
+	if(header.magic != TRACE_MAGIC || header.version != TRACE_VERSION)
+	{
+		std::cout << "ERROR::TRACE::INVALID_FILE\n" << path << std::endl;
+		Close();
+		return false;
+	}
+
+	m_NumCalls = 0;
+	Rewind();
+
+	// find out up front how frames are delimited by walking the call headers
+	m_HasEndFrames = false;
+	while(!m_HasEndFrames && (m_Cursor != m_ChunkEnd || NextChunk()))
+	{
+		TraceCallHeader call;
+		if(static_cast<size_t>(m_ChunkEnd - m_Cursor) < sizeof(call))
+			break;
+		memcpy(&call, m_Cursor, sizeof(call));
+		if(call.size > static_cast<size_t>(m_ChunkEnd - m_Cursor) - sizeof(call))
+			break;
+		m_HasEndFrames = call.type == TRACECALL_END_FRAME;
+		m_Cursor += sizeof(call) + call.size;
+	}
+	Rewind();
+
+	return true;
+}
+
+void TraceReplay::Close()
+{
+	DestroyObjects();
+
+	if(!m_Data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+	CloseHandle(static_cast<HANDLE>(m_Mapping));
+#else
+	munmap(const_cast<char *>(m_Data), m_Size);
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Mapping = nullptr;
+	m_Cursor = m_ChunkEnd = nullptr;
+}
+
+void TraceReplay::Rewind()
+{
+	DestroyObjects();
+
+	// the topology is not an object, so replaying again from the start must reset it to a new device's
+	m_RenderDevice->SetPrimitiveTopology(PRIMITIVETOPOLOGY_TRIANGLE_LIST);
+
+	if(m_Data)
+		m_Cursor = m_ChunkEnd = m_Data + sizeof(TraceFileHeader);
+	m_FrameHasDraws = false;
+}
+
+bool TraceReplay::NextChunk()
+{
+	const char *end = m_Data + m_Size;
+
+	TraceChunkHeader header;
+	if(static_cast<size_t>(end - m_Cursor) < sizeof(header))
+		return false;
+
+	memcpy(&header, m_Cursor, sizeof(header));
+	if(header.magic != TRACE_CHUNK_MAGIC || header.size > static_cast<uint64_t>(end - m_Cursor) - sizeof(header))
+	{
+		std::cout << "ERROR::TRACE::CORRUPT_CHUNK\n" << "at byte " << (m_Cursor - m_Data) << std::endl;
+		m_Cursor = m_ChunkEnd = end;
+		return false;
+	}
+
+	m_Cursor += sizeof(header);
+	m_ChunkEnd = m_Cursor + header.size;
+	return true;
+}
+
+bool TraceReplay::ReplayFrame()
+{
+	if(!m_Data)
+		return false;
+
+	bool replayed = false;
+	for(;;)
+	{
+		if(m_Cursor == m_ChunkEnd && !NextChunk())
+		{
+			// calls after the last EndFrame, such as resource destruction, do not make a frame
+			if(m_HasEndFrames)
+				return false;
+			if(replayed)
+				m_RenderDevice->EndFrame();
+			return replayed;
+		}
+
+		// the header must fit in the chunk before it is read, which also keeps the size check from wrapping around
+		TraceCallHeader header;
+		size_t remaining = static_cast<size_t>(m_ChunkEnd - m_Cursor);
+		bool fits = remaining >= sizeof(header);
+		if(fits)
+			memcpy(&header, m_Cursor, sizeof(header));
+		if(!fits || header.size > remaining - sizeof(header))
+		{
+			std::cout << "ERROR::TRACE::CORRUPT_CALL\n" << "at byte " << (m_Cursor - m_Data) << std::endl;
+			m_Cursor = m_ChunkEnd = m_Data + m_Size;
+			return replayed;
+		}
+
+		// without EndFrame calls in the trace, a clear after the frame has drawn something starts the next frame
+		if(header.type == TRACECALL_CLEAR && m_FrameHasDraws && !m_HasEndFrames)
+		{
+			m_RenderDevice->EndFrame();
+			m_FrameHasDraws = false;
+			return true;
+		}
+
+		ReplayCall(header.type, m_Cursor + sizeof(header));
+		m_Cursor += sizeof(header) + header.size;
+		m_NumCalls++;
+		replayed = true;
+
+		if(header.type == TRACECALL_END_FRAME)
+		{
+			m_FrameHasDraws = false;
+			return true;
+		}
+	}
+}
+
+template<class T>
+T *TraceReplay::GetObject(unsigned int id) const
+{
+	return id < m_Objects.size() ? static_cast<T *>(m_Objects[id].object) : nullptr;
+}
+
+void TraceReplay::SetObject(unsigned int id, unsigned int type, void *object)
+{
+	if(id >= m_Objects.size())
+		m_Objects.resize(id + 1, Object{ TRACECALL_MAX, nullptr, false });
+	m_Objects[id].type = type;
+	m_Objects[id].object = object;
+	m_Objects[id].transient = false;
+}
+
+long long TraceReplay::RemapFirstVertex(long long firstVertex) const
+{
+	if(!m_TransientVerticesBound)
+		return firstVertex;
+	auto iter = m_TransientVertexOffsets.find(firstVertex);
+	return iter != m_TransientVertexOffsets.end() ? iter->second : firstVertex;
+}
+
+long long TraceReplay::RemapIndexOffset(long long offset) const
+{
+	if(!m_TransientIndicesBound)
+		return offset;
+	auto iter = m_TransientIndexOffsets.find(offset);
+	return iter != m_TransientIndexOffsets.end() ? iter->second : offset;
+}
+
+void TraceReplay::ReplayCall(unsigned int type, const char *args)
+{
+	TraceReader reader(args);
+	RenderDevice *device = m_RenderDevice;
+
+	switch(type)
+	{
+	case TRACECALL_CREATE_VERTEX_SHADER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		SetObject(id, type, device->CreateVertexShader(reader.ReadString()));
+		break;
+	}
+	case TRACECALL_DESTROY_VERTEX_SHADER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyVertexShader(GetObject<VertexShader>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_CREATE_PIXEL_SHADER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		SetObject(id, type, device->CreatePixelShader(reader.ReadString()));
+		break;
+	}
+	case TRACECALL_DESTROY_PIXEL_SHADER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyPixelShader(GetObject<PixelShader>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_CREATE_PIPELINE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		VertexShader *vertexShader = GetObject<VertexShader>(reader.Read<uint32_t>());
+		PixelShader *pixelShader = GetObject<PixelShader>(reader.Read<uint32_t>());
+		SetObject(id, type, device->CreatePipeline(vertexShader, pixelShader));
+		break;
+	}
+	case TRACECALL_DESTROY_PIPELINE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyPipeline(GetObject<Pipeline>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_PIPELINE:
+		device->SetPipeline(GetObject<Pipeline>(reader.Read<uint32_t>()));
+		break;
+	case TRACECALL_GET_PARAM:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		Pipeline *pipeline = GetObject<Pipeline>(reader.Read<uint32_t>());
+		const char *name = reader.ReadString();
+		PipelineParam *param = pipeline ? pipeline->GetParam(name) : nullptr;
+		if(id)
+			SetObject(id, type, param);
+		break;
+	}
+	case TRACECALL_SET_PARAM_INT:
+	{
+		PipelineParam *param = GetObject<PipelineParam>(reader.Read<uint32_t>());
+		int32_t value = reader.Read<int32_t>();
+		if(param)
+			param->SetAsInt(value);
+		break;
+	}
+	case TRACECALL_SET_PARAM_FLOAT:
+	{
+		PipelineParam *param = GetObject<PipelineParam>(reader.Read<uint32_t>());
+		float value = reader.Read<float>();
+		if(param)
+			param->SetAsFloat(value);
+		break;
+	}
+	case TRACECALL_SET_PARAM_MAT4:
+	{
+		PipelineParam *param = GetObject<PipelineParam>(reader.Read<uint32_t>());
+		const float *value = static_cast<const float *>(reader.ReadBytes(16 * sizeof(float)));
+		if(param)
+			param->SetAsMat4(value);
+		break;
+	}
+	case TRACECALL_SET_PARAM_INT_ARRAY:
+	case TRACECALL_SET_PARAM_FLOAT_ARRAY:
+	case TRACECALL_SET_PARAM_MAT4_ARRAY:
+	{
+		PipelineParam *param = GetObject<PipelineParam>(reader.Read<uint32_t>());
+		int32_t count = reader.Read<int32_t>();
+		const void *values = reader.ReadBytes(0);
+		if(!param)
+			break;
+		if(type == TRACECALL_SET_PARAM_INT_ARRAY)
+			param->SetAsIntArray(count, static_cast<const int *>(values));
+		else if(type == TRACECALL_SET_PARAM_FLOAT_ARRAY)
+			param->SetAsFloatArray(count, static_cast<const float *>(values));
+		else
+			param->SetAsMat4Array(count, static_cast<const float *>(values));
+		break;
+	}
+	case TRACECALL_CREATE_VERTEX_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		SetObject(id, type, device->CreateVertexBuffer(size, reader.ReadBlob()));
+		break;
+	}
+	case TRACECALL_CREATE_VERTEX_BUFFER_USAGE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		BufferUsage usage = static_cast<BufferUsage>(reader.Read<uint32_t>());
+		SetObject(id, TRACECALL_CREATE_VERTEX_BUFFER, device->CreateVertexBuffer(size, reader.ReadBlob(), usage));
+		break;
+	}
+	case TRACECALL_UPDATE_VERTEX_BUFFER:
+	{
+		VertexBuffer *buffer = GetObject<VertexBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->UpdateVertexBuffer(buffer, offset, size, reader.ReadBlob());
+		break;
+	}
+	case TRACECALL_COPY_VERTEX_BUFFER:
+	{
+		VertexBuffer *destination = GetObject<VertexBuffer>(reader.Read<uint32_t>());
+		int64_t destinationOffset = reader.Read<int64_t>();
+		VertexBuffer *source = GetObject<VertexBuffer>(reader.Read<uint32_t>());
+		int64_t sourceOffset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->CopyVertexBuffer(destination, destinationOffset, source, sourceOffset, size);
+		break;
+	}
+	case TRACECALL_MAP_VERTEX_BUFFER:
+	{
+		VertexBuffer *buffer = GetObject<VertexBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		uint32_t mapFlags = reader.Read<uint32_t>();
+		const void *data = reader.ReadBlob();
+		void *mapping = device->MapVertexBuffer(buffer, offset, size, mapFlags);
+		if(!mapping)
+			break;
+		if(data)
+			memcpy(mapping, data, static_cast<size_t>(size));
+		device->UnmapVertexBuffer(buffer);
+		break;
+	}
+	case TRACECALL_DESTROY_VERTEX_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyVertexBuffer(GetObject<VertexBuffer>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_CREATE_VERTEX_DESCRIPTION:
+	case TRACECALL_CREATE_VERTEX_DESCRIPTION_DIVISORS:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		uint32_t numVertexElements = reader.Read<uint32_t>();
+		m_VertexElements.resize(numVertexElements);
+		for(uint32_t i = 0; i < numVertexElements; i++)
+		{
+			TraceVertexElement element = reader.Read<TraceVertexElement>();
+			m_VertexElements[i].index = element.index;
+			m_VertexElements[i].type = static_cast<VertexElementType>(element.type);
+			m_VertexElements[i].size = element.size;
+			m_VertexElements[i].stride = element.stride;
+			m_VertexElements[i].offset = element.offset;
+			m_VertexElements[i].divisor = 0;
+		}
+		if(type == TRACECALL_CREATE_VERTEX_DESCRIPTION_DIVISORS)
+			for(uint32_t i = 0; i < numVertexElements; i++)
+				m_VertexElements[i].divisor = reader.Read<uint32_t>();
+		SetObject(id, TRACECALL_CREATE_VERTEX_DESCRIPTION, device->CreateVertexDescription(numVertexElements, m_VertexElements.data()));
+		break;
+	}
+	case TRACECALL_DESTROY_VERTEX_DESCRIPTION:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyVertexDescription(GetObject<VertexDescription>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_CREATE_VERTEX_ARRAY:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		uint32_t numVertexBuffers = reader.Read<uint32_t>();
+		m_VertexBuffers.resize(numVertexBuffers);
+		m_VertexDescriptions.resize(numVertexBuffers);
+		bool transient = false;
+		for(uint32_t i = 0; i < numVertexBuffers; i++)
+		{
+			uint32_t vertexBuffer = reader.Read<uint32_t>();
+			m_VertexBuffers[i] = GetObject<VertexBuffer>(vertexBuffer);
+			transient = transient || (vertexBuffer < m_Objects.size() && m_Objects[vertexBuffer].transient);
+		}
+		for(uint32_t i = 0; i < numVertexBuffers; i++)
+			m_VertexDescriptions[i] = GetObject<VertexDescription>(reader.Read<uint32_t>());
+		SetObject(id, type, device->CreateVertexArray(numVertexBuffers, m_VertexBuffers.data(), m_VertexDescriptions.data()));
+		m_Objects[id].transient = transient;
+		break;
+	}
+	case TRACECALL_DESTROY_VERTEX_ARRAY:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyVertexArray(GetObject<VertexArray>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_VERTEX_ARRAY:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		m_TransientVerticesBound = id < m_Objects.size() && m_Objects[id].transient;
+		device->SetVertexArray(GetObject<VertexArray>(id));
+		break;
+	}
+	case TRACECALL_CREATE_INDEX_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		SetObject(id, type, device->CreateIndexBuffer(size, reader.ReadBlob()));
+		break;
+	}
+	case TRACECALL_CREATE_INDEX_BUFFER_USAGE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		BufferUsage usage = static_cast<BufferUsage>(reader.Read<uint32_t>());
+		SetObject(id, TRACECALL_CREATE_INDEX_BUFFER, device->CreateIndexBuffer(size, reader.ReadBlob(), usage));
+		break;
+	}
+	case TRACECALL_CREATE_INDEX_BUFFER_FORMAT:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		BufferUsage usage = static_cast<BufferUsage>(reader.Read<uint32_t>());
+		IndexFormat format = static_cast<IndexFormat>(reader.Read<uint32_t>());
+		SetObject(id, TRACECALL_CREATE_INDEX_BUFFER, device->CreateIndexBuffer(size, reader.ReadBlob(), usage, format));
+		break;
+	}
+	case TRACECALL_UPDATE_INDEX_BUFFER:
+	{
+		IndexBuffer *buffer = GetObject<IndexBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->UpdateIndexBuffer(buffer, offset, size, reader.ReadBlob());
+		break;
+	}
+	case TRACECALL_COPY_INDEX_BUFFER:
+	{
+		IndexBuffer *destination = GetObject<IndexBuffer>(reader.Read<uint32_t>());
+		int64_t destinationOffset = reader.Read<int64_t>();
+		IndexBuffer *source = GetObject<IndexBuffer>(reader.Read<uint32_t>());
+		int64_t sourceOffset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->CopyIndexBuffer(destination, destinationOffset, source, sourceOffset, size);
+		break;
+	}
+	case TRACECALL_MAP_INDEX_BUFFER:
+	{
+		IndexBuffer *buffer = GetObject<IndexBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		uint32_t mapFlags = reader.Read<uint32_t>();
+		const void *data = reader.ReadBlob();
+		void *mapping = device->MapIndexBuffer(buffer, offset, size, mapFlags);
+		if(!mapping)
+			break;
+		if(data)
+			memcpy(mapping, data, static_cast<size_t>(size));
+		device->UnmapIndexBuffer(buffer);
+		break;
+	}
+	case TRACECALL_DESTROY_INDEX_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyIndexBuffer(GetObject<IndexBuffer>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_INDEX_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		m_TransientIndicesBound = id < m_Objects.size() && m_Objects[id].transient;
+		device->SetIndexBuffer(GetObject<IndexBuffer>(id));
+		break;
+	}
+	case TRACECALL_SET_PRIMITIVE_TOPOLOGY:
+		device->SetPrimitiveTopology(static_cast<PrimitiveTopology>(reader.Read<uint32_t>()));
+		break;
+	case TRACECALL_CREATE_INDIRECT_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		BufferUsage usage = static_cast<BufferUsage>(reader.Read<uint32_t>());
+		SetObject(id, type, device->CreateIndirectBuffer(size, reader.ReadBlob(), usage));
+		break;
+	}
+	case TRACECALL_UPDATE_INDIRECT_BUFFER:
+	{
+		IndirectBuffer *buffer = GetObject<IndirectBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->UpdateIndirectBuffer(buffer, offset, size, reader.ReadBlob());
+		break;
+	}
+	case TRACECALL_COPY_INDIRECT_BUFFER:
+	{
+		IndirectBuffer *destination = GetObject<IndirectBuffer>(reader.Read<uint32_t>());
+		int64_t destinationOffset = reader.Read<int64_t>();
+		VertexBuffer *source = GetObject<VertexBuffer>(reader.Read<uint32_t>());
+		int64_t sourceOffset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->CopyIndirectBuffer(destination, destinationOffset, source, sourceOffset, size);
+		break;
+	}
+	case TRACECALL_DESTROY_INDIRECT_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyIndirectBuffer(GetObject<IndirectBuffer>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_CREATE_TEXTURE2D:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int32_t width = reader.Read<int32_t>();
+		int32_t height = reader.Read<int32_t>();
+		SetObject(id, type, device->CreateTexture2D(width, height, reader.ReadBlob()));
+		break;
+	}
+	case TRACECALL_CREATE_TEXTURE2D_FORMAT:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int32_t width = reader.Read<int32_t>();
+		int32_t height = reader.Read<int32_t>();
+		TextureFormat format = static_cast<TextureFormat>(reader.Read<uint32_t>());
+		int32_t mipLevels = reader.Read<int32_t>();
+		MipPolicy mipPolicy = static_cast<MipPolicy>(reader.Read<uint32_t>());
+		SetObject(id, TRACECALL_CREATE_TEXTURE2D, device->CreateTexture2D(width, height, reader.ReadBlob(), format, mipLevels, mipPolicy));
+		break;
+	}
+	case TRACECALL_UPDATE_TEXTURE2D:
+	{
+		Texture2D *texture2D = GetObject<Texture2D>(reader.Read<uint32_t>());
+		int32_t mipLevel = reader.Read<int32_t>();
+		int32_t x = reader.Read<int32_t>();
+		int32_t y = reader.Read<int32_t>();
+		int32_t width = reader.Read<int32_t>();
+		int32_t height = reader.Read<int32_t>();
+		bool async = reader.Read<uint32_t>() != 0;
+		device->UpdateTexture2D(texture2D, mipLevel, x, y, width, height, reader.ReadBlob(), async);
+		break;
+	}
+	case TRACECALL_DESTROY_TEXTURE2D:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyTexture2D(GetObject<Texture2D>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_TEXTURE2D:
+	{
+		uint32_t slot = reader.Read<uint32_t>();
+		device->SetTexture2D(slot, GetObject<Texture2D>(reader.Read<uint32_t>()));
+		break;
+	}
+	case TRACECALL_CREATE_TEXTURE2D_ARRAY:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int32_t width = reader.Read<int32_t>();
+		int32_t height = reader.Read<int32_t>();
+		int32_t layers = reader.Read<int32_t>();
+		TextureFormat format = static_cast<TextureFormat>(reader.Read<uint32_t>());
+		int32_t mipLevels = reader.Read<int32_t>();
+		MipPolicy mipPolicy = static_cast<MipPolicy>(reader.Read<uint32_t>());
+		SetObject(id, type, device->CreateTexture2DArray(width, height, layers, format, mipLevels, mipPolicy));
+		break;
+	}
+	case TRACECALL_UPLOAD_TEXTURE2D_ARRAY_LAYER:
+	{
+		Texture2DArray *texture2DArray = GetObject<Texture2DArray>(reader.Read<uint32_t>());
+		int32_t layer = reader.Read<int32_t>();
+		bool async = reader.Read<uint32_t>() != 0;
+		device->UploadTexture2DArrayLayer(texture2DArray, layer, reader.ReadBlob(), async);
+		break;
+	}
+	case TRACECALL_UPDATE_TEXTURE2D_ARRAY:
+	{
+		Texture2DArray *texture2DArray = GetObject<Texture2DArray>(reader.Read<uint32_t>());
+		int32_t layer = reader.Read<int32_t>();
+		int32_t mipLevel = reader.Read<int32_t>();
+		int32_t x = reader.Read<int32_t>();
+		int32_t y = reader.Read<int32_t>();
+		int32_t width = reader.Read<int32_t>();
+		int32_t height = reader.Read<int32_t>();
+		bool async = reader.Read<uint32_t>() != 0;
+		device->UpdateTexture2DArray(texture2DArray, layer, mipLevel, x, y, width, height, reader.ReadBlob(), async);
+		break;
+	}
+	case TRACECALL_DESTROY_TEXTURE2D_ARRAY:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyTexture2DArray(GetObject<Texture2DArray>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_TEXTURE2D_ARRAY:
+	{
+		uint32_t slot = reader.Read<uint32_t>();
+		device->SetTexture2DArray(slot, GetObject<Texture2DArray>(reader.Read<uint32_t>()));
+		break;
+	}
+	case TRACECALL_SET_UNIFORM_BLOCK_SLOT:
+	{
+		Pipeline *pipeline = GetObject<Pipeline>(reader.Read<uint32_t>());
+		uint32_t slot = reader.Read<uint32_t>();
+		const char *name = reader.ReadString();
+		if(pipeline)
+			pipeline->SetUniformBlockSlot(name, slot);
+		break;
+	}
+	case TRACECALL_CREATE_UNIFORM_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		SetObject(id, type, device->CreateUniformBuffer(size, reader.ReadBlob()));
+		break;
+	}
+	case TRACECALL_CREATE_UNIFORM_BUFFER_USAGE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int64_t size = reader.Read<int64_t>();
+		BufferUsage usage = static_cast<BufferUsage>(reader.Read<uint32_t>());
+		SetObject(id, TRACECALL_CREATE_UNIFORM_BUFFER, device->CreateUniformBuffer(size, reader.ReadBlob(), usage));
+		break;
+	}
+	case TRACECALL_UPDATE_UNIFORM_BUFFER:
+	{
+		UniformBuffer *buffer = GetObject<UniformBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		device->UpdateUniformBuffer(buffer, offset, size, reader.ReadBlob());
+		break;
+	}
+	case TRACECALL_MAP_UNIFORM_BUFFER:
+	{
+		UniformBuffer *buffer = GetObject<UniformBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		uint32_t mapFlags = reader.Read<uint32_t>();
+		const void *data = reader.ReadBlob();
+		void *mapping = device->MapUniformBuffer(buffer, offset, size, mapFlags);
+		if(!mapping)
+			break;
+		if(data)
+			memcpy(mapping, data, static_cast<size_t>(size));
+		device->UnmapUniformBuffer(buffer);
+		break;
+	}
+	case TRACECALL_DESTROY_UNIFORM_BUFFER:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyUniformBuffer(GetObject<UniformBuffer>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_UNIFORM_BUFFER:
+	{
+		uint32_t slot = reader.Read<uint32_t>();
+		device->SetUniformBuffer(slot, GetObject<UniformBuffer>(reader.Read<uint32_t>()));
+		break;
+	}
+	case TRACECALL_WRITE_UNIFORM_DATA:
+	{
+		// the replaying device may place the data elsewhere, so later SetUniformData calls are remapped
+		int64_t recordedOffset = reader.Read<int64_t>();
+		uint64_t size = reader.Read<uint64_t>();
+		const void *data = reader.ReadBytes(static_cast<size_t>(size));
+		long long offset = size ? device->WriteUniformData(data, static_cast<long long>(size)) : -1;
+		if(recordedOffset >= 0)
+			m_UniformDataOffsets[recordedOffset] = offset;
+		break;
+	}
+	case TRACECALL_SET_UNIFORM_DATA:
+	{
+		uint32_t slot = reader.Read<uint32_t>();
+		int64_t recordedOffset = reader.Read<int64_t>();
+		int64_t size = reader.Read<int64_t>();
+		auto iter = m_UniformDataOffsets.find(recordedOffset);
+		device->SetUniformData(slot, iter != m_UniformDataOffsets.end() ? iter->second : -1, size);
+		break;
+	}
+	case TRACECALL_WRITE_TRANSIENT_VERTICES:
+	{
+		// the replaying device may place the vertices elsewhere, so later draws from them are remapped
+		uint32_t id = reader.Read<uint32_t>();
+		int32_t count = reader.Read<int32_t>();
+		int32_t stride = reader.Read<int32_t>();
+		int32_t recordedFirstVertex = reader.Read<int32_t>();
+		const void *data = reader.ReadBlob();
+		if(!id || !data)
+			break;
+		TransientVertices vertices = device->WriteTransientVertices(data, count, stride);
+		SetObject(id, type, vertices.vertexBuffer);
+		m_Objects[id].transient = true;
+		m_TransientVertexOffsets[recordedFirstVertex] = vertices.firstVertex;
+		break;
+	}
+	case TRACECALL_WRITE_TRANSIENT_INDICES:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		int32_t count = reader.Read<int32_t>();
+		int32_t baseVertex = reader.Read<int32_t>();
+		int64_t recordedOffset = reader.Read<int64_t>();
+		const unsigned int *indices = static_cast<const unsigned int *>(reader.ReadBlob());
+		if(!id || !indices)
+			break;
+
+		// a base of transient vertices is moved with them
+		auto iter = m_TransientVertexOffsets.find(baseVertex);
+		if(iter != m_TransientVertexOffsets.end())
+			baseVertex = static_cast<int32_t>(iter->second);
+
+		TransientIndices transientIndices = device->WriteTransientIndices(indices, count, baseVertex);
+		SetObject(id, type, transientIndices.indexBuffer);
+		m_Objects[id].transient = true;
+		m_TransientIndexOffsets[recordedOffset] = transientIndices.offset;
+		break;
+	}
+	case TRACECALL_CREATE_SAMPLER_STATE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		TraceSamplerState state = reader.Read<TraceSamplerState>();
+		SetObject(id, type, device->CreateSamplerState(static_cast<TextureFilter>(state.minFilter), static_cast<TextureFilter>(state.magFilter),
+			static_cast<MipFilter>(state.mipFilter), static_cast<TextureWrap>(state.wrapS), static_cast<TextureWrap>(state.wrapT)));
+		break;
+	}
+	case TRACECALL_DESTROY_SAMPLER_STATE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroySamplerState(GetObject<SamplerState>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_SAMPLER_STATE:
+	{
+		uint32_t slot = reader.Read<uint32_t>();
+		device->SetSamplerState(slot, GetObject<SamplerState>(reader.Read<uint32_t>()));
+		break;
+	}
+	case TRACECALL_CREATE_RASTER_STATE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		TraceRasterState state = reader.Read<TraceRasterState>();
+		SetObject(id, type, device->CreateRasterState(state.cullEnabled != 0, static_cast<Winding>(state.frontFace),
+			static_cast<Face>(state.cullFace), static_cast<RasterMode>(state.rasterMode)));
+		break;
+	}
+	case TRACECALL_DESTROY_RASTER_STATE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyRasterState(GetObject<RasterState>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_RASTER_STATE:
+		device->SetRasterState(GetObject<RasterState>(reader.Read<uint32_t>()));
+		break;
+	case TRACECALL_CREATE_DEPTH_STENCIL_STATE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		TraceDepthStencilState state = reader.Read<TraceDepthStencilState>();
+		SetObject(id, type, device->CreateDepthStencilState(state.depthEnabled != 0, state.depthWriteEnabled != 0,
+			state.depthNear, state.depthFar, static_cast<Compare>(state.depthCompare),
+			state.front.enabled != 0, static_cast<Compare>(state.front.compare), static_cast<StencilAction>(state.front.fail),
+			static_cast<StencilAction>(state.front.pass), static_cast<StencilAction>(state.front.depthFail),
+			state.front.ref, state.front.readMask, state.front.writeMask,
+			state.back.enabled != 0, static_cast<Compare>(state.back.compare), static_cast<StencilAction>(state.back.fail),
+			static_cast<StencilAction>(state.back.pass), static_cast<StencilAction>(state.back.depthFail),
+			state.back.ref, state.back.readMask, state.back.writeMask));
+		break;
+	}
+	case TRACECALL_DESTROY_DEPTH_STENCIL_STATE:
+	{
+		uint32_t id = reader.Read<uint32_t>();
+		device->DestroyDepthStencilState(GetObject<DepthStencilState>(id));
+		SetObject(id, TRACECALL_MAX, nullptr);
+		break;
+	}
+	case TRACECALL_SET_DEPTH_STENCIL_STATE:
+		device->SetDepthStencilState(GetObject<DepthStencilState>(reader.Read<uint32_t>()));
+		break;
+	case TRACECALL_CLEAR:
+	{
+		float red = reader.Read<float>();
+		float green = reader.Read<float>();
+		float blue = reader.Read<float>();
+		float alpha = reader.Read<float>();
+		float depth = reader.Read<float>();
+		int32_t stencil = reader.Read<int32_t>();
+		device->Clear(red, green, blue, alpha, depth, stencil);
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES:
+	{
+		int32_t offset = reader.Read<int32_t>();
+		int32_t count = reader.Read<int32_t>();
+		offset = static_cast<int32_t>(RemapFirstVertex(offset));
+		device->DrawTriangles(offset, count);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INDEXED32:
+	{
+		int64_t offset = reader.Read<int64_t>();
+		int32_t count = reader.Read<int32_t>();
+		offset = RemapIndexOffset(offset);
+		device->DrawTrianglesIndexed32(offset, count);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INDEXED32_BASE_VERTEX:
+	{
+		int64_t offset = reader.Read<int64_t>();
+		int32_t count = reader.Read<int32_t>();
+		int32_t baseVertex = reader.Read<int32_t>();
+		offset = RemapIndexOffset(offset);
+		baseVertex = static_cast<int32_t>(RemapFirstVertex(baseVertex));
+		device->DrawTrianglesIndexed32(offset, count, baseVertex);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INDEXED16:
+	{
+		int64_t offset = reader.Read<int64_t>();
+		int32_t count = reader.Read<int32_t>();
+		int32_t baseVertex = reader.Read<int32_t>();
+		offset = RemapIndexOffset(offset);
+		baseVertex = static_cast<int32_t>(RemapFirstVertex(baseVertex));
+		device->DrawTrianglesIndexed16(offset, count, baseVertex);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INSTANCED:
+	{
+		int32_t offset = reader.Read<int32_t>();
+		int32_t count = reader.Read<int32_t>();
+		int32_t instanceCount = reader.Read<int32_t>();
+		offset = static_cast<int32_t>(RemapFirstVertex(offset));
+		device->DrawTrianglesInstanced(offset, count, instanceCount);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INDEXED32_INSTANCED:
+	case TRACECALL_DRAW_TRIANGLES_INDEXED16_INSTANCED:
+	{
+		int64_t offset = reader.Read<int64_t>();
+		int32_t count = reader.Read<int32_t>();
+		int32_t instanceCount = reader.Read<int32_t>();
+		int32_t baseVertex = reader.Read<int32_t>();
+		offset = RemapIndexOffset(offset);
+		baseVertex = static_cast<int32_t>(RemapFirstVertex(baseVertex));
+		if(type == TRACECALL_DRAW_TRIANGLES_INDEXED32_INSTANCED)
+			device->DrawTrianglesIndexed32Instanced(offset, count, instanceCount, baseVertex);
+		else
+			device->DrawTrianglesIndexed16Instanced(offset, count, instanceCount, baseVertex);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_MULTI:
+	{
+		int32_t drawCount = reader.Read<int32_t>();
+		m_MultiDrawFirsts.resize(std::max(drawCount, 0));
+		m_MultiDrawCounts.resize(std::max(drawCount, 0));
+		for(int32_t i = 0; i < drawCount; i++)
+			m_MultiDrawFirsts[i] = static_cast<int>(RemapFirstVertex(reader.Read<int32_t>()));
+		for(int32_t i = 0; i < drawCount; i++)
+			m_MultiDrawCounts[i] = reader.Read<int32_t>();
+		device->DrawTrianglesMulti(drawCount, m_MultiDrawFirsts.data(), m_MultiDrawCounts.data());
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INDEXED_MULTI:
+	{
+		IndexFormat format = static_cast<IndexFormat>(reader.Read<uint32_t>());
+		int32_t drawCount = reader.Read<int32_t>();
+		m_MultiDrawOffsets.resize(std::max(drawCount, 0));
+		m_MultiDrawCounts.resize(std::max(drawCount, 0));
+		m_MultiDrawFirsts.resize(std::max(drawCount, 0));
+		for(int32_t i = 0; i < drawCount; i++)
+			m_MultiDrawOffsets[i] = RemapIndexOffset(reader.Read<int64_t>());
+		for(int32_t i = 0; i < drawCount; i++)
+			m_MultiDrawCounts[i] = reader.Read<int32_t>();
+		for(int32_t i = 0; i < drawCount; i++)
+			m_MultiDrawFirsts[i] = static_cast<int>(RemapFirstVertex(reader.Read<int32_t>()));
+		device->DrawTrianglesIndexedMulti(drawCount, m_MultiDrawOffsets.data(), m_MultiDrawCounts.data(), m_MultiDrawFirsts.data(), format);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_DRAW_TRIANGLES_INDEXED_INDIRECT:
+	{
+		IndirectBuffer *buffer = GetObject<IndirectBuffer>(reader.Read<uint32_t>());
+		int64_t offset = reader.Read<int64_t>();
+		int32_t drawCount = reader.Read<int32_t>();
+		IndexFormat format = static_cast<IndexFormat>(reader.Read<uint32_t>());
+		device->DrawTrianglesIndexedIndirect(buffer, offset, drawCount, format);
+		m_FrameHasDraws = true;
+		break;
+	}
+	case TRACECALL_END_FRAME:
+		device->EndFrame();
+		m_UniformDataOffsets.clear();
+		m_TransientVertexOffsets.clear();
+		m_TransientIndexOffsets.clear();
+		break;
+	case TRACECALL_BEGIN_GPU_SCOPE:
+		device->BeginGpuScope(reader.ReadString());
+		break;
+	case TRACECALL_END_GPU_SCOPE:
+		device->EndGpuScope();
+		break;
+	default:
+		// calls from a newer trace version are skipped
+		break;
+	}
+}
+
+void TraceReplay::DestroyObjects()
+{
+	// destroy in reverse creation order, so objects go before the objects they reference
+	for(size_t id = m_Objects.size(); id-- > 0; )
+	{
+		void *object = m_Objects[id].object;
+		if(!object)
+			continue;
+
+		switch(m_Objects[id].type)
+		{
+		case TRACECALL_CREATE_VERTEX_SHADER: m_RenderDevice->DestroyVertexShader(static_cast<VertexShader *>(object)); break;
+		case TRACECALL_CREATE_PIXEL_SHADER: m_RenderDevice->DestroyPixelShader(static_cast<PixelShader *>(object)); break;
+		case TRACECALL_CREATE_PIPELINE: m_RenderDevice->DestroyPipeline(static_cast<Pipeline *>(object)); break;
+		case TRACECALL_CREATE_VERTEX_BUFFER: m_RenderDevice->DestroyVertexBuffer(static_cast<VertexBuffer *>(object)); break;
+		case TRACECALL_CREATE_VERTEX_DESCRIPTION: m_RenderDevice->DestroyVertexDescription(static_cast<VertexDescription *>(object)); break;
+		case TRACECALL_CREATE_VERTEX_ARRAY: m_RenderDevice->DestroyVertexArray(static_cast<VertexArray *>(object)); break;
+		case TRACECALL_CREATE_INDEX_BUFFER: m_RenderDevice->DestroyIndexBuffer(static_cast<IndexBuffer *>(object)); break;
+		case TRACECALL_CREATE_INDIRECT_BUFFER: m_RenderDevice->DestroyIndirectBuffer(static_cast<IndirectBuffer *>(object)); break;
+		case TRACECALL_CREATE_TEXTURE2D: m_RenderDevice->DestroyTexture2D(static_cast<Texture2D *>(object)); break;
+		case TRACECALL_CREATE_TEXTURE2D_ARRAY: m_RenderDevice->DestroyTexture2DArray(static_cast<Texture2DArray *>(object)); break;
+		case TRACECALL_CREATE_SAMPLER_STATE: m_RenderDevice->DestroySamplerState(static_cast<SamplerState *>(object)); break;
+		case TRACECALL_CREATE_UNIFORM_BUFFER: m_RenderDevice->DestroyUniformBuffer(static_cast<UniformBuffer *>(object)); break;
+		case TRACECALL_CREATE_RASTER_STATE: m_RenderDevice->DestroyRasterState(static_cast<RasterState *>(object)); break;
+		case TRACECALL_CREATE_DEPTH_STENCIL_STATE: m_RenderDevice->DestroyDepthStencilState(static_cast<DepthStencilState *>(object)); break;
+		default: break; // params are owned by their pipeline
+		}
+	}
+
+	m_Objects.clear();
+	m_UniformDataOffsets.clear();
+	m_TransientVertexOffsets.clear();
+	m_TransientIndexOffsets.clear();
+	m_TransientVerticesBound = false;
+	m_TransientIndicesBound = false;
+}
+
+} // end namespace render
@@ -0,0 +1,163 @@
+#include "render_device/triangle_strips.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace render
+{
+
+// Sort key of the directed edge from vertex a to vertex b
+static inline uint64_t EdgeKey(unsigned int a, unsigned int b)
+{
+	return static_cast<uint64_t>(a) << 32 | b;
+}
+
+// Finds unused triangles of a list by their directed edges
+class TriangleAdjacency
+{
+public:
+
+	TriangleAdjacency(long long numTriangles, const unsigned int *indices) : m_Indices(indices), m_Used(static_cast<size_t>(numTriangles), 1)
+	{
+		m_Edges.reserve(static_cast<size_t>(numTriangles) * 3);
+		for(long long triangle = 0; triangle < numTriangles; triangle++)
+		{
+			const unsigned int *vertices = indices + triangle * 3;
+			unsigned int a = vertices[0], b = vertices[1], c = vertices[2];
+			if(a == b || b == c || c == a || a == PRIMITIVE_RESTART_INDEX32 || b == PRIMITIVE_RESTART_INDEX32 || c == PRIMITIVE_RESTART_INDEX32)
+				continue;
+
+			uint32_t id = static_cast<uint32_t>(triangle);
+			m_Edges.push_back(std::make_pair(EdgeKey(a, b), id));
+			m_Edges.push_back(std::make_pair(EdgeKey(b, c), id));
+			m_Edges.push_back(std::make_pair(EdgeKey(c, a), id));
+			m_Used[static_cast<size_t>(triangle)] = 0;
+		}
+		std::sort(m_Edges.begin(), m_Edges.end());
+	}
+
+	bool IsUsed(uint32_t triangle) const { return m_Used[triangle] != 0; }
+
+	void SetUsed(uint32_t triangle, bool used) { m_Used[triangle] = used; }
+
+	// Returns an unused triangle with the directed edge from a to b, or -1; third receives its other vertex
+	long long Find(unsigned int a, unsigned int b, unsigned int &third) const
+	{
+		uint64_t key = EdgeKey(a, b);
+		auto edge = std::lower_bound(m_Edges.begin(), m_Edges.end(), std::make_pair(key, uint32_t(0)));
+		for(; edge != m_Edges.end() && edge->first == key; ++edge)
+		{
+			if(m_Used[edge->second])
+				continue;
+			const unsigned int *vertices = m_Indices + static_cast<size_t>(edge->second) * 3;
+			third = vertices[0] + vertices[1] + vertices[2] - a - b; // wraps around to the vertex that is neither
+			return edge->second;
+		}
+		return -1;
+	}
+
+	// Returns the number of unused triangles across the edges of a triangle
+	int CountNeighbours(uint32_t triangle) const
+	{
+		const unsigned int *vertices = m_Indices + static_cast<size_t>(triangle) * 3;
+		int neighbours = 0;
+		unsigned int third;
+		for(int i = 0; i < 3; i++)
+			neighbours += Find(vertices[(i + 1) % 3], vertices[i], third) >= 0;
+		return neighbours;
+	}
+
+private:
+
+	const unsigned int *m_Indices;
+	std::vector<std::pair<uint64_t, uint32_t>> m_Edges; // directed edges of the triangles kept, sorted
+	std::vector<char> m_Used; // by triangle; degenerate triangles start out used
+};
+
+// Grow a strip from its first three vertices, taking the triangles it passes through, and
+// return them in taken
+static void GrowStrip(TriangleAdjacency &adjacency, std::vector<unsigned int> &strip, std::vector<uint32_t> &taken)
+{
+	for(;;)
+	{
+		// the next triangle is (u, v, w) after an even number of triangles and (v, u, w) after
+		// an odd number, as strips alternate winding
+		size_t size = strip.size();
+		unsigned int u = strip[size - 2], v = strip[size - 1], w;
+		long long triangle = size % 2 == 0 ? adjacency.Find(u, v, w) : adjacency.Find(v, u, w);
+		if(triangle < 0)
+			return;
+
+		adjacency.SetUsed(static_cast<uint32_t>(triangle), true);
+		taken.push_back(static_cast<uint32_t>(triangle));
+		strip.push_back(w);
+	}
+}
+
+TriangleStripStats ConvertToTriangleStrips(long long count, const unsigned int *indices, std::vector<unsigned int> &strips)
+{
+	TriangleStripStats stats;
+	strips.clear();
+
+	const long long numTriangles = indices && count > 0 ? count / 3 : 0;
+	stats.listIndices = numTriangles * 3;
+	if(!numTriangles)
+		return stats;
+
+	TriangleAdjacency adjacency(numTriangles, indices);
+
+	// start strips at the triangles with the fewest neighbours, as counted up front, so that
+	// strips run in from the edges of the mesh rather than leaving islands behind
+	std::vector<uint32_t> order[4];
+	for(long long triangle = 0; triangle < numTriangles; triangle++)
+	{
+		uint32_t id = static_cast<uint32_t>(triangle);
+		if(adjacency.IsUsed(id))
+			stats.droppedTriangles++;
+		else
+			order[adjacency.CountNeighbours(id)].push_back(id);
+	}
+
+	std::vector<unsigned int> strip, bestStrip;
+	std::vector<uint32_t> taken, bestTaken;
+	for(const std::vector<uint32_t> &triangles : order)
+	{
+		for(uint32_t start : triangles)
+		{
+			if(adjacency.IsUsed(start))
+				continue;
+			adjacency.SetUsed(start, true);
+
+			// try each rotation of the first triangle, keeping the one that grows the longest strip
+			const unsigned int *vertices = indices + static_cast<size_t>(start) * 3;
+			bestStrip.clear();
+			for(int rotation = 0; rotation < 3; rotation++)
+			{
+				strip.assign({ vertices[rotation], vertices[(rotation + 1) % 3], vertices[(rotation + 2) % 3] });
+				taken.clear();
+				GrowStrip(adjacency, strip, taken);
+				for(uint32_t triangle : taken)
+					adjacency.SetUsed(triangle, false);
+				if(strip.size() > bestStrip.size())
+				{
+					bestStrip.swap(strip);
+					bestTaken.swap(taken);
+				}
+			}
+			for(uint32_t triangle : bestTaken)
+				adjacency.SetUsed(triangle, true);
+
+			if(stats.strips)
+				strips.push_back(PRIMITIVE_RESTART_INDEX32);
+			strips.insert(strips.end(), bestStrip.begin(), bestStrip.end());
+			stats.strips++;
+		}
+	}
+
+	stats.stripIndices = static_cast<long long>(strips.size());
+	stats.savings = 1.0f - static_cast<float>(stats.stripIndices) / static_cast<float>(stats.listIndices);
+	return stats;
+}
+
+} // end namespace render
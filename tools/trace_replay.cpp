@@ -0,0 +1,97 @@
+#include <render_device/platform.h>
+
+#include <render_device/render_device.h>
+#include <render_device/trace.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Replays a trace recorded with RENDER_DEVICE_CAPTURE as fast as the device allows,
+// presenting after each frame, and reports the time per frame.
+//
+// usage: trace_replay <trace> [passes]
+//
+// The device is selected with RENDER_DEVICE as usual, so the same trace can be timed
+// on each backend, or on two builds of the same backend.
+
+int main(int argc, char **argv)
+{
+	if(argc < 2)
+	{
+		std::cout << "usage: trace_replay <trace> [passes]" << std::endl;
+		return -1;
+	}
+
+	int passes = argc > 2 ? atoi(argv[2]) : 1;
+	if(passes < 1)
+		passes = 1;
+
+	platform::InitPlatform();
+
+	platform::PLATFORM_WINDOW_REF window =
+		platform::CreatePlatformWindow(800, 800, "Trace Replay");
+	if(!window)
+	{
+		platform::TerminatePlatform();
+		return -1;
+	}
+
+	render::RenderDevice *renderDevice = render::CreateRenderDevice(800, 800);
+
+	render::TraceReplay *replay = new render::TraceReplay(renderDevice);
+	if(!replay->Open(argv[1]))
+	{
+		delete replay;
+		render::DestroyRenderDevice(renderDevice);
+		platform::TerminatePlatform();
+		return -1;
+	}
+
+	int pass = 0, frames = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	while(platform::PollPlatformWindow(window))
+	{
+		if(!replay->ReplayFrame())
+		{
+			// end of the trace; start over until every pass has been replayed
+			if(++pass == passes)
+				break;
+			replay->Rewind();
+			continue;
+		}
+
+		frames++;
+
+		platform::PresentPlatformWindow(window);
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if(frames > 0)
+	{
+		std::cout << pass << " passes, " << frames << " frames, " << replay->GetNumCalls() << " calls in " << seconds << " s" << std::endl;
+		std::cout << (seconds * 1000.0 / frames) << " ms/frame, " << (replay->GetNumCalls() / seconds / 1000000.0) << " Mcalls/s" << std::endl;
+
+		// GPU scopes recorded in the trace, indented by nesting depth
+		std::vector<render::GpuScopeStats> gpuStats(renderDevice->GetGpuScopeStats(0, nullptr));
+		if(!gpuStats.empty())
+			renderDevice->GetGpuScopeStats(static_cast<unsigned int>(gpuStats.size()), &gpuStats[0]);
+		for(const render::GpuScopeStats &scope : gpuStats)
+		{
+			std::cout << std::string(2 * scope.depth, ' ') << scope.name << ": " << scope.avgMs << " ms avg, " << scope.minMs << " min, "
+				<< scope.maxMs << " max over " << scope.frames << " frames" << std::endl;
+		}
+	}
+
+	// the replay destroys the trace's resources, so it must go before the device
+	delete replay;
+
+	render::DestroyRenderDevice(renderDevice);
+
+	platform::TerminatePlatform();
+
+	return 0;
+}